@@ -0,0 +1,63 @@
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+#include <ftl/core.hpp>
+#include <benchmark/benchmark.h>
+
+namespace bench {
+  constexpr std::size_t BufferSize = 1 << 16;
+
+  // Builds a batch of short-lived vectors, the pattern arenas are meant for:
+  // many small containers whose memory is dropped together.
+  template <typename Vector, typename... Args>
+  void FillVectors(benchmark::State& state, Args&&... args)
+  {
+    const auto count = static_cast<int>(state.range(0));
+    for (int i = 0; i != 16; ++i) {
+      Vector vector(args...);
+      for (int j = 0; j != count; ++j) {
+        vector.push_back(j);
+      }
+      benchmark::DoNotOptimize(vector.data());
+    }
+  }
+
+  void StdAllocator(benchmark::State& state)
+  {
+    for (auto _ : state) {
+      FillVectors<ftl::vector<int>>(state);
+    }
+  }
+
+  void ArenaAllocator(benchmark::State& state)
+  {
+    alignas(std::max_align_t) static unsigned char buffer[BufferSize];
+    for (auto _ : state) {
+      ftl::arena arena(buffer, sizeof(buffer));
+      FillVectors<ftl::vector<int, ftl::arena_allocator<int>>>(state, arena);
+    }
+  }
+
+  void PmrMonotonic(benchmark::State& state)
+  {
+    alignas(std::max_align_t) static unsigned char buffer[BufferSize];
+    for (auto _ : state) {
+      std::pmr::monotonic_buffer_resource resource(buffer, sizeof(buffer));
+      FillVectors<ftl::pmr::vector<int>>(state, &resource);
+    }
+  }
+
+  void StdPmrMonotonic(benchmark::State& state)
+  {
+    alignas(std::max_align_t) static unsigned char buffer[BufferSize];
+    for (auto _ : state) {
+      std::pmr::monotonic_buffer_resource resource(buffer, sizeof(buffer));
+      FillVectors<std::pmr::vector<int>>(state, &resource);
+    }
+  }
+
+  BENCHMARK(StdAllocator)->RangeMultiplier(4)->Range(4, 1024);
+  BENCHMARK(ArenaAllocator)->RangeMultiplier(4)->Range(4, 1024);
+  BENCHMARK(PmrMonotonic)->RangeMultiplier(4)->Range(4, 1024);
+  BENCHMARK(StdPmrMonotonic)->RangeMultiplier(4)->Range(4, 1024);
+}
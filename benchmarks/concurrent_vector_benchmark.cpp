@@ -0,0 +1,56 @@
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <ftl/core.hpp>
+#include <benchmark/benchmark.h>
+
+// Several threads append to one shared vector: lock-free slot claiming
+// against a mutex around ftl::vector::push_back.
+namespace bench {
+  constexpr int appends_per_thread = 1 << 16;
+
+  template <typename Append>
+  void RunAppenders(int threads, Append append)
+  {
+    std::vector<std::thread> appenders;
+    for (int t = 0; t != threads; ++t) {
+      appenders.emplace_back([&append] {
+        for (int i = 0; i != appends_per_thread; ++i) {
+          append(i);
+        }
+      });
+    }
+    for (auto& appender : appenders) {
+      appender.join();
+    }
+  }
+
+  void ConcurrentVectorPushBack(benchmark::State& state)
+  {
+    const auto threads = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+      ftl::concurrent_vector<int> vector;
+      RunAppenders(threads, [&vector](int i) { vector.push_back(i); });
+      benchmark::DoNotOptimize(vector.size());
+    }
+    state.SetItemsProcessed(state.iterations() * threads * appends_per_thread);
+  }
+
+  void LockedVectorPushBack(benchmark::State& state)
+  {
+    const auto threads = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+      ftl::vector<int> vector;
+      std::mutex mutex;
+      RunAppenders(threads, [&vector, &mutex](int i) {
+        std::lock_guard<std::mutex> lock(mutex);
+        vector.push_back(i);
+      });
+      benchmark::DoNotOptimize(vector.size());
+    }
+    state.SetItemsProcessed(state.iterations() * threads * appends_per_thread);
+  }
+
+  BENCHMARK(ConcurrentVectorPushBack)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+  BENCHMARK(LockedVectorPushBack)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+}
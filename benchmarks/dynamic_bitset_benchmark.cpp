@@ -0,0 +1,85 @@
+#include <cstdint>
+#include <random>
+#include <ftl/core.hpp>
+#include <benchmark/benchmark.h>
+
+// Combining two filter masks and counting the survivors, with one byte per
+// flag against 64 flags per word, and walking the set bits of a sparse mask.
+namespace bench {
+  ftl::vector<std::uint8_t> RandomFlags(std::size_t count, std::uint64_t seed)
+  {
+    std::mt19937_64 engine(seed);
+    ftl::vector<std::uint8_t> flags(count);
+    for (auto& flag : flags) {
+      flag = engine() % 2;
+    }
+    return flags;
+  }
+
+  ftl::dynamic_bitset ToBitset(const ftl::vector<std::uint8_t>& flags)
+  {
+    ftl::dynamic_bitset bits(flags.size());
+    for (std::size_t i = 0; i != flags.size(); ++i) {
+      bits[i] = flags[i] != 0;
+    }
+    return bits;
+  }
+
+  void ByteMaskAndCount(benchmark::State& state)
+  {
+    const auto count = static_cast<std::size_t>(state.range(0));
+    auto lhs = RandomFlags(count, 1);
+    const auto rhs = RandomFlags(count, 2);
+    for (auto _ : state) {
+      std::size_t set = 0;
+      for (std::size_t i = 0; i != count; ++i) {
+        lhs[i] &= rhs[i];
+        set += lhs[i];
+      }
+      benchmark::DoNotOptimize(set);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void BitsetAndCount(benchmark::State& state)
+  {
+    const auto count = static_cast<std::size_t>(state.range(0));
+    auto lhs = ToBitset(RandomFlags(count, 1));
+    const auto rhs = ToBitset(RandomFlags(count, 2));
+    for (auto _ : state) {
+      lhs &= rhs;
+      benchmark::DoNotOptimize(lhs.count());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void BitsetCount(benchmark::State& state)
+  {
+    const auto bits = ToBitset(RandomFlags(
+        static_cast<std::size_t>(state.range(0)), 1));
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(bits.count());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void BitsetForEachSet(benchmark::State& state)
+  {
+    const auto count = static_cast<std::size_t>(state.range(0));
+    ftl::dynamic_bitset bits(count);
+    for (std::size_t i = 0; i < count; i += 97) {
+      bits.set(i);
+    }
+    for (auto _ : state) {
+      std::size_t sum = 0;
+      bits.for_each_set([&sum](std::size_t i) { sum += i; });
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  BENCHMARK(ByteMaskAndCount)->Arg(1 << 12)->Arg(1 << 20);
+  BENCHMARK(BitsetAndCount)->Arg(1 << 12)->Arg(1 << 20);
+  BENCHMARK(BitsetCount)->Arg(1 << 12)->Arg(1 << 20);
+  BENCHMARK(BitsetForEachSet)->Arg(1 << 12)->Arg(1 << 20);
+}
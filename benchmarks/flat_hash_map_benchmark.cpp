@@ -0,0 +1,104 @@
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <ftl/core.hpp>
+#include <benchmark/benchmark.h>
+
+// Lookups that hit and miss, inserts into a fresh map and erasing every
+// key, for ftl::flat_hash_map against the node-based std::unordered_map.
+// Keys are shuffled so that neither table sees them in hash order.
+namespace bench {
+  ftl::vector<std::uint64_t> RandomKeys(std::size_t count, std::uint64_t seed)
+  {
+    std::mt19937_64 engine(seed);
+    ftl::vector<std::uint64_t> keys;
+    keys.reserve(count);
+    for (std::size_t i = 0; i != count; ++i) {
+      keys.push_back(engine());
+    }
+    return keys;
+  }
+
+  template <typename Map>
+  Map FilledMap(const ftl::vector<std::uint64_t>& keys)
+  {
+    Map map;
+    for (std::uint64_t key : keys) {
+      map[key] = key;
+    }
+    return map;
+  }
+
+  template <typename Map>
+  void FindHit(benchmark::State& state)
+  {
+    const auto keys = RandomKeys(static_cast<std::size_t>(state.range(0)), 1);
+    const Map map = FilledMap<Map>(keys);
+    for (auto _ : state) {
+      std::uint64_t sum = 0;
+      for (std::uint64_t key : keys) {
+        sum += map.find(key)->second;
+      }
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  template <typename Map>
+  void FindMiss(benchmark::State& state)
+  {
+    const auto count = static_cast<std::size_t>(state.range(0));
+    const Map map = FilledMap<Map>(RandomKeys(count, 1));
+    const auto misses = RandomKeys(count, 2);
+    for (auto _ : state) {
+      std::size_t found = 0;
+      for (std::uint64_t key : misses) {
+        found += map.count(key);
+      }
+      benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  template <typename Map>
+  void Insert(benchmark::State& state)
+  {
+    const auto keys = RandomKeys(static_cast<std::size_t>(state.range(0)), 1);
+    for (auto _ : state) {
+      Map map;
+      for (std::uint64_t key : keys) {
+        map.emplace(key, key);
+      }
+      benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  template <typename Map>
+  void Erase(benchmark::State& state)
+  {
+    const auto keys = RandomKeys(static_cast<std::size_t>(state.range(0)), 1);
+    for (auto _ : state) {
+      state.PauseTiming();
+      Map map = FilledMap<Map>(keys);
+      state.ResumeTiming();
+      for (std::uint64_t key : keys) {
+        map.erase(key);
+      }
+      benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  using StdMap = std::unordered_map<std::uint64_t, std::uint64_t>;
+  using FlatMap = ftl::flat_hash_map<std::uint64_t, std::uint64_t>;
+
+  BENCHMARK_TEMPLATE(FindHit, StdMap)->Arg(1 << 10)->Arg(1 << 20);
+  BENCHMARK_TEMPLATE(FindHit, FlatMap)->Arg(1 << 10)->Arg(1 << 20);
+  BENCHMARK_TEMPLATE(FindMiss, StdMap)->Arg(1 << 10)->Arg(1 << 20);
+  BENCHMARK_TEMPLATE(FindMiss, FlatMap)->Arg(1 << 10)->Arg(1 << 20);
+  BENCHMARK_TEMPLATE(Insert, StdMap)->Arg(1 << 10)->Arg(1 << 20);
+  BENCHMARK_TEMPLATE(Insert, FlatMap)->Arg(1 << 10)->Arg(1 << 20);
+  BENCHMARK_TEMPLATE(Erase, StdMap)->Arg(1 << 10)->Arg(1 << 20);
+  BENCHMARK_TEMPLATE(Erase, FlatMap)->Arg(1 << 10)->Arg(1 << 20);
+}
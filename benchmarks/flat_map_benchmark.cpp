@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <utility>
+#include <ftl/core.hpp>
+#include <benchmark/benchmark.h>
+
+// Rebuilding a lookup table from sorted batches, merged in one pass or
+// inserted one element at a time, and looking keys up afterwards, for
+// ftl::flat_map against the node-based std::map.
+namespace bench {
+  using Batch = ftl::vector<std::pair<std::uint64_t, std::uint64_t>>;
+
+  ftl::vector<Batch> SortedBatches(std::size_t count, std::size_t size)
+  {
+    std::mt19937_64 engine(1);
+    ftl::vector<Batch> batches(count);
+    for (Batch& batch : batches) {
+      for (std::size_t i = 0; i != size; ++i) {
+        const std::uint64_t key = engine();
+        batch.push_back({ key, key });
+      }
+      std::sort(batch.begin(), batch.end());
+    }
+    return batches;
+  }
+
+  void FlatMapMergeBatches(benchmark::State& state)
+  {
+    const auto batches =
+        SortedBatches(16, static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+      ftl::flat_map<std::uint64_t, std::uint64_t> map;
+      for (const Batch& batch : batches) {
+        map.insert(ftl::sorted_unique, batch.begin(), batch.end());
+      }
+      benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 16);
+  }
+
+  void FlatMapInsertEach(benchmark::State& state)
+  {
+    const auto batches =
+        SortedBatches(16, static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+      ftl::flat_map<std::uint64_t, std::uint64_t> map;
+      for (const Batch& batch : batches) {
+        for (const auto& entry : batch) {
+          map.insert(entry);
+        }
+      }
+      benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 16);
+  }
+
+  void StdMapInsertEach(benchmark::State& state)
+  {
+    const auto batches =
+        SortedBatches(16, static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+      std::map<std::uint64_t, std::uint64_t> map;
+      for (const Batch& batch : batches) {
+        map.insert(batch.begin(), batch.end());
+      }
+      benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 16);
+  }
+
+  template <typename Map>
+  void Find(benchmark::State& state)
+  {
+    const auto batches =
+        SortedBatches(1, static_cast<std::size_t>(state.range(0)));
+    Map map(batches[0].begin(), batches[0].end());
+    auto keys = batches[0];
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(2));
+    for (auto _ : state) {
+      std::uint64_t sum = 0;
+      for (const auto& entry : keys) {
+        sum += map.find(entry.first)->second;
+      }
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  BENCHMARK(FlatMapMergeBatches)->Arg(1 << 8)->Arg(1 << 12);
+  BENCHMARK(FlatMapInsertEach)->Arg(1 << 8)->Arg(1 << 12);
+  BENCHMARK(StdMapInsertEach)->Arg(1 << 8)->Arg(1 << 12);
+  BENCHMARK_TEMPLATE(Find, std::map<std::uint64_t, std::uint64_t>)
+      ->Arg(1 << 10)
+      ->Arg(1 << 16);
+  BENCHMARK_TEMPLATE(Find, ftl::flat_map<std::uint64_t, std::uint64_t>)
+      ->Arg(1 << 10)
+      ->Arg(1 << 16);
+}
@@ -0,0 +1,36 @@
+#include <cstdint>
+#include <memory>
+#include <ftl/core.hpp>
+#include <benchmark/benchmark.h>
+
+namespace bench {
+  // Grows a vector to hundreds of MiB one element at a time; with mremap the
+  // reallocations move page mappings instead of bytes.
+  template <typename Allocator>
+  void GrowLargeVector(benchmark::State& state)
+  {
+    const auto count = static_cast<std::uint64_t>(state.range(0)) << 20;
+    for (auto _ : state) {
+      ftl::vector<std::uint64_t, Allocator> vector;
+      for (std::uint64_t i = 0; i != count; ++i) {
+        vector.push_back(i);
+      }
+      benchmark::DoNotOptimize(vector.data());
+    }
+    state.SetBytesProcessed(state.iterations() * count * 8);
+  }
+
+  BENCHMARK_TEMPLATE(GrowLargeVector, std::allocator<std::uint64_t>)
+      ->Arg(8)
+      ->Arg(32)
+      ->Unit(benchmark::kMillisecond);
+  BENCHMARK_TEMPLATE(GrowLargeVector, ftl::mmap_allocator<std::uint64_t>)
+      ->Arg(8)
+      ->Arg(32)
+      ->Unit(benchmark::kMillisecond);
+  BENCHMARK_TEMPLATE(GrowLargeVector,
+      ftl::mmap_allocator<std::uint64_t, true>)
+      ->Arg(8)
+      ->Arg(32)
+      ->Unit(benchmark::kMillisecond);
+}
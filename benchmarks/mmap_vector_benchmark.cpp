@@ -0,0 +1,92 @@
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <string>
+#include <ftl/core.hpp>
+#include <benchmark/benchmark.h>
+
+namespace bench {
+  // Loads a file of floats and sums it, either by reading it into an
+  // ftl::vector or by mapping it into an ftl::mmap_vector. The file stays
+  // in the page cache between runs, so this measures the copy a read makes
+  // against the page faults of a mapping. LoadOnly opens the file and
+  // touches one element, the startup cost when most of a table goes unused.
+#if defined(FTL_POSIX_FEATURES)
+  const std::string& FloatFile(std::size_t count)
+  {
+    static std::string path;
+    static std::size_t size = 0;
+    if (size != count) {
+      path = "/tmp/ftl_mmap_vector_benchmark";
+      std::remove(path.c_str());
+      ftl::mmap_vector<float> vector(path, ftl::mmap_mode::read_write);
+      vector.resize(count, 1.0f);
+      size = count;
+    }
+    return path;
+  }
+
+  ftl::vector<float> ReadFile(const std::string& path)
+  {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    std::fseek(file, 0, SEEK_END);
+    const auto bytes = static_cast<std::size_t>(std::ftell(file));
+    std::fseek(file, 0, SEEK_SET);
+    ftl::vector<float> vector(bytes / sizeof(float));
+    const auto read = std::fread(vector.data(), 1, bytes, file);
+    std::fclose(file);
+    benchmark::DoNotOptimize(read);
+    return vector;
+  }
+
+  void ReadAndSum(benchmark::State& state)
+  {
+    const auto count = static_cast<std::size_t>(state.range(0)) << 20;
+    const std::string& path = FloatFile(count);
+    for (auto _ : state) {
+      const ftl::vector<float> vector = ReadFile(path);
+      benchmark::DoNotOptimize(
+          std::accumulate(vector.begin(), vector.end(), 0.0f));
+    }
+    state.SetBytesProcessed(state.iterations() * count * sizeof(float));
+  }
+
+  void MapAndSum(benchmark::State& state)
+  {
+    const auto count = static_cast<std::size_t>(state.range(0)) << 20;
+    const std::string& path = FloatFile(count);
+    for (auto _ : state) {
+      ftl::mmap_vector<float> vector(path);
+      vector.advise(ftl::mmap_advice::sequential);
+      benchmark::DoNotOptimize(
+          std::accumulate(vector.cbegin(), vector.cend(), 0.0f));
+    }
+    state.SetBytesProcessed(state.iterations() * count * sizeof(float));
+  }
+
+  void ReadLoadOnly(benchmark::State& state)
+  {
+    const auto count = static_cast<std::size_t>(state.range(0)) << 20;
+    const std::string& path = FloatFile(count);
+    for (auto _ : state) {
+      const ftl::vector<float> vector = ReadFile(path);
+      benchmark::DoNotOptimize(vector[count / 2]);
+    }
+  }
+
+  void MapLoadOnly(benchmark::State& state)
+  {
+    const auto count = static_cast<std::size_t>(state.range(0)) << 20;
+    const std::string& path = FloatFile(count);
+    for (auto _ : state) {
+      const ftl::mmap_vector<float> vector(path);
+      benchmark::DoNotOptimize(vector[count / 2]);
+    }
+  }
+
+  BENCHMARK(ReadAndSum)->Arg(16)->Arg(64)->Unit(benchmark::kMillisecond);
+  BENCHMARK(MapAndSum)->Arg(16)->Arg(64)->Unit(benchmark::kMillisecond);
+  BENCHMARK(ReadLoadOnly)->Arg(16)->Arg(64)->Unit(benchmark::kMillisecond);
+  BENCHMARK(MapLoadOnly)->Arg(16)->Arg(64)->Unit(benchmark::kMillisecond);
+#endif
+}
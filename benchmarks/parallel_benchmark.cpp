@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <ftl/core.hpp>
+#include <benchmark/benchmark.h>
+
+// Each algorithm runs serially with std:: and in parallel on the default
+// pool over a vector of floats, the shape of a batch scoring pass.
+namespace bench {
+  ftl::vector<float> MakeScores(std::size_t count)
+  {
+    ftl::vector<float> scores(count);
+    std::uint32_t seed = 1;
+    for (auto& score : scores) {
+      seed = seed * 1664525u + 1013904223u;
+      score = static_cast<float>(seed >> 8) / 16777216.0f;
+    }
+    return scores;
+  }
+
+  const auto Score = [](float x) { return std::sqrt(x) * 0.5f + x * x; };
+
+  void StdTransform(benchmark::State& state)
+  {
+    const auto input = MakeScores(static_cast<std::size_t>(state.range(0)));
+    ftl::vector<float> output(input.size());
+    for (auto _ : state) {
+      std::transform(input.begin(), input.end(), output.begin(), Score);
+      benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void ParallelTransform(benchmark::State& state)
+  {
+    const auto input = MakeScores(static_cast<std::size_t>(state.range(0)));
+    ftl::vector<float> output(input.size());
+    for (auto _ : state) {
+      ftl::parallel::transform(input.begin(), input.end(), output.begin(),
+          Score);
+      benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void StdReduce(benchmark::State& state)
+  {
+    const auto input = MakeScores(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(
+          std::accumulate(input.begin(), input.end(), 0.0));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void ParallelReduce(benchmark::State& state)
+  {
+    const auto input = MakeScores(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(
+          ftl::parallel::reduce(input.begin(), input.end(), 0.0));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void StdInclusiveScan(benchmark::State& state)
+  {
+    const auto input = MakeScores(static_cast<std::size_t>(state.range(0)));
+    ftl::vector<float> output(input.size());
+    for (auto _ : state) {
+      std::partial_sum(input.begin(), input.end(), output.begin());
+      benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void ParallelInclusiveScan(benchmark::State& state)
+  {
+    const auto input = MakeScores(static_cast<std::size_t>(state.range(0)));
+    ftl::vector<float> output(input.size());
+    for (auto _ : state) {
+      ftl::parallel::inclusive_scan(input.begin(), input.end(),
+          output.begin());
+      benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void StdSort(benchmark::State& state)
+  {
+    const auto input = MakeScores(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+      state.PauseTiming();
+      auto scores = input;
+      state.ResumeTiming();
+      std::sort(scores.begin(), scores.end());
+      benchmark::DoNotOptimize(scores.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void ParallelSort(benchmark::State& state)
+  {
+    const auto input = MakeScores(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+      state.PauseTiming();
+      auto scores = input;
+      state.ResumeTiming();
+      ftl::parallel::sort(scores.begin(), scores.end());
+      benchmark::DoNotOptimize(scores.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  const auto IsLow = [](float score) { return score < 0.25f; };
+
+  void StdRemoveIf(benchmark::State& state)
+  {
+    const auto input = MakeScores(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+      state.PauseTiming();
+      auto scores = input;
+      state.ResumeTiming();
+      benchmark::DoNotOptimize(
+          std::remove_if(scores.begin(), scores.end(), IsLow));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void ParallelRemoveIf(benchmark::State& state)
+  {
+    const auto input = MakeScores(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+      state.PauseTiming();
+      auto scores = input;
+      state.ResumeTiming();
+      benchmark::DoNotOptimize(
+          ftl::parallel::remove_if(scores.begin(), scores.end(), IsLow));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+#define FTL_BENCHMARK_SIZES(Case)                                              \
+  BENCHMARK(Case)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24)->UseRealTime()
+
+  FTL_BENCHMARK_SIZES(StdTransform);
+  FTL_BENCHMARK_SIZES(ParallelTransform);
+  FTL_BENCHMARK_SIZES(StdReduce);
+  FTL_BENCHMARK_SIZES(ParallelReduce);
+  FTL_BENCHMARK_SIZES(StdInclusiveScan);
+  FTL_BENCHMARK_SIZES(ParallelInclusiveScan);
+  FTL_BENCHMARK_SIZES(StdSort);
+  FTL_BENCHMARK_SIZES(ParallelSort);
+  FTL_BENCHMARK_SIZES(StdRemoveIf);
+  FTL_BENCHMARK_SIZES(ParallelRemoveIf);
+
+#undef FTL_BENCHMARK_SIZES
+}
@@ -0,0 +1,32 @@
+#include <memory>
+#include <ftl/core.hpp>
+#include <benchmark/benchmark.h>
+
+namespace bench {
+  // Every thread builds and drops small vectors, so nearly all the time goes
+  // to allocation and the allocator's shared state is contended.
+  template <typename Allocator>
+  void ChurnSmallVectors(benchmark::State& state)
+  {
+    const auto count = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+      ftl::vector<int, Allocator> vector;
+      for (int i = 0; i != count; ++i) {
+        vector.push_back(i);
+      }
+      benchmark::DoNotOptimize(vector.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+
+  BENCHMARK_TEMPLATE(ChurnSmallVectors, std::allocator<int>)
+      ->RangeMultiplier(4)
+      ->Range(4, 256)
+      ->ThreadRange(1, 32)
+      ->UseRealTime();
+  BENCHMARK_TEMPLATE(ChurnSmallVectors, ftl::pool_allocator<int>)
+      ->RangeMultiplier(4)
+      ->Range(4, 256)
+      ->ThreadRange(1, 32)
+      ->UseRealTime();
+}
@@ -0,0 +1,75 @@
+#include <array>
+#include <numeric>
+#include <ftl/core.hpp>
+#include <benchmark/benchmark.h>
+
+// Appending large records, where ftl::vector pays for moving every element
+// on each reallocation, and summing a vector of floats segment by segment
+// against one contiguous loop.
+namespace bench {
+  using Record = std::array<double, 32>;
+
+  template <typename Vector>
+  void AppendRecords(benchmark::State& state)
+  {
+    const auto count = static_cast<std::size_t>(state.range(0));
+    Record record{};
+    for (auto _ : state) {
+      Vector records;
+      for (std::size_t i = 0; i != count; ++i) {
+        record[0] = static_cast<double>(i);
+        records.push_back(record);
+      }
+      benchmark::DoNotOptimize(&records.back());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void VectorSum(benchmark::State& state)
+  {
+    ftl::vector<float> values(static_cast<std::size_t>(state.range(0)), 1.0f);
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(
+          std::accumulate(values.begin(), values.end(), 0.0f));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void SegmentedVectorSum(benchmark::State& state)
+  {
+    ftl::segmented_vector<float> values(
+        static_cast<std::size_t>(state.range(0)), 1.0f);
+    for (auto _ : state) {
+      float sum = 0.0f;
+      values.for_each_segment([&sum](const float* first, const float* last) {
+        sum = std::accumulate(first, last, sum);
+      });
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void SegmentedVectorIndexSum(benchmark::State& state)
+  {
+    ftl::segmented_vector<float> values(
+        static_cast<std::size_t>(state.range(0)), 1.0f);
+    for (auto _ : state) {
+      float sum = 0.0f;
+      for (std::size_t i = 0; i != values.size(); ++i) {
+        sum += values[i];
+      }
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  BENCHMARK_TEMPLATE(AppendRecords, ftl::vector<Record>)
+      ->Arg(1 << 10)
+      ->Arg(1 << 16);
+  BENCHMARK_TEMPLATE(AppendRecords, ftl::segmented_vector<Record>)
+      ->Arg(1 << 10)
+      ->Arg(1 << 16);
+  BENCHMARK(VectorSum)->Arg(1 << 16)->Arg(1 << 20);
+  BENCHMARK(SegmentedVectorSum)->Arg(1 << 16)->Arg(1 << 20);
+  BENCHMARK(SegmentedVectorIndexSum)->Arg(1 << 16)->Arg(1 << 20);
+}
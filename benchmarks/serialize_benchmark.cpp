@@ -0,0 +1,74 @@
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <ftl/core.hpp>
+#include <benchmark/benchmark.h>
+
+namespace bench {
+  // Writes and reads back a vector of 32 byte records through a string
+  // stream, element by element with push_back as hand-written code does,
+  // and with ftl::serialize / ftl::deserialize, with and without the
+  // checksum.
+  struct Record
+  {
+    std::uint64_t id;
+    double values[3];
+  };
+
+  ftl::vector<Record> MakeRecords(std::size_t count)
+  {
+    ftl::vector<Record> records(count);
+    for (std::size_t i = 0; i != count; ++i) {
+      records[i] = Record{i, {1.0 * i, 2.0 * i, 3.0 * i}};
+    }
+    return records;
+  }
+
+  void ElementwiseRoundTrip(benchmark::State& state)
+  {
+    const auto records = MakeRecords(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+      std::ostringstream os;
+      const std::uint64_t size = records.size();
+      os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+      for (const Record& record : records) {
+        os.write(reinterpret_cast<const char*>(&record), sizeof(record));
+      }
+      std::istringstream is(os.str());
+      std::uint64_t count = 0;
+      is.read(reinterpret_cast<char*>(&count), sizeof(count));
+      ftl::vector<Record> read;
+      for (std::uint64_t i = 0; i != count; ++i) {
+        Record record;
+        is.read(reinterpret_cast<char*>(&record), sizeof(record));
+        read.push_back(record);
+      }
+      benchmark::DoNotOptimize(read.data());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) *
+        sizeof(Record));
+  }
+
+  void SerializeRoundTrip(benchmark::State& state)
+  {
+    const auto records = MakeRecords(static_cast<std::size_t>(state.range(0)));
+    const bool checksum = state.range(1) != 0;
+    for (auto _ : state) {
+      std::ostringstream os;
+      ftl::serialize(os, records, checksum);
+      std::istringstream is(os.str());
+      ftl::vector<Record> read;
+      ftl::deserialize(is, read);
+      benchmark::DoNotOptimize(read.data());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) *
+        sizeof(Record));
+  }
+
+  BENCHMARK(ElementwiseRoundTrip)->Arg(1 << 10)->Arg(1 << 18);
+  BENCHMARK(SerializeRoundTrip)
+      ->Args({1 << 10, 0})
+      ->Args({1 << 18, 0})
+      ->Args({1 << 10, 1})
+      ->Args({1 << 18, 1});
+}
@@ -0,0 +1,63 @@
+#include <ftl/core.hpp>
+#include <benchmark/benchmark.h>
+
+// A kernel that reads two of a particle's eight fields, over an array of
+// structs and over a soa_vector with the same fields.
+namespace bench {
+  struct Particle
+  {
+    float x, y, z;
+    float vx, vy, vz;
+    float mass;
+    int id;
+  };
+
+  using Particles =
+      ftl::soa_vector<float, float, float, float, float, float, float, int>;
+
+  void AosAdvance(benchmark::State& state)
+  {
+    ftl::vector<Particle> particles(static_cast<std::size_t>(state.range(0)),
+        Particle{ 0, 0, 0, 1, 1, 1, 1, 0 });
+    for (auto _ : state) {
+      for (auto& particle : particles) {
+        particle.x += particle.vx * 0.01f;
+      }
+      benchmark::DoNotOptimize(particles.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void SoaAdvance(benchmark::State& state)
+  {
+    Particles particles;
+    for (auto i = state.range(0); i != 0; --i) {
+      particles.emplace_back(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0);
+    }
+    for (auto _ : state) {
+      auto xs = particles.column<0>();
+      auto vxs = particles.column<3>();
+      for (std::size_t i = 0; i != xs.size(); ++i) {
+        xs[i] += vxs[i] * 0.01f;
+      }
+      benchmark::DoNotOptimize(xs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  void SoaEmplaceBack(benchmark::State& state)
+  {
+    for (auto _ : state) {
+      Particles particles;
+      for (auto i = state.range(0); i != 0; --i) {
+        particles.emplace_back(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0);
+      }
+      benchmark::DoNotOptimize(particles.data<0>());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+
+  BENCHMARK(AosAdvance)->Arg(1 << 12)->Arg(1 << 20);
+  BENCHMARK(SoaAdvance)->Arg(1 << 12)->Arg(1 << 20);
+  BENCHMARK(SoaEmplaceBack)->Arg(1 << 12)->Arg(1 << 20);
+}
@@ -0,0 +1,131 @@
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <ftl/core.hpp>
+#include <benchmark/benchmark.h>
+
+namespace bench {
+  // Throughput: a producer thread streams 64-bit values to the benchmark
+  // thread through an spsc_ring, one at a time or in batches of
+  // state.range(0), under each wait strategy, against a mutex-guarded
+  // ftl::vector swapped out whole by the consumer. Latency: a value makes a
+  // round trip to an echo thread and back through two rings, so the time
+  // per iteration is two one-way hand-offs.
+  constexpr std::uint64_t items = 1 << 20;
+  constexpr std::size_t ring_capacity = 4096;
+
+  template <typename Wait>
+  void RingThroughput(benchmark::State& state)
+  {
+    const auto batch = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+      ftl::spsc_ring<std::uint64_t, Wait> ring(ring_capacity);
+      std::thread producer([&ring, batch]() {
+        std::uint64_t values[256];
+        for (std::uint64_t i = 0; i != items; i += batch) {
+          for (std::size_t k = 0; k != batch; ++k) {
+            values[k] = i + k;
+          }
+          ring.push_n(values, batch);
+        }
+      });
+      std::uint64_t values[256];
+      std::uint64_t sum = 0;
+      for (std::uint64_t i = 0; i != items; i += batch) {
+        ring.pop_n(values, batch);
+        sum += values[batch - 1];
+      }
+      producer.join();
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * items);
+  }
+
+  void MutexVectorThroughput(benchmark::State& state)
+  {
+    const auto batch = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+      std::mutex mutex;
+      std::condition_variable ready;
+      ftl::vector<std::uint64_t> shared;
+      std::thread producer([&]() {
+        for (std::uint64_t i = 0; i != items; i += batch) {
+          std::unique_lock<std::mutex> lock(mutex);
+          ready.wait(lock, [&]() { return shared.size() < ring_capacity; });
+          for (std::size_t k = 0; k != batch; ++k) {
+            shared.push_back(i + k);
+          }
+          ready.notify_one();
+        }
+      });
+      ftl::vector<std::uint64_t> taken;
+      std::uint64_t received = 0;
+      std::uint64_t sum = 0;
+      while (received != items) {
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          ready.wait(lock, [&]() { return !shared.empty(); });
+          taken.swap(shared);
+          ready.notify_one();
+        }
+        received += taken.size();
+        sum += taken.back();
+        taken.clear();
+      }
+      producer.join();
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * items);
+  }
+
+  template <typename Wait>
+  void RingRoundTrip(benchmark::State& state)
+  {
+    ftl::spsc_ring<std::uint64_t, Wait> ping(64);
+    ftl::spsc_ring<std::uint64_t, Wait> pong(64);
+    std::thread echo([&ping, &pong]() {
+      for (;;) {
+        const std::uint64_t value = ping.pop();
+        pong.push(value);
+        if (value == 0) {
+          return;
+        }
+      }
+    });
+    std::uint64_t value = 1;
+    for (auto _ : state) {
+      ping.push(value);
+      benchmark::DoNotOptimize(pong.pop());
+      ++value;
+    }
+    ping.push(0);
+    pong.pop();
+    echo.join();
+  }
+
+  BENCHMARK_TEMPLATE(RingThroughput, ftl::spin_wait)
+      ->Arg(1)
+      ->Arg(64)
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime();
+  BENCHMARK_TEMPLATE(RingThroughput, ftl::yield_wait)
+      ->Arg(1)
+      ->Arg(64)
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime();
+  BENCHMARK_TEMPLATE(RingThroughput, ftl::futex_wait)
+      ->Arg(1)
+      ->Arg(64)
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime();
+  BENCHMARK(MutexVectorThroughput)
+      ->Arg(1)
+      ->Arg(64)
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime();
+
+  BENCHMARK_TEMPLATE(RingRoundTrip, ftl::spin_wait)->UseRealTime();
+  BENCHMARK_TEMPLATE(RingRoundTrip, ftl::yield_wait)->UseRealTime();
+  BENCHMARK_TEMPLATE(RingRoundTrip, ftl::futex_wait)->UseRealTime();
+}
@@ -0,0 +1,72 @@
+#include <future>
+#include <vector>
+#include <ftl/core.hpp>
+#include <benchmark/benchmark.h>
+
+namespace bench {
+  ftl::thread_pool& Pool()
+  {
+    static ftl::thread_pool pool;
+    return pool;
+  }
+
+  // One empty task submitted from outside the pool and waited for: the
+  // round trip through the shared queue and a sleeping worker.
+  void SubmitAndGet(benchmark::State& state)
+  {
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(Pool().submit([] { return 1; }).get());
+    }
+  }
+
+  void StdAsyncAndGet(benchmark::State& state)
+  {
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(
+          std::async(std::launch::async, [] { return 1; }).get());
+    }
+  }
+
+  // Empty tasks submitted from outside the pool, then waited for together.
+  void SpawnExternal(benchmark::State& state)
+  {
+    const auto count = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+      for (int i = 0; i != count; ++i) {
+        Pool().submit([] {});
+      }
+      Pool().wait_idle();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+  }
+
+  // Empty tasks spawned by a task onto its worker's own deque, the path
+  // fork-join algorithms take.
+  void SpawnFromWorker(benchmark::State& state)
+  {
+    const auto count = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+      Pool()
+          .submit([count] {
+            std::vector<ftl::task_handle<void>> children;
+            children.reserve(count);
+            for (int i = 0; i != count; ++i) {
+              children.push_back(Pool().submit([] {}));
+            }
+            for (auto& child : children) {
+              child.get();
+            }
+          })
+          .get();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+  }
+
+  BENCHMARK(SubmitAndGet)->UseRealTime();
+  BENCHMARK(StdAsyncAndGet)->UseRealTime();
+  BENCHMARK(SpawnExternal)->RangeMultiplier(16)->Range(16, 4096)->UseRealTime();
+  BENCHMARK(SpawnFromWorker)
+      ->RangeMultiplier(16)
+      ->Range(16, 4096)
+      ->UseRealTime();
+}
@@ -0,0 +1,250 @@
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <ftl/core.hpp>
+#include <benchmark/benchmark.h>
+
+// Every case runs against ftl::vector and std::vector for three element
+// kinds: trivially copyable, move-only and expensive to copy. The ftl_bench
+// target runs the whole suite and stores JSON results for comparison.
+namespace bench {
+  using Trivial = int;
+  using MoveOnly = std::unique_ptr<int>;
+  using Expensive = std::string;
+  using Byte = std::uint8_t;
+  using Key = std::uint64_t;
+
+  template <typename T>
+  struct Make;
+
+  template <>
+  struct Make<Trivial>
+  {
+    static Trivial value(int i) { return i; }
+  };
+
+  template <>
+  struct Make<Byte>
+  {
+    static Byte value(int i) { return static_cast<Byte>(i); }
+  };
+
+  template <>
+  struct Make<Key>
+  {
+    static Key value(int i) { return static_cast<Key>(i) * 2654435761u; }
+  };
+
+  template <>
+  struct Make<MoveOnly>
+  {
+    static MoveOnly value(int i) { return std::make_unique<int>(i); }
+  };
+
+  template <>
+  struct Make<Expensive>
+  {
+    static Expensive value(int i)
+    {
+      return std::string(48, 'x') + std::to_string(i);
+    }
+  };
+
+  template <typename Vector>
+  Vector MakeVector(int count)
+  {
+    Vector vector;
+    vector.reserve(count);
+    for (int i = 0; i != count; ++i) {
+      vector.push_back(Make<typename Vector::value_type>::value(i));
+    }
+    return vector;
+  }
+
+  // std::vector has no std::hash, so it always combines std::hash of every
+  // element, which is the fallback std::hash<ftl::vector> uses for
+  // Expensive. Trivial elements are hashed as bytes on the ftl side, so
+  // that case compares the byte hash against the per-element fallback.
+  template <typename T>
+  std::size_t Hash(const std::vector<T>& vector)
+  {
+    return ftl::detail::hash_contiguous(vector, std::false_type());
+  }
+
+  template <typename T>
+  std::size_t Hash(const ftl::vector<T>& vector)
+  {
+    return std::hash<ftl::vector<T>>{}(vector);
+  }
+
+  template <typename Vector>
+  void PushBack(benchmark::State& state)
+  {
+    using T = typename Vector::value_type;
+    const auto count = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+      Vector vector;
+      for (int i = 0; i != count; ++i) {
+        vector.push_back(Make<T>::value(i));
+      }
+      benchmark::DoNotOptimize(vector.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+  }
+
+  template <typename Vector>
+  void EmplaceBackReserved(benchmark::State& state)
+  {
+    using T = typename Vector::value_type;
+    const auto count = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+      Vector vector;
+      vector.reserve(count);
+      for (int i = 0; i != count; ++i) {
+        vector.emplace_back(Make<T>::value(i));
+      }
+      benchmark::DoNotOptimize(vector.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+  }
+
+  template <typename Vector>
+  void InsertEraseMiddle(benchmark::State& state)
+  {
+    using T = typename Vector::value_type;
+    const auto count = static_cast<int>(state.range(0));
+    Vector vector = MakeVector<Vector>(count);
+    for (auto _ : state) {
+      vector.insert(vector.begin() + count / 2, Make<T>::value(0));
+      vector.erase(vector.begin() + count / 2);
+      benchmark::DoNotOptimize(vector.data());
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+  }
+
+  template <typename Vector>
+  void RangeConstruct(benchmark::State& state)
+  {
+    const auto count = static_cast<int>(state.range(0));
+    const auto source =
+        MakeVector<std::vector<typename Vector::value_type>>(count);
+    for (auto _ : state) {
+      Vector vector(source.begin(), source.end());
+      benchmark::DoNotOptimize(vector.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+  }
+
+  template <typename Vector>
+  void Copy(benchmark::State& state)
+  {
+    const auto count = static_cast<int>(state.range(0));
+    const Vector source = MakeVector<Vector>(count);
+    for (auto _ : state) {
+      Vector copy(source);
+      benchmark::DoNotOptimize(copy.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+  }
+
+  template <typename Vector>
+  void Move(benchmark::State& state)
+  {
+    const auto count = static_cast<int>(state.range(0));
+    Vector source = MakeVector<Vector>(count);
+    for (auto _ : state) {
+      Vector moved(std::move(source));
+      benchmark::DoNotOptimize(moved.data());
+      source = std::move(moved);
+    }
+  }
+
+  template <typename Vector>
+  void Resize(benchmark::State& state)
+  {
+    const auto count = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+      Vector vector;
+      vector.resize(count);
+      vector.resize(count / 2);
+      vector.resize(count * 2);
+      benchmark::DoNotOptimize(vector.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count * 2);
+  }
+
+  template <typename Vector>
+  void Compare(benchmark::State& state)
+  {
+    const auto count = static_cast<int>(state.range(0));
+    const Vector lhs = MakeVector<Vector>(count);
+    const Vector rhs = MakeVector<Vector>(count);
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(lhs == rhs);
+      benchmark::DoNotOptimize(lhs < rhs);
+    }
+    state.SetItemsProcessed(state.iterations() * count * 2);
+  }
+
+  // Key vectors that agree up to the last element, the worst case for the
+  // ordered comparisons an index merge makes between neighbouring runs.
+  template <typename Vector>
+  void CompareSortedKeys(benchmark::State& state)
+  {
+    const auto count = static_cast<int>(state.range(0));
+    const Vector lhs = MakeVector<Vector>(count);
+    Vector rhs = MakeVector<Vector>(count);
+    ++rhs.back();
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(lhs == rhs);
+      benchmark::DoNotOptimize(lhs < rhs);
+    }
+    state.SetItemsProcessed(state.iterations() * count * 2);
+  }
+
+  template <typename Vector>
+  void HashVector(benchmark::State& state)
+  {
+    const auto count = static_cast<int>(state.range(0));
+    const Vector vector = MakeVector<Vector>(count);
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(Hash(vector));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+  }
+
+#define FTL_BENCHMARK_VECTORS(Case, T)                                         \
+  BENCHMARK_TEMPLATE(Case, ftl::vector<T>)->RangeMultiplier(16)->Range(16,     \
+      1 << 16);                                                                \
+  BENCHMARK_TEMPLATE(Case, std::vector<T>)->RangeMultiplier(16)->Range(16,     \
+      1 << 16)
+
+#define FTL_BENCHMARK_ALL_KINDS(Case)                                          \
+  FTL_BENCHMARK_VECTORS(Case, Trivial);                                        \
+  FTL_BENCHMARK_VECTORS(Case, MoveOnly);                                       \
+  FTL_BENCHMARK_VECTORS(Case, Expensive)
+
+#define FTL_BENCHMARK_COPYABLE_KINDS(Case)                                     \
+  FTL_BENCHMARK_VECTORS(Case, Trivial);                                        \
+  FTL_BENCHMARK_VECTORS(Case, Expensive)
+
+  FTL_BENCHMARK_ALL_KINDS(PushBack);
+  FTL_BENCHMARK_ALL_KINDS(EmplaceBackReserved);
+  FTL_BENCHMARK_ALL_KINDS(InsertEraseMiddle);
+  FTL_BENCHMARK_ALL_KINDS(Move);
+  FTL_BENCHMARK_ALL_KINDS(Resize);
+  FTL_BENCHMARK_COPYABLE_KINDS(RangeConstruct);
+  FTL_BENCHMARK_COPYABLE_KINDS(Copy);
+  FTL_BENCHMARK_COPYABLE_KINDS(Compare);
+  FTL_BENCHMARK_VECTORS(CompareSortedKeys, Byte);
+  FTL_BENCHMARK_VECTORS(CompareSortedKeys, Key);
+  FTL_BENCHMARK_COPYABLE_KINDS(HashVector);
+
+#undef FTL_BENCHMARK_COPYABLE_KINDS
+#undef FTL_BENCHMARK_ALL_KINDS
+#undef FTL_BENCHMARK_VECTORS
+}
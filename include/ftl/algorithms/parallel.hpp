@@ -0,0 +1,456 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_ALGORITHMS_PARALLEL_HPP
+#define FTL_ALGORITHMS_PARALLEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include "../concurrency/thread_pool.hpp"
+#include "../containers/vector.hpp"
+
+// Parallel versions of standard algorithms for random access ranges, such
+// as those of ftl::vector. Each one splits its range into chunks of about
+// grain elements and runs them as tasks of a thread_pool, by default the one
+// returned by default_pool(). A grain of zero picks one from the range size
+// and the pool size. The functions may be called from inside a task of the
+// same pool; they then share its workers instead of blocking one.
+namespace ftl {
+  namespace parallel {
+
+    // A pool with one worker per hardware thread, started on first use and
+    // never stopped.
+    inline thread_pool& default_pool()
+    {
+      static thread_pool* pool = new thread_pool();
+      return *pool;
+    }
+  }
+
+  namespace detail {
+
+    // Below this many elements per chunk the cost of a task outweighs the
+    // work for any cheap operation.
+    constexpr std::size_t parallel_min_grain = 1024;
+
+    inline std::size_t parallel_grain(const thread_pool& pool, std::size_t n,
+        std::size_t grain) noexcept
+    {
+      if (grain != 0) {
+        return grain;
+      }
+      const std::size_t even = n / (8 * pool.size());
+      return even < parallel_min_grain ? parallel_min_grain : even;
+    }
+
+    // Runs left as a task and right on the calling thread, and returns once
+    // both have finished. An exception from either is rethrown, but only
+    // after the other is done with whatever the two share.
+    template <typename Left, typename Right>
+    void fork_join(thread_pool& pool, Left&& left, Right&& right)
+    {
+      auto handle = pool.submit(std::forward<Left>(left));
+      try {
+        right();
+      } catch (...) {
+        handle.wait();
+        throw;
+      }
+      handle.get();
+    }
+
+    // Calls f on a worker of pool, so that the tasks it spawns go to a
+    // worker's own deque.
+    template <typename F>
+    void run_on(thread_pool& pool, F& f)
+    {
+      if (pool.is_worker()) {
+        f();
+      } else {
+        pool.submit(std::ref(f)).get();
+      }
+    }
+
+    // Calls body(begin, end) on disjoint subranges of [begin, end) of at
+    // most grain indices that together cover it.
+    template <typename Body>
+    void parallel_for(thread_pool& pool, std::size_t begin, std::size_t end,
+        std::size_t grain, const Body& body)
+    {
+      if (end - begin <= grain) {
+        body(begin, end);
+        return;
+      }
+      const std::size_t mid = begin + (end - begin) / 2;
+      fork_join(pool,
+          [&pool, mid, end, grain, &body] {
+            parallel_for(pool, mid, end, grain, body);
+          },
+          [&] { parallel_for(pool, begin, mid, grain, body); });
+    }
+
+    template <typename Body>
+    void parallel_for(thread_pool& pool, std::size_t n, std::size_t grain,
+        const Body& body)
+    {
+      if (n == 0) {
+        return;
+      }
+      auto root = [&] { parallel_for(pool, 0, n, grain, body); };
+      run_on(pool, root);
+    }
+
+    template <typename It, typename T, typename BinaryOp>
+    T parallel_reduce(thread_pool& pool, It first, std::size_t n,
+        std::size_t grain, BinaryOp& op)
+    {
+      if (n <= grain) {
+        return std::accumulate(first + 1, first + n, T(*first), op);
+      }
+      const std::size_t half = n / 2;
+      auto right = pool.submit([&pool, first, half, n, grain, &op] {
+        return parallel_reduce<It, T>(pool, first + half, n - half, grain, op);
+      });
+      T left = [&] {
+        try {
+          return parallel_reduce<It, T>(pool, first, half, grain, op);
+        } catch (...) {
+          right.wait();
+          throw;
+        }
+      }();
+      return op(std::move(left), right.get());
+    }
+
+    template <typename InputIt, typename OutputIt, typename Compare>
+    void parallel_merge(thread_pool& pool, InputIt a_first, InputIt a_last,
+        InputIt b_first, InputIt b_last, OutputIt out, Compare& comp,
+        std::size_t grain)
+    {
+      const auto a_size = static_cast<std::size_t>(a_last - a_first);
+      const auto b_size = static_cast<std::size_t>(b_last - b_first);
+      if (a_size + b_size <= grain) {
+        std::merge(std::make_move_iterator(a_first),
+            std::make_move_iterator(a_last), std::make_move_iterator(b_first),
+            std::make_move_iterator(b_last), out, comp);
+        return;
+      }
+      // The middle of the longer run is the pivot: the elements that go
+      // before it are merged on one side and those after it on the other.
+      // Equal elements of the first run stay ahead of those of the second,
+      // so the merge is stable.
+      const bool pivot_in_a = a_size >= b_size;
+      InputIt a_split;
+      InputIt b_split;
+      if (pivot_in_a) {
+        a_split = a_first + a_size / 2;
+        b_split = std::lower_bound(b_first, b_last, *a_split, comp);
+      } else {
+        b_split = b_first + b_size / 2;
+        a_split = std::upper_bound(a_first, a_last, *b_split, comp);
+      }
+      const OutputIt out_pivot =
+          out + ((a_split - a_first) + (b_split - b_first));
+      *out_pivot = std::move(pivot_in_a ? *a_split : *b_split);
+      const InputIt a_rest = pivot_in_a ? a_split + 1 : a_split;
+      const InputIt b_rest = pivot_in_a ? b_split : b_split + 1;
+      fork_join(pool,
+          [&pool, a_rest, a_last, b_rest, b_last, out_pivot, &comp, grain] {
+            parallel_merge(pool, a_rest, a_last, b_rest, b_last, out_pivot + 1,
+                comp, grain);
+          },
+          [&] {
+            parallel_merge(pool, a_first, a_split, b_first, b_split, out, comp,
+                grain);
+          });
+    }
+
+    // Sorts the n elements at src. The result ends up at src if to_src is
+    // set and at dst otherwise; the elements at dst serve as scratch space.
+    template <typename SrcIt, typename DstIt, typename Compare>
+    void parallel_sort(thread_pool& pool, SrcIt src, DstIt dst, std::size_t n,
+        bool to_src, Compare& comp, std::size_t grain)
+    {
+      if (n <= grain) {
+        std::sort(src, src + n, comp);
+        if (!to_src) {
+          std::move(src, src + n, dst);
+        }
+        return;
+      }
+      const std::size_t half = n / 2;
+      fork_join(pool,
+          [&pool, src, dst, half, n, to_src, &comp, grain] {
+            parallel_sort(pool, src + half, dst + half, n - half, !to_src,
+                comp, grain);
+          },
+          [&] {
+            parallel_sort(pool, src, dst, half, !to_src, comp, grain);
+          });
+      if (to_src) {
+        parallel_merge(pool, dst, dst + half, dst + half, dst + n, src, comp,
+            grain);
+      } else {
+        parallel_merge(pool, src, src + half, src + half, src + n, dst, comp,
+            grain);
+      }
+    }
+
+    template <typename It, typename Predicate>
+    It parallel_remove_if(thread_pool& pool, It first, It last,
+        Predicate& pred, std::size_t grain,
+        std::false_type /* nothrow movable */)
+    {
+      static_cast<void>(pool);
+      static_cast<void>(grain);
+      return std::remove_if(first, last, pred);
+    }
+
+    // Marks the kept elements and counts them per block, moves them into a
+    // buffer at their final offsets, then moves the buffer back. The moves
+    // cannot throw, so the buffer never holds elements that would be lost.
+    template <typename It, typename Predicate>
+    It parallel_remove_if(thread_pool& pool, It first, It last,
+        Predicate& pred, std::size_t grain,
+        std::true_type /* nothrow movable */)
+    {
+      using T = typename std::iterator_traits<It>::value_type;
+      const auto n = static_cast<std::size_t>(last - first);
+      if (n == 0) {
+        return first;
+      }
+      const std::size_t blocks = (n + grain - 1) / grain;
+      ftl::vector<unsigned char> keep(n);
+      ftl::vector<std::size_t> offsets(blocks + 1);
+      parallel_for(pool, blocks, 1, [&](std::size_t b0, std::size_t b1) {
+        for (std::size_t b = b0; b != b1; ++b) {
+          const std::size_t end = std::min(n, (b + 1) * grain);
+          std::size_t count = 0;
+          for (std::size_t i = b * grain; i != end; ++i) {
+            keep[i] = !pred(first[i]);
+            count += keep[i];
+          }
+          offsets[b + 1] = count;
+        }
+      });
+      for (std::size_t b = 0; b != blocks; ++b) {
+        offsets[b + 1] += offsets[b];
+      }
+      const std::size_t kept = offsets[blocks];
+      if (kept == n) {
+        return last;
+      }
+
+      std::allocator<T> alloc;
+      T* buffer = alloc.allocate(kept);
+      parallel_for(pool, blocks, 1, [&](std::size_t b0, std::size_t b1) {
+        for (std::size_t b = b0; b != b1; ++b) {
+          const std::size_t end = std::min(n, (b + 1) * grain);
+          T* out = buffer + offsets[b];
+          for (std::size_t i = b * grain; i != end; ++i) {
+            if (keep[i]) {
+              ::new (static_cast<void*>(out++)) T(std::move(first[i]));
+            }
+          }
+        }
+      });
+      parallel_for(pool, kept, grain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i != end; ++i) {
+          first[i] = std::move(buffer[i]);
+          buffer[i].~T();
+        }
+      });
+      alloc.deallocate(buffer, kept);
+      return first + kept;
+    }
+  }
+
+  namespace parallel {
+
+    // Calls f on every element.
+    template <typename It, typename F>
+    void for_each(thread_pool& pool, It first, It last, F f,
+        std::size_t grain = 0)
+    {
+      const auto n = static_cast<std::size_t>(last - first);
+      detail::parallel_for(pool, n, detail::parallel_grain(pool, n, grain),
+          [first, &f](std::size_t begin, std::size_t end) {
+            std::for_each(first + begin, first + end, f);
+          });
+    }
+
+    template <typename It, typename F>
+    void for_each(It first, It last, F f, std::size_t grain = 0)
+    {
+      parallel::for_each(default_pool(), first, last, f, grain);
+    }
+
+    // Writes op(x) for every element x to the range at d_first, which may be
+    // first itself, and returns the end of the written range.
+    template <typename InputIt, typename OutputIt, typename UnaryOp>
+    OutputIt transform(thread_pool& pool, InputIt first, InputIt last,
+        OutputIt d_first, UnaryOp op, std::size_t grain = 0)
+    {
+      const auto n = static_cast<std::size_t>(last - first);
+      detail::parallel_for(pool, n, detail::parallel_grain(pool, n, grain),
+          [first, d_first, &op](std::size_t begin, std::size_t end) {
+            std::transform(first + begin, first + end, d_first + begin, op);
+          });
+      return d_first + n;
+    }
+
+    template <typename InputIt, typename OutputIt, typename UnaryOp>
+    OutputIt transform(InputIt first, InputIt last, OutputIt d_first,
+        UnaryOp op, std::size_t grain = 0)
+    {
+      return parallel::transform(default_pool(), first, last, d_first, op,
+          grain);
+    }
+
+    // Folds the elements and init with op, which must be associative. Unlike
+    // std::reduce, the elements are combined in their order, so op need not
+    // be commutative.
+    template <typename It, typename T, typename BinaryOp = std::plus<>>
+    T reduce(thread_pool& pool, It first, It last, T init,
+        BinaryOp op = BinaryOp(), std::size_t grain = 0)
+    {
+      const auto n = static_cast<std::size_t>(last - first);
+      if (n == 0) {
+        return init;
+      }
+      grain = detail::parallel_grain(pool, n, grain);
+      T result = init;
+      auto root = [&] {
+        result = op(std::move(result),
+            detail::parallel_reduce<It, T>(pool, first, n, grain, op));
+      };
+      detail::run_on(pool, root);
+      return result;
+    }
+
+    template <typename It, typename T, typename BinaryOp = std::plus<>>
+    T reduce(It first, It last, T init, BinaryOp op = BinaryOp(),
+        std::size_t grain = 0)
+    {
+      return parallel::reduce(default_pool(), first, last, std::move(init), op,
+          grain);
+    }
+
+    // Writes the running fold of the elements with op, which must be
+    // associative, to the range at d_first, which may be first itself. Each
+    // block is reduced, the block totals are scanned, and each block is then
+    // scanned again starting from the total of the blocks before it.
+    template <typename InputIt, typename OutputIt,
+        typename BinaryOp = std::plus<>>
+    OutputIt inclusive_scan(thread_pool& pool, InputIt first, InputIt last,
+        OutputIt d_first, BinaryOp op = BinaryOp(), std::size_t grain = 0)
+    {
+      using T = typename std::iterator_traits<InputIt>::value_type;
+      const auto n = static_cast<std::size_t>(last - first);
+      if (n == 0) {
+        return d_first;
+      }
+      grain = detail::parallel_grain(pool, n, grain);
+      const std::size_t blocks = (n + grain - 1) / grain;
+      ftl::vector<T> totals(blocks, *first);
+      detail::parallel_for(pool, blocks - 1, 1,
+          [&](std::size_t b0, std::size_t b1) {
+            for (std::size_t b = b0; b != b1; ++b) {
+              const std::size_t end = std::min(n, (b + 1) * grain);
+              totals[b] = std::accumulate(first + (b * grain + 1),
+                  first + end, T(first[b * grain]), op);
+            }
+          });
+      for (std::size_t b = 1; b < blocks - 1; ++b) {
+        totals[b] = op(totals[b - 1], totals[b]);
+      }
+      detail::parallel_for(pool, blocks, 1,
+          [&](std::size_t b0, std::size_t b1) {
+            for (std::size_t b = b0; b != b1; ++b) {
+              const std::size_t begin = b * grain;
+              const std::size_t end = std::min(n, begin + grain);
+              T sum = b == 0 ? T(first[begin])
+                             : op(totals[b - 1], first[begin]);
+              d_first[begin] = sum;
+              for (std::size_t i = begin + 1; i != end; ++i) {
+                sum = op(std::move(sum), first[i]);
+                d_first[i] = sum;
+              }
+            }
+          });
+      return d_first + n;
+    }
+
+    template <typename InputIt, typename OutputIt,
+        typename BinaryOp = std::plus<>>
+    OutputIt inclusive_scan(InputIt first, InputIt last, OutputIt d_first,
+        BinaryOp op = BinaryOp(), std::size_t grain = 0)
+    {
+      return parallel::inclusive_scan(default_pool(), first, last, d_first, op,
+          grain);
+    }
+
+    // A merge sort: halves are sorted in parallel down to grain elements,
+    // then merged by splitting each merge around the median of the longer
+    // run. It uses a buffer as large as the range. Chunks are sorted with
+    // std::sort, so the sort is not stable.
+    template <typename It, typename Compare = std::less<>>
+    void sort(thread_pool& pool, It first, It last, Compare comp = Compare(),
+        std::size_t grain = 0)
+    {
+      using T = typename std::iterator_traits<It>::value_type;
+      const auto n = static_cast<std::size_t>(last - first);
+      grain = detail::parallel_grain(pool, n, grain);
+      if (n <= grain) {
+        std::sort(first, last, comp);
+        return;
+      }
+      ftl::vector<T> buffer(std::make_move_iterator(first),
+          std::make_move_iterator(last));
+      auto root = [&] {
+        detail::parallel_sort(pool, buffer.begin(), first, n, false, comp,
+            grain);
+      };
+      detail::run_on(pool, root);
+    }
+
+    template <typename It, typename Compare = std::less<>>
+    void sort(It first, It last, Compare comp = Compare(),
+        std::size_t grain = 0)
+    {
+      parallel::sort(default_pool(), first, last, comp, grain);
+    }
+
+    // Moves the elements for which pred is false to the front, keeping
+    // their order, and returns the end of them. Elements whose move may
+    // throw are handled by std::remove_if on the calling thread.
+    template <typename It, typename Predicate>
+    It remove_if(thread_pool& pool, It first, It last, Predicate pred,
+        std::size_t grain = 0)
+    {
+      using T = typename std::iterator_traits<It>::value_type;
+      const auto n = static_cast<std::size_t>(last - first);
+      return detail::parallel_remove_if(pool, first, last, pred,
+          detail::parallel_grain(pool, n, grain),
+          std::integral_constant<bool,
+              std::is_nothrow_move_constructible<T>::value &&
+                  std::is_nothrow_move_assignable<T>::value>());
+    }
+
+    template <typename It, typename Predicate>
+    It remove_if(It first, It last, Predicate pred, std::size_t grain = 0)
+    {
+      return parallel::remove_if(default_pool(), first, last, pred, grain);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,487 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_CONCURRENCY_SPSC_RING_HPP
+#define FTL_CONCURRENCY_SPSC_RING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "../internal/exception_guard.hpp"
+
+#if defined(__linux__)
+#  include <linux/futex.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#  include <emmintrin.h>
+#endif
+
+namespace ftl {
+  namespace detail {
+
+    inline void cpu_relax() noexcept
+    {
+#if defined(__SSE2__) || defined(_M_X64)
+      _mm_pause();
+#elif defined(__aarch64__)
+      __asm__ __volatile__("yield");
+#endif
+    }
+  }
+
+  // Wait strategies for the blocking operations of spsc_ring. wait(word,
+  // old) returns once word may no longer hold old; notify(word) is called
+  // after word changed if the other side announced that it is waiting,
+  // which only strategies with blocking set to true_type do.
+
+  // Busy-waits with a pause instruction: the lowest latency, at the cost
+  // of a core per waiting side.
+  struct spin_wait
+  {
+    using blocking = std::false_type;
+
+    static void wait(const std::atomic<std::uint32_t>& word,
+        std::uint32_t old) noexcept
+    {
+      while (word.load(std::memory_order_acquire) == old) {
+        detail::cpu_relax();
+      }
+    }
+
+    static void notify(std::atomic<std::uint32_t>&) noexcept {}
+  };
+
+  // Gives up the time slice between checks.
+  struct yield_wait
+  {
+    using blocking = std::false_type;
+
+    static void wait(const std::atomic<std::uint32_t>& word,
+        std::uint32_t old) noexcept
+    {
+      while (word.load(std::memory_order_acquire) == old) {
+        std::this_thread::yield();
+      }
+    }
+
+    static void notify(std::atomic<std::uint32_t>&) noexcept {}
+  };
+
+  // Spins briefly, then sleeps in the kernel on the index it waits for
+  // until the other side wakes it. The other side then pays a fence per
+  // operation and a system call per wake-up. Falls back to yielding where
+  // there is no futex.
+  struct futex_wait
+  {
+    using blocking = std::true_type;
+
+    static void wait(const std::atomic<std::uint32_t>& word,
+        std::uint32_t old) noexcept
+    {
+      for (int spins = 0; spins != 128; ++spins) {
+        if (word.load(std::memory_order_acquire) != old) {
+          return;
+        }
+        detail::cpu_relax();
+      }
+      while (word.load(std::memory_order_acquire) == old) {
+#if defined(__linux__)
+        ::syscall(SYS_futex, address(word), FUTEX_WAIT_PRIVATE, old, nullptr,
+            nullptr, 0);
+#else
+        std::this_thread::yield();
+#endif
+      }
+    }
+
+    static void notify(std::atomic<std::uint32_t>& word) noexcept
+    {
+#if defined(__linux__)
+      ::syscall(SYS_futex, address(word), FUTEX_WAKE_PRIVATE, 1, nullptr,
+          nullptr, 0);
+#else
+      static_cast<void>(word);
+#endif
+    }
+
+  private:
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+        "futex_wait needs a lock-free 32-bit atomic");
+
+    static std::uint32_t* address(
+        const std::atomic<std::uint32_t>& word) noexcept
+    {
+      return reinterpret_cast<std::uint32_t*>(
+          const_cast<std::atomic<std::uint32_t>*>(&word));
+    }
+  };
+
+  // A bounded queue between one producer thread and one consumer thread,
+  // in a ring of a power-of-two capacity. Each side owns one index and
+  // keeps a cached copy of the other's, so it only reads the other side's
+  // cache line when the cached value says the ring is full or empty. The
+  // indices sit on separate cache lines.
+  //
+  // try_push_n and try_pop_n move up to n elements in at most two
+  // contiguous runs and publish them with a single index update; for
+  // trivially copyable elements and pointer iterators each run is one
+  // memmove. The blocking push and pop wait with Wait: spin_wait,
+  // yield_wait or futex_wait.
+  //
+  // Push operations may only be called from the producer thread and pop
+  // operations from the consumer thread; size() and empty() are exact on
+  // neither side while the other is running.
+  template <typename T, typename Wait = spin_wait>
+  class spsc_ring final
+  {
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using wait_policy = Wait;
+
+    // Rounds capacity up to a power of two, of at most 2^31.
+    explicit spsc_ring(size_type capacity);
+    spsc_ring(const spsc_ring&) = delete;
+    spsc_ring& operator=(const spsc_ring&) = delete;
+    ~spsc_ring();
+
+    // Producer only. Return false if the ring is full.
+    bool try_push(const value_type& value) { return try_emplace(value); }
+    bool try_push(value_type&& value) { return try_emplace(std::move(value)); }
+    template <typename... Args>
+    bool try_emplace(Args&&...);
+
+    // Producer only. Copies up to n elements from first, as many as there
+    // is room for, and returns how many. If a copy throws, none is pushed.
+    template <typename ForwardIt>
+    size_type try_push_n(ForwardIt first, size_type n);
+
+    // Producer only. Wait for room.
+    void push(const value_type& value) { emplace(value); }
+    void push(value_type&& value) { emplace(std::move(value)); }
+    template <typename... Args>
+    void emplace(Args&&...);
+    template <typename ForwardIt>
+    void push_n(ForwardIt first, size_type n);
+
+    // Consumer only. Returns false if the ring is empty.
+    bool try_pop(value_type&);
+
+    // Consumer only. Moves up to n elements to out, as many as there are,
+    // and returns how many. If a move throws, none is popped.
+    template <typename OutputIt>
+    size_type try_pop_n(OutputIt out, size_type n);
+
+    // Consumer only. Wait for elements.
+    value_type pop();
+    template <typename OutputIt>
+    void pop_n(OutputIt out, size_type n);
+
+    size_type size() const noexcept;
+    bool empty() const noexcept { return size() == 0; }
+    size_type capacity() const noexcept { return mask_ + size_type(1); }
+    static constexpr size_type max_size() noexcept
+    {
+      return size_type(1) << 31;
+    }
+
+  private:
+    using index_type = std::uint32_t;
+
+    // Read-only after construction but for the waiting flags, which change
+    // only around sleeps. The padding keeps each side's index and its cache
+    // of the other's on a line of their own; it is padding rather than
+    // alignas so that rings may be allocated with new before C++17.
+    T* slots_;
+    index_type mask_;
+    std::atomic<index_type> producer_waiting_{ 0 };
+    std::atomic<index_type> consumer_waiting_{ 0 };
+    unsigned char padding0_[64];
+    std::atomic<index_type> tail_{ 0 };
+    index_type head_cache_ = 0;
+    unsigned char padding1_[64];
+    std::atomic<index_type> head_{ 0 };
+    index_type tail_cache_ = 0;
+    unsigned char padding2_[64];
+
+    size_type free_slots(index_type tail, size_type wanted) noexcept;
+    size_type used_slots(index_type head, size_type wanted) noexcept;
+    void publish(std::atomic<index_type>&, index_type,
+        const std::atomic<index_type>&);
+    void publish(std::atomic<index_type>&, index_type,
+        const std::atomic<index_type>&, std::true_type);
+    void publish(std::atomic<index_type>&, index_type,
+        const std::atomic<index_type>&, std::false_type);
+    void wait_for(const std::atomic<index_type>&, index_type,
+        std::atomic<index_type>&);
+    void wait_for(const std::atomic<index_type>&, index_type,
+        std::atomic<index_type>&, std::true_type);
+    void wait_for(const std::atomic<index_type>&, index_type,
+        std::atomic<index_type>&, std::false_type);
+  };
+
+  template <typename T, typename Wait>
+  spsc_ring<T, Wait>::spsc_ring(size_type capacity)
+  {
+    if (capacity > max_size()) {
+      throw std::length_error("ftl::spsc_ring length_error");
+    }
+    size_type rounded = 1;
+    while (rounded < capacity) {
+      rounded <<= 1;
+    }
+    slots_ = std::allocator<T>().allocate(rounded);
+    mask_ = static_cast<index_type>(rounded - 1);
+  }
+
+  template <typename T, typename Wait>
+  spsc_ring<T, Wait>::~spsc_ring()
+  {
+    const index_type tail = tail_.load(std::memory_order_relaxed);
+    for (index_type i = head_.load(std::memory_order_relaxed); i != tail;
+         ++i) {
+      slots_[i & mask_].~T();
+    }
+    std::allocator<T>().deallocate(slots_, capacity());
+  }
+
+  template <typename T, typename Wait>
+  template <typename... Args>
+  bool spsc_ring<T, Wait>::try_emplace(Args&&... args)
+  {
+    const index_type tail = tail_.load(std::memory_order_relaxed);
+    if (free_slots(tail, 1) == 0) {
+      return false;
+    }
+    ::new (static_cast<void*>(slots_ + (tail & mask_)))
+        T(std::forward<Args>(args)...);
+    publish(tail_, tail + 1, consumer_waiting_);
+    return true;
+  }
+
+  template <typename T, typename Wait>
+  template <typename ForwardIt>
+  typename spsc_ring<T, Wait>::size_type spsc_ring<T, Wait>::try_push_n(
+      ForwardIt first, size_type n)
+  {
+    const index_type tail = tail_.load(std::memory_order_relaxed);
+    const size_type count = free_slots(tail, n);
+    if (count == 0) {
+      return 0;
+    }
+    const size_type offset = tail & mask_;
+    const size_type head_run = std::min(count, capacity() - offset);
+    T* const run = slots_ + offset;
+    std::uninitialized_copy_n(first, head_run, run);
+    if (head_run != count) {
+      auto rollback = [run, head_run]() {
+        std::for_each(run, run + head_run, [](T& slot) { slot.~T(); });
+      };
+      detail::exception_guard<decltype(rollback)> guard(rollback);
+      std::advance(first, head_run);
+      std::uninitialized_copy_n(first, count - head_run, slots_);
+      guard.complete();
+    }
+    publish(tail_, static_cast<index_type>(tail + count), consumer_waiting_);
+    return count;
+  }
+
+  template <typename T, typename Wait>
+  template <typename... Args>
+  void spsc_ring<T, Wait>::emplace(Args&&... args)
+  {
+    const index_type tail = tail_.load(std::memory_order_relaxed);
+    while (free_slots(tail, 1) == 0) {
+      wait_for(head_, head_cache_, producer_waiting_);
+    }
+    ::new (static_cast<void*>(slots_ + (tail & mask_)))
+        T(std::forward<Args>(args)...);
+    publish(tail_, tail + 1, consumer_waiting_);
+  }
+
+  template <typename T, typename Wait>
+  template <typename ForwardIt>
+  void spsc_ring<T, Wait>::push_n(ForwardIt first, size_type n)
+  {
+    while (n != 0) {
+      const size_type pushed = try_push_n(first, n);
+      if (pushed == 0) {
+        wait_for(head_, head_cache_, producer_waiting_);
+        continue;
+      }
+      std::advance(first, pushed);
+      n -= pushed;
+    }
+  }
+
+  template <typename T, typename Wait>
+  bool spsc_ring<T, Wait>::try_pop(value_type& value)
+  {
+    const index_type head = head_.load(std::memory_order_relaxed);
+    if (used_slots(head, 1) == 0) {
+      return false;
+    }
+    T& slot = slots_[head & mask_];
+    value = std::move(slot);
+    slot.~T();
+    publish(head_, head + 1, producer_waiting_);
+    return true;
+  }
+
+  template <typename T, typename Wait>
+  template <typename OutputIt>
+  typename spsc_ring<T, Wait>::size_type spsc_ring<T, Wait>::try_pop_n(
+      OutputIt out, size_type n)
+  {
+    const index_type head = head_.load(std::memory_order_relaxed);
+    const size_type count = used_slots(head, n);
+    if (count == 0) {
+      return 0;
+    }
+    const size_type offset = head & mask_;
+    const size_type head_run = std::min(count, capacity() - offset);
+    out = std::move(slots_ + offset, slots_ + offset + head_run, out);
+    std::move(slots_, slots_ + (count - head_run), out);
+    std::for_each(slots_ + offset, slots_ + offset + head_run,
+        [](T& slot) { slot.~T(); });
+    std::for_each(slots_, slots_ + (count - head_run),
+        [](T& slot) { slot.~T(); });
+    publish(head_, static_cast<index_type>(head + count), producer_waiting_);
+    return count;
+  }
+
+  template <typename T, typename Wait>
+  typename spsc_ring<T, Wait>::value_type spsc_ring<T, Wait>::pop()
+  {
+    const index_type head = head_.load(std::memory_order_relaxed);
+    while (used_slots(head, 1) == 0) {
+      wait_for(tail_, tail_cache_, consumer_waiting_);
+    }
+    T& slot = slots_[head & mask_];
+    value_type value(std::move(slot));
+    slot.~T();
+    publish(head_, head + 1, producer_waiting_);
+    return value;
+  }
+
+  template <typename T, typename Wait>
+  template <typename OutputIt>
+  void spsc_ring<T, Wait>::pop_n(OutputIt out, size_type n)
+  {
+    while (n != 0) {
+      const size_type popped = try_pop_n(out, n);
+      if (popped == 0) {
+        wait_for(tail_, tail_cache_, consumer_waiting_);
+        continue;
+      }
+      std::advance(out, popped);
+      n -= popped;
+    }
+  }
+
+  template <typename T, typename Wait>
+  typename spsc_ring<T, Wait>::size_type
+  spsc_ring<T, Wait>::size() const noexcept
+  {
+    const index_type head = head_.load(std::memory_order_acquire);
+    return static_cast<index_type>(
+        tail_.load(std::memory_order_acquire) - head);
+  }
+
+  // The number of free slots, up to wanted. head_ is only read when the
+  // cached copy shows fewer.
+  template <typename T, typename Wait>
+  typename spsc_ring<T, Wait>::size_type spsc_ring<T, Wait>::free_slots(
+      index_type tail, size_type wanted) noexcept
+  {
+    size_type free =
+        capacity() - static_cast<index_type>(tail - head_cache_);
+    if (free < wanted) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      free = capacity() - static_cast<index_type>(tail - head_cache_);
+    }
+    return std::min(free, wanted);
+  }
+
+  template <typename T, typename Wait>
+  typename spsc_ring<T, Wait>::size_type spsc_ring<T, Wait>::used_slots(
+      index_type head, size_type wanted) noexcept
+  {
+    size_type used = static_cast<index_type>(tail_cache_ - head);
+    if (used < wanted) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      used = static_cast<index_type>(tail_cache_ - head);
+    }
+    return std::min(used, wanted);
+  }
+
+  template <typename T, typename Wait>
+  void spsc_ring<T, Wait>::publish(std::atomic<index_type>& index,
+      index_type value, const std::atomic<index_type>& waiting)
+  {
+    publish(index, value, waiting, typename Wait::blocking());
+  }
+
+  // A side about to sleep raises its waiting flag and then reads the index
+  // once more; the publisher stores the index and then reads the flag. The
+  // fences on both sides ensure that one of them sees the other, so a
+  // sleeper is never left waiting for an index that already moved.
+  template <typename T, typename Wait>
+  void spsc_ring<T, Wait>::publish(std::atomic<index_type>& index,
+      index_type value, const std::atomic<index_type>& waiting,
+      std::true_type)
+  {
+    index.store(value, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting.load(std::memory_order_relaxed) != 0) {
+      Wait::notify(index);
+    }
+  }
+
+  template <typename T, typename Wait>
+  void spsc_ring<T, Wait>::publish(std::atomic<index_type>& index,
+      index_type value, const std::atomic<index_type>&, std::false_type)
+  {
+    index.store(value, std::memory_order_release);
+  }
+
+  template <typename T, typename Wait>
+  void spsc_ring<T, Wait>::wait_for(const std::atomic<index_type>& index,
+      index_type old, std::atomic<index_type>& waiting)
+  {
+    wait_for(index, old, waiting, typename Wait::blocking());
+  }
+
+  template <typename T, typename Wait>
+  void spsc_ring<T, Wait>::wait_for(const std::atomic<index_type>& index,
+      index_type old, std::atomic<index_type>& waiting, std::true_type)
+  {
+    waiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (index.load(std::memory_order_relaxed) == old) {
+      Wait::wait(index, old);
+    }
+    waiting.store(0, std::memory_order_relaxed);
+  }
+
+  template <typename T, typename Wait>
+  void spsc_ring<T, Wait>::wait_for(const std::atomic<index_type>& index,
+      index_type old, std::atomic<index_type>&, std::false_type)
+  {
+    Wait::wait(index, old);
+  }
+}
+
+#endif
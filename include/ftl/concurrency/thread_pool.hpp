@@ -0,0 +1,543 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_CONCURRENCY_THREAD_POOL_HPP
+#define FTL_CONCURRENCY_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "../internal/work_deque.hpp"
+
+namespace ftl {
+  class thread_pool;
+
+  namespace detail {
+
+    // A submitted task and the shared state of its handle, in one block.
+    // The pool and the handle each hold a reference.
+    class pool_task
+    {
+    public:
+      pool_task(const pool_task&) = delete;
+      pool_task& operator=(const pool_task&) = delete;
+
+      virtual void run() noexcept = 0;
+
+      bool ready() const noexcept
+      {
+        return done_.load(std::memory_order_acquire);
+      }
+
+      // Blocks the calling thread until the task has run.
+      void block() const
+      {
+        blocked_.store(true, std::memory_order_seq_cst);
+        if (done_.load(std::memory_order_seq_cst)) {
+          return;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!done_.load(std::memory_order_acquire)) {
+          cv_.wait(lock);
+        }
+      }
+
+      void release() noexcept
+      {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          delete this;
+        }
+      }
+
+    protected:
+      pool_task() = default;
+      virtual ~pool_task() = default;
+
+      void finish() noexcept
+      {
+        done_.store(true, std::memory_order_seq_cst);
+        if (blocked_.load(std::memory_order_seq_cst)) {
+          std::lock_guard<std::mutex> lock(mutex_);
+          cv_.notify_all();
+        }
+      }
+
+    private:
+      std::atomic<int> refs_{ 2 };
+      std::atomic<bool> done_{ false };
+      mutable std::atomic<bool> blocked_{ false };
+      mutable std::mutex mutex_;
+      mutable std::condition_variable cv_;
+    };
+
+    template <typename R>
+    class task_state : public pool_task
+    {
+    public:
+      R take()
+      {
+        rethrow();
+        return std::move(*reinterpret_cast<R*>(value_));
+      }
+
+    protected:
+      ~task_state() override
+      {
+        if (has_value_) {
+          reinterpret_cast<R*>(value_)->~R();
+        }
+      }
+
+      template <typename F>
+      void invoke(F& f)
+      {
+        ::new (static_cast<void*>(value_)) R(f());
+        has_value_ = true;
+      }
+
+      void rethrow() const
+      {
+        if (error_) {
+          std::rethrow_exception(error_);
+        }
+      }
+
+      std::exception_ptr error_;
+
+    private:
+      alignas(R) unsigned char value_[sizeof(R)];
+      bool has_value_ = false;
+    };
+
+    template <>
+    class task_state<void> : public pool_task
+    {
+    public:
+      void take() { rethrow(); }
+
+    protected:
+      template <typename F>
+      void invoke(F& f)
+      {
+        f();
+      }
+
+      void rethrow() const
+      {
+        if (error_) {
+          std::rethrow_exception(error_);
+        }
+      }
+
+      std::exception_ptr error_;
+    };
+
+    template <typename F, typename R>
+    class task_node final : public task_state<R>
+    {
+    public:
+      template <typename G>
+      explicit task_node(G&& f) : f_(std::forward<G>(f))
+      {
+      }
+
+      void run() noexcept override
+      {
+        try {
+          this->invoke(f_);
+        } catch (...) {
+          this->error_ = std::current_exception();
+        }
+        this->finish();
+      }
+
+    private:
+      F f_;
+    };
+
+    template <typename F>
+    using task_result_t =
+        typename std::decay<decltype(std::declval<F&>()())>::type;
+
+    struct pool_worker
+    {
+      thread_pool* pool = nullptr;
+      std::size_t index = 0;
+      std::uint64_t rng = 0;
+      work_deque<pool_task> deque;
+      std::thread thread;
+    };
+
+    // The worker running on the calling thread, or null off the pools.
+    inline pool_worker*& current_pool_worker() noexcept
+    {
+      static thread_local pool_worker* worker = nullptr;
+      return worker;
+    }
+  }
+
+  // The result of a task submitted to a thread_pool. get() waits for the
+  // task and returns its result or rethrows its exception; it may be called
+  // once. Waiting on a pool thread runs other queued tasks meanwhile, so
+  // tasks may wait on the tasks they spawn without starving the pool.
+  template <typename R>
+  class task_handle final
+  {
+  public:
+    task_handle() noexcept = default;
+
+    task_handle(task_handle&& other) noexcept :
+      state_(std::exchange(other.state_, nullptr))
+    {
+    }
+
+    task_handle& operator=(task_handle&& other) noexcept
+    {
+      task_handle(std::move(other)).swap(*this);
+      return *this;
+    }
+
+    ~task_handle()
+    {
+      if (state_ != nullptr) {
+        state_->release();
+      }
+    }
+
+    void swap(task_handle& other) noexcept { std::swap(state_, other.state_); }
+
+    bool valid() const noexcept { return state_ != nullptr; }
+    bool ready() const noexcept { return state_->ready(); }
+    void wait() const;
+
+    R get()
+    {
+      wait();
+      task_handle owner(std::move(*this));
+      return owner.state_->take();
+    }
+
+  private:
+    friend class thread_pool;
+
+    detail::task_state<R>* state_ = nullptr;
+
+    explicit task_handle(detail::task_state<R>* state) noexcept :
+      state_(state)
+    {
+    }
+  };
+
+  // A fixed set of worker threads sharing tasks by work stealing. Every
+  // worker owns a Chase-Lev deque: tasks submitted from a worker go to the
+  // bottom of its own deque, where it takes them back newest first, while
+  // idle workers steal the oldest tasks from the top of a random victim's.
+  // Tasks submitted from other threads go through a shared queue. Workers
+  // that find nothing to do sleep until the next submission.
+  class thread_pool final
+  {
+  public:
+    // Starts one worker per hardware thread.
+    thread_pool() : thread_pool(std::thread::hardware_concurrency()) {}
+
+    // Starts the given number of workers, or one if it is zero.
+    explicit thread_pool(std::size_t workers);
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    // Runs every submitted task, then stops the workers.
+    ~thread_pool();
+
+    std::size_t size() const noexcept { return size_; }
+
+    // Whether the calling thread is one of this pool's workers.
+    bool is_worker() const noexcept
+    {
+      const detail::pool_worker* worker = detail::current_pool_worker();
+      return worker != nullptr && worker->pool == this;
+    }
+
+    // Queues f(), which takes no arguments, and returns a handle to its
+    // result. The result is stored by value.
+    template <typename F>
+    task_handle<detail::task_result_t<F>> submit(F&& f);
+
+    // Blocks until every task submitted so far, and every task those
+    // spawned, has finished. Must not be called from a task of this pool.
+    void wait_idle();
+
+    // Runs one queued task on the calling thread. Returns false if none was
+    // found.
+    bool run_pending_task();
+
+  private:
+    static constexpr int spin_rounds = 64;
+
+    std::unique_ptr<detail::pool_worker[]> workers_;
+    std::size_t size_;
+
+    std::mutex inject_mutex_;
+    std::deque<detail::pool_task*> injected_;
+    std::atomic<std::size_t> injected_size_{ 0 };
+
+    std::atomic<std::size_t> active_{ 0 };
+    std::atomic<std::size_t> sleepers_{ 0 };
+    std::atomic<std::uint64_t> epoch_{ 0 };
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    bool stopping_ = false;
+
+    std::atomic<std::size_t> idle_waiters_{ 0 };
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+
+    void enqueue(detail::pool_task* task);
+    void wake_one();
+    detail::pool_task* find_task(detail::pool_worker* self);
+    detail::pool_task* steal(detail::pool_worker* self);
+    detail::pool_task* take_injected();
+    void execute(detail::pool_task* task) noexcept;
+    void work(detail::pool_worker& self);
+  };
+
+  template <typename R>
+  void task_handle<R>::wait() const
+  {
+    if (state_->ready()) {
+      return;
+    }
+    detail::pool_worker* worker = detail::current_pool_worker();
+    if (worker == nullptr) {
+      state_->block();
+      return;
+    }
+    while (!state_->ready()) {
+      if (!worker->pool->run_pending_task()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  inline thread_pool::thread_pool(std::size_t workers) :
+    workers_(new detail::pool_worker[workers == 0 ? 1 : workers]),
+    size_(workers == 0 ? 1 : workers)
+  {
+    for (std::size_t i = 0; i != size_; ++i) {
+      workers_[i].pool = this;
+      workers_[i].index = i;
+      workers_[i].rng = 0x9e3779b97f4a7c15ULL * (i + 1);
+    }
+    std::size_t started = 0;
+    try {
+      for (; started != size_; ++started) {
+        detail::pool_worker& worker = workers_[started];
+        worker.thread = std::thread([this, &worker] { work(worker); });
+      }
+    } catch (...) {
+      {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_ = true;
+      }
+      sleep_cv_.notify_all();
+      for (std::size_t i = 0; i != started; ++i) {
+        workers_[i].thread.join();
+      }
+      throw;
+    }
+  }
+
+  inline thread_pool::~thread_pool()
+  {
+    wait_idle();
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      stopping_ = true;
+    }
+    sleep_cv_.notify_all();
+    for (std::size_t i = 0; i != size_; ++i) {
+      workers_[i].thread.join();
+    }
+  }
+
+  template <typename F>
+  task_handle<detail::task_result_t<F>> thread_pool::submit(F&& f)
+  {
+    using R = detail::task_result_t<F>;
+    auto task = new detail::task_node<typename std::decay<F>::type, R>(
+        std::forward<F>(f));
+    task_handle<R> handle(task);
+    enqueue(task);
+    return handle;
+  }
+
+  inline void thread_pool::wait_idle()
+  {
+    idle_waiters_.fetch_add(1, std::memory_order_seq_cst);
+    {
+      std::unique_lock<std::mutex> lock(idle_mutex_);
+      while (active_.load(std::memory_order_seq_cst) != 0) {
+        idle_cv_.wait(lock);
+      }
+    }
+    idle_waiters_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  inline bool thread_pool::run_pending_task()
+  {
+    detail::pool_task* task =
+        find_task(is_worker() ? detail::current_pool_worker() : nullptr);
+    if (task == nullptr) {
+      return false;
+    }
+    execute(task);
+    return true;
+  }
+
+  inline void thread_pool::enqueue(detail::pool_task* task)
+  {
+    active_.fetch_add(1, std::memory_order_relaxed);
+    try {
+      if (is_worker()) {
+        detail::current_pool_worker()->deque.push(task);
+      } else {
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        injected_.push_back(task);
+        injected_size_.fetch_add(1, std::memory_order_relaxed);
+      }
+    } catch (...) {
+      active_.fetch_sub(1, std::memory_order_relaxed);
+      task->release();
+      throw;
+    }
+    wake_one();
+  }
+
+  // A worker about to sleep announces itself in sleepers_ and then looks for
+  // work once more; a submitter publishes its task and then reads
+  // sleepers_. The fences on both sides ensure that one of them sees the
+  // other, so a task is never left queued with every worker asleep.
+  inline void thread_pool::wake_one()
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) == 0) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      epoch_.fetch_add(1, std::memory_order_release);
+    }
+    sleep_cv_.notify_one();
+  }
+
+  inline detail::pool_task* thread_pool::find_task(detail::pool_worker* self)
+  {
+    detail::pool_task* task = nullptr;
+    if (self != nullptr) {
+      task = self->deque.pop();
+    }
+    if (task == nullptr) {
+      task = steal(self);
+    }
+    if (task == nullptr) {
+      task = take_injected();
+    }
+    return task;
+  }
+
+  // Visits every other worker once, starting from a random one.
+  inline detail::pool_task* thread_pool::steal(detail::pool_worker* self)
+  {
+    std::size_t start = 0;
+    if (self != nullptr) {
+      std::uint64_t& x = self->rng;
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+      start = static_cast<std::size_t>(x % size_);
+    }
+    for (std::size_t i = 0; i != size_; ++i) {
+      detail::pool_worker& victim = workers_[(start + i) % size_];
+      if (&victim == self) {
+        continue;
+      }
+      if (detail::pool_task* task = victim.deque.steal()) {
+        return task;
+      }
+    }
+    return nullptr;
+  }
+
+  inline detail::pool_task* thread_pool::take_injected()
+  {
+    if (injected_size_.load(std::memory_order_relaxed) == 0) {
+      return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(inject_mutex_);
+    if (injected_.empty()) {
+      return nullptr;
+    }
+    detail::pool_task* task = injected_.front();
+    injected_.pop_front();
+    injected_size_.fetch_sub(1, std::memory_order_relaxed);
+    return task;
+  }
+
+  inline void thread_pool::execute(detail::pool_task* task) noexcept
+  {
+    task->run();
+    task->release();
+    if (active_.fetch_sub(1, std::memory_order_seq_cst) == 1 &&
+        idle_waiters_.load(std::memory_order_seq_cst) != 0) {
+      std::lock_guard<std::mutex> lock(idle_mutex_);
+      idle_cv_.notify_all();
+    }
+  }
+
+  inline void thread_pool::work(detail::pool_worker& self)
+  {
+    detail::current_pool_worker() = &self;
+    for (;;) {
+      detail::pool_task* task = nullptr;
+      for (int spin = 0; spin != spin_rounds && task == nullptr; ++spin) {
+        task = find_task(&self);
+        if (task == nullptr) {
+          std::this_thread::yield();
+        }
+      }
+      if (task == nullptr) {
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::uint64_t epoch = epoch_.load(std::memory_order_acquire);
+        task = find_task(&self);
+        if (task == nullptr) {
+          std::unique_lock<std::mutex> lock(sleep_mutex_);
+          while (epoch_.load(std::memory_order_relaxed) == epoch &&
+              !stopping_) {
+            sleep_cv_.wait(lock);
+          }
+          if (stopping_) {
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            return;
+          }
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+      }
+      if (task != nullptr) {
+        execute(task);
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,535 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_CONTAINERS_CONCURRENT_VECTOR_HPP
+#define FTL_CONTAINERS_CONCURRENT_VECTOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include "../internal/index_iterator.hpp"
+#include "vector.hpp"
+
+namespace ftl {
+  namespace detail {
+
+    inline std::size_t floor_log2(std::size_t x) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<std::size_t>(std::numeric_limits<std::size_t>::digits -
+          1 - __builtin_clzll(x));
+#else
+      std::size_t log = 0;
+      while (x >>= 1) {
+        ++log;
+      }
+      return log;
+#endif
+    }
+  }
+
+  // A vector that many threads may append to at once. Elements live in
+  // segments of geometrically growing size that are never moved or freed
+  // while the vector lives, so push_back and grow_by never invalidate
+  // references, and they need no lock: a slot is claimed with one atomic
+  // add and a missing segment is installed with a compare-and-swap.
+  //
+  // size() counts the published elements, the longest prefix of slots
+  // whose construction has finished; reading any of them is safe while
+  // other threads keep appending. An element is also safe to use by the
+  // thread that appended it as soon as push_back returns. If constructing
+  // an element throws, its slot stays empty: it is still counted by size()
+  // but must not be read, and compact() and the destructor skip it. If a
+  // segment cannot be allocated the append throws std::bad_alloc, the
+  // segment is marked lost and its slots become holes like failed ones;
+  // later appends skip over it, and clear() lets it be allocated again.
+  // operator[] and the iterators do not check for holes (debug builds
+  // assert instead), so after a failed append use at(), which throws
+  // std::out_of_range for a hole, or compact().
+  //
+  // clear(), compact() and destruction must not overlap with appends.
+  template <typename T>
+  class concurrent_vector final
+  {
+  public:
+    using value_type = T;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = detail::index_iterator<concurrent_vector, value_type>;
+    using const_iterator =
+        detail::index_iterator<const concurrent_vector, const value_type>;
+
+    // Segment k holds first_segment_size << k elements.
+    static constexpr size_type first_segment_size = 16;
+
+    concurrent_vector() noexcept = default;
+    concurrent_vector(const concurrent_vector&) = delete;
+    concurrent_vector& operator=(const concurrent_vector&) = delete;
+    ~concurrent_vector();
+
+    reference push_back(const_reference value) { return emplace_back(value); }
+    reference push_back(value_type&& value)
+    {
+      return emplace_back(std::move(value));
+    }
+
+    template <typename... Args>
+    reference emplace_back(Args&&...);
+
+    // Appends n value-initialized elements, or n copies of value, in
+    // consecutive slots and returns an iterator to the first.
+    iterator grow_by(size_type n);
+    iterator grow_by(size_type n, const_reference value);
+
+    // Allocates the segments for the first n elements in advance.
+    void reserve(size_type n);
+
+    reference operator[](size_type i) noexcept
+    {
+      assert(is_ready(i));
+      return *slot(i);
+    }
+
+    const_reference operator[](size_type i) const noexcept
+    {
+      assert(is_ready(i));
+      return *slot(i);
+    }
+
+    reference at(size_type);
+    const_reference at(size_type) const;
+
+    size_type size() const noexcept
+    {
+      return published_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+    size_type max_size() const noexcept;
+    size_type capacity() const noexcept;
+
+    iterator begin() noexcept { return iterator(this, 0); }
+    iterator end() noexcept { return iterator(this, size()); }
+    const_iterator begin() const noexcept { return const_iterator(this, 0); }
+    const_iterator end() const noexcept
+    {
+      return const_iterator(this, size());
+    }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    // Destroys every element but keeps the segments for reuse.
+    void clear() noexcept;
+
+    // Copies the elements, in order, into one contiguous vector.
+    ftl::vector<value_type> compact() const;
+
+  private:
+    enum slot_state : unsigned char
+    {
+      slot_empty,
+      slot_ready,
+      slot_failed
+    };
+
+    static constexpr size_type segment_count =
+        std::numeric_limits<size_type>::digits - 4;
+
+    std::atomic<T*> segments_[segment_count] = {};
+    std::atomic<size_type> claimed_{ 0 };
+    std::atomic<size_type> published_{ 0 };
+
+    static size_type segment_of(size_type i) noexcept
+    {
+      return detail::floor_log2(i / first_segment_size + 1);
+    }
+
+    static size_type segment_base(size_type k) noexcept
+    {
+      return first_segment_size * ((size_type(1) << k) - 1);
+    }
+
+    static size_type segment_size(size_type k) noexcept
+    {
+      return first_segment_size << k;
+    }
+
+    // A segment is one block: the elements, then one state byte per slot.
+    static size_type segment_units(size_type k) noexcept
+    {
+      return segment_size(k) + (segment_size(k) + sizeof(T) - 1) / sizeof(T);
+    }
+
+    static std::atomic<unsigned char>* states_of(T* segment,
+        size_type k) noexcept
+    {
+      return reinterpret_cast<std::atomic<unsigned char>*>(
+          segment + segment_size(k));
+    }
+
+    // Installed in place of a segment that could not be allocated. Every
+    // slot in it counts as failed; it is never dereferenced.
+    static T* lost_segment() noexcept
+    {
+      alignas(T) static unsigned char tag;
+      return reinterpret_cast<T*>(&tag);
+    }
+
+    T* slot(size_type i) const noexcept
+    {
+      const size_type k = segment_of(i);
+      return segments_[k].load(std::memory_order_acquire) +
+          (i - segment_base(k));
+    }
+
+    std::atomic<unsigned char>& state(size_type i) const noexcept
+    {
+      const size_type k = segment_of(i);
+      return states_of(segments_[k].load(std::memory_order_acquire),
+          k)[i - segment_base(k)];
+    }
+
+    bool is_ready(size_type i) const noexcept;
+    T* segment(size_type k);
+    size_type claim(size_type n);
+    void abandon(size_type first, size_type n) noexcept;
+    void publish() noexcept;
+
+    template <typename... Args>
+    void construct(size_type first, size_type n, const Args&... args);
+
+    void throw_out_of_range() const;
+    void throw_length_error() const;
+  };
+
+  template <typename T>
+  constexpr typename concurrent_vector<T>::size_type
+      concurrent_vector<T>::first_segment_size;
+
+  template <typename T>
+  concurrent_vector<T>::~concurrent_vector()
+  {
+    clear();
+    for (size_type k = 0; k != segment_count; ++k) {
+      T* seg = segments_[k].load(std::memory_order_relaxed);
+      if (seg != nullptr && seg != lost_segment()) {
+        std::allocator<T>().deallocate(seg, segment_units(k));
+      }
+    }
+  }
+
+  template <typename T>
+  template <typename... Args>
+  typename concurrent_vector<T>::reference
+  concurrent_vector<T>::emplace_back(Args&&... args)
+  {
+    const size_type i = claim(1);
+    T* p = slot(i);
+    try {
+      ::new (static_cast<void*>(p)) T(std::forward<Args>(args)...);
+    } catch (...) {
+      state(i).store(slot_failed, std::memory_order_seq_cst);
+      publish();
+      throw;
+    }
+    state(i).store(slot_ready, std::memory_order_seq_cst);
+    publish();
+    return *p;
+  }
+
+  template <typename T>
+  typename concurrent_vector<T>::iterator
+  concurrent_vector<T>::grow_by(size_type n)
+  {
+    const size_type first = claim(n);
+    construct(first, n);
+    return iterator(this, first);
+  }
+
+  template <typename T>
+  typename concurrent_vector<T>::iterator
+  concurrent_vector<T>::grow_by(size_type n, const_reference value)
+  {
+    const size_type first = claim(n);
+    construct(first, n, value);
+    return iterator(this, first);
+  }
+
+  template <typename T>
+  void concurrent_vector<T>::reserve(size_type n)
+  {
+    if (n > max_size()) {
+      throw_length_error();
+    }
+    for (size_type k = 0; n != 0 && k <= segment_of(n - 1); ++k) {
+      if (segment(k) == lost_segment()) {
+        throw std::bad_alloc();
+      }
+    }
+  }
+
+  template <typename T>
+  typename concurrent_vector<T>::reference concurrent_vector<T>::at(
+      size_type i)
+  {
+    if (i >= size() || !is_ready(i)) {
+      throw_out_of_range();
+    }
+    return *slot(i);
+  }
+
+  template <typename T>
+  typename concurrent_vector<T>::const_reference concurrent_vector<T>::at(
+      size_type i) const
+  {
+    if (i >= size() || !is_ready(i)) {
+      throw_out_of_range();
+    }
+    return *slot(i);
+  }
+
+  template <typename T>
+  typename concurrent_vector<T>::size_type
+  concurrent_vector<T>::max_size() const noexcept
+  {
+    return segment_base(segment_count - 1);
+  }
+
+  template <typename T>
+  typename concurrent_vector<T>::size_type
+  concurrent_vector<T>::capacity() const noexcept
+  {
+    size_type k = 0;
+    for (; k != segment_count; ++k) {
+      T* seg = segments_[k].load(std::memory_order_acquire);
+      if (seg == nullptr || seg == lost_segment()) {
+        break;
+      }
+    }
+    return segment_base(k);
+  }
+
+  template <typename T>
+  void concurrent_vector<T>::clear() noexcept
+  {
+    const size_type n = claimed_.load(std::memory_order_relaxed);
+    for (size_type k = 0; k != segment_count && segment_base(k) < n; ++k) {
+      T* seg = segments_[k].load(std::memory_order_relaxed);
+      if (seg == lost_segment()) {
+        segments_[k].store(nullptr, std::memory_order_relaxed);
+        continue;
+      }
+      if (seg == nullptr) {
+        continue;
+      }
+      std::atomic<unsigned char>* states = states_of(seg, k);
+      const size_type count = std::min(n - segment_base(k), segment_size(k));
+      for (size_type i = 0; i != count; ++i) {
+        if (states[i].load(std::memory_order_relaxed) == slot_ready) {
+          seg[i].~T();
+        }
+        states[i].store(slot_empty, std::memory_order_relaxed);
+      }
+    }
+    claimed_.store(0, std::memory_order_relaxed);
+    published_.store(0, std::memory_order_release);
+  }
+
+  template <typename T>
+  ftl::vector<T> concurrent_vector<T>::compact() const
+  {
+    const size_type n = size();
+    ftl::vector<T> result;
+    result.reserve(n);
+    for (size_type i = 0; i != n; ++i) {
+      if (is_ready(i)) {
+        result.push_back(*slot(i));
+      }
+    }
+    return result;
+  }
+
+  template <typename T>
+  bool concurrent_vector<T>::is_ready(size_type i) const noexcept
+  {
+    const size_type k = segment_of(i);
+    T* seg = segments_[k].load(std::memory_order_acquire);
+    return seg != nullptr && seg != lost_segment() &&
+        states_of(seg, k)[i - segment_base(k)].load(
+            std::memory_order_relaxed) == slot_ready;
+  }
+
+  // Returns segment k, allocating it if needed, or lost_segment() if it
+  // could not be allocated before.
+  template <typename T>
+  T* concurrent_vector<T>::segment(size_type k)
+  {
+    T* seg = segments_[k].load(std::memory_order_acquire);
+    if (seg != nullptr) {
+      return seg;
+    }
+    T* fresh = std::allocator<T>().allocate(segment_units(k));
+    std::atomic<unsigned char>* states = states_of(fresh, k);
+    for (size_type i = 0; i != segment_size(k); ++i) {
+      ::new (static_cast<void*>(states + i))
+          std::atomic<unsigned char>(slot_empty);
+    }
+    if (segments_[k].compare_exchange_strong(seg, fresh,
+            std::memory_order_acq_rel, std::memory_order_acquire)) {
+      return fresh;
+    }
+    std::allocator<T>().deallocate(fresh, segment_units(k));
+    return seg;
+  }
+
+  // Takes n consecutive slots and makes sure their segments exist. If that
+  // fails the slots are abandoned, so that publishing goes on past them. A
+  // range that runs into a lost segment is abandoned too, and the claim is
+  // retried past the end of that segment.
+  template <typename T>
+  typename concurrent_vector<T>::size_type concurrent_vector<T>::claim(
+      size_type n)
+  {
+    for (;;) {
+      if (n > max_size() - claimed_.load(std::memory_order_relaxed)) {
+        throw_length_error();
+      }
+      const size_type first =
+          claimed_.fetch_add(n, std::memory_order_relaxed);
+      if (n == 0) {
+        return first;
+      }
+      const size_type last = segment_of(first + n - 1);
+      size_type k = segment_of(first);
+      try {
+        while (k <= last && segment(k) != lost_segment()) {
+          ++k;
+        }
+      } catch (...) {
+        abandon(first, n);
+        publish();
+        throw;
+      }
+      if (k > last) {
+        return first;
+      }
+      abandon(first, n);
+      const size_type next = segment_base(k + 1);
+      size_type claimed = claimed_.load(std::memory_order_relaxed);
+      while (claimed < next &&
+          !claimed_.compare_exchange_weak(claimed, next,
+              std::memory_order_relaxed)) {
+      }
+      publish();
+    }
+  }
+
+  // Turns every slot of [first, first + n) into a hole: slots in allocated
+  // segments are marked failed, and a segment that still cannot be
+  // allocated is marked lost as a whole.
+  template <typename T>
+  void concurrent_vector<T>::abandon(size_type first, size_type n) noexcept
+  {
+    const size_type last = first + n;
+    for (size_type i = first; i != last;) {
+      const size_type k = segment_of(i);
+      const size_type segment_end = std::min(last, segment_base(k + 1));
+      T* seg = nullptr;
+      try {
+        seg = segment(k);
+      } catch (...) {
+        if (segments_[k].compare_exchange_strong(seg, lost_segment(),
+                std::memory_order_seq_cst)) {
+          seg = lost_segment();
+        }
+      }
+      if (seg != lost_segment()) {
+        for (; i != segment_end; ++i) {
+          state(i).store(slot_failed, std::memory_order_seq_cst);
+        }
+      }
+      i = segment_end;
+    }
+  }
+
+  template <typename T>
+  template <typename... Args>
+  void concurrent_vector<T>::construct(size_type first, size_type n,
+      const Args&... args)
+  {
+    size_type i = first;
+    try {
+      for (; i != first + n; ++i) {
+        ::new (static_cast<void*>(slot(i))) T(args...);
+        state(i).store(slot_ready, std::memory_order_seq_cst);
+      }
+    } catch (...) {
+      for (; i != first + n; ++i) {
+        state(i).store(slot_failed, std::memory_order_seq_cst);
+      }
+      publish();
+      throw;
+    }
+    publish();
+  }
+
+  // Moves published_ past every finished slot that follows it. A thread
+  // marks its slots before reading published_, and the sequentially
+  // consistent state accesses make sure that of two threads finishing
+  // neighbouring slots at once, at least one sees the other's slot done.
+  template <typename T>
+  void concurrent_vector<T>::publish() noexcept
+  {
+    size_type from = published_.load(std::memory_order_acquire);
+    for (;;) {
+      size_type to = from;
+      const size_type claimed = claimed_.load(std::memory_order_acquire);
+      while (to != claimed) {
+        const size_type k = segment_of(to);
+        T* seg = segments_[k].load(std::memory_order_seq_cst);
+        if (seg == lost_segment()) {
+          to = std::min(claimed, segment_base(k + 1));
+          continue;
+        }
+        if (seg == nullptr ||
+            states_of(seg, k)[to - segment_base(k)].load(
+                std::memory_order_seq_cst) == slot_empty) {
+          break;
+        }
+        ++to;
+      }
+      if (to == from) {
+        return;
+      }
+      if (published_.compare_exchange_weak(from, to,
+              std::memory_order_release, std::memory_order_acquire)) {
+        from = to;
+      }
+    }
+  }
+
+  template <typename T>
+  void concurrent_vector<T>::throw_out_of_range() const
+  {
+    throw std::out_of_range("ftl::concurrent_vector out_of_range");
+  }
+
+  template <typename T>
+  void concurrent_vector<T>::throw_length_error() const
+  {
+    throw std::length_error("ftl::concurrent_vector length_error");
+  }
+}
+
+#endif
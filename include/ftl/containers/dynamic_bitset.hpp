@@ -0,0 +1,500 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_CONTAINERS_DYNAMIC_BITSET_HPP
+#define FTL_CONTAINERS_DYNAMIC_BITSET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include "../internal/bit_ops.hpp"
+#include "../internal/compare.hpp"
+#include "../internal/config.hpp"
+#include "vector.hpp"
+
+namespace ftl {
+
+  // A resizable sequence of bits packed 64 to a word in an ftl::vector.
+  // Boolean operations between bitsets and count() work a whole word at a
+  // time, count() with AVX2 where available, and find_first(), find_next()
+  // and for_each_set() skip zero words and locate bits with tzcnt.
+  //
+  // Bits past size() in the last word are kept zero, so words can be
+  // compared and counted without masking. The binary operations require
+  // both bitsets to have the same size.
+  template <typename Allocator = std::allocator<std::uint64_t>>
+  class basic_dynamic_bitset final
+  {
+  public:
+    using block_type = std::uint64_t;
+    using size_type = std::size_t;
+    using allocator_type = Allocator;
+
+    static constexpr size_type bits_per_block = 64;
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+    // A proxy for one bit, returned by the non-const operator[].
+    class reference
+    {
+      friend class basic_dynamic_bitset;
+
+    public:
+      reference(const reference&) = default;
+
+      reference& operator=(bool value) noexcept
+      {
+        *block_ = value ? *block_ | mask_ : *block_ & ~mask_;
+        return *this;
+      }
+
+      reference& operator=(const reference& rhs) noexcept
+      {
+        return *this = static_cast<bool>(rhs);
+      }
+
+      operator bool() const noexcept { return (*block_ & mask_) != 0; }
+      bool operator~() const noexcept { return (*block_ & mask_) == 0; }
+
+      reference& flip() noexcept
+      {
+        *block_ ^= mask_;
+        return *this;
+      }
+
+    private:
+      block_type* block_;
+      block_type mask_;
+
+      reference(block_type* block, block_type mask) noexcept :
+        block_(block),
+        mask_(mask)
+      {
+      }
+    };
+
+    basic_dynamic_bitset() : basic_dynamic_bitset(allocator_type()) {}
+    explicit basic_dynamic_bitset(const allocator_type& alloc) :
+      blocks_(alloc),
+      size_(0)
+    {
+    }
+    explicit basic_dynamic_bitset(size_type, bool value = false,
+        const allocator_type& = allocator_type());
+
+    bool operator[](size_type i) const noexcept
+    {
+      return (blocks_[i / bits_per_block] >> (i % bits_per_block)) & 1;
+    }
+
+    reference operator[](size_type i) noexcept
+    {
+      return reference(&blocks_[i / bits_per_block], bit_mask(i));
+    }
+
+    bool test(size_type) const;
+
+    basic_dynamic_bitset& set() noexcept;
+    basic_dynamic_bitset& set(size_type, bool value = true);
+    basic_dynamic_bitset& reset() noexcept;
+    basic_dynamic_bitset& reset(size_type i) { return set(i, false); }
+    basic_dynamic_bitset& flip() noexcept;
+    basic_dynamic_bitset& flip(size_type);
+
+    bool all() const noexcept;
+    bool any() const noexcept;
+    bool none() const noexcept { return !any(); }
+    size_type count() const noexcept
+    {
+      return detail::popcount_words(blocks_.data(), blocks_.size());
+    }
+
+    size_type find_first() const noexcept { return find_from(0); }
+    size_type find_next(size_type i) const noexcept
+    {
+      return i + 1 >= size_ ? npos : find_from(i + 1);
+    }
+
+    // Calls f(i) for the index i of every set bit, in increasing order.
+    template <typename F>
+    void for_each_set(F f) const;
+
+    basic_dynamic_bitset& operator&=(const basic_dynamic_bitset&);
+    basic_dynamic_bitset& operator|=(const basic_dynamic_bitset&);
+    basic_dynamic_bitset& operator^=(const basic_dynamic_bitset&);
+    // Clears the bits that are set in rhs, the and-not of the two.
+    basic_dynamic_bitset& operator-=(const basic_dynamic_bitset&);
+    basic_dynamic_bitset operator~() const
+    {
+      return basic_dynamic_bitset(*this).flip();
+    }
+
+    bool empty() const noexcept { return size_ == 0; }
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept
+    {
+      return blocks_.capacity() * bits_per_block;
+    }
+    size_type max_size() const noexcept;
+    size_type num_blocks() const noexcept { return blocks_.size(); }
+    const block_type* data() const noexcept { return blocks_.data(); }
+    allocator_type get_allocator() const noexcept
+    {
+      return blocks_.get_allocator();
+    }
+
+    void resize(size_type, bool value = false);
+    void reserve(size_type bits) { blocks_.reserve(blocks_for(bits)); }
+    void shrink_to_fit() { blocks_.shrink_to_fit(); }
+    void push_back(bool);
+    void pop_back() { resize(size_ - 1); }
+    void clear() noexcept;
+    void swap(basic_dynamic_bitset&) noexcept;
+
+  private:
+    vector<block_type, allocator_type> blocks_;
+    size_type size_;
+
+    static size_type blocks_for(size_type bits) noexcept
+    {
+      return (bits + bits_per_block - 1) / bits_per_block;
+    }
+
+    static block_type bit_mask(size_type i) noexcept
+    {
+      return block_type(1) << (i % bits_per_block);
+    }
+
+    size_type find_from(size_type) const noexcept;
+    void clear_unused_bits() noexcept;
+    void check_same_size(const basic_dynamic_bitset&) const;
+    void throw_out_of_range() const;
+  };
+
+  template <typename Allocator>
+  constexpr typename basic_dynamic_bitset<Allocator>::size_type
+      basic_dynamic_bitset<Allocator>::bits_per_block;
+
+  template <typename Allocator>
+  constexpr typename basic_dynamic_bitset<Allocator>::size_type
+      basic_dynamic_bitset<Allocator>::npos;
+
+  using dynamic_bitset = basic_dynamic_bitset<>;
+
+  template <typename Allocator>
+  basic_dynamic_bitset<Allocator>::basic_dynamic_bitset(size_type size,
+      bool value, const allocator_type& alloc) :
+    blocks_(blocks_for(size), value ? ~block_type(0) : block_type(0), alloc),
+    size_(size)
+  {
+    clear_unused_bits();
+  }
+
+  template <typename Allocator>
+  bool basic_dynamic_bitset<Allocator>::test(size_type i) const
+  {
+    if (i >= size_) {
+      throw_out_of_range();
+    }
+    return (*this)[i];
+  }
+
+  template <typename Allocator>
+  basic_dynamic_bitset<Allocator>&
+  basic_dynamic_bitset<Allocator>::set() noexcept
+  {
+    for (block_type& block : blocks_) {
+      block = ~block_type(0);
+    }
+    clear_unused_bits();
+    return *this;
+  }
+
+  template <typename Allocator>
+  basic_dynamic_bitset<Allocator>& basic_dynamic_bitset<Allocator>::set(
+      size_type i, bool value)
+  {
+    if (i >= size_) {
+      throw_out_of_range();
+    }
+    (*this)[i] = value;
+    return *this;
+  }
+
+  template <typename Allocator>
+  basic_dynamic_bitset<Allocator>&
+  basic_dynamic_bitset<Allocator>::reset() noexcept
+  {
+    for (block_type& block : blocks_) {
+      block = 0;
+    }
+    return *this;
+  }
+
+  template <typename Allocator>
+  basic_dynamic_bitset<Allocator>&
+  basic_dynamic_bitset<Allocator>::flip() noexcept
+  {
+    for (block_type& block : blocks_) {
+      block = ~block;
+    }
+    clear_unused_bits();
+    return *this;
+  }
+
+  template <typename Allocator>
+  basic_dynamic_bitset<Allocator>& basic_dynamic_bitset<Allocator>::flip(
+      size_type i)
+  {
+    if (i >= size_) {
+      throw_out_of_range();
+    }
+    (*this)[i].flip();
+    return *this;
+  }
+
+  template <typename Allocator>
+  bool basic_dynamic_bitset<Allocator>::all() const noexcept
+  {
+    const size_type full = size_ / bits_per_block;
+    for (size_type i = 0; i != full; ++i) {
+      if (blocks_[i] != ~block_type(0)) {
+        return false;
+      }
+    }
+    const size_type tail = size_ % bits_per_block;
+    return tail == 0 || blocks_[full] == (block_type(1) << tail) - 1;
+  }
+
+  template <typename Allocator>
+  bool basic_dynamic_bitset<Allocator>::any() const noexcept
+  {
+    for (block_type block : blocks_) {
+      if (block != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  template <typename Allocator>
+  template <typename F>
+  void basic_dynamic_bitset<Allocator>::for_each_set(F f) const
+  {
+    const block_type* blocks = blocks_.data();
+    const size_type n = blocks_.size();
+    for (size_type b = 0; b != n; ++b) {
+      for (block_type block = blocks[b]; block != 0; block &= block - 1) {
+        f(b * bits_per_block + detail::ctz64(block));
+      }
+    }
+  }
+
+  template <typename Allocator>
+  basic_dynamic_bitset<Allocator>& basic_dynamic_bitset<Allocator>::operator&=(
+      const basic_dynamic_bitset& rhs)
+  {
+    check_same_size(rhs);
+    block_type* l = blocks_.data();
+    const block_type* r = rhs.blocks_.data();
+    for (size_type i = 0, n = blocks_.size(); i != n; ++i) {
+      l[i] &= r[i];
+    }
+    return *this;
+  }
+
+  template <typename Allocator>
+  basic_dynamic_bitset<Allocator>& basic_dynamic_bitset<Allocator>::operator|=(
+      const basic_dynamic_bitset& rhs)
+  {
+    check_same_size(rhs);
+    block_type* l = blocks_.data();
+    const block_type* r = rhs.blocks_.data();
+    for (size_type i = 0, n = blocks_.size(); i != n; ++i) {
+      l[i] |= r[i];
+    }
+    return *this;
+  }
+
+  template <typename Allocator>
+  basic_dynamic_bitset<Allocator>& basic_dynamic_bitset<Allocator>::operator^=(
+      const basic_dynamic_bitset& rhs)
+  {
+    check_same_size(rhs);
+    block_type* l = blocks_.data();
+    const block_type* r = rhs.blocks_.data();
+    for (size_type i = 0, n = blocks_.size(); i != n; ++i) {
+      l[i] ^= r[i];
+    }
+    return *this;
+  }
+
+  template <typename Allocator>
+  basic_dynamic_bitset<Allocator>& basic_dynamic_bitset<Allocator>::operator-=(
+      const basic_dynamic_bitset& rhs)
+  {
+    check_same_size(rhs);
+    block_type* l = blocks_.data();
+    const block_type* r = rhs.blocks_.data();
+    for (size_type i = 0, n = blocks_.size(); i != n; ++i) {
+      l[i] &= ~r[i];
+    }
+    return *this;
+  }
+
+  template <typename Allocator>
+  typename basic_dynamic_bitset<Allocator>::size_type
+  basic_dynamic_bitset<Allocator>::max_size() const noexcept
+  {
+    const size_type blocks = blocks_.max_size();
+    return blocks > npos / bits_per_block ? npos - 1
+                                          : blocks * bits_per_block;
+  }
+
+  // New bits of a growing bitset take value; the words already there get
+  // their unused bits set first when value is true.
+  template <typename Allocator>
+  void basic_dynamic_bitset<Allocator>::resize(size_type size, bool value)
+  {
+    const size_type tail = size_ % bits_per_block;
+    if (value && size > size_ && tail != 0) {
+      blocks_.back() |= ~block_type(0) << tail;
+    }
+    blocks_.resize(blocks_for(size), value ? ~block_type(0) : block_type(0));
+    size_ = size;
+    clear_unused_bits();
+  }
+
+  template <typename Allocator>
+  void basic_dynamic_bitset<Allocator>::push_back(bool value)
+  {
+    if (size_ % bits_per_block == 0) {
+      blocks_.push_back(0);
+    }
+    if (value) {
+      blocks_.back() |= bit_mask(size_);
+    }
+    ++size_;
+  }
+
+  template <typename Allocator>
+  void basic_dynamic_bitset<Allocator>::clear() noexcept
+  {
+    blocks_.clear();
+    size_ = 0;
+  }
+
+  template <typename Allocator>
+  void basic_dynamic_bitset<Allocator>::swap(
+      basic_dynamic_bitset& rhs) noexcept
+  {
+    blocks_.swap(rhs.blocks_);
+    std::swap(size_, rhs.size_);
+  }
+
+  template <typename Allocator>
+  typename basic_dynamic_bitset<Allocator>::size_type
+  basic_dynamic_bitset<Allocator>::find_from(size_type i) const noexcept
+  {
+    size_type b = i / bits_per_block;
+    const size_type n = blocks_.size();
+    if (b == n) {
+      return npos;
+    }
+    block_type block = blocks_[b] & (~block_type(0) << (i % bits_per_block));
+    while (block == 0) {
+      if (++b == n) {
+        return npos;
+      }
+      block = blocks_[b];
+    }
+    return b * bits_per_block + detail::ctz64(block);
+  }
+
+  template <typename Allocator>
+  void basic_dynamic_bitset<Allocator>::clear_unused_bits() noexcept
+  {
+    const size_type tail = size_ % bits_per_block;
+    if (tail != 0) {
+      blocks_.back() &= (block_type(1) << tail) - 1;
+    }
+  }
+
+  template <typename Allocator>
+  void basic_dynamic_bitset<Allocator>::check_same_size(
+      const basic_dynamic_bitset& rhs) const
+  {
+    if (size_ != rhs.size_) {
+      throw std::invalid_argument("ftl::dynamic_bitset size mismatch");
+    }
+  }
+
+  template <typename Allocator>
+  void basic_dynamic_bitset<Allocator>::throw_out_of_range() const
+  {
+    throw std::out_of_range("ftl::dynamic_bitset out_of_range");
+  }
+
+  template <typename Allocator>
+  void swap(basic_dynamic_bitset<Allocator>& lhs,
+      basic_dynamic_bitset<Allocator>& rhs) noexcept
+  {
+    lhs.swap(rhs);
+  }
+
+  template <typename Allocator>
+  basic_dynamic_bitset<Allocator> operator&(
+      const basic_dynamic_bitset<Allocator>& lhs,
+      const basic_dynamic_bitset<Allocator>& rhs)
+  {
+    return basic_dynamic_bitset<Allocator>(lhs) &= rhs;
+  }
+
+  template <typename Allocator>
+  basic_dynamic_bitset<Allocator> operator|(
+      const basic_dynamic_bitset<Allocator>& lhs,
+      const basic_dynamic_bitset<Allocator>& rhs)
+  {
+    return basic_dynamic_bitset<Allocator>(lhs) |= rhs;
+  }
+
+  template <typename Allocator>
+  basic_dynamic_bitset<Allocator> operator^(
+      const basic_dynamic_bitset<Allocator>& lhs,
+      const basic_dynamic_bitset<Allocator>& rhs)
+  {
+    return basic_dynamic_bitset<Allocator>(lhs) ^= rhs;
+  }
+
+  template <typename Allocator>
+  basic_dynamic_bitset<Allocator> operator-(
+      const basic_dynamic_bitset<Allocator>& lhs,
+      const basic_dynamic_bitset<Allocator>& rhs)
+  {
+    return basic_dynamic_bitset<Allocator>(lhs) -= rhs;
+  }
+
+  // The unused bits are zero on both sides, so whole words compare.
+  template <typename Allocator>
+  bool operator==(const basic_dynamic_bitset<Allocator>& lhs,
+      const basic_dynamic_bitset<Allocator>& rhs)
+  {
+    return lhs.size() == rhs.size() &&
+        detail::contiguous_equal(lhs.data(), rhs.data(), lhs.num_blocks());
+  }
+
+#if !defined(FTL_CPP20_FEATURES)
+
+  template <typename Allocator>
+  bool operator!=(const basic_dynamic_bitset<Allocator>& lhs,
+      const basic_dynamic_bitset<Allocator>& rhs)
+  {
+    return !(lhs == rhs);
+  }
+
+#endif
+}
+
+#endif
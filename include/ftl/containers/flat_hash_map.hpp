@@ -0,0 +1,227 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_CONTAINERS_FLAT_HASH_MAP_HPP
+#define FTL_CONTAINERS_FLAT_HASH_MAP_HPP
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include "../internal/config.hpp"
+#include "../internal/raw_hash_set.hpp"
+
+namespace ftl {
+  namespace detail {
+
+    // Elements are stored as std::pair<const Key, T> but are moved during
+    // rehashing through a std::pair<Key, T> view of the same object, as
+    // std::map node handles and Abseil do.
+    template <typename Key, typename T>
+    struct hash_map_policy
+    {
+      using key_type = Key;
+      using value_type = std::pair<const Key, T>;
+      using mutable_type = std::pair<Key, T>;
+
+      template <typename Pair>
+      static const Key& key(const Pair& value) noexcept
+      {
+        return value.first;
+      }
+
+      static mutable_type& mutable_ref(value_type& value) noexcept
+      {
+        return reinterpret_cast<mutable_type&>(value);
+      }
+    };
+  }
+
+  // An unordered map that stores its key-value pairs inline in one open
+  // addressing table, in the style of Abseil's SwissTable. A lookup probes
+  // sixteen control bytes at once and usually touches a single element.
+  //
+  // Unlike std::unordered_map, elements move when the table grows or is
+  // rehashed, so insertion invalidates iterators, pointers and references;
+  // erasure invalidates only those to the erased element. Lookups accept
+  // any key type when Hash and Eq both define is_transparent.
+  template <typename Key, typename T, typename Hash = std::hash<Key>,
+      typename Eq = std::equal_to<Key>,
+      typename Allocator = std::allocator<std::pair<const Key, T>>>
+  class flat_hash_map final :
+    public detail::raw_hash_set<detail::hash_map_policy<Key, T>, Hash, Eq,
+        Allocator>
+  {
+    using Base = detail::raw_hash_set<detail::hash_map_policy<Key, T>, Hash,
+        Eq, Allocator>;
+
+    template <typename K>
+    using key_arg = typename Base::template key_arg<K>;
+
+  public:
+    using mapped_type = T;
+    using typename Base::const_iterator;
+    using typename Base::iterator;
+    using typename Base::key_type;
+
+    using Base::Base;
+    using Base::operator=;
+
+    flat_hash_map() = default;
+
+    template <typename K = key_type>
+    T& at(const key_arg<K>&);
+    template <typename K = key_type>
+    const T& at(const key_arg<K>&) const;
+
+    T& operator[](const key_type& key)
+    {
+      return try_emplace(key).first->second;
+    }
+
+    T& operator[](key_type&& key)
+    {
+      return try_emplace(std::move(key)).first->second;
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const key_type&, Args&&...);
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(key_type&&, Args&&...);
+    template <typename... Args>
+    iterator try_emplace(const_iterator, const key_type& key, Args&&... args)
+    {
+      return try_emplace(key, std::forward<Args>(args)...).first;
+    }
+    template <typename... Args>
+    iterator try_emplace(const_iterator, key_type&& key, Args&&... args)
+    {
+      return try_emplace(std::move(key), std::forward<Args>(args)...).first;
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(const key_type&, M&&);
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(key_type&&, M&&);
+
+  private:
+    void throw_out_of_range() const;
+  };
+
+  template <typename Key, typename T, typename Hash, typename Eq,
+      typename Allocator>
+  template <typename K>
+  T& flat_hash_map<Key, T, Hash, Eq, Allocator>::at(const key_arg<K>& key)
+  {
+    iterator it = this->find(key);
+    if (it == this->end()) {
+      throw_out_of_range();
+    }
+    return it->second;
+  }
+
+  template <typename Key, typename T, typename Hash, typename Eq,
+      typename Allocator>
+  template <typename K>
+  const T& flat_hash_map<Key, T, Hash, Eq, Allocator>::at(
+      const key_arg<K>& key) const
+  {
+    return const_cast<flat_hash_map*>(this)->at(key);
+  }
+
+  template <typename Key, typename T, typename Hash, typename Eq,
+      typename Allocator>
+  template <typename... Args>
+  std::pair<typename flat_hash_map<Key, T, Hash, Eq, Allocator>::iterator,
+      bool>
+  flat_hash_map<Key, T, Hash, Eq, Allocator>::try_emplace(const key_type& key,
+      Args&&... args)
+  {
+    return this->emplace_key(key, std::piecewise_construct,
+        std::forward_as_tuple(key),
+        std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  // The key is only moved from once the lookup has missed.
+  template <typename Key, typename T, typename Hash, typename Eq,
+      typename Allocator>
+  template <typename... Args>
+  std::pair<typename flat_hash_map<Key, T, Hash, Eq, Allocator>::iterator,
+      bool>
+  flat_hash_map<Key, T, Hash, Eq, Allocator>::try_emplace(key_type&& key,
+      Args&&... args)
+  {
+    return this->emplace_key(key, std::piecewise_construct,
+        std::forward_as_tuple(std::move(key)),
+        std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  template <typename Key, typename T, typename Hash, typename Eq,
+      typename Allocator>
+  template <typename M>
+  std::pair<typename flat_hash_map<Key, T, Hash, Eq, Allocator>::iterator,
+      bool>
+  flat_hash_map<Key, T, Hash, Eq, Allocator>::insert_or_assign(
+      const key_type& key, M&& obj)
+  {
+    auto result = try_emplace(key, std::forward<M>(obj));
+    if (!result.second) {
+      result.first->second = std::forward<M>(obj);
+    }
+    return result;
+  }
+
+  template <typename Key, typename T, typename Hash, typename Eq,
+      typename Allocator>
+  template <typename M>
+  std::pair<typename flat_hash_map<Key, T, Hash, Eq, Allocator>::iterator,
+      bool>
+  flat_hash_map<Key, T, Hash, Eq, Allocator>::insert_or_assign(key_type&& key,
+      M&& obj)
+  {
+    auto result = try_emplace(std::move(key), std::forward<M>(obj));
+    if (!result.second) {
+      result.first->second = std::forward<M>(obj);
+    }
+    return result;
+  }
+
+  template <typename Key, typename T, typename Hash, typename Eq,
+      typename Allocator>
+  void flat_hash_map<Key, T, Hash, Eq, Allocator>::throw_out_of_range() const
+  {
+    throw std::out_of_range("ftl::flat_hash_map out_of_range");
+  }
+
+  template <typename Key, typename T, typename Hash, typename Eq,
+      typename Allocator>
+  void swap(flat_hash_map<Key, T, Hash, Eq, Allocator>& lhs,
+      flat_hash_map<Key, T, Hash, Eq, Allocator>& rhs) noexcept
+  {
+    lhs.swap(rhs);
+  }
+
+  template <typename Key, typename T, typename Hash, typename Eq,
+      typename Allocator>
+  bool operator==(const flat_hash_map<Key, T, Hash, Eq, Allocator>& lhs,
+      const flat_hash_map<Key, T, Hash, Eq, Allocator>& rhs)
+  {
+    return detail::hash_set_equal(lhs, rhs);
+  }
+
+#if !defined(FTL_CPP20_FEATURES)
+
+  template <typename Key, typename T, typename Hash, typename Eq,
+      typename Allocator>
+  bool operator!=(const flat_hash_map<Key, T, Hash, Eq, Allocator>& lhs,
+      const flat_hash_map<Key, T, Hash, Eq, Allocator>& rhs)
+  {
+    return !(lhs == rhs);
+  }
+
+#endif
+}
+
+#endif
@@ -0,0 +1,79 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_CONTAINERS_FLAT_HASH_SET_HPP
+#define FTL_CONTAINERS_FLAT_HASH_SET_HPP
+
+#include <functional>
+#include <memory>
+#include "../internal/config.hpp"
+#include "../internal/raw_hash_set.hpp"
+
+namespace ftl {
+  namespace detail {
+
+    template <typename Key>
+    struct hash_set_policy
+    {
+      using key_type = Key;
+      using value_type = Key;
+      using mutable_type = Key;
+
+      static const Key& key(const Key& value) noexcept { return value; }
+      static Key& mutable_ref(Key& value) noexcept { return value; }
+    };
+  }
+
+  // An unordered set that stores its elements inline in one open
+  // addressing table, in the style of Abseil's SwissTable. A lookup probes
+  // sixteen control bytes at once and usually touches a single element.
+  //
+  // Unlike std::unordered_set, elements move when the table grows or is
+  // rehashed, so insertion invalidates iterators, pointers and references;
+  // erasure invalidates only those to the erased element. Lookups accept
+  // any key type when Hash and Eq both define is_transparent.
+  template <typename Key, typename Hash = std::hash<Key>,
+      typename Eq = std::equal_to<Key>,
+      typename Allocator = std::allocator<Key>>
+  class flat_hash_set final :
+    public detail::raw_hash_set<detail::hash_set_policy<Key>, Hash, Eq,
+        Allocator>
+  {
+    using Base = detail::raw_hash_set<detail::hash_set_policy<Key>, Hash, Eq,
+        Allocator>;
+
+  public:
+    using Base::Base;
+    using Base::operator=;
+
+    flat_hash_set() = default;
+  };
+
+  template <typename Key, typename Hash, typename Eq, typename Allocator>
+  void swap(flat_hash_set<Key, Hash, Eq, Allocator>& lhs,
+      flat_hash_set<Key, Hash, Eq, Allocator>& rhs) noexcept
+  {
+    lhs.swap(rhs);
+  }
+
+  template <typename Key, typename Hash, typename Eq, typename Allocator>
+  bool operator==(const flat_hash_set<Key, Hash, Eq, Allocator>& lhs,
+      const flat_hash_set<Key, Hash, Eq, Allocator>& rhs)
+  {
+    return detail::hash_set_equal(lhs, rhs);
+  }
+
+#if !defined(FTL_CPP20_FEATURES)
+
+  template <typename Key, typename Hash, typename Eq, typename Allocator>
+  bool operator!=(const flat_hash_set<Key, Hash, Eq, Allocator>& lhs,
+      const flat_hash_set<Key, Hash, Eq, Allocator>& rhs)
+  {
+    return !(lhs == rhs);
+  }
+
+#endif
+}
+
+#endif
@@ -0,0 +1,833 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_CONTAINERS_FLAT_MAP_HPP
+#define FTL_CONTAINERS_FLAT_MAP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include "../internal/config.hpp"
+#include "../internal/exception_guard.hpp"
+#include "../internal/index_iterator.hpp"
+#include "../internal/type_traits.hpp"
+#include "vector.hpp"
+
+#if defined(FTL_CPP20_FEATURES)
+#  include <compare>
+#endif
+
+namespace ftl {
+  namespace detail {
+
+    // The key and value columns of a flat_map, indexable as rows of
+    // reference pairs for index_iterator.
+    template <typename KeyContainer, typename MappedContainer>
+    struct flat_map_storage
+    {
+      using key_type = typename KeyContainer::value_type;
+      using mapped_type = typename MappedContainer::value_type;
+      using reference = std::pair<const key_type&, mapped_type&>;
+      using const_reference = std::pair<const key_type&, const mapped_type&>;
+
+      KeyContainer keys;
+      MappedContainer values;
+
+      reference operator[](std::size_t i)
+      {
+        return reference(keys[i], values[i]);
+      }
+
+      const_reference operator[](std::size_t i) const
+      {
+        return const_reference(keys[i], values[i]);
+      }
+    };
+  }
+
+  // An ordered map kept as two parallel sorted sequence containers, one of
+  // keys and one of values, like C++23 std::flat_map. Lookups binary search
+  // the contiguous keys without touching the values, and there is no
+  // per-element node. Elements are visited as std::pair<const Key&, T&>
+  // proxies. Inserting a single element shifts the elements after it, so
+  // batches should go through insert(first, last), which sorts the batch
+  // and merges it in O(n + m) after the sort, or
+  // insert(sorted_unique, first, last) for batches already in order.
+  //
+  // KeyContainer and MappedContainer are random access sequence containers
+  // such as ftl::vector. extract() and replace() move them out and in
+  // without copying. Iterators are invalidated by every insertion and
+  // erasure. If an exception escapes a bulk operation the map is left
+  // empty.
+  template <typename Key, typename T, typename Compare = std::less<Key>,
+      typename KeyContainer = vector<Key>,
+      typename MappedContainer = vector<T>>
+  class flat_map final
+  {
+    using Storage = detail::flat_map_storage<KeyContainer, MappedContainer>;
+
+  public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<key_type, mapped_type>;
+    using key_compare = Compare;
+    using reference = typename Storage::reference;
+    using const_reference = typename Storage::const_reference;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = detail::index_iterator<Storage, value_type, reference>;
+    using const_iterator = detail::index_iterator<const Storage,
+        const value_type, const_reference>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using key_container_type = KeyContainer;
+    using mapped_container_type = MappedContainer;
+
+    struct containers
+    {
+      key_container_type keys;
+      mapped_container_type values;
+    };
+
+    class value_compare
+    {
+      friend class flat_map;
+
+    public:
+      template <typename Lhs, typename Rhs>
+      bool operator()(const Lhs& lhs, const Rhs& rhs) const
+      {
+        return comp_(lhs.first, rhs.first);
+      }
+
+    private:
+      key_compare comp_;
+
+      explicit value_compare(const key_compare& comp) : comp_(comp) {}
+    };
+
+  private:
+    template <typename K>
+    using key_arg = typename detail::key_arg_impl<
+        detail::is_transparent<Compare>::value>::template type<K, key_type>;
+
+  public:
+    flat_map() : flat_map(key_compare()) {}
+    explicit flat_map(const key_compare& comp) : c_(), comp_(comp) {}
+    // Throw std::invalid_argument, like replace(), unless there is one
+    // value per key.
+    flat_map(key_container_type, mapped_container_type,
+        const key_compare& = key_compare());
+    flat_map(sorted_unique_t, key_container_type, mapped_container_type,
+        const key_compare& = key_compare());
+
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    flat_map(InputIt first, InputIt last,
+        const key_compare& comp = key_compare()) :
+      flat_map(comp)
+    {
+      insert(first, last);
+    }
+
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    flat_map(sorted_unique_t, InputIt first, InputIt last,
+        const key_compare& comp = key_compare()) :
+      flat_map(comp)
+    {
+      insert(sorted_unique, first, last);
+    }
+
+    flat_map(std::initializer_list<value_type> list,
+        const key_compare& comp = key_compare()) :
+      flat_map(list.begin(), list.end(), comp)
+    {
+    }
+
+    flat_map(sorted_unique_t, std::initializer_list<value_type> list,
+        const key_compare& comp = key_compare()) :
+      flat_map(sorted_unique, list.begin(), list.end(), comp)
+    {
+    }
+
+    flat_map& operator=(std::initializer_list<value_type>);
+
+    iterator begin() noexcept { return iterator(&c_, 0); }
+    iterator end() noexcept { return iterator(&c_, size()); }
+    const_iterator begin() const noexcept { return const_iterator(&c_, 0); }
+    const_iterator end() const noexcept
+    {
+      return const_iterator(&c_, size());
+    }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const noexcept
+    {
+      return const_reverse_iterator(end());
+    }
+    const_reverse_iterator rend() const noexcept
+    {
+      return const_reverse_iterator(begin());
+    }
+    const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+    const_reverse_iterator crend() const noexcept { return rend(); }
+
+    bool empty() const noexcept { return c_.keys.empty(); }
+    size_type size() const noexcept { return c_.keys.size(); }
+    size_type max_size() const noexcept
+    {
+      return std::min<size_type>(c_.keys.max_size(), c_.values.max_size());
+    }
+
+    mapped_type& operator[](const key_type& key)
+    {
+      return try_emplace(key).first->second;
+    }
+
+    mapped_type& operator[](key_type&& key)
+    {
+      return try_emplace(std::move(key)).first->second;
+    }
+
+    template <typename K = key_type>
+    T& at(const key_arg<K>&);
+    template <typename K = key_type>
+    const T& at(const key_arg<K>&) const;
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&...);
+    template <typename... Args>
+    iterator emplace_hint(const_iterator, Args&&... args)
+    {
+      return emplace(std::forward<Args>(args)...).first;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+      return try_emplace(value.first, value.second);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value)
+    {
+      return try_emplace(std::move(value.first), std::move(value.second));
+    }
+
+    iterator insert(const_iterator, const value_type& value)
+    {
+      return insert(value).first;
+    }
+
+    iterator insert(const_iterator, value_type&& value)
+    {
+      return insert(std::move(value)).first;
+    }
+
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    void insert(InputIt, InputIt);
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    void insert(sorted_unique_t, InputIt, InputIt);
+    void insert(std::initializer_list<value_type> list)
+    {
+      insert(list.begin(), list.end());
+    }
+    void insert(sorted_unique_t, std::initializer_list<value_type> list)
+    {
+      insert(sorted_unique, list.begin(), list.end());
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+    {
+      return emplace_unique(key, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
+    {
+      return emplace_unique(std::move(key), std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    iterator try_emplace(const_iterator, const key_type& key, Args&&... args)
+    {
+      return try_emplace(key, std::forward<Args>(args)...).first;
+    }
+
+    template <typename... Args>
+    iterator try_emplace(const_iterator, key_type&& key, Args&&... args)
+    {
+      return try_emplace(std::move(key), std::forward<Args>(args)...).first;
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(const key_type&, M&&);
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(key_type&&, M&&);
+
+    containers extract() &&;
+    void replace(key_container_type&&, mapped_container_type&&);
+
+    iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+    iterator erase(const_iterator);
+    iterator erase(const_iterator, const_iterator);
+    template <typename K = key_type>
+    size_type erase(const key_arg<K>&);
+
+    void swap(flat_map&) noexcept;
+    void clear() noexcept;
+
+    key_compare key_comp() const { return comp_; }
+    value_compare value_comp() const { return value_compare(comp_); }
+
+    // The underlying sorted columns, for bulk reads.
+    const key_container_type& keys() const noexcept { return c_.keys; }
+    const mapped_container_type& values() const noexcept { return c_.values; }
+
+    template <typename K = key_type>
+    iterator find(const key_arg<K>& key)
+    {
+      return iterator(&c_, find_index(key));
+    }
+    template <typename K = key_type>
+    const_iterator find(const key_arg<K>& key) const
+    {
+      return const_iterator(&c_, find_index(key));
+    }
+    template <typename K = key_type>
+    bool contains(const key_arg<K>& key) const
+    {
+      return find_index(key) != size();
+    }
+    template <typename K = key_type>
+    size_type count(const key_arg<K>& key) const
+    {
+      return contains(key) ? 1 : 0;
+    }
+
+    template <typename K = key_type>
+    iterator lower_bound(const key_arg<K>& key)
+    {
+      return iterator(&c_, lower_index(key));
+    }
+    template <typename K = key_type>
+    const_iterator lower_bound(const key_arg<K>& key) const
+    {
+      return const_iterator(&c_, lower_index(key));
+    }
+    template <typename K = key_type>
+    iterator upper_bound(const key_arg<K>& key)
+    {
+      return iterator(&c_, upper_index(key));
+    }
+    template <typename K = key_type>
+    const_iterator upper_bound(const key_arg<K>& key) const
+    {
+      return const_iterator(&c_, upper_index(key));
+    }
+    template <typename K = key_type>
+    std::pair<iterator, iterator> equal_range(const key_arg<K>& key)
+    {
+      return { lower_bound(key), upper_bound(key) };
+    }
+    template <typename K = key_type>
+    std::pair<const_iterator, const_iterator> equal_range(
+        const key_arg<K>& key) const
+    {
+      return { lower_bound(key), upper_bound(key) };
+    }
+
+  private:
+    Storage c_;
+    key_compare comp_;
+
+    template <typename K>
+    size_type lower_index(const K& key) const
+    {
+      return static_cast<size_type>(
+          std::lower_bound(c_.keys.begin(), c_.keys.end(), key, comp_) -
+          c_.keys.begin());
+    }
+
+    template <typename K>
+    size_type upper_index(const K& key) const
+    {
+      return static_cast<size_type>(
+          std::upper_bound(c_.keys.begin(), c_.keys.end(), key, comp_) -
+          c_.keys.begin());
+    }
+
+    template <typename K>
+    size_type find_index(const K& key) const
+    {
+      const size_type i = lower_index(key);
+      return i != size() && !comp_(key, c_.keys[i]) ? i : size();
+    }
+
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> emplace_unique(K&&, Args&&...);
+    template <typename Pair>
+    void append(Pair&&);
+    void sort_unique(size_type);
+    void merge_unique(size_type);
+    void check_same_size() const;
+    void throw_out_of_range() const;
+  };
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  flat_map<Key, T, Compare, KeyContainer, MappedContainer>::flat_map(
+      key_container_type keys, mapped_container_type values,
+      const key_compare& comp) :
+    c_{ std::move(keys), std::move(values) },
+    comp_(comp)
+  {
+    check_same_size();
+    sort_unique(0);
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  flat_map<Key, T, Compare, KeyContainer, MappedContainer>::flat_map(
+      sorted_unique_t, key_container_type keys, mapped_container_type values,
+      const key_compare& comp) :
+    c_{ std::move(keys), std::move(values) },
+    comp_(comp)
+  {
+    check_same_size();
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  flat_map<Key, T, Compare, KeyContainer, MappedContainer>&
+  flat_map<Key, T, Compare, KeyContainer, MappedContainer>::operator=(
+      std::initializer_list<value_type> list)
+  {
+    clear();
+    insert(list.begin(), list.end());
+    return *this;
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  template <typename K>
+  T& flat_map<Key, T, Compare, KeyContainer, MappedContainer>::at(
+      const key_arg<K>& key)
+  {
+    const size_type i = find_index(key);
+    if (i == size()) {
+      throw_out_of_range();
+    }
+    return c_.values[i];
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  template <typename K>
+  const T& flat_map<Key, T, Compare, KeyContainer, MappedContainer>::at(
+      const key_arg<K>& key) const
+  {
+    const size_type i = find_index(key);
+    if (i == size()) {
+      throw_out_of_range();
+    }
+    return c_.values[i];
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  template <typename... Args>
+  std::pair<
+      typename flat_map<Key, T, Compare, KeyContainer, MappedContainer>::
+          iterator,
+      bool>
+  flat_map<Key, T, Compare, KeyContainer, MappedContainer>::emplace(
+      Args&&... args)
+  {
+    value_type value(std::forward<Args>(args)...);
+    return emplace_unique(std::move(value.first), std::move(value.second));
+  }
+
+  // Appends the batch to both columns, sorts it on its own and merges the
+  // two sorted runs, instead of shifting both tails once per element.
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
+  void flat_map<Key, T, Compare, KeyContainer, MappedContainer>::insert(
+      InputIt first, InputIt last)
+  {
+    auto deleter = [this]() { clear(); };
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    const size_type size = this->size();
+    for (; first != last; ++first) {
+      append(*first);
+    }
+    sort_unique(size);
+    merge_unique(size);
+    guard.complete();
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
+  void flat_map<Key, T, Compare, KeyContainer, MappedContainer>::insert(
+      sorted_unique_t, InputIt first, InputIt last)
+  {
+    auto deleter = [this]() { clear(); };
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    const size_type size = this->size();
+    for (; first != last; ++first) {
+      append(*first);
+    }
+    merge_unique(size);
+    guard.complete();
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  template <typename M>
+  std::pair<
+      typename flat_map<Key, T, Compare, KeyContainer, MappedContainer>::
+          iterator,
+      bool>
+  flat_map<Key, T, Compare, KeyContainer, MappedContainer>::insert_or_assign(
+      const key_type& key, M&& obj)
+  {
+    auto result = try_emplace(key, std::forward<M>(obj));
+    if (!result.second) {
+      result.first->second = std::forward<M>(obj);
+    }
+    return result;
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  template <typename M>
+  std::pair<
+      typename flat_map<Key, T, Compare, KeyContainer, MappedContainer>::
+          iterator,
+      bool>
+  flat_map<Key, T, Compare, KeyContainer, MappedContainer>::insert_or_assign(
+      key_type&& key, M&& obj)
+  {
+    auto result = try_emplace(std::move(key), std::forward<M>(obj));
+    if (!result.second) {
+      result.first->second = std::forward<M>(obj);
+    }
+    return result;
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  typename flat_map<Key, T, Compare, KeyContainer, MappedContainer>::containers
+  flat_map<Key, T, Compare, KeyContainer, MappedContainer>::extract() &&
+  {
+    containers result{ std::move(c_.keys), std::move(c_.values) };
+    clear();
+    return result;
+  }
+
+  // The keys must already be sorted and unique, with one value per key.
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  void flat_map<Key, T, Compare, KeyContainer, MappedContainer>::replace(
+      key_container_type&& keys, mapped_container_type&& values)
+  {
+    if (keys.size() != values.size()) {
+      throw std::invalid_argument("ftl::flat_map size mismatch");
+    }
+    c_.keys = std::move(keys);
+    c_.values = std::move(values);
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  typename flat_map<Key, T, Compare, KeyContainer, MappedContainer>::iterator
+  flat_map<Key, T, Compare, KeyContainer, MappedContainer>::erase(
+      const_iterator pos)
+  {
+    const auto i = static_cast<difference_type>(pos.index());
+    c_.keys.erase(c_.keys.begin() + i);
+    c_.values.erase(c_.values.begin() + i);
+    return iterator(&c_, pos.index());
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  typename flat_map<Key, T, Compare, KeyContainer, MappedContainer>::iterator
+  flat_map<Key, T, Compare, KeyContainer, MappedContainer>::erase(
+      const_iterator first, const_iterator last)
+  {
+    const auto i = static_cast<difference_type>(first.index());
+    const auto j = static_cast<difference_type>(last.index());
+    c_.keys.erase(c_.keys.begin() + i, c_.keys.begin() + j);
+    c_.values.erase(c_.values.begin() + i, c_.values.begin() + j);
+    return iterator(&c_, first.index());
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  template <typename K>
+  typename flat_map<Key, T, Compare, KeyContainer, MappedContainer>::size_type
+  flat_map<Key, T, Compare, KeyContainer, MappedContainer>::erase(
+      const key_arg<K>& key)
+  {
+    const size_type i = find_index(key);
+    if (i == size()) {
+      return 0;
+    }
+    erase(const_iterator(&c_, i));
+    return 1;
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  void flat_map<Key, T, Compare, KeyContainer, MappedContainer>::swap(
+      flat_map& rhs) noexcept
+  {
+    using std::swap;
+    swap(c_.keys, rhs.c_.keys);
+    swap(c_.values, rhs.c_.values);
+    swap(comp_, rhs.comp_);
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  void flat_map<Key, T, Compare, KeyContainer,
+      MappedContainer>::clear() noexcept
+  {
+    c_.keys.clear();
+    c_.values.clear();
+  }
+
+  // A failed value insertion takes the key back out, so the columns stay
+  // the same length.
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  template <typename K, typename... Args>
+  std::pair<
+      typename flat_map<Key, T, Compare, KeyContainer, MappedContainer>::
+          iterator,
+      bool>
+  flat_map<Key, T, Compare, KeyContainer, MappedContainer>::emplace_unique(
+      K&& key, Args&&... args)
+  {
+    const size_type i = lower_index(key);
+    if (i != size() && !comp_(key, c_.keys[i])) {
+      return { iterator(&c_, i), false };
+    }
+    const auto offset = static_cast<difference_type>(i);
+    c_.keys.emplace(c_.keys.begin() + offset, std::forward<K>(key));
+    auto deleter = [this, offset]() {
+      c_.keys.erase(c_.keys.begin() + offset);
+    };
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    c_.values.emplace(c_.values.begin() + offset, std::forward<Args>(args)...);
+    guard.complete();
+    return { iterator(&c_, i), true };
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  template <typename Pair>
+  void flat_map<Key, T, Compare, KeyContainer, MappedContainer>::append(
+      Pair&& pair)
+  {
+    c_.keys.push_back(std::get<0>(std::forward<Pair>(pair)));
+    c_.values.push_back(std::get<1>(std::forward<Pair>(pair)));
+  }
+
+  // Sorts the rows from index first on by key and drops repeats, keeping
+  // the earliest of each run of equivalent keys. The columns are permuted
+  // through a sorted index array, since they cannot be sorted together.
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  void flat_map<Key, T, Compare, KeyContainer, MappedContainer>::sort_unique(
+      size_type first)
+  {
+    const size_type size = this->size();
+    vector<size_type> order(size - first);
+    std::iota(order.begin(), order.end(), first);
+    std::stable_sort(order.begin(), order.end(),
+        [this](size_type lhs, size_type rhs) {
+          return comp_(c_.keys[lhs], c_.keys[rhs]);
+        });
+
+    key_container_type keys;
+    mapped_container_type values;
+    keys.reserve(order.size());
+    values.reserve(order.size());
+    for (size_type i : order) {
+      if (keys.empty() || comp_(keys.back(), c_.keys[i])) {
+        keys.push_back(std::move(c_.keys[i]));
+        values.push_back(std::move(c_.values[i]));
+      }
+    }
+    const auto offset = static_cast<difference_type>(first);
+    c_.keys.erase(c_.keys.begin() + offset, c_.keys.end());
+    c_.values.erase(c_.values.begin() + offset, c_.values.end());
+    c_.keys.insert(c_.keys.end(), std::make_move_iterator(keys.begin()),
+        std::make_move_iterator(keys.end()));
+    c_.values.insert(c_.values.end(), std::make_move_iterator(values.begin()),
+        std::make_move_iterator(values.end()));
+  }
+
+  // Merges the sorted, unique rows from index middle on into the ones
+  // before it. One pass over both runs moves the new rows whose key is not
+  // present yet aside, then the two runs are merged back to front into
+  // their final places, so an old row moves at most once and a new one
+  // twice. flat_set merges its keys the same way.
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  void flat_map<Key, T, Compare, KeyContainer, MappedContainer>::merge_unique(
+      size_type middle)
+  {
+    auto& keys = c_.keys;
+    auto& values = c_.values;
+    if (middle == 0 || middle == size() ||
+        comp_(keys[middle - 1], keys[middle])) {
+      return;
+    }
+
+    key_container_type tail_keys;
+    mapped_container_type tail_values;
+    tail_keys.reserve(size() - middle);
+    tail_values.reserve(size() - middle);
+    size_type head = 0;
+    for (size_type i = middle; i != size(); ++i) {
+      while (head != middle && comp_(keys[head], keys[i])) {
+        ++head;
+      }
+      if (head == middle || comp_(keys[i], keys[head])) {
+        tail_keys.push_back(std::move(keys[i]));
+        tail_values.push_back(std::move(values[i]));
+      }
+    }
+    const size_type out = middle + tail_keys.size();
+    keys.erase(keys.begin() + static_cast<difference_type>(out), keys.end());
+    values.erase(values.begin() + static_cast<difference_type>(out),
+        values.end());
+
+    size_type i = middle;
+    size_type j = tail_keys.size();
+    size_type k = out;
+    while (j != 0) {
+      --k;
+      if (i != 0 && comp_(tail_keys[j - 1], keys[i - 1])) {
+        --i;
+        keys[k] = std::move(keys[i]);
+        values[k] = std::move(values[i]);
+      } else {
+        --j;
+        keys[k] = std::move(tail_keys[j]);
+        values[k] = std::move(tail_values[j]);
+      }
+    }
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  void flat_map<Key, T, Compare, KeyContainer,
+      MappedContainer>::check_same_size() const
+  {
+    if (c_.keys.size() != c_.values.size()) {
+      throw std::invalid_argument("ftl::flat_map size mismatch");
+    }
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  void flat_map<Key, T, Compare, KeyContainer,
+      MappedContainer>::throw_out_of_range() const
+  {
+    throw std::out_of_range("ftl::flat_map out_of_range");
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  void swap(flat_map<Key, T, Compare, KeyContainer, MappedContainer>& lhs,
+      flat_map<Key, T, Compare, KeyContainer, MappedContainer>& rhs) noexcept
+  {
+    lhs.swap(rhs);
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  bool operator==(
+      const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& lhs,
+      const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& rhs)
+  {
+    return lhs.keys() == rhs.keys() && lhs.values() == rhs.values();
+  }
+
+#if !defined(FTL_CPP20_FEATURES)
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  bool operator!=(
+      const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& lhs,
+      const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& rhs)
+  {
+    return !(lhs == rhs);
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  bool operator<(
+      const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& lhs,
+      const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& rhs)
+  {
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(),
+        rhs.end());
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  bool operator>(
+      const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& lhs,
+      const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& rhs)
+  {
+    return rhs < lhs;
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  bool operator<=(
+      const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& lhs,
+      const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& rhs)
+  {
+    return !(lhs > rhs);
+  }
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  bool operator>=(
+      const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& lhs,
+      const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& rhs)
+  {
+    return !(lhs < rhs);
+  }
+
+#else
+
+  template <typename Key, typename T, typename Compare, typename KeyContainer,
+      typename MappedContainer>
+  auto operator<=>(
+      const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& lhs,
+      const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& rhs)
+  {
+    return std::lexicographical_compare_three_way(lhs.begin(), lhs.end(),
+        rhs.begin(), rhs.end());
+  }
+
+#endif
+}
+
+#endif
@@ -0,0 +1,453 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_CONTAINERS_FLAT_SET_HPP
+#define FTL_CONTAINERS_FLAT_SET_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+#include "../internal/config.hpp"
+#include "../internal/exception_guard.hpp"
+#include "../internal/type_traits.hpp"
+#include "vector.hpp"
+
+#if defined(FTL_CPP20_FEATURES)
+#  include <compare>
+#endif
+
+namespace ftl {
+
+  // An ordered set kept as a sorted sequence container, like C++23
+  // std::flat_set. Lookups are binary searches over contiguous keys, and
+  // there is no per-element node. Inserting a single element shifts the
+  // elements after it, so batches should go through insert(first, last),
+  // which sorts the batch and merges it in O(n + m) after the sort, or
+  // insert(sorted_unique, first, last) for batches already in order.
+  //
+  // KeyContainer is a random access sequence container such as ftl::vector.
+  // extract() and replace() move it out and in without copying. Iterators
+  // are invalidated by every insertion and erasure. If an exception
+  // escapes a bulk operation the set is left empty.
+  template <typename Key, typename Compare = std::less<Key>,
+      typename KeyContainer = vector<Key>>
+  class flat_set final
+  {
+  public:
+    using key_type = Key;
+    using value_type = Key;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = typename KeyContainer::const_iterator;
+    using const_iterator = typename KeyContainer::const_iterator;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using container_type = KeyContainer;
+
+  private:
+    template <typename K>
+    using key_arg = typename detail::key_arg_impl<
+        detail::is_transparent<Compare>::value>::template type<K, key_type>;
+
+  public:
+    flat_set() : flat_set(key_compare()) {}
+    explicit flat_set(const key_compare& comp) : keys_(), comp_(comp) {}
+    explicit flat_set(container_type, const key_compare& = key_compare());
+    flat_set(sorted_unique_t, container_type keys,
+        const key_compare& comp = key_compare()) :
+      keys_(std::move(keys)),
+      comp_(comp)
+    {
+    }
+
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    flat_set(InputIt first, InputIt last,
+        const key_compare& comp = key_compare()) :
+      flat_set(container_type(first, last), comp)
+    {
+    }
+
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    flat_set(sorted_unique_t, InputIt first, InputIt last,
+        const key_compare& comp = key_compare()) :
+      flat_set(sorted_unique, container_type(first, last), comp)
+    {
+    }
+
+    flat_set(std::initializer_list<value_type> list,
+        const key_compare& comp = key_compare()) :
+      flat_set(list.begin(), list.end(), comp)
+    {
+    }
+
+    flat_set(sorted_unique_t, std::initializer_list<value_type> list,
+        const key_compare& comp = key_compare()) :
+      flat_set(sorted_unique, list.begin(), list.end(), comp)
+    {
+    }
+
+    flat_set& operator=(std::initializer_list<value_type>);
+
+    iterator begin() const noexcept { return keys_.begin(); }
+    iterator end() const noexcept { return keys_.end(); }
+    const_iterator cbegin() const noexcept { return keys_.begin(); }
+    const_iterator cend() const noexcept { return keys_.end(); }
+    reverse_iterator rbegin() const noexcept { return reverse_iterator(end()); }
+    reverse_iterator rend() const noexcept
+    {
+      return reverse_iterator(begin());
+    }
+    const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+    const_reverse_iterator crend() const noexcept { return rend(); }
+
+    bool empty() const noexcept { return keys_.empty(); }
+    size_type size() const noexcept { return keys_.size(); }
+    size_type max_size() const noexcept { return keys_.max_size(); }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&...);
+    template <typename... Args>
+    iterator emplace_hint(const_iterator, Args&&... args)
+    {
+      return emplace(std::forward<Args>(args)...).first;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+      return insert_unique(value);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value)
+    {
+      return insert_unique(std::move(value));
+    }
+
+    iterator insert(const_iterator, const value_type& value)
+    {
+      return insert(value).first;
+    }
+
+    iterator insert(const_iterator, value_type&& value)
+    {
+      return insert(std::move(value)).first;
+    }
+
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    void insert(InputIt, InputIt);
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    void insert(sorted_unique_t, InputIt, InputIt);
+    void insert(std::initializer_list<value_type> list)
+    {
+      insert(list.begin(), list.end());
+    }
+    void insert(sorted_unique_t, std::initializer_list<value_type> list)
+    {
+      insert(sorted_unique, list.begin(), list.end());
+    }
+
+    container_type extract() &&;
+    void replace(container_type&&);
+
+    iterator erase(const_iterator pos) { return keys_.erase(pos); }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+      return keys_.erase(first, last);
+    }
+    template <typename K = key_type>
+    size_type erase(const key_arg<K>&);
+
+    void swap(flat_set&) noexcept;
+    void clear() noexcept { keys_.clear(); }
+
+    key_compare key_comp() const { return comp_; }
+    value_compare value_comp() const { return comp_; }
+
+    template <typename K = key_type>
+    iterator find(const key_arg<K>&) const;
+    template <typename K = key_type>
+    bool contains(const key_arg<K>& key) const
+    {
+      return find(key) != end();
+    }
+    template <typename K = key_type>
+    size_type count(const key_arg<K>& key) const
+    {
+      return contains(key) ? 1 : 0;
+    }
+    template <typename K = key_type>
+    iterator lower_bound(const key_arg<K>& key) const
+    {
+      return std::lower_bound(begin(), end(), key, comp_);
+    }
+    template <typename K = key_type>
+    iterator upper_bound(const key_arg<K>& key) const
+    {
+      return std::upper_bound(begin(), end(), key, comp_);
+    }
+    template <typename K = key_type>
+    std::pair<iterator, iterator> equal_range(const key_arg<K>& key) const
+    {
+      return std::equal_range(begin(), end(), key, comp_);
+    }
+
+    // The underlying sorted container, for bulk reads.
+    const container_type& keys() const noexcept { return keys_; }
+
+  private:
+    container_type keys_;
+    key_compare comp_;
+
+    bool equivalent(const key_type& lhs, const key_type& rhs) const
+    {
+      return !comp_(lhs, rhs) && !comp_(rhs, lhs);
+    }
+
+    template <typename V>
+    std::pair<iterator, bool> insert_unique(V&&);
+    void sort_unique(size_type);
+    void merge_unique(size_type);
+  };
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  flat_set<Key, Compare, KeyContainer>::flat_set(container_type keys,
+      const key_compare& comp) :
+    keys_(std::move(keys)),
+    comp_(comp)
+  {
+    sort_unique(0);
+  }
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  flat_set<Key, Compare, KeyContainer>&
+  flat_set<Key, Compare, KeyContainer>::operator=(
+      std::initializer_list<value_type> list)
+  {
+    clear();
+    insert(list.begin(), list.end());
+    return *this;
+  }
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  template <typename... Args>
+  std::pair<typename flat_set<Key, Compare, KeyContainer>::iterator, bool>
+  flat_set<Key, Compare, KeyContainer>::emplace(Args&&... args)
+  {
+    return insert_unique(value_type(std::forward<Args>(args)...));
+  }
+
+  // Appends the batch, sorts it on its own and merges the two sorted runs,
+  // instead of shifting the tail once per element.
+  template <typename Key, typename Compare, typename KeyContainer>
+  template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
+  void flat_set<Key, Compare, KeyContainer>::insert(InputIt first,
+      InputIt last)
+  {
+    auto deleter = [this]() { clear(); };
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    const size_type size = keys_.size();
+    keys_.insert(keys_.end(), first, last);
+    sort_unique(size);
+    merge_unique(size);
+    guard.complete();
+  }
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
+  void flat_set<Key, Compare, KeyContainer>::insert(sorted_unique_t,
+      InputIt first, InputIt last)
+  {
+    auto deleter = [this]() { clear(); };
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    const size_type size = keys_.size();
+    keys_.insert(keys_.end(), first, last);
+    merge_unique(size);
+    guard.complete();
+  }
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  typename flat_set<Key, Compare, KeyContainer>::container_type
+  flat_set<Key, Compare, KeyContainer>::extract() &&
+  {
+    container_type keys = std::move(keys_);
+    keys_.clear();
+    return keys;
+  }
+
+  // The keys must already be sorted and unique.
+  template <typename Key, typename Compare, typename KeyContainer>
+  void flat_set<Key, Compare, KeyContainer>::replace(container_type&& keys)
+  {
+    keys_ = std::move(keys);
+  }
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  template <typename K>
+  typename flat_set<Key, Compare, KeyContainer>::size_type
+  flat_set<Key, Compare, KeyContainer>::erase(const key_arg<K>& key)
+  {
+    const iterator it = find(key);
+    if (it == end()) {
+      return 0;
+    }
+    keys_.erase(it);
+    return 1;
+  }
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  void flat_set<Key, Compare, KeyContainer>::swap(flat_set& rhs) noexcept
+  {
+    using std::swap;
+    swap(keys_, rhs.keys_);
+    swap(comp_, rhs.comp_);
+  }
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  template <typename K>
+  typename flat_set<Key, Compare, KeyContainer>::iterator
+  flat_set<Key, Compare, KeyContainer>::find(const key_arg<K>& key) const
+  {
+    const iterator it = lower_bound(key);
+    return it != end() && !comp_(key, *it) ? it : end();
+  }
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  template <typename V>
+  std::pair<typename flat_set<Key, Compare, KeyContainer>::iterator, bool>
+  flat_set<Key, Compare, KeyContainer>::insert_unique(V&& value)
+  {
+    const iterator it = lower_bound(value);
+    if (it != end() && !comp_(value, *it)) {
+      return { it, false };
+    }
+    return { keys_.insert(it, std::forward<V>(value)), true };
+  }
+
+  // Sorts the keys from index first on and drops repeats, keeping the
+  // earliest of each run of equivalent keys.
+  template <typename Key, typename Compare, typename KeyContainer>
+  void flat_set<Key, Compare, KeyContainer>::sort_unique(size_type first)
+  {
+    const auto from = keys_.begin() + static_cast<difference_type>(first);
+    std::stable_sort(from, keys_.end(), comp_);
+    keys_.erase(std::unique(from, keys_.end(),
+                    [this](const key_type& lhs, const key_type& rhs) {
+                      return equivalent(lhs, rhs);
+                    }),
+        keys_.end());
+  }
+
+  // Merges the sorted, unique keys from index middle on into the ones
+  // before it. One pass over both runs moves the new keys that are not
+  // present yet aside, then the two runs are merged back to front into
+  // their final places, so an old key moves at most once and a new one
+  // twice. flat_map merges its rows the same way.
+  template <typename Key, typename Compare, typename KeyContainer>
+  void flat_set<Key, Compare, KeyContainer>::merge_unique(size_type middle)
+  {
+    if (middle == 0 || middle == keys_.size() ||
+        comp_(keys_[middle - 1], keys_[middle])) {
+      return;
+    }
+
+    container_type tail;
+    tail.reserve(keys_.size() - middle);
+    size_type head = 0;
+    for (size_type i = middle; i != keys_.size(); ++i) {
+      while (head != middle && comp_(keys_[head], keys_[i])) {
+        ++head;
+      }
+      if (head == middle || comp_(keys_[i], keys_[head])) {
+        tail.push_back(std::move(keys_[i]));
+      }
+    }
+    const size_type out = middle + tail.size();
+    keys_.erase(keys_.begin() + static_cast<difference_type>(out),
+        keys_.end());
+
+    size_type i = middle;
+    size_type j = tail.size();
+    size_type k = out;
+    while (j != 0) {
+      --k;
+      if (i != 0 && comp_(tail[j - 1], keys_[i - 1])) {
+        --i;
+        keys_[k] = std::move(keys_[i]);
+      } else {
+        --j;
+        keys_[k] = std::move(tail[j]);
+      }
+    }
+  }
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  void swap(flat_set<Key, Compare, KeyContainer>& lhs,
+      flat_set<Key, Compare, KeyContainer>& rhs) noexcept
+  {
+    lhs.swap(rhs);
+  }
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  bool operator==(const flat_set<Key, Compare, KeyContainer>& lhs,
+      const flat_set<Key, Compare, KeyContainer>& rhs)
+  {
+    return lhs.keys() == rhs.keys();
+  }
+
+#if !defined(FTL_CPP20_FEATURES)
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  bool operator!=(const flat_set<Key, Compare, KeyContainer>& lhs,
+      const flat_set<Key, Compare, KeyContainer>& rhs)
+  {
+    return !(lhs == rhs);
+  }
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  bool operator<(const flat_set<Key, Compare, KeyContainer>& lhs,
+      const flat_set<Key, Compare, KeyContainer>& rhs)
+  {
+    return lhs.keys() < rhs.keys();
+  }
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  bool operator>(const flat_set<Key, Compare, KeyContainer>& lhs,
+      const flat_set<Key, Compare, KeyContainer>& rhs)
+  {
+    return rhs < lhs;
+  }
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  bool operator<=(const flat_set<Key, Compare, KeyContainer>& lhs,
+      const flat_set<Key, Compare, KeyContainer>& rhs)
+  {
+    return !(lhs > rhs);
+  }
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  bool operator>=(const flat_set<Key, Compare, KeyContainer>& lhs,
+      const flat_set<Key, Compare, KeyContainer>& rhs)
+  {
+    return !(lhs < rhs);
+  }
+
+#else
+
+  template <typename Key, typename Compare, typename KeyContainer>
+  auto operator<=>(const flat_set<Key, Compare, KeyContainer>& lhs,
+      const flat_set<Key, Compare, KeyContainer>& rhs)
+  {
+    return lhs.keys() <=> rhs.keys();
+  }
+
+#endif
+}
+
+#endif
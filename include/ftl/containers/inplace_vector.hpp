@@ -0,0 +1,881 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_CONTAINERS_INPLACE_VECTOR_HPP
+#define FTL_CONTAINERS_INPLACE_VECTOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "../internal/config.hpp"
+#include "../internal/hash.hpp"
+#include "../internal/type_traits.hpp"
+#include "../internal/wrap_iterator.hpp"
+
+namespace ftl {
+  namespace detail {
+
+    // Element storage of inplace_vector. Objects are created in raw bytes
+    // and the copy and move operations work element by element.
+    template <typename T, std::size_t N,
+        bool = std::is_trivial<T>::value && std::is_copy_assignable<T>::value>
+    class inplace_storage
+    {
+    public:
+      using size_type = std::size_t;
+
+      inplace_storage() noexcept : size_(0) {}
+
+      inplace_storage(const inplace_storage& rhs) : size_(0)
+      {
+        append(rhs.data(), rhs.size_);
+      }
+
+      inplace_storage(inplace_storage&& rhs) noexcept(
+          std::is_nothrow_move_constructible<T>::value) :
+        size_(0)
+      {
+        append(std::make_move_iterator(rhs.data()), rhs.size_);
+      }
+
+      ~inplace_storage() { clear(); }
+
+      inplace_storage& operator=(const inplace_storage& rhs)
+      {
+        if (this != &rhs) {
+          assign(rhs.data(), rhs.size_);
+        }
+        return *this;
+      }
+
+      inplace_storage& operator=(inplace_storage&& rhs) noexcept(
+          std::is_nothrow_move_assignable<T>::value &&
+          std::is_nothrow_move_constructible<T>::value)
+      {
+        if (this != &rhs) {
+          assign(std::make_move_iterator(rhs.data()), rhs.size_);
+        }
+        return *this;
+      }
+
+      T* data() noexcept { return reinterpret_cast<T*>(bytes_); }
+      const T* data() const noexcept
+      {
+        return reinterpret_cast<const T*>(bytes_);
+      }
+
+      size_type size() const noexcept { return size_; }
+      void set_size(size_type size) noexcept { size_ = size; }
+
+      template <typename... Args>
+      void construct(T* p, Args&&... args)
+      {
+        ::new (static_cast<void*>(p)) T(std::forward<Args>(args)...);
+      }
+
+      void default_init(T* p) { ::new (static_cast<void*>(p)) T; }
+      void destroy(T* p) noexcept { p->~T(); }
+
+    private:
+      alignas(T) unsigned char bytes_[(N == 0 ? 1 : N) * sizeof(T)];
+      size_type size_;
+
+      template <typename InputIt>
+      void append(InputIt first, size_type count)
+      {
+        for (; size_ != count; ++first, ++size_) {
+          construct(data() + size_, *first);
+        }
+      }
+
+      template <typename InputIt>
+      void assign(InputIt first, size_type count)
+      {
+        const size_type common = std::min(size_, count);
+        for (size_type i = 0; i != common; ++i, ++first) {
+          data()[i] = *first;
+        }
+        if (count > size_) {
+          append(first, count);
+          return;
+        }
+        for (size_type i = count; i != size_; ++i) {
+          destroy(data() + i);
+        }
+        size_ = count;
+      }
+
+      void clear() noexcept
+      {
+        for (size_type i = 0; i != size_; ++i) {
+          destroy(data() + i);
+        }
+        size_ = 0;
+      }
+    };
+
+    // Trivial elements are kept in a plain array: the container stays
+    // trivially copyable and every operation is usable in constant
+    // expressions from C++20 on. Constructing an element is an assignment.
+    template <typename T, std::size_t N>
+    class inplace_storage<T, N, true>
+    {
+    public:
+      using size_type = std::size_t;
+
+      FTL_CONSTEXPR_SINCE_CXX20 inplace_storage() noexcept : size_(0) {}
+
+      FTL_CONSTEXPR_SINCE_CXX14 T* data() noexcept { return data_; }
+      constexpr const T* data() const noexcept { return data_; }
+
+      constexpr size_type size() const noexcept { return size_; }
+      FTL_CONSTEXPR_SINCE_CXX14 void set_size(size_type size) noexcept
+      {
+        size_ = size;
+      }
+
+      template <typename... Args>
+      FTL_CONSTEXPR_SINCE_CXX14 void construct(T* p, Args&&... args)
+      {
+        *p = T(std::forward<Args>(args)...);
+      }
+
+      FTL_CONSTEXPR_SINCE_CXX14 void default_init(T*) noexcept {}
+      FTL_CONSTEXPR_SINCE_CXX14 void destroy(T*) noexcept {}
+
+    private:
+      T data_[N == 0 ? 1 : N];
+      size_type size_;
+    };
+  }
+}
+
+namespace ftl {
+
+  // A vector with a fixed capacity of N elements stored inside the object.
+  // It never allocates: operations that would grow it past N throw
+  // std::bad_alloc, while try_push_back and try_emplace_back return nullptr.
+  template <typename T, std::size_t N>
+  class inplace_vector final
+  {
+  public:
+    using value_type = T;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = detail::wrap_iterator<pointer>;
+    using const_iterator = detail::wrap_iterator<const_pointer>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  private:
+    using Storage = detail::inplace_storage<value_type, N>;
+    using IsNothrowMovable = std::is_nothrow_move_constructible<value_type>;
+
+  public:
+    inplace_vector() = default;
+    inplace_vector(const inplace_vector&) = default;
+    inplace_vector(inplace_vector&&) = default;
+    FTL_CONSTEXPR_SINCE_CXX20 inplace_vector(size_type);
+    FTL_CONSTEXPR_SINCE_CXX20 inplace_vector(size_type, default_init_t);
+    FTL_CONSTEXPR_SINCE_CXX20 inplace_vector(size_type, const_reference);
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    FTL_CONSTEXPR_SINCE_CXX20 inplace_vector(InputIt, InputIt);
+    FTL_CONSTEXPR_SINCE_CXX20 inplace_vector(std::initializer_list<value_type>);
+    ~inplace_vector() = default;
+
+    inplace_vector& operator=(const inplace_vector&) = default;
+    inplace_vector& operator=(inplace_vector&&) = default;
+    FTL_CONSTEXPR_SINCE_CXX20 reference operator[](size_type i) noexcept
+    {
+      return data()[i];
+    }
+    constexpr const_reference operator[](size_type i) const noexcept
+    {
+      return data()[i];
+    }
+
+    FTL_CONSTEXPR_SINCE_CXX20 void reserve(size_type);
+    FTL_CONSTEXPR_SINCE_CXX20 void resize(size_type);
+    FTL_CONSTEXPR_SINCE_CXX20 void resize(size_type, const_reference);
+    FTL_CONSTEXPR_SINCE_CXX20 void resize_for_overwrite(size_type);
+    FTL_CONSTEXPR_SINCE_CXX20 void shrink_to_fit() noexcept {}
+    FTL_CONSTEXPR_SINCE_CXX20 void clear() noexcept { destroy_at_end(data()); }
+    FTL_CONSTEXPR_SINCE_CXX20 void
+    swap(inplace_vector&) noexcept(IsNothrowMovable::value);
+
+    FTL_CONSTEXPR_SINCE_CXX20 void push_back(const_reference);
+    FTL_CONSTEXPR_SINCE_CXX20 void push_back(value_type&&);
+    FTL_CONSTEXPR_SINCE_CXX20 void pop_back();
+
+    FTL_CONSTEXPR_SINCE_CXX20 pointer try_push_back(const_reference);
+    FTL_CONSTEXPR_SINCE_CXX20 pointer try_push_back(value_type&&);
+    template <typename... Args>
+    FTL_CONSTEXPR_SINCE_CXX20 pointer try_emplace_back(Args&&...);
+
+    FTL_CONSTEXPR_SINCE_CXX20 reference at(size_type);
+    FTL_CONSTEXPR_SINCE_CXX20 const_reference at(size_type) const;
+
+    FTL_CONSTEXPR_SINCE_CXX20 void assign(size_type, const_reference);
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    FTL_CONSTEXPR_SINCE_CXX20 void assign(InputIt, InputIt);
+    FTL_CONSTEXPR_SINCE_CXX20 void assign(std::initializer_list<value_type>);
+
+    FTL_CONSTEXPR_SINCE_CXX20 iterator insert(const_iterator, const_reference);
+    FTL_CONSTEXPR_SINCE_CXX20 iterator insert(const_iterator, value_type&&);
+    FTL_CONSTEXPR_SINCE_CXX20 iterator
+    insert(const_iterator, size_type, const_reference);
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    FTL_CONSTEXPR_SINCE_CXX20 iterator
+    insert(const_iterator, InputIt, InputIt);
+    FTL_CONSTEXPR_SINCE_CXX20 iterator
+    insert(const_iterator, std::initializer_list<value_type>);
+
+    template <typename... Args>
+    FTL_CONSTEXPR_SINCE_CXX20 iterator emplace(const_iterator, Args&&...);
+    template <typename... Args>
+    FTL_CONSTEXPR_SINCE_CXX20 void emplace_back(Args&&...);
+    template <typename Writer>
+    size_type append_uninitialized(size_type, Writer);
+
+    FTL_CONSTEXPR_SINCE_CXX20 iterator erase(const_iterator);
+    FTL_CONSTEXPR_SINCE_CXX20 iterator erase(const_iterator, const_iterator);
+
+    FTL_CONSTEXPR_SINCE_CXX20 reference front() noexcept { return *data(); }
+    FTL_CONSTEXPR_SINCE_CXX20 reference back() noexcept
+    {
+      return *(end_() - 1);
+    }
+    FTL_CONSTEXPR_SINCE_CXX20 pointer data() noexcept
+    {
+      return storage_.data();
+    }
+    constexpr const_reference front() const noexcept { return *data(); }
+    constexpr const_reference back() const noexcept { return *(end_() - 1); }
+    constexpr const_pointer data() const noexcept { return storage_.data(); }
+
+    FTL_CONSTEXPR_SINCE_CXX20 iterator begin() noexcept
+    {
+      return iterator(data());
+    }
+    FTL_CONSTEXPR_SINCE_CXX20 iterator end() noexcept
+    {
+      return iterator(end_());
+    }
+    constexpr const_iterator begin() const noexcept
+    {
+      return const_iterator(data());
+    }
+    constexpr const_iterator end() const noexcept
+    {
+      return const_iterator(end_());
+    }
+    constexpr const_iterator cbegin() const noexcept { return begin(); }
+    constexpr const_iterator cend() const noexcept { return end(); }
+    FTL_CONSTEXPR_SINCE_CXX20 reverse_iterator rbegin() noexcept
+    {
+      return reverse_iterator(end());
+    }
+    FTL_CONSTEXPR_SINCE_CXX20 reverse_iterator rend() noexcept
+    {
+      return reverse_iterator(begin());
+    }
+    FTL_CONSTEXPR_SINCE_CXX20 const_reverse_iterator crbegin() const noexcept
+    {
+      return const_reverse_iterator(cend());
+    }
+    FTL_CONSTEXPR_SINCE_CXX20 const_reverse_iterator crend() const noexcept
+    {
+      return const_reverse_iterator(cbegin());
+    }
+
+    constexpr bool empty() const noexcept { return storage_.size() == 0; }
+    constexpr size_type size() const noexcept { return storage_.size(); }
+    static constexpr size_type capacity() noexcept { return N; }
+    static constexpr size_type max_size() noexcept { return N; }
+
+  private:
+    Storage storage_;
+
+    FTL_CONSTEXPR_SINCE_CXX20 pointer end_() noexcept
+    {
+      return data() + size();
+    }
+    constexpr const_pointer end_() const noexcept { return data() + size(); }
+
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    FTL_CONSTEXPR_SINCE_CXX20 void construct_at_end(InputIt, InputIt);
+    template <typename... Args>
+    FTL_CONSTEXPR_SINCE_CXX20 void construct_at_end(size_type, Args&&...);
+    FTL_CONSTEXPR_SINCE_CXX20 void destroy_at_end(pointer) noexcept;
+    FTL_CONSTEXPR_SINCE_CXX20 void ensure_spare_capacity(size_type) const;
+
+    template <typename InputIt>
+    FTL_CONSTEXPR_SINCE_CXX20 void
+    assign_range(InputIt, InputIt, std::input_iterator_tag);
+    template <typename ForwardIt>
+    FTL_CONSTEXPR_SINCE_CXX20 void
+    assign_range(ForwardIt, ForwardIt, std::forward_iterator_tag);
+    template <typename InputIt>
+    FTL_CONSTEXPR_SINCE_CXX20 pointer
+    insert_range(pointer, InputIt, InputIt, std::input_iterator_tag);
+    template <typename ForwardIt>
+    FTL_CONSTEXPR_SINCE_CXX20 pointer
+    insert_range(pointer, ForwardIt, ForwardIt, std::forward_iterator_tag);
+    FTL_CONSTEXPR_SINCE_CXX20 pointer
+    insert_fill(pointer, size_type, const_reference);
+    FTL_CONSTEXPR_SINCE_CXX20 void move_right(pointer, pointer, pointer);
+
+    void throw_out_of_range() const;
+    void throw_bad_alloc() const;
+  };
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 inplace_vector<T, N>::inplace_vector(size_type size)
+  {
+    ensure_spare_capacity(size);
+    construct_at_end(size);
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 inplace_vector<T, N>::inplace_vector(
+      size_type size, default_init_t)
+  {
+    resize_for_overwrite(size);
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 inplace_vector<T, N>::inplace_vector(
+      size_type size, const_reference value)
+  {
+    ensure_spare_capacity(size);
+    construct_at_end(size, value);
+  }
+
+  template <typename T, std::size_t N>
+  template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
+  FTL_CONSTEXPR_SINCE_CXX20 inplace_vector<T, N>::inplace_vector(
+      InputIt first, InputIt last)
+  {
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    assign_range(first, last, category());
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 inplace_vector<T, N>::inplace_vector(
+      std::initializer_list<value_type> list)
+  {
+    ensure_spare_capacity(list.size());
+    construct_at_end(list.begin(), list.end());
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 void inplace_vector<T, N>::reserve(size_type size)
+  {
+    if (size > N) {
+      throw_bad_alloc();
+    }
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 void inplace_vector<T, N>::resize(size_type size)
+  {
+    if (size <= this->size()) {
+      destroy_at_end(data() + size);
+    } else {
+      ensure_spare_capacity(size - this->size());
+      construct_at_end(size - this->size());
+    }
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 void
+  inplace_vector<T, N>::resize(size_type size, const_reference value)
+  {
+    if (size <= this->size()) {
+      destroy_at_end(data() + size);
+    } else {
+      insert_fill(end_(), size - this->size(), value);
+    }
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 void
+  inplace_vector<T, N>::resize_for_overwrite(size_type size)
+  {
+    if (size <= this->size()) {
+      destroy_at_end(data() + size);
+      return;
+    }
+    ensure_spare_capacity(size - this->size());
+    for (size_type i = this->size(); i != size; ++i) {
+      storage_.default_init(data() + i);
+      storage_.set_size(i + 1);
+    }
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 void inplace_vector<T, N>::swap(
+      inplace_vector& rhs) noexcept(IsNothrowMovable::value)
+  {
+    inplace_vector& longer = size() < rhs.size() ? rhs : *this;
+    inplace_vector& shorter = size() < rhs.size() ? *this : rhs;
+    const size_type common = shorter.size();
+    std::swap_ranges(shorter.data(), shorter.data() + common, longer.data());
+    shorter.construct_at_end(std::make_move_iterator(longer.data() + common),
+        std::make_move_iterator(longer.end_()));
+    longer.destroy_at_end(longer.data() + common);
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 void
+  inplace_vector<T, N>::push_back(const_reference value)
+  {
+    emplace_back(value);
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 void
+  inplace_vector<T, N>::push_back(value_type&& value)
+  {
+    emplace_back(std::move(value));
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 void inplace_vector<T, N>::pop_back()
+  {
+    destroy_at_end(end_() - 1);
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 typename inplace_vector<T, N>::pointer
+  inplace_vector<T, N>::try_push_back(const_reference value)
+  {
+    return try_emplace_back(value);
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 typename inplace_vector<T, N>::pointer
+  inplace_vector<T, N>::try_push_back(value_type&& value)
+  {
+    return try_emplace_back(std::move(value));
+  }
+
+  template <typename T, std::size_t N>
+  template <typename... Args>
+  FTL_CONSTEXPR_SINCE_CXX20 typename inplace_vector<T, N>::pointer
+  inplace_vector<T, N>::try_emplace_back(Args&&... args)
+  {
+    if (size() == N) {
+      return nullptr;
+    }
+    pointer position = end_();
+    storage_.construct(position, std::forward<Args>(args)...);
+    storage_.set_size(size() + 1);
+    return position;
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 typename inplace_vector<T, N>::reference
+  inplace_vector<T, N>::at(size_type i)
+  {
+    if (i >= size()) {
+      throw_out_of_range();
+    }
+    return data()[i];
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 typename inplace_vector<T, N>::const_reference
+  inplace_vector<T, N>::at(size_type i) const
+  {
+    if (i >= size()) {
+      throw_out_of_range();
+    }
+    return data()[i];
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 void
+  inplace_vector<T, N>::assign(size_type count, const_reference value)
+  {
+    if (count > N) {
+      throw_bad_alloc();
+    }
+    const size_type common = std::min(count, size());
+    std::fill_n(data(), common, value);
+    if (count > size()) {
+      construct_at_end(count - size(), value);
+    } else {
+      destroy_at_end(data() + count);
+    }
+  }
+
+  template <typename T, std::size_t N>
+  template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
+  FTL_CONSTEXPR_SINCE_CXX20 void
+  inplace_vector<T, N>::assign(InputIt first, InputIt last)
+  {
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    assign_range(first, last, category());
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 void
+  inplace_vector<T, N>::assign(std::initializer_list<value_type> list)
+  {
+    assign_range(list.begin(), list.end(), std::random_access_iterator_tag());
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 typename inplace_vector<T, N>::iterator
+  inplace_vector<T, N>::insert(const_iterator position, const_reference value)
+  {
+    return emplace(position, value);
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 typename inplace_vector<T, N>::iterator
+  inplace_vector<T, N>::insert(const_iterator position, value_type&& value)
+  {
+    return emplace(position, std::move(value));
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 typename inplace_vector<T, N>::iterator
+  inplace_vector<T, N>::insert(const_iterator position, size_type count,
+      const_reference value)
+  {
+    pointer pos = data() + (position - cbegin());
+    return iterator(insert_fill(pos, count, value));
+  }
+
+  template <typename T, std::size_t N>
+  template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
+  FTL_CONSTEXPR_SINCE_CXX20 typename inplace_vector<T, N>::iterator
+  inplace_vector<T, N>::insert(const_iterator position, InputIt first,
+      InputIt last)
+  {
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    pointer pos = data() + (position - cbegin());
+    return iterator(insert_range(pos, first, last, category()));
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 typename inplace_vector<T, N>::iterator
+  inplace_vector<T, N>::insert(const_iterator position,
+      std::initializer_list<value_type> list)
+  {
+    return insert(position, list.begin(), list.end());
+  }
+
+  template <typename T, std::size_t N>
+  template <typename... Args>
+  FTL_CONSTEXPR_SINCE_CXX20 typename inplace_vector<T, N>::iterator
+  inplace_vector<T, N>::emplace(const_iterator position, Args&&... args)
+  {
+    ensure_spare_capacity(1);
+    pointer pos = data() + (position - cbegin());
+    if (pos == end_()) {
+      construct_at_end(1, std::forward<Args>(args)...);
+    } else {
+      value_type tmp(std::forward<Args>(args)...);
+      move_right(pos, end_(), pos + 1);
+      *pos = std::move(tmp);
+    }
+    return iterator(pos);
+  }
+
+  template <typename T, std::size_t N>
+  template <typename... Args>
+  FTL_CONSTEXPR_SINCE_CXX20 void
+  inplace_vector<T, N>::emplace_back(Args&&... args)
+  {
+    ensure_spare_capacity(1);
+    construct_at_end(1, std::forward<Args>(args)...);
+  }
+
+  template <typename T, std::size_t N>
+  template <typename Writer>
+  typename inplace_vector<T, N>::size_type
+  inplace_vector<T, N>::append_uninitialized(size_type count, Writer writer)
+  {
+    static_assert(std::is_trivially_copyable<value_type>::value &&
+            std::is_trivially_default_constructible<value_type>::value,
+        "append_uninitialized requires a trivial value_type");
+    ensure_spare_capacity(count);
+    const size_type written = writer(end_(), count);
+    storage_.set_size(size() + std::min(written, count));
+    return written;
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 typename inplace_vector<T, N>::iterator
+  inplace_vector<T, N>::erase(const_iterator position)
+  {
+    return erase(position, position + 1);
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 typename inplace_vector<T, N>::iterator
+  inplace_vector<T, N>::erase(const_iterator first, const_iterator last)
+  {
+    pointer pos = data() + (first - cbegin());
+    if (first != last) {
+      pointer tail = data() + (last - cbegin());
+      destroy_at_end(std::move(tail, end_(), pos));
+    }
+    return iterator(pos);
+  }
+
+  template <typename T, std::size_t N>
+  template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
+  FTL_CONSTEXPR_SINCE_CXX20 void
+  inplace_vector<T, N>::construct_at_end(InputIt first, InputIt last)
+  {
+    for (; first != last; ++first) {
+      storage_.construct(end_(), *first);
+      storage_.set_size(size() + 1);
+    }
+  }
+
+  template <typename T, std::size_t N>
+  template <typename... Args>
+  FTL_CONSTEXPR_SINCE_CXX20 void
+  inplace_vector<T, N>::construct_at_end(size_type count, Args&&... args)
+  {
+    for (; count != 0; --count) {
+      storage_.construct(end_(), std::forward<Args>(args)...);
+      storage_.set_size(size() + 1);
+    }
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 void
+  inplace_vector<T, N>::destroy_at_end(pointer new_end) noexcept
+  {
+    for (pointer p = new_end; p != end_(); ++p) {
+      storage_.destroy(p);
+    }
+    storage_.set_size(new_end - data());
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 void
+  inplace_vector<T, N>::ensure_spare_capacity(size_type count) const
+  {
+    if (count > N - size()) {
+      throw_bad_alloc();
+    }
+  }
+
+  template <typename T, std::size_t N>
+  template <typename InputIt>
+  FTL_CONSTEXPR_SINCE_CXX20 void inplace_vector<T, N>::assign_range(
+      InputIt first, InputIt last, std::input_iterator_tag)
+  {
+    clear();
+    for (; first != last; ++first) {
+      emplace_back(*first);
+    }
+  }
+
+  template <typename T, std::size_t N>
+  template <typename ForwardIt>
+  FTL_CONSTEXPR_SINCE_CXX20 void inplace_vector<T, N>::assign_range(
+      ForwardIt first, ForwardIt last, std::forward_iterator_tag)
+  {
+    const auto count = static_cast<size_type>(std::distance(first, last));
+    if (count > N) {
+      throw_bad_alloc();
+    }
+    if (count > size()) {
+      ForwardIt middle = first;
+      std::advance(middle, size());
+      std::copy(first, middle, data());
+      construct_at_end(middle, last);
+    } else {
+      destroy_at_end(std::copy(first, last, data()));
+    }
+  }
+
+  template <typename T, std::size_t N>
+  template <typename InputIt>
+  FTL_CONSTEXPR_SINCE_CXX20 typename inplace_vector<T, N>::pointer
+  inplace_vector<T, N>::insert_range(pointer position, InputIt first,
+      InputIt last, std::input_iterator_tag)
+  {
+    const difference_type offset = position - data();
+    const size_type old_size = size();
+    for (; first != last; ++first) {
+      emplace_back(*first);
+    }
+    std::rotate(data() + offset, data() + old_size, end_());
+    return data() + offset;
+  }
+
+  // Elements that land past the old end are constructed there first, then
+  // the tail is shifted right once and the gap it leaves is overwritten.
+  template <typename T, std::size_t N>
+  template <typename ForwardIt>
+  FTL_CONSTEXPR_SINCE_CXX20 typename inplace_vector<T, N>::pointer
+  inplace_vector<T, N>::insert_range(pointer position, ForwardIt first,
+      ForwardIt last, std::forward_iterator_tag)
+  {
+    const auto count = static_cast<size_type>(std::distance(first, last));
+    if (count == 0) {
+      return position;
+    }
+    ensure_spare_capacity(count);
+    pointer old_end = end_();
+    const size_type tail = old_end - position;
+    ForwardIt middle = last;
+    if (count > tail) {
+      middle = first;
+      std::advance(middle, tail);
+      construct_at_end(middle, last);
+    }
+    if (tail != 0) {
+      move_right(position, old_end, position + count);
+      std::copy(first, middle, position);
+    }
+    return position;
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 typename inplace_vector<T, N>::pointer
+  inplace_vector<T, N>::insert_fill(pointer position, size_type count,
+      const_reference value)
+  {
+    if (count == 0) {
+      return position;
+    }
+    ensure_spare_capacity(count);
+    pointer old_end = end_();
+    const size_type tail = old_end - position;
+    if (count > tail) {
+      construct_at_end(count - tail, value);
+    }
+    if (tail != 0) {
+      // value may refer to an element that is about to be shifted.
+      value_type copy(value);
+      move_right(position, old_end, position + count);
+      std::fill_n(position, std::min(count, tail), copy);
+    }
+    return position;
+  }
+
+  // Shifts [first, last) to start at out: the part landing past the end is
+  // move constructed there, the rest is move assigned back to front.
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 void
+  inplace_vector<T, N>::move_right(pointer first, pointer last, pointer out)
+  {
+    pointer old_end = end_();
+    pointer split = first + (old_end - out);
+    construct_at_end(std::make_move_iterator(split),
+        std::make_move_iterator(last));
+    std::move_backward(first, split, old_end);
+  }
+
+  template <typename T, std::size_t N>
+  void inplace_vector<T, N>::throw_out_of_range() const
+  {
+    throw std::out_of_range("ftl::inplace_vector out_of_range");
+  }
+
+  template <typename T, std::size_t N>
+  void inplace_vector<T, N>::throw_bad_alloc() const
+  {
+    throw std::bad_alloc();
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 void
+  swap(inplace_vector<T, N>& lhs,
+      inplace_vector<T, N>& rhs) noexcept(noexcept(lhs.swap(rhs)))
+  {
+    lhs.swap(rhs);
+  }
+
+  template <typename T, std::size_t N>
+  FTL_CONSTEXPR_SINCE_CXX20 bool operator==(const inplace_vector<T, N>& lhs,
+      const inplace_vector<T, N>& rhs)
+  {
+    const bool is_same_size = lhs.size() == rhs.size();
+    return is_same_size && std::equal(lhs.cbegin(), lhs.cend(), rhs.cbegin());
+  }
+
+#if !defined(FTL_CPP20_FEATURES)
+
+  template <typename T, std::size_t N>
+  bool operator!=(const inplace_vector<T, N>& lhs,
+      const inplace_vector<T, N>& rhs)
+  {
+    return !(lhs == rhs);
+  }
+
+  template <typename T, std::size_t N>
+  bool
+  operator<(const inplace_vector<T, N>& l, const inplace_vector<T, N>& r)
+  {
+    return std::lexicographical_compare(l.cbegin(), l.cend(), r.cbegin(),
+        r.cend());
+  }
+
+  template <typename T, std::size_t N>
+  bool operator>(const inplace_vector<T, N>& lhs,
+      const inplace_vector<T, N>& rhs)
+  {
+    return rhs < lhs;
+  }
+
+  template <typename T, std::size_t N>
+  bool operator<=(const inplace_vector<T, N>& lhs,
+      const inplace_vector<T, N>& rhs)
+  {
+    return !(lhs > rhs);
+  }
+
+  template <typename T, std::size_t N>
+  bool operator>=(const inplace_vector<T, N>& lhs,
+      const inplace_vector<T, N>& rhs)
+  {
+    return !(lhs < rhs);
+  }
+
+#else
+
+  template <typename T, std::size_t N>
+  constexpr auto operator<=>(const inplace_vector<T, N>& lhs,
+      const inplace_vector<T, N>& rhs)
+  {
+    return std::lexicographical_compare_three_way(lhs.cbegin(), lhs.cend(),
+        rhs.cbegin(), rhs.cend());
+  }
+
+#endif
+}
+
+namespace std {
+  template <typename T, std::size_t N>
+  struct hash<ftl::inplace_vector<T, N>>
+  {
+    size_t operator()(const ftl::inplace_vector<T, N>& vec) const
+    {
+      return ftl::detail::hash_contiguous(vec);
+    }
+  };
+}
+
+#endif
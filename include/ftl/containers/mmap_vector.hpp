@@ -0,0 +1,545 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_CONTAINERS_MMAP_VECTOR_HPP
+#define FTL_CONTAINERS_MMAP_VECTOR_HPP
+
+#include "../internal/config.hpp"
+
+#if defined(FTL_POSIX_FEATURES)
+
+#  include <algorithm>
+#  include <cerrno>
+#  include <cstddef>
+#  include <iterator>
+#  include <limits>
+#  include <stdexcept>
+#  include <string>
+#  include <system_error>
+#  include <type_traits>
+#  include <utility>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  include "../internal/growth_policy.hpp"
+#  include "../internal/wrap_iterator.hpp"
+#  include "../memory/mmap_allocator.hpp"
+
+namespace ftl {
+
+  enum class mmap_mode
+  {
+    // Maps an existing file for reading; the vector cannot be modified.
+    read_only,
+    // Maps a file for reading and writing, creating it if it is missing.
+    // Changes reach the file through the page cache.
+    read_write
+  };
+
+  // Access patterns passed on to madvise.
+  enum class mmap_advice
+  {
+    normal,
+    sequential,
+    random,
+    willneed,
+    dontneed
+  };
+
+  namespace detail {
+
+    [[noreturn]] inline void throw_mmap_error(const char* what)
+    {
+      throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    inline void* mmap_map_file(int fd, std::size_t length, bool writable)
+    {
+      void* p = ::mmap(nullptr, length,
+          writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+      if (p == MAP_FAILED) {
+        throw_mmap_error("ftl::mmap_vector mmap");
+      }
+      return p;
+    }
+
+    inline int mmap_advice_flag(mmap_advice advice) noexcept
+    {
+      switch (advice) {
+      case mmap_advice::sequential:
+        return MADV_SEQUENTIAL;
+      case mmap_advice::random:
+        return MADV_RANDOM;
+      case mmap_advice::willneed:
+        return MADV_WILLNEED;
+      case mmap_advice::dontneed:
+        return MADV_DONTNEED;
+      default:
+        return MADV_NORMAL;
+      }
+    }
+  }
+
+  // A vector whose elements live in a file mapped into memory, for arrays
+  // too large to read and copy at startup. Opening a file maps it and
+  // nothing else: pages are read on first access, and advise() tells the
+  // kernel to read ahead or drop them. The read interface matches
+  // ftl::vector.
+  //
+  // In read_write mode the vector grows like ftl::vector, except that the
+  // file is extended with ftruncate and the mapping with mremap, so growth
+  // never copies the elements. The file is cut back to size() elements when
+  // the vector is closed; until then it holds capacity() whole elements, so
+  // a file whose vector was never closed still opens, with the elements past
+  // size() reading as zero. sync() writes dirty pages back with msync.
+  //
+  // In read_only mode the file is mapped without write access, so only the
+  // const interface may be used: the non-const accessors and every member
+  // that changes the size throw std::logic_error instead of handing out
+  // references that would fault when written through.
+  //
+  // Elements are stored as raw bytes in the file, so T must be trivially
+  // copyable, and the file is only portable between machines with the same
+  // layout for T.
+  template <typename T>
+  class mmap_vector final
+  {
+    static_assert(std::is_trivially_copyable<T>::value,
+        "ftl::mmap_vector needs trivially copyable elements");
+
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = detail::wrap_iterator<pointer>;
+    using const_iterator = detail::wrap_iterator<const_pointer>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    mmap_vector() noexcept;
+    explicit mmap_vector(const std::string& path,
+        mmap_mode mode = mmap_mode::read_only);
+    mmap_vector(const mmap_vector&) = delete;
+    mmap_vector(mmap_vector&&) noexcept;
+    ~mmap_vector();
+
+    mmap_vector& operator=(const mmap_vector&) = delete;
+    mmap_vector& operator=(mmap_vector&&) noexcept;
+
+    void open(const std::string&, mmap_mode = mmap_mode::read_only);
+    void close();
+    bool is_open() const noexcept { return fd_ != -1; }
+    bool writable() const noexcept { return mode_ == mmap_mode::read_write; }
+
+    reference operator[](size_type i) { return mutable_data()[i]; }
+    const_reference operator[](size_type i) const noexcept { return data_[i]; }
+    reference at(size_type);
+    const_reference at(size_type) const;
+
+    reference front() { return *mutable_data(); }
+    reference back() { return mutable_data()[size_ - 1]; }
+    const_reference front() const noexcept { return *data_; }
+    const_reference back() const noexcept { return data_[size_ - 1]; }
+    pointer data() { return mutable_data(); }
+    const_pointer data() const noexcept { return data_; }
+
+    iterator begin() { return iterator(mutable_data()); }
+    iterator end() { return iterator(mutable_data() + size_); }
+    const_iterator begin() const noexcept { return const_iterator(data_); }
+    const_iterator end() const noexcept
+    {
+      return const_iterator(data_ + size_);
+    }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const noexcept
+    {
+      return const_reverse_iterator(end());
+    }
+    const_reverse_iterator rend() const noexcept
+    {
+      return const_reverse_iterator(begin());
+    }
+    const_reverse_iterator crbegin() const noexcept
+    {
+      return const_reverse_iterator(end());
+    }
+    const_reverse_iterator crend() const noexcept
+    {
+      return const_reverse_iterator(begin());
+    }
+
+    bool empty() const noexcept { return size_ == 0; }
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept { return capacity_; }
+    size_type max_size() const noexcept
+    {
+      return static_cast<size_type>(std::numeric_limits<off_t>::max()) /
+          sizeof(T);
+    }
+
+    void reserve(size_type);
+    void resize(size_type);
+    void resize(size_type, const_reference);
+    void push_back(const_reference);
+    void pop_back();
+    void clear();
+    void swap(mmap_vector&) noexcept;
+
+    void sync(bool async = false);
+    void advise(mmap_advice);
+    void advise(mmap_advice, size_type first, size_type count);
+
+  private:
+    T* data_;
+    size_type size_;
+    size_type capacity_;
+    std::size_t length_;
+    int fd_;
+    mmap_mode mode_;
+
+    void grow_to(size_type);
+    void remap(size_type);
+    pointer mutable_data() const;
+    void check_writable() const;
+    void throw_out_of_range() const;
+    void throw_length_error() const;
+  };
+
+  template <typename T>
+  mmap_vector<T>::mmap_vector() noexcept :
+    data_(nullptr),
+    size_(0),
+    capacity_(0),
+    length_(0),
+    fd_(-1),
+    mode_(mmap_mode::read_only)
+  {
+  }
+
+  template <typename T>
+  mmap_vector<T>::mmap_vector(const std::string& path, mmap_mode mode) :
+    mmap_vector()
+  {
+    open(path, mode);
+  }
+
+  template <typename T>
+  mmap_vector<T>::mmap_vector(mmap_vector&& rhs) noexcept :
+    data_(std::exchange(rhs.data_, nullptr)),
+    size_(std::exchange(rhs.size_, 0)),
+    capacity_(std::exchange(rhs.capacity_, 0)),
+    length_(std::exchange(rhs.length_, 0)),
+    fd_(std::exchange(rhs.fd_, -1)),
+    mode_(rhs.mode_)
+  {
+  }
+
+  // Errors while cutting the file back cannot be reported from here; call
+  // close() first to see them.
+  template <typename T>
+  mmap_vector<T>::~mmap_vector()
+  {
+    try {
+      close();
+    } catch (...) {
+    }
+  }
+
+  template <typename T>
+  mmap_vector<T>& mmap_vector<T>::operator=(mmap_vector&& rhs) noexcept
+  {
+    if (this != &rhs) {
+      mmap_vector temp(std::move(rhs));
+      swap(temp);
+    }
+    return *this;
+  }
+
+  template <typename T>
+  void mmap_vector<T>::open(const std::string& path, mmap_mode mode)
+  {
+    close();
+    const bool writable = mode == mmap_mode::read_write;
+    const int fd = writable ? ::open(path.c_str(), O_RDWR | O_CREAT, 0644)
+                            : ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+      detail::throw_mmap_error("ftl::mmap_vector open");
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+      const int error = errno;
+      ::close(fd);
+      errno = error;
+      detail::throw_mmap_error("ftl::mmap_vector fstat");
+    }
+    const auto bytes = static_cast<std::size_t>(info.st_size);
+    if (bytes % sizeof(T) != 0) {
+      ::close(fd);
+      throw std::invalid_argument("ftl::mmap_vector file size mismatch");
+    }
+    if (bytes != 0) {
+      try {
+        data_ = static_cast<T*>(detail::mmap_map_file(fd, bytes, writable));
+      } catch (...) {
+        ::close(fd);
+        throw;
+      }
+    }
+    fd_ = fd;
+    mode_ = mode;
+    length_ = bytes;
+    size_ = bytes / sizeof(T);
+    capacity_ = size_;
+  }
+
+  // Unmaps the file and, in read_write mode, cuts it back to the elements
+  // in use. The vector is empty and closed afterwards even if that fails.
+  template <typename T>
+  void mmap_vector<T>::close()
+  {
+    if (fd_ == -1) {
+      return;
+    }
+    if (length_ != 0) {
+      ::munmap(data_, length_);
+    }
+    const int fd = std::exchange(fd_, -1);
+    const bool truncate = writable() && capacity_ != size_;
+    const auto bytes = static_cast<off_t>(size_ * sizeof(T));
+    data_ = nullptr;
+    size_ = 0;
+    capacity_ = 0;
+    length_ = 0;
+    const bool truncated = !truncate || ::ftruncate(fd, bytes) == 0;
+    const int error = errno;
+    ::close(fd);
+    if (!truncated) {
+      errno = error;
+      detail::throw_mmap_error("ftl::mmap_vector ftruncate");
+    }
+  }
+
+  template <typename T>
+  typename mmap_vector<T>::reference mmap_vector<T>::at(size_type i)
+  {
+    if (i >= size_) {
+      throw_out_of_range();
+    }
+    return mutable_data()[i];
+  }
+
+  template <typename T>
+  typename mmap_vector<T>::const_reference mmap_vector<T>::at(
+      size_type i) const
+  {
+    if (i >= size_) {
+      throw_out_of_range();
+    }
+    return data_[i];
+  }
+
+  template <typename T>
+  void mmap_vector<T>::reserve(size_type capacity)
+  {
+    check_writable();
+    if (capacity > capacity_) {
+      if (capacity > max_size()) {
+        throw_length_error();
+      }
+      remap(capacity);
+    }
+  }
+
+  template <typename T>
+  void mmap_vector<T>::resize(size_type size)
+  {
+    resize(size, T());
+  }
+
+  template <typename T>
+  void mmap_vector<T>::resize(size_type size, const_reference value)
+  {
+    check_writable();
+    if (size > capacity_) {
+      const T copy = value;
+      grow_to(size);
+      std::fill(data_ + size_, data_ + size, copy);
+    } else if (size > size_) {
+      std::fill(data_ + size_, data_ + size, value);
+    }
+    size_ = size;
+  }
+
+  template <typename T>
+  void mmap_vector<T>::push_back(const_reference value)
+  {
+    check_writable();
+    if (size_ == capacity_) {
+      const T copy = value;
+      grow_to(size_ + 1);
+      data_[size_++] = copy;
+    } else {
+      data_[size_++] = value;
+    }
+  }
+
+  template <typename T>
+  void mmap_vector<T>::pop_back()
+  {
+    check_writable();
+    --size_;
+  }
+
+  template <typename T>
+  void mmap_vector<T>::clear()
+  {
+    check_writable();
+    size_ = 0;
+  }
+
+  template <typename T>
+  void mmap_vector<T>::swap(mmap_vector& rhs) noexcept
+  {
+    std::swap(data_, rhs.data_);
+    std::swap(size_, rhs.size_);
+    std::swap(capacity_, rhs.capacity_);
+    std::swap(length_, rhs.length_);
+    std::swap(fd_, rhs.fd_);
+    std::swap(mode_, rhs.mode_);
+  }
+
+  template <typename T>
+  void mmap_vector<T>::sync(bool async)
+  {
+    if (writable() && length_ != 0 &&
+        ::msync(data_, length_, async ? MS_ASYNC : MS_SYNC) != 0) {
+      detail::throw_mmap_error("ftl::mmap_vector msync");
+    }
+  }
+
+  template <typename T>
+  void mmap_vector<T>::advise(mmap_advice advice)
+  {
+    if (length_ != 0 &&
+        ::madvise(data_, length_, detail::mmap_advice_flag(advice)) != 0) {
+      detail::throw_mmap_error("ftl::mmap_vector madvise");
+    }
+  }
+
+  // madvise works on whole pages, so the range is widened to the pages
+  // that hold it.
+  template <typename T>
+  void mmap_vector<T>::advise(mmap_advice advice, size_type first,
+      size_type count)
+  {
+    if (first > size_ || count > size_ - first) {
+      throw_out_of_range();
+    }
+    if (count == 0) {
+      return;
+    }
+    const std::size_t page = detail::mmap_page_size();
+    const std::size_t begin = first * sizeof(T) / page * page;
+    const std::size_t end = (first + count) * sizeof(T);
+    char* base = reinterpret_cast<char*>(data_);
+    if (::madvise(base + begin, end - begin,
+            detail::mmap_advice_flag(advice)) != 0) {
+      detail::throw_mmap_error("ftl::mmap_vector madvise");
+    }
+  }
+
+  template <typename T>
+  void mmap_vector<T>::grow_to(size_type required)
+  {
+    if (required > max_size()) {
+      throw_length_error();
+    }
+    remap(growth_factor_2::recommend<T>(capacity_, required, max_size()));
+  }
+
+  // Extends the file, then the mapping. mremap keeps the pages in place or
+  // moves them without copying; elsewhere the file is simply mapped again,
+  // since its contents are the elements. The mapping covers whole pages,
+  // but the file only grows to the whole elements that fit in them. If the
+  // mapping fails the file is cut back to the old capacity.
+  template <typename T>
+  void mmap_vector<T>::remap(size_type capacity)
+  {
+    const std::size_t length = detail::mmap_length(capacity * sizeof(T),
+        false);
+    capacity = length / sizeof(T);
+    if (::ftruncate(fd_, static_cast<off_t>(capacity * sizeof(T))) != 0) {
+      detail::throw_mmap_error("ftl::mmap_vector ftruncate");
+    }
+    void* p = nullptr;
+    if (length_ != 0) {
+      p = detail::mmap_remap(data_, length_, length, true);
+    }
+    if (p == nullptr) {
+      try {
+        p = detail::mmap_map_file(fd_, length, true);
+      } catch (...) {
+        const int shrunk =
+            ::ftruncate(fd_, static_cast<off_t>(capacity_ * sizeof(T)));
+        static_cast<void>(shrunk);
+        throw;
+      }
+      if (length_ != 0) {
+        ::munmap(data_, length_);
+      }
+    }
+    data_ = static_cast<T*>(p);
+    length_ = length;
+    capacity_ = capacity;
+  }
+
+  // An empty mapping hands out nothing to write through, so closed and
+  // empty vectors pass in either mode.
+  template <typename T>
+  typename mmap_vector<T>::pointer mmap_vector<T>::mutable_data() const
+  {
+    if (length_ != 0) {
+      check_writable();
+    }
+    return data_;
+  }
+
+  template <typename T>
+  void mmap_vector<T>::check_writable() const
+  {
+    if (!writable()) {
+      throw std::logic_error("ftl::mmap_vector is read_only");
+    }
+  }
+
+  template <typename T>
+  void mmap_vector<T>::throw_out_of_range() const
+  {
+    throw std::out_of_range("ftl::mmap_vector out_of_range");
+  }
+
+  template <typename T>
+  void mmap_vector<T>::throw_length_error() const
+  {
+    throw std::length_error("ftl::mmap_vector length_error");
+  }
+
+  template <typename T>
+  void swap(mmap_vector<T>& lhs, mmap_vector<T>& rhs) noexcept
+  {
+    lhs.swap(rhs);
+  }
+}
+
+#endif
+
+#endif
@@ -0,0 +1,573 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_CONTAINERS_SEGMENTED_VECTOR_HPP
+#define FTL_CONTAINERS_SEGMENTED_VECTOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "../internal/compare.hpp"
+#include "../internal/config.hpp"
+#include "../internal/index_iterator.hpp"
+#include "../internal/type_traits.hpp"
+#include "vector.hpp"
+
+#if defined(FTL_CPP20_FEATURES)
+#  include <compare>
+#endif
+
+namespace ftl {
+  namespace detail {
+
+    // The largest power of two that keeps a segment within 4 KiB, but at
+    // least 16 elements.
+    template <typename T>
+    constexpr std::size_t default_segment_size() noexcept
+    {
+      std::size_t size = 16;
+      while (size * 2 * sizeof(T) <= 4096) {
+        size *= 2;
+      }
+      return size;
+    }
+  }
+
+  // A vector that stores its elements in fixed-size segments reached
+  // through an index of segment pointers. Appending never moves an
+  // element: a full vector gets one more segment, so references and
+  // pointers to elements stay valid until the element is removed, and
+  // elements need not be movable at all. Indexing costs a shift and a mask
+  // more than for ftl::vector, and for_each_segment() hands out each
+  // segment as a contiguous range for loops that should vectorize.
+  //
+  // SegmentSize must be a power of two. Segments are kept after clear()
+  // and pop_back() for reuse until shrink_to_fit().
+  template <typename T,
+      std::size_t SegmentSize = detail::default_segment_size<T>()>
+  class segmented_vector final
+  {
+    static_assert(SegmentSize != 0 && (SegmentSize & (SegmentSize - 1)) == 0,
+        "ftl::segmented_vector segment size must be a power of two");
+
+  public:
+    using value_type = T;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = detail::index_iterator<segmented_vector, value_type>;
+    using const_iterator =
+        detail::index_iterator<const segmented_vector, const value_type>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    static constexpr size_type segment_size = SegmentSize;
+
+    segmented_vector() noexcept = default;
+    segmented_vector(const segmented_vector&);
+    segmented_vector(segmented_vector&&) noexcept;
+    explicit segmented_vector(size_type);
+    segmented_vector(size_type, const_reference);
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    segmented_vector(InputIt, InputIt);
+    segmented_vector(std::initializer_list<value_type>);
+    ~segmented_vector();
+
+    segmented_vector& operator=(const segmented_vector&);
+    segmented_vector& operator=(segmented_vector&&) noexcept;
+    segmented_vector& operator=(std::initializer_list<value_type>);
+
+    reference operator[](size_type i) noexcept
+    {
+      return segments_[i / SegmentSize][i % SegmentSize];
+    }
+
+    const_reference operator[](size_type i) const noexcept
+    {
+      return segments_[i / SegmentSize][i % SegmentSize];
+    }
+
+    reference at(size_type);
+    const_reference at(size_type) const;
+
+    reference front() noexcept { return segments_[0][0]; }
+    reference back() noexcept { return (*this)[size_ - 1]; }
+    const_reference front() const noexcept { return segments_[0][0]; }
+    const_reference back() const noexcept { return (*this)[size_ - 1]; }
+
+    void reserve(size_type);
+    void resize(size_type);
+    void resize(size_type, const_reference);
+    void shrink_to_fit();
+    void clear() noexcept;
+    void swap(segmented_vector&) noexcept;
+
+    void push_back(const_reference value) { emplace_back(value); }
+    void push_back(value_type&& value) { emplace_back(std::move(value)); }
+    template <typename... Args>
+    reference emplace_back(Args&&...);
+    void pop_back() noexcept;
+
+    // Calls f(first, last) for every segment in use, in order, with the
+    // elements of the segment as a pointer range.
+    template <typename F>
+    void for_each_segment(F f);
+    template <typename F>
+    void for_each_segment(F f) const;
+
+    iterator begin() noexcept { return iterator(this, 0); }
+    iterator end() noexcept { return iterator(this, size_); }
+    const_iterator begin() const noexcept { return const_iterator(this, 0); }
+    const_iterator end() const noexcept { return const_iterator(this, size_); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const noexcept;
+    const_reverse_iterator rend() const noexcept;
+    const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+    const_reverse_iterator crend() const noexcept { return rend(); }
+
+    bool empty() const noexcept { return size_ == 0; }
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept
+    {
+      return segments_.size() * SegmentSize;
+    }
+    size_type max_size() const noexcept;
+
+  private:
+    ftl::vector<pointer> segments_;
+    size_type size_ = 0;
+
+    pointer slot(size_type i) noexcept
+    {
+      return segments_[i / SegmentSize] + i % SegmentSize;
+    }
+
+    void add_segment();
+    void release() noexcept;
+    void destroy_from(size_type) noexcept;
+
+    template <typename InputIt>
+    void append_range(InputIt, InputIt);
+
+    void throw_out_of_range() const;
+    void throw_length_error() const;
+  };
+
+  template <typename T, std::size_t SegmentSize>
+  constexpr typename segmented_vector<T, SegmentSize>::size_type
+      segmented_vector<T, SegmentSize>::segment_size;
+
+  template <typename T, std::size_t SegmentSize>
+  segmented_vector<T, SegmentSize>::segmented_vector(
+      const segmented_vector& rhs)
+  {
+    try {
+      reserve(rhs.size_);
+      rhs.for_each_segment([this](const_pointer first, const_pointer last) {
+        append_range(first, last);
+      });
+    } catch (...) {
+      release();
+      throw;
+    }
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  segmented_vector<T, SegmentSize>::segmented_vector(
+      segmented_vector&& rhs) noexcept :
+    segments_(std::move(rhs.segments_)),
+    size_(std::exchange(rhs.size_, 0))
+  {
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  segmented_vector<T, SegmentSize>::segmented_vector(size_type size)
+  {
+    try {
+      resize(size);
+    } catch (...) {
+      release();
+      throw;
+    }
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  segmented_vector<T, SegmentSize>::segmented_vector(size_type size,
+      const_reference value)
+  {
+    try {
+      resize(size, value);
+    } catch (...) {
+      release();
+      throw;
+    }
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
+  segmented_vector<T, SegmentSize>::segmented_vector(InputIt first,
+      InputIt last)
+  {
+    try {
+      append_range(first, last);
+    } catch (...) {
+      release();
+      throw;
+    }
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  segmented_vector<T, SegmentSize>::segmented_vector(
+      std::initializer_list<value_type> list)
+  {
+    try {
+      reserve(list.size());
+      append_range(list.begin(), list.end());
+    } catch (...) {
+      release();
+      throw;
+    }
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  segmented_vector<T, SegmentSize>::~segmented_vector()
+  {
+    release();
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  segmented_vector<T, SegmentSize>& segmented_vector<T, SegmentSize>::operator=(
+      const segmented_vector& rhs)
+  {
+    if (this != &rhs) {
+      clear();
+      reserve(rhs.size_);
+      rhs.for_each_segment([this](const_pointer first, const_pointer last) {
+        append_range(first, last);
+      });
+    }
+    return *this;
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  segmented_vector<T, SegmentSize>& segmented_vector<T, SegmentSize>::operator=(
+      segmented_vector&& rhs) noexcept
+  {
+    if (this != &rhs) {
+      release();
+      segments_ = std::move(rhs.segments_);
+      size_ = std::exchange(rhs.size_, 0);
+    }
+    return *this;
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  segmented_vector<T, SegmentSize>& segmented_vector<T, SegmentSize>::operator=(
+      std::initializer_list<value_type> list)
+  {
+    clear();
+    reserve(list.size());
+    append_range(list.begin(), list.end());
+    return *this;
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  typename segmented_vector<T, SegmentSize>::reference
+  segmented_vector<T, SegmentSize>::at(size_type i)
+  {
+    if (i >= size_) {
+      throw_out_of_range();
+    }
+    return (*this)[i];
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  typename segmented_vector<T, SegmentSize>::const_reference
+  segmented_vector<T, SegmentSize>::at(size_type i) const
+  {
+    if (i >= size_) {
+      throw_out_of_range();
+    }
+    return (*this)[i];
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  void segmented_vector<T, SegmentSize>::reserve(size_type n)
+  {
+    if (n > max_size()) {
+      throw_length_error();
+    }
+    if (n > capacity()) {
+      segments_.reserve((n + SegmentSize - 1) / SegmentSize);
+      while (capacity() < n) {
+        add_segment();
+      }
+    }
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  void segmented_vector<T, SegmentSize>::resize(size_type n)
+  {
+    if (n <= size_) {
+      destroy_from(n);
+      return;
+    }
+    reserve(n);
+    for (; size_ != n; ++size_) {
+      ::new (static_cast<void*>(slot(size_))) value_type();
+    }
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  void segmented_vector<T, SegmentSize>::resize(size_type n,
+      const_reference value)
+  {
+    if (n <= size_) {
+      destroy_from(n);
+      return;
+    }
+    reserve(n);
+    for (; size_ != n; ++size_) {
+      ::new (static_cast<void*>(slot(size_))) value_type(value);
+    }
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  void segmented_vector<T, SegmentSize>::shrink_to_fit()
+  {
+    const size_type used = (size_ + SegmentSize - 1) / SegmentSize;
+    while (segments_.size() != used) {
+      std::allocator<value_type>().deallocate(segments_.back(), SegmentSize);
+      segments_.pop_back();
+    }
+    segments_.shrink_to_fit();
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  void segmented_vector<T, SegmentSize>::clear() noexcept
+  {
+    destroy_from(0);
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  void segmented_vector<T, SegmentSize>::swap(segmented_vector& rhs) noexcept
+  {
+    segments_.swap(rhs.segments_);
+    std::swap(size_, rhs.size_);
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  template <typename... Args>
+  typename segmented_vector<T, SegmentSize>::reference
+  segmented_vector<T, SegmentSize>::emplace_back(Args&&... args)
+  {
+    if (size_ == capacity()) {
+      add_segment();
+    }
+    pointer p = slot(size_);
+    ::new (static_cast<void*>(p)) value_type(std::forward<Args>(args)...);
+    ++size_;
+    return *p;
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  void segmented_vector<T, SegmentSize>::pop_back() noexcept
+  {
+    --size_;
+    slot(size_)->~value_type();
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  template <typename F>
+  void segmented_vector<T, SegmentSize>::for_each_segment(F f)
+  {
+    const size_type full = size_ / SegmentSize;
+    for (size_type k = 0; k != full; ++k) {
+      f(segments_[k], segments_[k] + SegmentSize);
+    }
+    if (size_ % SegmentSize != 0) {
+      f(segments_[full], segments_[full] + size_ % SegmentSize);
+    }
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  template <typename F>
+  void segmented_vector<T, SegmentSize>::for_each_segment(F f) const
+  {
+    const size_type full = size_ / SegmentSize;
+    for (size_type k = 0; k != full; ++k) {
+      f(const_pointer(segments_[k]), const_pointer(segments_[k] + SegmentSize));
+    }
+    if (size_ % SegmentSize != 0) {
+      f(const_pointer(segments_[full]),
+          const_pointer(segments_[full] + size_ % SegmentSize));
+    }
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  typename segmented_vector<T, SegmentSize>::const_reverse_iterator
+  segmented_vector<T, SegmentSize>::rbegin() const noexcept
+  {
+    return const_reverse_iterator(end());
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  typename segmented_vector<T, SegmentSize>::const_reverse_iterator
+  segmented_vector<T, SegmentSize>::rend() const noexcept
+  {
+    return const_reverse_iterator(begin());
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  typename segmented_vector<T, SegmentSize>::size_type
+  segmented_vector<T, SegmentSize>::max_size() const noexcept
+  {
+    return std::min(segments_.max_size(),
+               std::allocator_traits<std::allocator<value_type>>::max_size(
+                   std::allocator<value_type>()) /
+                   SegmentSize) *
+        SegmentSize;
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  void segmented_vector<T, SegmentSize>::add_segment()
+  {
+    pointer segment = std::allocator<value_type>().allocate(SegmentSize);
+    try {
+      segments_.push_back(segment);
+    } catch (...) {
+      std::allocator<value_type>().deallocate(segment, SegmentSize);
+      throw;
+    }
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  void segmented_vector<T, SegmentSize>::release() noexcept
+  {
+    clear();
+    for (pointer segment : segments_) {
+      std::allocator<value_type>().deallocate(segment, SegmentSize);
+    }
+    segments_.clear();
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  void segmented_vector<T, SegmentSize>::destroy_from(size_type n) noexcept
+  {
+    while (size_ != n) {
+      pop_back();
+    }
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  template <typename InputIt>
+  void segmented_vector<T, SegmentSize>::append_range(InputIt first,
+      InputIt last)
+  {
+    for (; first != last; ++first) {
+      emplace_back(*first);
+    }
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  void segmented_vector<T, SegmentSize>::throw_out_of_range() const
+  {
+    throw std::out_of_range("ftl::segmented_vector out_of_range");
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  void segmented_vector<T, SegmentSize>::throw_length_error() const
+  {
+    throw std::length_error("ftl::segmented_vector length_error");
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  void swap(segmented_vector<T, SegmentSize>& lhs,
+      segmented_vector<T, SegmentSize>& rhs) noexcept
+  {
+    lhs.swap(rhs);
+  }
+
+  // Both sides split their elements at the same indices, so equality can
+  // compare whole segments with the contiguous fast paths.
+  template <typename T, std::size_t SegmentSize>
+  bool operator==(const segmented_vector<T, SegmentSize>& lhs,
+      const segmented_vector<T, SegmentSize>& rhs)
+  {
+    if (lhs.size() != rhs.size()) {
+      return false;
+    }
+    for (std::size_t i = 0; i < lhs.size(); i += SegmentSize) {
+      const std::size_t n = std::min(SegmentSize, lhs.size() - i);
+      if (!detail::contiguous_equal(&lhs[i], &rhs[i], n)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+#if !defined(FTL_CPP20_FEATURES)
+
+  template <typename T, std::size_t SegmentSize>
+  bool operator!=(const segmented_vector<T, SegmentSize>& lhs,
+      const segmented_vector<T, SegmentSize>& rhs)
+  {
+    return !(lhs == rhs);
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  bool operator<(const segmented_vector<T, SegmentSize>& lhs,
+      const segmented_vector<T, SegmentSize>& rhs)
+  {
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(),
+        rhs.end());
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  bool operator>(const segmented_vector<T, SegmentSize>& lhs,
+      const segmented_vector<T, SegmentSize>& rhs)
+  {
+    return rhs < lhs;
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  bool operator<=(const segmented_vector<T, SegmentSize>& lhs,
+      const segmented_vector<T, SegmentSize>& rhs)
+  {
+    return !(lhs > rhs);
+  }
+
+  template <typename T, std::size_t SegmentSize>
+  bool operator>=(const segmented_vector<T, SegmentSize>& lhs,
+      const segmented_vector<T, SegmentSize>& rhs)
+  {
+    return !(lhs < rhs);
+  }
+
+#else
+
+  template <typename T, std::size_t SegmentSize>
+  auto operator<=>(const segmented_vector<T, SegmentSize>& lhs,
+      const segmented_vector<T, SegmentSize>& rhs)
+  {
+    return std::lexicographical_compare_three_way(lhs.begin(), lhs.end(),
+        rhs.begin(), rhs.end());
+  }
+
+#endif
+}
+
+#endif
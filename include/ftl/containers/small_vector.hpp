@@ -0,0 +1,1399 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_CONTAINERS_SMALL_VECTOR_HPP
+#define FTL_CONTAINERS_SMALL_VECTOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include "../internal/compare.hpp"
+#include "../internal/compressed_pair.hpp"
+#include "../internal/exception_guard.hpp"
+#include "../internal/hash.hpp"
+#include "../internal/relocate.hpp"
+#include "../internal/type_traits.hpp"
+#include "../internal/uninitialized.hpp"
+#include "../internal/wrap_iterator.hpp"
+
+namespace ftl {
+  namespace detail {
+
+    template <typename T, std::size_t N>
+    class inline_buffer
+    {
+    public:
+      T* data() noexcept { return reinterpret_cast<T*>(bytes_); }
+      const T* data() const noexcept
+      {
+        return reinterpret_cast<const T*>(bytes_);
+      }
+
+    private:
+      alignas(T) unsigned char bytes_[N * sizeof(T)];
+    };
+
+    template <typename T>
+    class inline_buffer<T, 0>
+    {
+    public:
+      T* data() noexcept { return nullptr; }
+      const T* data() const noexcept { return nullptr; }
+    };
+  }
+}
+
+namespace ftl {
+
+  // A vector that keeps up to N elements inside the object and moves them to
+  // an allocated block once it grows past that. Moving or swapping a
+  // small_vector whose elements are stored inline moves the elements.
+  template <typename T, std::size_t N, typename Allocator = std::allocator<T>>
+  class small_vector final
+  {
+  public:
+    using value_type = T;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using allocator_type = Allocator;
+
+  private:
+    using AllocTraits = std::allocator_traits<allocator_type>;
+    using StorageTraits = detail::storage_traits<allocator_type>;
+    using CanRelocate = detail::is_relocatable_with<allocator_type>;
+    using CanSkipInit = detail::is_trivially_default_init_with<allocator_type>;
+    using IsNothrowMovable = std::is_nothrow_move_constructible<value_type>;
+    using PropagateOnCopy =
+        typename AllocTraits::propagate_on_container_copy_assignment;
+    using PropagateOnMove =
+        typename AllocTraits::propagate_on_container_move_assignment;
+    using PropagateOnSwap = typename AllocTraits::propagate_on_container_swap;
+    using CanStealOnMove = std::integral_constant<bool,
+        PropagateOnMove::value || AllocTraits::is_always_equal::value>;
+    using CanStealOnSwap = std::integral_constant<bool,
+        PropagateOnSwap::value || AllocTraits::is_always_equal::value>;
+
+    static_assert(std::is_pointer<typename AllocTraits::pointer>::value,
+        "small_vector requires an allocator with raw pointers");
+
+  public:
+    using pointer = typename AllocTraits::pointer;
+    using const_pointer = typename AllocTraits::const_pointer;
+    using size_type = typename AllocTraits::size_type;
+    using difference_type = typename AllocTraits::difference_type;
+    using iterator = detail::wrap_iterator<pointer>;
+    using const_iterator = detail::wrap_iterator<const_pointer>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    small_vector() : small_vector(allocator_type()) {}
+    small_vector(const small_vector&);
+    small_vector(small_vector&&) noexcept(IsNothrowMovable::value);
+    small_vector(const allocator_type& alloc);
+    small_vector(size_type, const allocator_type& = allocator_type());
+    small_vector(size_type, default_init_t,
+        const allocator_type& = allocator_type());
+    small_vector(size_type, const_reference,
+        const allocator_type& = allocator_type());
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    small_vector(InputIt, InputIt, const allocator_type& = allocator_type());
+    small_vector(std::initializer_list<value_type>,
+        const allocator_type& = allocator_type());
+    ~small_vector();
+
+    small_vector& operator=(const small_vector&) &;
+    small_vector& operator=(small_vector&&) & noexcept(
+        IsNothrowMovable::value && CanStealOnMove::value);
+    reference operator[](size_type i) noexcept;
+    const_reference operator[](size_type i) const noexcept;
+
+    void reserve(size_type);
+    void resize(size_type);
+    void resize(size_type, const_reference);
+    void resize_for_overwrite(size_type);
+    void shrink_to_fit();
+    void clear() noexcept;
+    void swap(small_vector&) noexcept(
+        IsNothrowMovable::value && CanStealOnSwap::value);
+
+    void push_back(const_reference);
+    void push_back(value_type&&);
+    void pop_back();
+
+    reference at(size_type);
+    const_reference at(size_type) const;
+
+    void assign(size_type, const_reference);
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    void assign(InputIt, InputIt);
+    void assign(std::initializer_list<value_type>);
+
+    iterator insert(const_iterator, const_reference);
+    iterator insert(const_iterator, value_type&&);
+    iterator insert(const_iterator, size_type, const_reference);
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    iterator insert(const_iterator, InputIt, InputIt);
+    iterator insert(const_iterator, std::initializer_list<value_type>);
+
+    template <typename... Args>
+    iterator emplace(const_iterator, Args&&...);
+    template <typename... Args>
+    void emplace_back(Args&&...);
+    template <typename Writer>
+    size_type append_uninitialized(size_type, Writer);
+
+    iterator erase(const_iterator);
+    iterator erase(const_iterator, const_iterator);
+
+    reference front() noexcept { return *begin_; }
+    reference back() noexcept { return *(end_ - 1); }
+    pointer data() noexcept { return begin_; }
+    const_reference front() const noexcept { return *begin_; }
+    const_reference back() const noexcept { return *(end_ - 1); }
+    const_pointer data() const noexcept { return begin_; }
+
+    iterator begin() noexcept { return iterator(begin_); }
+    iterator end() noexcept { return iterator(end_); }
+    const_iterator begin() const noexcept { return const_iterator(begin_); }
+    const_iterator end() const noexcept { return const_iterator(end_); }
+    const_iterator cbegin() const noexcept { return const_iterator(begin_); }
+    const_iterator cend() const noexcept { return const_iterator(end_); }
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator crbegin() const noexcept;
+    const_reverse_iterator crend() const noexcept;
+
+    bool empty() const noexcept { return begin_ == end_; }
+    size_type size() const noexcept { return end_ - begin_; }
+    size_type capacity() const noexcept { return end_cap_() - begin_; }
+    size_type max_size() const noexcept;
+    allocator_type get_allocator() const noexcept { return alloc_(); }
+
+    static constexpr size_type inline_capacity() noexcept { return N; }
+    bool is_inline() const noexcept;
+
+  private:
+    class Deleter;
+
+    pointer begin_;
+    pointer end_;
+    detail::compressed_pair<pointer, allocator_type> end_cap_alloc_;
+    detail::inline_buffer<value_type, N> buffer_;
+
+    void allocate(size_type);
+    void deallocate() noexcept;
+    void release_storage() noexcept;
+    void reset_to_inline() noexcept;
+    void steal_or_move(small_vector&);
+    void copy_assign_alloc(const small_vector&, std::true_type);
+    void copy_assign_alloc(const small_vector&, std::false_type) noexcept {}
+    void move_assign(small_vector&, std::true_type) noexcept(
+        IsNothrowMovable::value);
+    void move_assign(small_vector&, std::false_type);
+    void move_assign_alloc(small_vector&, std::true_type) noexcept;
+    void move_assign_alloc(small_vector&, std::false_type) noexcept {}
+    void swap_alloc(small_vector&, std::true_type) noexcept;
+    void swap_alloc(small_vector&, std::false_type) noexcept {}
+
+    template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
+    void construct_at_end(InputIt, InputIt);
+    template <typename... Args>
+    void construct_at_end(size_type, Args&&...);
+    void default_init_at_end(size_type, std::true_type) noexcept;
+    void default_init_at_end(size_type, std::false_type);
+    void destroy_at_end(pointer) noexcept;
+    void ensure_spare_capacity(size_type);
+
+    template <typename InputIt>
+    void append_range(InputIt, InputIt, std::input_iterator_tag);
+    template <typename ForwardIt>
+    void append_range(ForwardIt, ForwardIt, std::forward_iterator_tag);
+    template <typename InputIt>
+    void assign_range(InputIt, InputIt, std::input_iterator_tag);
+    template <typename ForwardIt>
+    void assign_range(ForwardIt, ForwardIt, std::forward_iterator_tag);
+    template <typename InputIt>
+    pointer insert_range(pointer, InputIt, InputIt, std::input_iterator_tag);
+    template <typename ForwardIt>
+    pointer
+    insert_range(pointer, ForwardIt, ForwardIt, std::forward_iterator_tag);
+    template <typename ForwardIt>
+    void insert_range_in_place(std::true_type, pointer, ForwardIt, ForwardIt,
+        size_type);
+    template <typename ForwardIt>
+    void insert_range_in_place(std::false_type, pointer, ForwardIt, ForwardIt,
+        size_type);
+    pointer insert_fill(pointer, size_type, const_reference);
+    void insert_fill_in_place(std::true_type, pointer, size_type,
+        const_reference);
+    void insert_fill_in_place(std::false_type, pointer, size_type,
+        const_reference);
+
+    template <typename... Args>
+    void emplace_back_slow(std::true_type, Args&&...);
+    template <typename... Args>
+    void emplace_back_slow(std::false_type, Args&&...);
+    template <typename... Args>
+    pointer emplace_unsafe(std::true_type, pointer, Args&&...);
+    template <typename... Args>
+    pointer emplace_unsafe(std::false_type, pointer, Args&&...);
+
+    void reallocate_storage(size_type);
+    void reallocate_storage(size_type, std::true_type);
+    void reallocate_storage(size_type, std::false_type);
+    void move_to_inline(std::true_type) noexcept;
+    void move_to_inline(std::false_type);
+    void swap_out_storage(pointer, size_type, pointer, size_type);
+    void swap_out_storage(pointer, size_type, pointer, size_type,
+        std::true_type) noexcept;
+    void swap_out_storage(pointer, size_type, pointer, size_type,
+        std::false_type);
+    void move_right(pointer, pointer, pointer, std::true_type) noexcept;
+    void move_right(pointer, pointer, pointer, std::false_type);
+    void move_left(pointer, pointer, std::true_type) noexcept;
+    void move_left(pointer, pointer, std::false_type);
+    size_type growth_capacity(size_type) const;
+
+    void throw_out_of_range() const;
+    void throw_length_error() const;
+
+    pointer& end_cap_() noexcept;
+    allocator_type& alloc_() noexcept;
+    const pointer& end_cap_() const noexcept;
+    const allocator_type& alloc_() const noexcept;
+  };
+
+  template <typename T, std::size_t N, typename Allocator>
+  small_vector<T, N, Allocator>::small_vector(const small_vector& rhs) :
+    small_vector(
+        AllocTraits::select_on_container_copy_construction(rhs.alloc_()))
+  {
+    allocate(rhs.size());
+    detail::exception_guard<Deleter> guard(Deleter(*this));
+    construct_at_end(rhs.begin_, rhs.end_);
+    guard.complete();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  small_vector<T, N, Allocator>::small_vector(small_vector&& rhs) noexcept(
+      IsNothrowMovable::value) :
+    small_vector(rhs.alloc_())
+  {
+    steal_or_move(rhs);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  small_vector<T, N, Allocator>::small_vector(const allocator_type& alloc) :
+    begin_(nullptr),
+    end_(nullptr),
+    end_cap_alloc_(nullptr, alloc)
+  {
+    reset_to_inline();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  small_vector<T, N, Allocator>::small_vector(size_type size,
+      const allocator_type& alloc) :
+    small_vector(alloc)
+  {
+    allocate(size);
+    detail::exception_guard<Deleter> guard(Deleter(*this));
+    construct_at_end(size);
+    guard.complete();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  small_vector<T, N, Allocator>::small_vector(size_type size, default_init_t,
+      const allocator_type& alloc) :
+    small_vector(alloc)
+  {
+    allocate(size);
+    detail::exception_guard<Deleter> guard(Deleter(*this));
+    default_init_at_end(size, CanSkipInit());
+    guard.complete();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  small_vector<T, N, Allocator>::small_vector(size_type size,
+      const_reference value, const allocator_type& alloc) :
+    small_vector(alloc)
+  {
+    allocate(size);
+    detail::exception_guard<Deleter> guard(Deleter(*this));
+    construct_at_end(size, value);
+    guard.complete();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
+  small_vector<T, N, Allocator>::small_vector(InputIt first, InputIt last,
+      const allocator_type& alloc) :
+    small_vector(alloc)
+  {
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    detail::exception_guard<Deleter> guard(Deleter(*this));
+    append_range(first, last, category());
+    guard.complete();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  small_vector<T, N, Allocator>::small_vector(
+      std::initializer_list<value_type> list, const allocator_type& alloc) :
+    small_vector(alloc)
+  {
+    allocate(list.size());
+    detail::exception_guard<Deleter> guard(Deleter(*this));
+    construct_at_end(list.begin(), list.end());
+    guard.complete();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  small_vector<T, N, Allocator>::~small_vector()
+  {
+    deallocate();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  small_vector<T, N, Allocator>&
+  small_vector<T, N, Allocator>::operator=(const small_vector& rhs) &
+  {
+    if (this != &rhs) {
+      copy_assign_alloc(rhs, PropagateOnCopy());
+      assign(rhs.begin_, rhs.end_);
+    }
+    return *this;
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  small_vector<T, N, Allocator>& small_vector<T, N, Allocator>::operator=(
+      small_vector&& rhs) & noexcept(
+      IsNothrowMovable::value && CanStealOnMove::value)
+  {
+    if (this != &rhs) {
+      move_assign(rhs, CanStealOnMove());
+    }
+    return *this;
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::reference
+  small_vector<T, N, Allocator>::operator[](size_type index) noexcept
+  {
+    return *(begin_ + index);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::const_reference
+  small_vector<T, N, Allocator>::operator[](size_type index) const noexcept
+  {
+    return *(begin_ + index);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::reserve(size_type new_capacity)
+  {
+    if (new_capacity <= capacity()) {
+      return;
+    }
+    if (new_capacity > max_size()) {
+      throw_length_error();
+    }
+    reallocate_storage(new_capacity);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::resize(size_type new_size)
+  {
+    if (size() >= new_size) {
+      destroy_at_end(begin_ + new_size);
+      return;
+    }
+    ensure_spare_capacity(new_size - size());
+    construct_at_end(new_size - size());
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::resize(size_type new_size,
+      const_reference value)
+  {
+    if (size() >= new_size) {
+      destroy_at_end(begin_ + new_size);
+      return;
+    }
+    insert_fill(end_, new_size - size(), value);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::resize_for_overwrite(size_type new_size)
+  {
+    if (size() >= new_size) {
+      destroy_at_end(begin_ + new_size);
+      return;
+    }
+    ensure_spare_capacity(new_size - size());
+    default_init_at_end(new_size - size(), CanSkipInit());
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::shrink_to_fit()
+  {
+    if (is_inline()) {
+      return;
+    }
+    if (size() <= N) {
+      move_to_inline(CanRelocate());
+    } else if (end_ != end_cap_()) {
+      reallocate_storage(size());
+    }
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::clear() noexcept
+  {
+    destroy_at_end(begin_);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::swap(small_vector& rhs) noexcept(
+      IsNothrowMovable::value && CanStealOnSwap::value)
+  {
+    if (this == &rhs) {
+      return;
+    }
+    if (!CanStealOnSwap::value && alloc_() != rhs.alloc_()) {
+      // Each side keeps its allocator, so the elements change hands one by
+      // one into storage owned by the receiving side.
+      small_vector tmp(std::move(rhs));
+      rhs.assign(std::make_move_iterator(begin_),
+          std::make_move_iterator(end_));
+      assign(std::make_move_iterator(tmp.begin_),
+          std::make_move_iterator(tmp.end_));
+      return;
+    }
+    if (!is_inline() && !rhs.is_inline()) {
+      using std::swap;
+      swap(begin_, rhs.begin_);
+      swap(end_, rhs.end_);
+      swap(end_cap_(), rhs.end_cap_());
+      swap_alloc(rhs, PropagateOnSwap());
+      return;
+    }
+    small_vector lhs_tmp(std::move(*this));
+    small_vector rhs_tmp(std::move(rhs));
+    swap_alloc(rhs, PropagateOnSwap());
+    steal_or_move(rhs_tmp);
+    rhs.steal_or_move(lhs_tmp);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::push_back(const_reference value)
+  {
+    emplace_back(value);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::push_back(value_type&& value)
+  {
+    emplace_back(std::forward<value_type>(value));
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::pop_back()
+  {
+    destroy_at_end(end_ - 1);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::reference
+  small_vector<T, N, Allocator>::at(size_type index)
+  {
+    if (index >= size()) {
+      throw_out_of_range();
+    }
+    return *(begin_ + index);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::const_reference
+  small_vector<T, N, Allocator>::at(size_type index) const
+  {
+    if (index >= size()) {
+      throw_out_of_range();
+    }
+    return *(begin_ + index);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void
+  small_vector<T, N, Allocator>::assign(size_type size, const_reference value)
+  {
+    if (capacity() < size) {
+      small_vector tmp(size, value, alloc_());
+      swap(tmp);
+      return;
+    }
+    clear();
+    construct_at_end(size, value);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
+  void small_vector<T, N, Allocator>::assign(InputIt first, InputIt last)
+  {
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    assign_range(first, last, category());
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::assign(
+      std::initializer_list<value_type> list)
+  {
+    assign(list.begin(), list.end());
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::iterator
+  small_vector<T, N, Allocator>::insert(const_iterator position,
+      const_reference value)
+  {
+    return emplace(position, value);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::iterator
+  small_vector<T, N, Allocator>::insert(const_iterator position,
+      value_type&& value)
+  {
+    return emplace(position, std::forward<value_type>(value));
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::iterator
+  small_vector<T, N, Allocator>::insert(const_iterator position,
+      size_type size, const_reference value)
+  {
+    pointer pos = begin_ + (position - cbegin());
+    return iterator(insert_fill(pos, size, value));
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
+  typename small_vector<T, N, Allocator>::iterator
+  small_vector<T, N, Allocator>::insert(const_iterator position,
+      InputIt first, InputIt last)
+  {
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    pointer pos = begin_ + (position - cbegin());
+    return iterator(insert_range(pos, first, last, category()));
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::iterator
+  small_vector<T, N, Allocator>::insert(const_iterator position,
+      std::initializer_list<value_type> list)
+  {
+    return insert(position, list.begin(), list.end());
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename... Args>
+  typename small_vector<T, N, Allocator>::iterator
+  small_vector<T, N, Allocator>::emplace(const_iterator position,
+      Args&&... args)
+  {
+    if (position == cend()) {
+      emplace_back(std::forward<Args>(args)...);
+      return iterator(end_ - 1);
+    }
+    pointer pos = begin_ + (position - cbegin());
+    if (end_ != end_cap_()) {
+      return iterator(
+          emplace_unsafe(CanRelocate(), pos, std::forward<Args>(args)...));
+    }
+    const size_type new_capacity = growth_capacity(size() + 1);
+    const size_type shift = pos - begin_;
+    pointer new_begin = StorageTraits::allocate(alloc_(), new_capacity);
+    auto deleter = [&]() {
+      StorageTraits::deallocate(alloc_(), new_begin, new_capacity);
+    };
+
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    AllocTraits::construct(alloc_(), new_begin + shift,
+        std::forward<Args>(args)...);
+    guard.complete();
+    swap_out_storage(new_begin, new_capacity, pos, 1);
+    return iterator(begin_ + shift);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename... Args>
+  void small_vector<T, N, Allocator>::emplace_back(Args&&... args)
+  {
+    if (end_ == end_cap_()) {
+      emplace_back_slow(CanRelocate(), std::forward<Args>(args)...);
+      return;
+    }
+    AllocTraits::construct(alloc_(), end_, std::forward<Args>(args)...);
+    ++end_;
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename Writer>
+  typename small_vector<T, N, Allocator>::size_type
+  small_vector<T, N, Allocator>::append_uninitialized(size_type count,
+      Writer writer)
+  {
+    static_assert(std::is_trivially_copyable<value_type>::value &&
+            CanSkipInit::value,
+        "append_uninitialized requires a trivial value_type");
+    ensure_spare_capacity(count);
+    const size_type written = writer(end_, count);
+    end_ += std::min(written, count);
+    return written;
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::iterator
+  small_vector<T, N, Allocator>::erase(const_iterator position)
+  {
+    return erase(position, position + 1);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::iterator
+  small_vector<T, N, Allocator>::erase(const_iterator first,
+      const_iterator last)
+  {
+    pointer first_ptr = begin_ + (first - cbegin());
+    pointer last_ptr = begin_ + (last - cbegin());
+    if (first_ptr == last_ptr) {
+      return iterator(first_ptr);
+    }
+    move_left(first_ptr, last_ptr, CanRelocate());
+    return iterator(first_ptr);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::const_reverse_iterator
+  small_vector<T, N, Allocator>::crbegin() const noexcept
+  {
+    return const_reverse_iterator(end());
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::const_reverse_iterator
+  small_vector<T, N, Allocator>::crend() const noexcept
+  {
+    return const_reverse_iterator(begin());
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::size_type
+  small_vector<T, N, Allocator>::max_size() const noexcept
+  {
+    using size_limits = std::numeric_limits<size_type>;
+    using diff_limits = std::numeric_limits<difference_type>;
+    const size_type alloc_max = AllocTraits::max_size(alloc_());
+    constexpr size_type diff_max = static_cast<size_type>(diff_limits::max());
+    constexpr size_type bytes_max = size_limits::max() / sizeof(T);
+    return std::min({ alloc_max, diff_max, bytes_max });
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  bool small_vector<T, N, Allocator>::is_inline() const noexcept
+  {
+    return begin_ == buffer_.data();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  class small_vector<T, N, Allocator>::Deleter
+  {
+  public:
+    Deleter(small_vector& v) : v_(v) {}
+    void operator()() { v_.deallocate(); }
+
+  private:
+    small_vector& v_;
+  };
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::allocate(size_type size)
+  {
+    if (size <= N) {
+      return;
+    }
+    if (size > max_size()) {
+      throw_length_error();
+    }
+    begin_ = StorageTraits::allocate(alloc_(), size);
+    end_ = begin_;
+    end_cap_() = begin_ + size;
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::deallocate() noexcept
+  {
+    clear();
+    release_storage();
+    reset_to_inline();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::release_storage() noexcept
+  {
+    if (!is_inline()) {
+      StorageTraits::deallocate(alloc_(), begin_, capacity());
+    }
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::reset_to_inline() noexcept
+  {
+    begin_ = end_ = buffer_.data();
+    end_cap_() = buffer_.data() + N;
+  }
+
+  // Takes over the heap block of rhs, or moves its inline elements into the
+  // (empty, inline) storage of *this. rhs is left empty. The allocators must
+  // be equal.
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::steal_or_move(small_vector& rhs)
+  {
+    if (!rhs.is_inline()) {
+      begin_ = rhs.begin_;
+      end_ = rhs.end_;
+      end_cap_() = rhs.end_cap_();
+      rhs.reset_to_inline();
+      return;
+    }
+    if (CanRelocate::value) {
+      end_ = detail::relocate(rhs.begin_, rhs.end_, begin_);
+      rhs.end_ = rhs.begin_;
+      return;
+    }
+    construct_at_end(std::make_move_iterator(rhs.begin_),
+        std::make_move_iterator(rhs.end_));
+    rhs.clear();
+  }
+
+  // A propagating allocator replaces ours, so storage obtained from ours has
+  // to go first unless the two are interchangeable.
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::copy_assign_alloc(
+      const small_vector& rhs, std::true_type)
+  {
+    if (alloc_() != rhs.alloc_()) {
+      deallocate();
+    }
+    alloc_() = rhs.alloc_();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::move_assign(small_vector& rhs,
+      std::true_type) noexcept(IsNothrowMovable::value)
+  {
+    deallocate();
+    move_assign_alloc(rhs, PropagateOnMove());
+    steal_or_move(rhs);
+  }
+
+  // A heap block can only be taken over from an equal allocator; otherwise
+  // the elements are moved one by one into storage owned by ours.
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::move_assign(small_vector& rhs,
+      std::false_type)
+  {
+    if (alloc_() == rhs.alloc_()) {
+      move_assign(rhs, std::true_type());
+      return;
+    }
+    assign(std::make_move_iterator(rhs.begin_),
+        std::make_move_iterator(rhs.end_));
+    rhs.clear();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::move_assign_alloc(small_vector& rhs,
+      std::true_type) noexcept
+  {
+    alloc_() = std::move(rhs.alloc_());
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::swap_alloc(small_vector& rhs,
+      std::true_type) noexcept
+  {
+    using std::swap;
+    swap(alloc_(), rhs.alloc_());
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename... Args>
+  void small_vector<T, N, Allocator>::construct_at_end(size_type size,
+      Args&&... args)
+  {
+    for (size_type i = 0; i != size; ++i, ++end_) {
+      AllocTraits::construct(alloc_(), end_, args...);
+    }
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
+  void small_vector<T, N, Allocator>::construct_at_end(InputIt first,
+      InputIt last)
+  {
+    for (; first != last; ++first, ++end_) {
+      AllocTraits::construct(alloc_(), end_, *first);
+    }
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::default_init_at_end(size_type size,
+      std::true_type) noexcept
+  {
+    end_ += size;
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::default_init_at_end(size_type size,
+      std::false_type)
+  {
+    construct_at_end(size);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::ensure_spare_capacity(size_type count)
+  {
+    if (count > static_cast<size_type>(end_cap_() - end_)) {
+      reallocate_storage(growth_capacity(size() + count));
+    }
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::destroy_at_end(pointer new_end) noexcept
+  {
+    for (; end_ != new_end; --end_) {
+      AllocTraits::destroy(alloc_(), end_ - 1);
+    }
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename InputIt>
+  void small_vector<T, N, Allocator>::append_range(InputIt first,
+      InputIt last, std::input_iterator_tag)
+  {
+    for (; first != last; ++first) {
+      emplace_back(*first);
+    }
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename ForwardIt>
+  void small_vector<T, N, Allocator>::append_range(ForwardIt first,
+      ForwardIt last, std::forward_iterator_tag)
+  {
+    ensure_spare_capacity(std::distance(first, last));
+    construct_at_end(first, last);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename InputIt>
+  void small_vector<T, N, Allocator>::assign_range(InputIt first,
+      InputIt last, std::input_iterator_tag)
+  {
+    clear();
+    append_range(first, last, std::input_iterator_tag());
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename ForwardIt>
+  void small_vector<T, N, Allocator>::assign_range(ForwardIt first,
+      ForwardIt last, std::forward_iterator_tag)
+  {
+    if (capacity() < static_cast<size_type>(std::distance(first, last))) {
+      small_vector tmp(first, last, alloc_());
+      swap(tmp);
+      return;
+    }
+    clear();
+    construct_at_end(first, last);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename InputIt>
+  typename small_vector<T, N, Allocator>::pointer
+  small_vector<T, N, Allocator>::insert_range(pointer position, InputIt first,
+      InputIt last, std::input_iterator_tag)
+  {
+    const size_type shift = position - begin_;
+    const_iterator pos(position);
+    for (; first != last; ++first) {
+      pos = emplace(pos, *first);
+      ++pos;
+    }
+    return begin_ + shift;
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename ForwardIt>
+  typename small_vector<T, N, Allocator>::pointer
+  small_vector<T, N, Allocator>::insert_range(pointer position,
+      ForwardIt first, ForwardIt last, std::forward_iterator_tag)
+  {
+    const size_type count = std::distance(first, last);
+    if (count == 0) {
+      return position;
+    }
+    if (count <= static_cast<size_type>(end_cap_() - end_)) {
+      insert_range_in_place(CanRelocate(), position, first, last, count);
+      return position;
+    }
+    const size_type new_capacity = growth_capacity(size() + count);
+    const size_type shift = position - begin_;
+    pointer new_begin = StorageTraits::allocate(alloc_(), new_capacity);
+    auto deleter = [&]() {
+      StorageTraits::deallocate(alloc_(), new_begin, new_capacity);
+    };
+
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    detail::uninitialized_copy(alloc_(), first, last, new_begin + shift);
+    guard.complete();
+    swap_out_storage(new_begin, new_capacity, position, count);
+    return begin_ + shift;
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename ForwardIt>
+  void small_vector<T, N, Allocator>::insert_range_in_place(std::true_type,
+      pointer position, ForwardIt first, ForwardIt last, size_type count)
+  {
+    move_right(position, end_, position + count, std::true_type());
+    auto rollback = [&]() {
+      end_ = detail::relocate(position + count, end_, position);
+    };
+
+    detail::exception_guard<decltype(rollback)> guard(rollback);
+    detail::uninitialized_copy(alloc_(), first, last, position);
+    guard.complete();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename ForwardIt>
+  void small_vector<T, N, Allocator>::insert_range_in_place(std::false_type,
+      pointer position, ForwardIt first, ForwardIt last, size_type count)
+  {
+    pointer old_end = end_;
+    const size_type tail = old_end - position;
+    ForwardIt middle = last;
+    if (count > tail) {
+      middle = first;
+      std::advance(middle, tail);
+      construct_at_end(middle, last);
+    }
+    if (tail != 0) {
+      move_right(position, old_end, position + count, std::false_type());
+      std::copy(first, middle, position);
+    }
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::pointer
+  small_vector<T, N, Allocator>::insert_fill(pointer position,
+      size_type count, const_reference value)
+  {
+    if (count == 0) {
+      return position;
+    }
+    if (count <= static_cast<size_type>(end_cap_() - end_)) {
+      insert_fill_in_place(CanRelocate(), position, count, value);
+      return position;
+    }
+    const size_type new_capacity = growth_capacity(size() + count);
+    const size_type shift = position - begin_;
+    pointer new_begin = StorageTraits::allocate(alloc_(), new_capacity);
+    auto deleter = [&]() {
+      StorageTraits::deallocate(alloc_(), new_begin, new_capacity);
+    };
+
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    detail::uninitialized_fill_n(alloc_(), new_begin + shift, count, value);
+    guard.complete();
+    swap_out_storage(new_begin, new_capacity, position, count);
+    return begin_ + shift;
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::insert_fill_in_place(std::true_type,
+      pointer position, size_type count, const_reference value)
+  {
+    const_pointer source = std::addressof(value);
+    if (position <= source && source < end_) {
+      source += count;
+    }
+    move_right(position, end_, position + count, std::true_type());
+    auto rollback = [&]() {
+      end_ = detail::relocate(position + count, end_, position);
+    };
+
+    detail::exception_guard<decltype(rollback)> guard(rollback);
+    detail::uninitialized_fill_n(alloc_(), position, count, *source);
+    guard.complete();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::insert_fill_in_place(std::false_type,
+      pointer position, size_type count, const_reference value)
+  {
+    pointer old_end = end_;
+    const size_type tail = old_end - position;
+    if (count > tail) {
+      construct_at_end(count - tail, value);
+    }
+    if (tail != 0) {
+      const_pointer source = std::addressof(value);
+      move_right(position, old_end, position + count, std::false_type());
+      if (position <= source && source < end_) {
+        source += count;
+      }
+      std::fill_n(position, std::min(count, tail), *source);
+    }
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename... Args>
+  void small_vector<T, N, Allocator>::emplace_back_slow(std::true_type,
+      Args&&... args)
+  {
+    alignas(value_type) unsigned char buffer[sizeof(value_type)];
+    pointer tmp = reinterpret_cast<pointer>(buffer);
+    AllocTraits::construct(alloc_(), tmp, std::forward<Args>(args)...);
+    auto destroy_tmp = [&]() { AllocTraits::destroy(alloc_(), tmp); };
+    detail::exception_guard<decltype(destroy_tmp)> guard(destroy_tmp);
+    reallocate_storage(growth_capacity(size() + 1));
+    guard.complete();
+    end_ = detail::relocate(tmp, tmp + 1, end_);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename... Args>
+  void small_vector<T, N, Allocator>::emplace_back_slow(std::false_type,
+      Args&&... args)
+  {
+    const size_type new_capacity = growth_capacity(size() + 1);
+    pointer new_begin = StorageTraits::allocate(alloc_(), new_capacity);
+    auto deleter = [&]() {
+      StorageTraits::deallocate(alloc_(), new_begin, new_capacity);
+    };
+
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    AllocTraits::construct(alloc_(), new_begin + size(),
+        std::forward<Args>(args)...);
+    guard.complete();
+    swap_out_storage(new_begin, new_capacity, end_, 1);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename... Args>
+  typename small_vector<T, N, Allocator>::pointer
+  small_vector<T, N, Allocator>::emplace_unsafe(std::true_type,
+      pointer position, Args&&... args)
+  {
+    alignas(value_type) unsigned char buffer[sizeof(value_type)];
+    pointer tmp = reinterpret_cast<pointer>(buffer);
+    AllocTraits::construct(alloc_(), tmp, std::forward<Args>(args)...);
+    move_right(position, end_, position + 1, std::true_type());
+    detail::relocate(tmp, tmp + 1, position);
+    return position;
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  template <typename... Args>
+  typename small_vector<T, N, Allocator>::pointer
+  small_vector<T, N, Allocator>::emplace_unsafe(std::false_type,
+      pointer position, Args&&... args)
+  {
+    value_type tmp(std::forward<Args>(args)...);
+    move_right(position, end_, position + 1, std::false_type());
+    *position = std::move(tmp);
+    return position;
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::reallocate_storage(size_type new_capacity)
+  {
+    if (new_capacity <= N) {
+      if (!is_inline()) {
+        move_to_inline(CanRelocate());
+      }
+      return;
+    }
+    reallocate_storage(new_capacity, CanRelocate());
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::reallocate_storage(
+      size_type new_capacity, std::true_type)
+  {
+    if (is_inline()) {
+      swap_out_storage(StorageTraits::allocate(alloc_(), new_capacity),
+          new_capacity, end_, 0, std::true_type());
+      return;
+    }
+    const size_type old_size = size();
+    auto allocation = StorageTraits::reallocate(alloc_(), begin_, old_size,
+        capacity(), new_capacity);
+    begin_ = allocation.ptr;
+    end_ = begin_ + old_size;
+    end_cap_() = begin_ + allocation.count;
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::reallocate_storage(
+      size_type new_capacity, std::false_type)
+  {
+    swap_out_storage(StorageTraits::allocate(alloc_(), new_capacity),
+        new_capacity, end_, 0, std::false_type());
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::move_to_inline(std::true_type) noexcept
+  {
+    pointer old_begin = begin_;
+    const size_type old_capacity = capacity();
+    pointer new_end = detail::relocate(begin_, end_, buffer_.data());
+    StorageTraits::deallocate(alloc_(), old_begin, old_capacity);
+    reset_to_inline();
+    end_ = new_end;
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::move_to_inline(std::false_type)
+  {
+    pointer new_end = detail::uninitialized_move_if_noexcept(alloc_(), begin_,
+        end_, buffer_.data());
+    deallocate();
+    end_ = new_end;
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::swap_out_storage(pointer new_begin,
+      size_type new_capacity, pointer position, size_type count)
+  {
+    swap_out_storage(new_begin, new_capacity, position, count, CanRelocate());
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::swap_out_storage(pointer new_begin,
+      size_type new_capacity, pointer position, size_type count,
+      std::true_type) noexcept
+  {
+    pointer new_position = new_begin + (position - begin_);
+    detail::relocate(begin_, position, new_begin);
+    pointer new_end = detail::relocate(position, end_, new_position + count);
+    release_storage();
+    begin_ = new_begin;
+    end_ = new_end;
+    end_cap_() = new_begin + new_capacity;
+  }
+
+  // Moves the elements of *this into a new heap block around the already
+  // constructed range [new_position, new_position + count) and adopts it.
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::swap_out_storage(pointer new_begin,
+      size_type new_capacity, pointer position, size_type count,
+      std::false_type)
+  {
+    pointer new_first = new_begin + (position - begin_);
+    pointer new_last = new_first + count;
+    auto deleter = [&]() {
+      detail::destroy(alloc_(), new_first, new_last);
+      StorageTraits::deallocate(alloc_(), new_begin, new_capacity);
+    };
+
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    for (pointer i = position; i != begin_; --new_first) {
+      AllocTraits::construct(alloc_(), new_first - 1,
+          std::move_if_noexcept(*--i));
+    }
+    for (pointer i = position; i != end_; ++i, ++new_last) {
+      AllocTraits::construct(alloc_(), new_last, std::move_if_noexcept(*i));
+    }
+    guard.complete();
+    deallocate();
+
+    begin_ = new_begin;
+    end_ = new_last;
+    end_cap_() = new_begin + new_capacity;
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::move_right(pointer first, pointer last,
+      pointer out, std::true_type) noexcept
+  {
+    end_ = detail::relocate(first, last, out);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::move_right(pointer first, pointer last,
+      pointer out, std::false_type)
+  {
+    pointer old_end = end_;
+    pointer split = first + (old_end - out);
+    for (pointer i = split; i != last; ++i, ++end_) {
+      AllocTraits::construct(alloc_(), end_, std::move(*i));
+    }
+    std::move_backward(first, split, old_end);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::move_left(pointer first, pointer last,
+      std::true_type) noexcept
+  {
+    detail::destroy(alloc_(), first, last);
+    end_ = detail::relocate(last, end_, first);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::move_left(pointer first, pointer last,
+      std::false_type)
+  {
+    pointer new_end = std::move(last, end_, first);
+    destroy_at_end(new_end);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::size_type
+  small_vector<T, N, Allocator>::growth_capacity(size_type new_capacity) const
+  {
+    size_type max_sz = max_size();
+    if (new_capacity > max_sz) {
+      throw_length_error();
+    }
+    size_type cap = capacity();
+    if (cap >= max_sz / 2) {
+      return max_sz;
+    }
+    return std::max(cap * 2, new_capacity);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::throw_out_of_range() const
+  {
+    throw std::out_of_range("ftl::small_vector out_of_range");
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void small_vector<T, N, Allocator>::throw_length_error() const
+  {
+    throw std::length_error("ftl::small_vector length_error");
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::pointer&
+  small_vector<T, N, Allocator>::end_cap_() noexcept
+  {
+    return end_cap_alloc_.first();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  const typename small_vector<T, N, Allocator>::pointer&
+  small_vector<T, N, Allocator>::end_cap_() const noexcept
+  {
+    return end_cap_alloc_.first();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  typename small_vector<T, N, Allocator>::allocator_type&
+  small_vector<T, N, Allocator>::alloc_() noexcept
+  {
+    return end_cap_alloc_.second();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  const typename small_vector<T, N, Allocator>::allocator_type&
+  small_vector<T, N, Allocator>::alloc_() const noexcept
+  {
+    return end_cap_alloc_.second();
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  void swap(small_vector<T, N, Allocator>& lhs,
+      small_vector<T, N, Allocator>& rhs) noexcept(noexcept(lhs.swap(rhs)))
+  {
+    lhs.swap(rhs);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  bool operator==(const small_vector<T, N, Allocator>& lhs,
+      const small_vector<T, N, Allocator>& rhs)
+  {
+    return detail::contiguous_equal(lhs, rhs);
+  }
+
+#if !defined(FTL_CPP20_FEATURES)
+
+  template <typename T, std::size_t N, typename Allocator>
+  bool operator!=(const small_vector<T, N, Allocator>& lhs,
+      const small_vector<T, N, Allocator>& rhs)
+  {
+    return !(lhs == rhs);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  bool operator<(const small_vector<T, N, Allocator>& l,
+      const small_vector<T, N, Allocator>& r)
+  {
+    return detail::contiguous_less(l, r);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  bool operator>(const small_vector<T, N, Allocator>& lhs,
+      const small_vector<T, N, Allocator>& rhs)
+  {
+    return rhs < lhs;
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  bool operator<=(const small_vector<T, N, Allocator>& lhs,
+      const small_vector<T, N, Allocator>& rhs)
+  {
+    return !(lhs > rhs);
+  }
+
+  template <typename T, std::size_t N, typename Allocator>
+  bool operator>=(const small_vector<T, N, Allocator>& lhs,
+      const small_vector<T, N, Allocator>& rhs)
+  {
+    return !(lhs < rhs);
+  }
+
+#else
+
+  template <typename T, std::size_t N, typename Allocator>
+  auto operator<=>(const small_vector<T, N, Allocator>& lhs,
+      const small_vector<T, N, Allocator>& rhs)
+  {
+    return detail::contiguous_three_way(lhs, rhs);
+  }
+
+#endif
+}
+
+namespace std {
+  template <typename T, std::size_t N, typename Allocator>
+  struct hash<ftl::small_vector<T, N, Allocator>>
+  {
+    size_t operator()(const ftl::small_vector<T, N, Allocator>& vec) const
+    {
+      return ftl::detail::hash_contiguous(vec);
+    }
+  };
+}
+
+#endif
@@ -0,0 +1,941 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_CONTAINERS_SOA_VECTOR_HPP
+#define FTL_CONTAINERS_SOA_VECTOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "../internal/compare.hpp"
+#include "../internal/compressed_pair.hpp"
+#include "../internal/config.hpp"
+#include "../internal/exception_guard.hpp"
+#include "../internal/growth_policy.hpp"
+#include "../internal/index_iterator.hpp"
+#include "../internal/relocate.hpp"
+#include "../internal/type_traits.hpp"
+#include "../internal/uninitialized.hpp"
+
+namespace ftl {
+
+  // A view of one column of a soa_vector: a pointer and a length.
+  template <typename T>
+  class column_span final
+  {
+  public:
+    using element_type = T;
+    using value_type = typename std::remove_const<T>::type;
+    using size_type = std::size_t;
+    using iterator = T*;
+
+    column_span() noexcept : data_(nullptr), size_(0) {}
+    column_span(T* data, size_type size) noexcept : data_(data), size_(size)
+    {
+    }
+
+    T* data() const noexcept { return data_; }
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    iterator begin() const noexcept { return data_; }
+    iterator end() const noexcept { return data_ + size_; }
+    T& operator[](size_type i) const noexcept { return data_[i]; }
+
+  private:
+    T* data_;
+    size_type size_;
+  };
+
+  namespace detail {
+
+    template <std::size_t I, typename Alloc, typename T, typename Args>
+    void construct_from_tuple(Alloc& alloc, T* p, Args&&,
+        std::true_type /* empty */)
+    {
+      std::allocator_traits<Alloc>::construct(alloc, p);
+    }
+
+    template <std::size_t I, typename Alloc, typename T, typename Args>
+    void construct_from_tuple(Alloc& alloc, T* p, Args&& args,
+        std::false_type /* empty */)
+    {
+      std::allocator_traits<Alloc>::construct(alloc, p,
+          std::get<I>(std::forward<Args>(args)));
+    }
+
+    // Constructs *p from the I-th element of the tuple args, or
+    // value-initializes it if args is empty.
+    template <std::size_t I, typename Alloc, typename T, typename Args>
+    void construct_from_tuple(Alloc& alloc, T* p, Args&& args)
+    {
+      using empty = std::integral_constant<bool,
+          std::tuple_size<typename std::decay<Args>::type>::value == 0>;
+      construct_from_tuple<I>(alloc, p, std::forward<Args>(args), empty());
+    }
+  }
+
+  // A vector of rows with fields Ts... stored as one array per field, all
+  // in a single allocation, so a loop that reads one field streams through
+  // exactly that field's memory. Every column starts on a 64-byte boundary.
+  //
+  // Rows are read and written through tuples: operator[] and the iterators
+  // yield std::tuple<Ts&...> proxies, push_back takes a std::tuple<Ts...>
+  // and emplace_back takes one constructor argument per column. column<I>()
+  // gives the I-th field of all rows as a contiguous span.
+  //
+  // Growth moves every column into the new block in one reallocation.
+  // Columns whose move constructor may throw are copied first, so a throw
+  // leaves the old block untouched; a column type that can neither be
+  // copied nor moved without throwing cannot grow.
+  template <typename Allocator, typename... Ts>
+  class basic_soa_vector final
+  {
+    static_assert(sizeof...(Ts) != 0, "ftl::soa_vector needs a column");
+
+  public:
+    using value_type = std::tuple<Ts...>;
+    using reference = std::tuple<Ts&...>;
+    using const_reference = std::tuple<const Ts&...>;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator =
+        detail::index_iterator<basic_soa_vector, value_type, reference>;
+    using const_iterator = detail::index_iterator<const basic_soa_vector,
+        const value_type, const_reference>;
+
+    template <std::size_t I>
+    using column_type = typename std::tuple_element<I, value_type>::type;
+
+    static constexpr size_type column_count = sizeof...(Ts);
+    static constexpr size_type column_alignment =
+        std::max({ std::size_t(64), alignof(Ts)... });
+
+  private:
+    using AllocTraits = std::allocator_traits<allocator_type>;
+    using ByteAlloc =
+        typename AllocTraits::template rebind_alloc<unsigned char>;
+    using ByteTraits = std::allocator_traits<ByteAlloc>;
+    template <std::size_t I>
+    using ColumnAlloc =
+        typename AllocTraits::template rebind_alloc<column_type<I>>;
+    template <std::size_t I>
+    using ColumnTraits = std::allocator_traits<ColumnAlloc<I>>;
+    using PropagateOnCopy =
+        typename AllocTraits::propagate_on_container_copy_assignment;
+    using PropagateOnMove =
+        typename AllocTraits::propagate_on_container_move_assignment;
+    using PropagateOnSwap = typename AllocTraits::propagate_on_container_swap;
+    using CanStealOnMove = std::integral_constant<bool,
+        PropagateOnMove::value || AllocTraits::is_always_equal::value>;
+    using Columns = std::tuple<Ts*...>;
+    using Indices = std::index_sequence_for<Ts...>;
+
+    static_assert(std::is_pointer<typename ByteTraits::pointer>::value,
+        "ftl::soa_vector needs an allocator with raw pointers");
+
+    // How growth carries a column over: 0 relocates it bitwise, 1 copies it
+    // before anything else moves and 2 moves it element by element, which
+    // must not throw once other columns have been relocated.
+    template <std::size_t I>
+    using growth_kind = std::integral_constant<int,
+        detail::is_relocatable_with<ColumnAlloc<I>>::value ? 0
+            : !std::is_nothrow_move_constructible<column_type<I>>::value &&
+                std::is_copy_constructible<column_type<I>>::value
+            ? 1
+            : 2>;
+
+    struct storage
+    {
+      unsigned char* block;
+      Columns columns;
+    };
+
+  public:
+    basic_soa_vector() noexcept(noexcept(allocator_type())) :
+      basic_soa_vector(allocator_type())
+    {
+    }
+
+    explicit basic_soa_vector(const allocator_type&) noexcept;
+    explicit basic_soa_vector(size_type,
+        const allocator_type& = allocator_type());
+    basic_soa_vector(const basic_soa_vector&);
+    basic_soa_vector(basic_soa_vector&&) noexcept;
+    ~basic_soa_vector();
+
+    basic_soa_vector& operator=(const basic_soa_vector&);
+    basic_soa_vector& operator=(basic_soa_vector&&) noexcept(
+        CanStealOnMove::value);
+
+    reference operator[](size_type i) noexcept { return row(i, Indices()); }
+    const_reference operator[](size_type i) const noexcept
+    {
+      return row(i, Indices());
+    }
+
+    reference at(size_type);
+    const_reference at(size_type) const;
+    reference front() noexcept { return row(0, Indices()); }
+    reference back() noexcept { return row(size_ - 1, Indices()); }
+    const_reference front() const noexcept { return row(0, Indices()); }
+    const_reference back() const noexcept
+    {
+      return row(size_ - 1, Indices());
+    }
+
+    template <std::size_t I>
+    column_type<I>* data() noexcept
+    {
+      return std::get<I>(columns_);
+    }
+
+    template <std::size_t I>
+    const column_type<I>* data() const noexcept
+    {
+      return std::get<I>(columns_);
+    }
+
+    template <std::size_t I>
+    column_span<column_type<I>> column() noexcept
+    {
+      return column_span<column_type<I>>(std::get<I>(columns_), size_);
+    }
+
+    template <std::size_t I>
+    column_span<const column_type<I>> column() const noexcept
+    {
+      return column_span<const column_type<I>>(std::get<I>(columns_), size_);
+    }
+
+    void reserve(size_type);
+    void resize(size_type);
+    void shrink_to_fit();
+    void clear() noexcept;
+    void swap(basic_soa_vector&) noexcept;
+
+    void push_back(const value_type& row)
+    {
+      emplace_row(row, Indices());
+    }
+
+    void push_back(value_type&& row)
+    {
+      emplace_row(std::move(row), Indices());
+    }
+
+    template <typename... Args>
+    reference emplace_back(Args&&...);
+    void pop_back() noexcept;
+
+    iterator begin() noexcept { return iterator(this, 0); }
+    iterator end() noexcept { return iterator(this, size_); }
+    const_iterator begin() const noexcept { return const_iterator(this, 0); }
+    const_iterator end() const noexcept { return const_iterator(this, size_); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    bool empty() const noexcept { return size_ == 0; }
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept { return cap_alloc_.first(); }
+    size_type max_size() const noexcept;
+    allocator_type get_allocator() const noexcept { return alloc_(); }
+
+  private:
+    Columns columns_;
+    unsigned char* block_;
+    size_type size_;
+    detail::compressed_pair<size_type, allocator_type> cap_alloc_;
+
+    template <typename F, std::size_t... I>
+    static void for_each_column(F&& f, std::index_sequence<I...>)
+    {
+      using expand = int[];
+      (void)expand{ 0, (f(std::integral_constant<std::size_t, I>()), 0)... };
+    }
+
+    template <std::size_t... I>
+    reference row(size_type i, std::index_sequence<I...>) noexcept
+    {
+      return reference(std::get<I>(columns_)[i]...);
+    }
+
+    template <std::size_t... I>
+    const_reference row(size_type i, std::index_sequence<I...>) const noexcept
+    {
+      return const_reference(std::get<I>(columns_)[i]...);
+    }
+
+    template <typename Row, std::size_t... I>
+    void emplace_row(Row&& row, std::index_sequence<I...>)
+    {
+      emplace_back(std::get<I>(std::forward<Row>(row))...);
+    }
+
+    template <std::size_t... I>
+    void copy_row(const basic_soa_vector& rhs, size_type i,
+        std::index_sequence<I...>)
+    {
+      construct_row(columns_, size_,
+          std::forward_as_tuple(rhs.template data<I>()[i]...),
+          std::integral_constant<std::size_t, 0>());
+      ++size_;
+    }
+
+    template <std::size_t... I>
+    void move_row(basic_soa_vector& rhs, size_type i,
+        std::index_sequence<I...>)
+    {
+      construct_row(columns_, size_,
+          std::forward_as_tuple(std::move(rhs.template data<I>()[i])...),
+          std::integral_constant<std::size_t, 0>());
+      ++size_;
+    }
+
+    template <std::size_t I>
+    ColumnAlloc<I> column_alloc() const noexcept
+    {
+      return ColumnAlloc<I>(alloc_());
+    }
+
+    static size_type column_offsets(size_type, size_type*) noexcept;
+    static size_type block_bytes(size_type) noexcept;
+    storage allocate(size_type);
+    void deallocate(unsigned char*, size_type) noexcept;
+    void install(const storage&, size_type) noexcept;
+
+    template <std::size_t... I>
+    static Columns make_columns(unsigned char*, const size_type*,
+        std::index_sequence<I...>) noexcept;
+
+    template <typename Args, std::size_t I>
+    void construct_row(const Columns&, size_type, Args&&,
+        std::integral_constant<std::size_t, I>);
+    template <typename Args>
+    void construct_row(const Columns&, size_type, Args&&,
+        std::integral_constant<std::size_t, column_count>) noexcept
+    {
+    }
+
+    void destroy_rows(size_type, size_type) noexcept;
+    void relocate_into(const Columns&);
+
+    template <std::size_t I>
+    void copy_column(const Columns&, std::integral_constant<int, 1>);
+    template <std::size_t I, int Kind>
+    void copy_column(const Columns&, std::integral_constant<int, Kind>)
+    {
+    }
+
+    template <std::size_t I>
+    void uncopy_column(const Columns&, std::integral_constant<int, 1>) noexcept;
+    template <std::size_t I, int Kind>
+    void
+    uncopy_column(const Columns&, std::integral_constant<int, Kind>) noexcept
+    {
+    }
+
+    template <std::size_t I>
+    void move_column(const Columns&, std::integral_constant<int, 0>) noexcept;
+    template <std::size_t I>
+    void move_column(const Columns&, std::integral_constant<int, 1>) noexcept;
+    template <std::size_t I>
+    void move_column(const Columns&, std::integral_constant<int, 2>) noexcept;
+
+    template <typename... Args>
+    void emplace_back_slow(Args&&...);
+    void reallocate(size_type);
+    size_type growth_capacity(size_type) const;
+
+    void copy_assign_alloc(const basic_soa_vector&, std::true_type);
+    void copy_assign_alloc(const basic_soa_vector&, std::false_type) noexcept
+    {
+    }
+    void move_assign(basic_soa_vector&, std::true_type) noexcept;
+    void move_assign(basic_soa_vector&, std::false_type);
+    void swap_alloc(basic_soa_vector&, std::true_type) noexcept;
+    void swap_alloc(basic_soa_vector&, std::false_type) noexcept {}
+    void steal(basic_soa_vector&) noexcept;
+
+    void throw_out_of_range() const;
+    void throw_length_error() const;
+
+    allocator_type& alloc_() noexcept { return cap_alloc_.second(); }
+    const allocator_type& alloc_() const noexcept
+    {
+      return cap_alloc_.second();
+    }
+  };
+
+  template <typename... Ts>
+  using soa_vector = basic_soa_vector<std::allocator<unsigned char>, Ts...>;
+
+  template <typename Allocator, typename... Ts>
+  constexpr typename basic_soa_vector<Allocator, Ts...>::size_type
+      basic_soa_vector<Allocator, Ts...>::column_count;
+
+  template <typename Allocator, typename... Ts>
+  constexpr typename basic_soa_vector<Allocator, Ts...>::size_type
+      basic_soa_vector<Allocator, Ts...>::column_alignment;
+
+  template <typename Allocator, typename... Ts>
+  basic_soa_vector<Allocator, Ts...>::basic_soa_vector(
+      const allocator_type& alloc) noexcept :
+    columns_(),
+    block_(nullptr),
+    size_(0),
+    cap_alloc_(size_type(0), alloc)
+  {
+  }
+
+  template <typename Allocator, typename... Ts>
+  basic_soa_vector<Allocator, Ts...>::basic_soa_vector(size_type size,
+      const allocator_type& alloc) :
+    basic_soa_vector(alloc)
+  {
+    resize(size);
+  }
+
+  template <typename Allocator, typename... Ts>
+  basic_soa_vector<Allocator, Ts...>::basic_soa_vector(
+      const basic_soa_vector& rhs) :
+    basic_soa_vector(
+        AllocTraits::select_on_container_copy_construction(rhs.alloc_()))
+  {
+    // The delegated constructor has finished, so if a copy throws the
+    // destructor releases the rows copied so far and the block.
+    reserve(rhs.size_);
+    for (size_type i = 0; i != rhs.size_; ++i) {
+      copy_row(rhs, i, Indices());
+    }
+  }
+
+  template <typename Allocator, typename... Ts>
+  basic_soa_vector<Allocator, Ts...>::basic_soa_vector(
+      basic_soa_vector&& rhs) noexcept :
+    columns_(std::exchange(rhs.columns_, Columns())),
+    block_(std::exchange(rhs.block_, nullptr)),
+    size_(std::exchange(rhs.size_, 0)),
+    cap_alloc_(std::exchange(rhs.cap_alloc_.first(), 0),
+        std::move(rhs.alloc_()))
+  {
+  }
+
+  template <typename Allocator, typename... Ts>
+  basic_soa_vector<Allocator, Ts...>::~basic_soa_vector()
+  {
+    clear();
+    deallocate(block_, capacity());
+  }
+
+  template <typename Allocator, typename... Ts>
+  basic_soa_vector<Allocator, Ts...>&
+  basic_soa_vector<Allocator, Ts...>::operator=(const basic_soa_vector& rhs)
+  {
+    if (this != &rhs) {
+      clear();
+      copy_assign_alloc(rhs, PropagateOnCopy());
+      reserve(rhs.size_);
+      for (size_type i = 0; i != rhs.size_; ++i) {
+        copy_row(rhs, i, Indices());
+      }
+    }
+    return *this;
+  }
+
+  template <typename Allocator, typename... Ts>
+  basic_soa_vector<Allocator, Ts...>&
+  basic_soa_vector<Allocator, Ts...>::operator=(
+      basic_soa_vector&& rhs) noexcept(CanStealOnMove::value)
+  {
+    if (this != &rhs) {
+      move_assign(rhs, CanStealOnMove());
+    }
+    return *this;
+  }
+
+  template <typename Allocator, typename... Ts>
+  typename basic_soa_vector<Allocator, Ts...>::reference
+  basic_soa_vector<Allocator, Ts...>::at(size_type i)
+  {
+    if (i >= size_) {
+      throw_out_of_range();
+    }
+    return row(i, Indices());
+  }
+
+  template <typename Allocator, typename... Ts>
+  typename basic_soa_vector<Allocator, Ts...>::const_reference
+  basic_soa_vector<Allocator, Ts...>::at(size_type i) const
+  {
+    if (i >= size_) {
+      throw_out_of_range();
+    }
+    return row(i, Indices());
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::reserve(size_type new_capacity)
+  {
+    if (new_capacity <= capacity()) {
+      return;
+    }
+    if (new_capacity > max_size()) {
+      throw_length_error();
+    }
+    reallocate(new_capacity);
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::resize(size_type new_size)
+  {
+    if (new_size <= size_) {
+      destroy_rows(new_size, size_);
+      size_ = new_size;
+      return;
+    }
+    reserve(new_size);
+    for (; size_ != new_size; ++size_) {
+      construct_row(columns_, size_, std::tuple<>(),
+          std::integral_constant<std::size_t, 0>());
+    }
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::shrink_to_fit()
+  {
+    if (capacity() == size_) {
+      return;
+    }
+    if (size_ == 0) {
+      deallocate(block_, capacity());
+      install(storage{ nullptr, Columns() }, 0);
+      return;
+    }
+    reallocate(size_);
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::clear() noexcept
+  {
+    destroy_rows(0, size_);
+    size_ = 0;
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::swap(basic_soa_vector& rhs) noexcept
+  {
+    using std::swap;
+    swap(columns_, rhs.columns_);
+    swap(block_, rhs.block_);
+    swap(size_, rhs.size_);
+    swap(cap_alloc_.first(), rhs.cap_alloc_.first());
+    swap_alloc(rhs, PropagateOnSwap());
+  }
+
+  template <typename Allocator, typename... Ts>
+  template <typename... Args>
+  typename basic_soa_vector<Allocator, Ts...>::reference
+  basic_soa_vector<Allocator, Ts...>::emplace_back(Args&&... args)
+  {
+    static_assert(sizeof...(Args) == column_count,
+        "ftl::soa_vector::emplace_back takes one argument per column");
+    if (size_ == capacity()) {
+      emplace_back_slow(std::forward<Args>(args)...);
+    } else {
+      construct_row(columns_, size_,
+          std::forward_as_tuple(std::forward<Args>(args)...),
+          std::integral_constant<std::size_t, 0>());
+      ++size_;
+    }
+    return back();
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::pop_back() noexcept
+  {
+    --size_;
+    destroy_rows(size_, size_ + 1);
+  }
+
+  template <typename Allocator, typename... Ts>
+  typename basic_soa_vector<Allocator, Ts...>::size_type
+  basic_soa_vector<Allocator, Ts...>::max_size() const noexcept
+  {
+    const size_type row_bytes[] = { sizeof(Ts)... };
+    size_type bytes = 0;
+    for (size_type size : row_bytes) {
+      bytes += size;
+    }
+    const size_type limit = ByteTraits::max_size(ByteAlloc(alloc_()));
+    const size_type padding = (column_count + 1) * column_alignment;
+    return limit > padding ? (limit - padding) / bytes : 0;
+  }
+
+  // Lays the columns out one after another, each rounded up to a whole
+  // number of alignment units, and returns the bytes they take together.
+  template <typename Allocator, typename... Ts>
+  typename basic_soa_vector<Allocator, Ts...>::size_type
+  basic_soa_vector<Allocator, Ts...>::column_offsets(size_type capacity,
+      size_type* offsets) noexcept
+  {
+    const size_type sizes[] = { sizeof(Ts)... };
+    size_type offset = 0;
+    for (size_type i = 0; i != column_count; ++i) {
+      offsets[i] = offset;
+      const size_type bytes = capacity * sizes[i];
+      offset += (bytes + column_alignment - 1) / column_alignment *
+          column_alignment;
+    }
+    return offset;
+  }
+
+  template <typename Allocator, typename... Ts>
+  typename basic_soa_vector<Allocator, Ts...>::size_type
+  basic_soa_vector<Allocator, Ts...>::block_bytes(size_type capacity) noexcept
+  {
+    size_type offsets[column_count];
+    return column_offsets(capacity, offsets) + column_alignment - 1;
+  }
+
+  template <typename Allocator, typename... Ts>
+  typename basic_soa_vector<Allocator, Ts...>::storage
+  basic_soa_vector<Allocator, Ts...>::allocate(size_type capacity)
+  {
+    size_type offsets[column_count];
+    column_offsets(capacity, offsets);
+    ByteAlloc alloc(alloc_());
+    unsigned char* block = ByteTraits::allocate(alloc, block_bytes(capacity));
+    const auto address = reinterpret_cast<std::uintptr_t>(block);
+    unsigned char* base = block +
+        (column_alignment - address % column_alignment) % column_alignment;
+    return storage{ block, make_columns(base, offsets, Indices()) };
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::deallocate(unsigned char* block,
+      size_type capacity) noexcept
+  {
+    if (block != nullptr) {
+      ByteAlloc alloc(alloc_());
+      ByteTraits::deallocate(alloc, block, block_bytes(capacity));
+    }
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::install(const storage& fresh,
+      size_type capacity) noexcept
+  {
+    block_ = fresh.block;
+    columns_ = fresh.columns;
+    cap_alloc_.first() = capacity;
+  }
+
+  template <typename Allocator, typename... Ts>
+  template <std::size_t... I>
+  typename basic_soa_vector<Allocator, Ts...>::Columns
+  basic_soa_vector<Allocator, Ts...>::make_columns(unsigned char* base,
+      const size_type* offsets, std::index_sequence<I...>) noexcept
+  {
+    return Columns(reinterpret_cast<Ts*>(base + offsets[I])...);
+  }
+
+  // Constructs column I onwards of one row from the matching elements of
+  // args, or value-initializes them if args is empty. A throw destroys the
+  // columns of the row constructed so far.
+  template <typename Allocator, typename... Ts>
+  template <typename Args, std::size_t I>
+  void basic_soa_vector<Allocator, Ts...>::construct_row(
+      const Columns& columns, size_type i, Args&& args,
+      std::integral_constant<std::size_t, I>)
+  {
+    ColumnAlloc<I> alloc = column_alloc<I>();
+    column_type<I>* p = std::get<I>(columns) + i;
+    detail::construct_from_tuple<I>(alloc, p, std::forward<Args>(args));
+    auto deleter = [&alloc, p]() { ColumnTraits<I>::destroy(alloc, p); };
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    construct_row(columns, i, std::forward<Args>(args),
+        std::integral_constant<std::size_t, I + 1>());
+    guard.complete();
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::destroy_rows(size_type first,
+      size_type last) noexcept
+  {
+    for_each_column(
+        [&](auto i) {
+          constexpr std::size_t I = decltype(i)::value;
+          ColumnAlloc<I> alloc = column_alloc<I>();
+          detail::destroy(alloc, std::get<I>(columns_) + first,
+              std::get<I>(columns_) + last);
+        },
+        Indices());
+  }
+
+  // Carries every row over into columns, a freshly allocated block. The
+  // columns that would be copied go first; if one of them throws, only
+  // those copies are undone and the current block is left as it was.
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::relocate_into(const Columns& columns)
+  {
+    std::size_t copied = 0;
+    auto deleter = [&]() {
+      for_each_column(
+          [&](auto i) {
+            constexpr std::size_t I = decltype(i)::value;
+            if (I < copied) {
+              uncopy_column<I>(columns, growth_kind<I>());
+            }
+          },
+          Indices());
+    };
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    for_each_column(
+        [&](auto i) {
+          constexpr std::size_t I = decltype(i)::value;
+          copy_column<I>(columns, growth_kind<I>());
+          ++copied;
+        },
+        Indices());
+    guard.complete();
+    for_each_column(
+        [&](auto i) {
+          constexpr std::size_t I = decltype(i)::value;
+          move_column<I>(columns, growth_kind<I>());
+        },
+        Indices());
+  }
+
+  template <typename Allocator, typename... Ts>
+  template <std::size_t I>
+  void basic_soa_vector<Allocator, Ts...>::copy_column(const Columns& columns,
+      std::integral_constant<int, 1>)
+  {
+    ColumnAlloc<I> alloc = column_alloc<I>();
+    detail::uninitialized_copy(alloc, std::get<I>(columns_),
+        std::get<I>(columns_) + size_, std::get<I>(columns));
+  }
+
+  template <typename Allocator, typename... Ts>
+  template <std::size_t I>
+  void basic_soa_vector<Allocator, Ts...>::uncopy_column(
+      const Columns& columns, std::integral_constant<int, 1>) noexcept
+  {
+    ColumnAlloc<I> alloc = column_alloc<I>();
+    detail::destroy(alloc, std::get<I>(columns),
+        std::get<I>(columns) + size_);
+  }
+
+  template <typename Allocator, typename... Ts>
+  template <std::size_t I>
+  void basic_soa_vector<Allocator, Ts...>::move_column(const Columns& columns,
+      std::integral_constant<int, 0>) noexcept
+  {
+    detail::relocate(std::get<I>(columns_), std::get<I>(columns_) + size_,
+        std::get<I>(columns));
+  }
+
+  template <typename Allocator, typename... Ts>
+  template <std::size_t I>
+  void basic_soa_vector<Allocator, Ts...>::move_column(const Columns&,
+      std::integral_constant<int, 1>) noexcept
+  {
+    ColumnAlloc<I> alloc = column_alloc<I>();
+    detail::destroy(alloc, std::get<I>(columns_),
+        std::get<I>(columns_) + size_);
+  }
+
+  template <typename Allocator, typename... Ts>
+  template <std::size_t I>
+  void basic_soa_vector<Allocator, Ts...>::move_column(const Columns& columns,
+      std::integral_constant<int, 2>) noexcept
+  {
+    static_assert(std::is_nothrow_move_constructible<column_type<I>>::value,
+        "ftl::soa_vector columns must be copyable or nothrow movable");
+    ColumnAlloc<I> alloc = column_alloc<I>();
+    column_type<I>* from = std::get<I>(columns_);
+    column_type<I>* to = std::get<I>(columns);
+    for (size_type i = 0; i != size_; ++i) {
+      ColumnTraits<I>::construct(alloc, to + i, std::move(from[i]));
+      ColumnTraits<I>::destroy(alloc, from + i);
+    }
+  }
+
+  // The new row is built in the new block before the old rows move, so
+  // arguments that refer into the vector stay valid while it is built.
+  template <typename Allocator, typename... Ts>
+  template <typename... Args>
+  void basic_soa_vector<Allocator, Ts...>::emplace_back_slow(Args&&... args)
+  {
+    const size_type new_capacity = growth_capacity(size_ + 1);
+    storage fresh = allocate(new_capacity);
+    auto deleter = [&]() { deallocate(fresh.block, new_capacity); };
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    construct_row(fresh.columns, size_,
+        std::forward_as_tuple(std::forward<Args>(args)...),
+        std::integral_constant<std::size_t, 0>());
+    auto row_deleter = [&]() {
+      for_each_column(
+          [&](auto i) {
+            constexpr std::size_t I = decltype(i)::value;
+            ColumnAlloc<I> alloc = column_alloc<I>();
+            ColumnTraits<I>::destroy(alloc, std::get<I>(fresh.columns) + size_);
+          },
+          Indices());
+    };
+    detail::exception_guard<decltype(row_deleter)> row_guard(row_deleter);
+    relocate_into(fresh.columns);
+    row_guard.complete();
+    guard.complete();
+    deallocate(block_, capacity());
+    install(fresh, new_capacity);
+    ++size_;
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::reallocate(size_type new_capacity)
+  {
+    storage fresh = allocate(new_capacity);
+    auto deleter = [&]() { deallocate(fresh.block, new_capacity); };
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    relocate_into(fresh.columns);
+    guard.complete();
+    deallocate(block_, capacity());
+    install(fresh, new_capacity);
+  }
+
+  template <typename Allocator, typename... Ts>
+  typename basic_soa_vector<Allocator, Ts...>::size_type
+  basic_soa_vector<Allocator, Ts...>::growth_capacity(
+      size_type new_capacity) const
+  {
+    const size_type max_sz = max_size();
+    if (new_capacity > max_sz) {
+      throw_length_error();
+    }
+    return growth_factor_2::template recommend<value_type>(capacity(),
+        new_capacity, max_sz);
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::copy_assign_alloc(
+      const basic_soa_vector& rhs, std::true_type)
+  {
+    if (alloc_() != rhs.alloc_()) {
+      deallocate(block_, capacity());
+      install(storage{ nullptr, Columns() }, 0);
+    }
+    alloc_() = rhs.alloc_();
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::move_assign(basic_soa_vector& rhs,
+      std::true_type) noexcept
+  {
+    clear();
+    deallocate(block_, capacity());
+    steal(rhs);
+    if (PropagateOnMove::value) {
+      alloc_() = std::move(rhs.alloc_());
+    }
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::move_assign(basic_soa_vector& rhs,
+      std::false_type)
+  {
+    if (alloc_() == rhs.alloc_()) {
+      move_assign(rhs, std::true_type());
+      return;
+    }
+    clear();
+    reserve(rhs.size_);
+    for (size_type i = 0; i != rhs.size_; ++i) {
+      move_row(rhs, i, Indices());
+    }
+    rhs.clear();
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::swap_alloc(basic_soa_vector& rhs,
+      std::true_type) noexcept
+  {
+    using std::swap;
+    swap(alloc_(), rhs.alloc_());
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::steal(
+      basic_soa_vector& rhs) noexcept
+  {
+    columns_ = std::exchange(rhs.columns_, Columns());
+    block_ = std::exchange(rhs.block_, nullptr);
+    size_ = std::exchange(rhs.size_, 0);
+    cap_alloc_.first() = std::exchange(rhs.cap_alloc_.first(), 0);
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::throw_out_of_range() const
+  {
+    throw std::out_of_range("ftl::soa_vector out_of_range");
+  }
+
+  template <typename Allocator, typename... Ts>
+  void basic_soa_vector<Allocator, Ts...>::throw_length_error() const
+  {
+    throw std::length_error("ftl::soa_vector length_error");
+  }
+
+  template <typename Allocator, typename... Ts>
+  void swap(basic_soa_vector<Allocator, Ts...>& lhs,
+      basic_soa_vector<Allocator, Ts...>& rhs) noexcept
+  {
+    lhs.swap(rhs);
+  }
+
+  namespace detail {
+
+    template <typename Allocator, typename... Ts, std::size_t... I>
+    bool soa_equal(const basic_soa_vector<Allocator, Ts...>& lhs,
+        const basic_soa_vector<Allocator, Ts...>& rhs,
+        std::index_sequence<I...>)
+    {
+      bool equal = lhs.size() == rhs.size();
+      using expand = int[];
+      (void)expand{ 0,
+        (equal = equal &&
+              contiguous_equal(lhs.template data<I>(),
+                  rhs.template data<I>(), lhs.size()),
+            0)... };
+      return equal;
+    }
+  }
+
+  // Compares column by column, each with the contiguous fast paths.
+  template <typename Allocator, typename... Ts>
+  bool operator==(const basic_soa_vector<Allocator, Ts...>& lhs,
+      const basic_soa_vector<Allocator, Ts...>& rhs)
+  {
+    return detail::soa_equal(lhs, rhs, std::index_sequence_for<Ts...>());
+  }
+
+#if !defined(FTL_CPP20_FEATURES)
+
+  template <typename Allocator, typename... Ts>
+  bool operator!=(const basic_soa_vector<Allocator, Ts...>& lhs,
+      const basic_soa_vector<Allocator, Ts...>& rhs)
+  {
+    return !(lhs == rhs);
+  }
+
+#endif
+}
+
+#endif
@@ -10,38 +10,30 @@
 #include <limits>
 #include <memory>
 #include <type_traits>
+#include "../internal/compare.hpp"
 #include "../internal/compressed_pair.hpp"
+#include "../internal/config.hpp"
 #include "../internal/exception_guard.hpp"
+#include "../internal/growth_policy.hpp"
+#include "../internal/hash.hpp"
+#include "../internal/relocate.hpp"
+#include "../internal/stats.hpp"
+#include "../internal/type_traits.hpp"
+#include "../internal/uninitialized.hpp"
 #include "../internal/wrap_iterator.hpp"
 
-namespace ftl {
-  namespace detail {
-
-    template <typename...>
-    using void_t = void;
-
-    template <typename T, typename = void>
-    struct is_input_iterator : std::false_type
-    {
-    };
-
-    template <typename T>
-    struct is_input_iterator<T,
-        void_t<typename std::iterator_traits<T>::iterator_category>> :
-      std::is_base_of<std::input_iterator_tag,
-          typename std::iterator_traits<T>::iterator_category>
-    {
-    };
-
-    template <typename Iterator>
-    using enable_if_input_iterator =
-        typename std::enable_if<is_input_iterator<Iterator>::value, int>::type;
-  }
-}
+#if defined(FTL_CPP17_FEATURES)
+#  include <memory_resource>
+#endif
 
 namespace ftl {
 
-  template <typename T, typename Allocator = std::allocator<T>>
+  // GrowthPolicy chooses the capacity to grow to once the vector is full;
+  // see growth_policy.hpp for the requirements and the built-in policies.
+  // Stats is told about allocations, reallocations and element shifts; see
+  // stats.hpp. The default records nothing.
+  template <typename T, typename Allocator = std::allocator<T>,
+      typename GrowthPolicy = growth_factor_2, typename Stats = no_stats>
   class vector final
   {
   public:
@@ -52,6 +44,16 @@ namespace ftl {
 
   private:
     using AllocTraits = std::allocator_traits<allocator_type>;
+    using StorageTraits = detail::storage_traits<allocator_type>;
+    using CanRelocate = detail::is_relocatable_with<allocator_type>;
+    using CanSkipInit = detail::is_trivially_default_init_with<allocator_type>;
+    using PropagateOnCopy =
+        typename AllocTraits::propagate_on_container_copy_assignment;
+    using PropagateOnMove =
+        typename AllocTraits::propagate_on_container_move_assignment;
+    using PropagateOnSwap = typename AllocTraits::propagate_on_container_swap;
+    using CanStealOnMove = std::integral_constant<bool,
+        PropagateOnMove::value || AllocTraits::is_always_equal::value>;
 
   public:
     using pointer = typename AllocTraits::pointer;
@@ -68,6 +70,7 @@ namespace ftl {
     vector(vector&&) noexcept;
     vector(const allocator_type& alloc);
     vector(size_type, const allocator_type& = allocator_type());
+    vector(size_type, default_init_t, const allocator_type& = allocator_type());
     vector(size_type, const_reference,
         const allocator_type& = allocator_type());
     template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
@@ -77,12 +80,14 @@ namespace ftl {
     ~vector();
 
     vector& operator=(const vector&) &;
-    vector& operator=(vector&&) & noexcept;
+    vector& operator=(vector&&) & noexcept(CanStealOnMove::value);
     reference operator[](size_type i) noexcept;
     const_reference operator[](size_type i) const noexcept;
 
     void reserve(size_type);
-    void resize(size_type, const_reference = value_type());
+    void resize(size_type);
+    void resize(size_type, const_reference);
+    void resize_for_overwrite(size_type);
     void shrink_to_fit();
     void clear() noexcept;
     void swap(vector&) noexcept;
@@ -110,6 +115,8 @@ namespace ftl {
     iterator emplace(const_iterator, Args&&...);
     template <typename... Args>
     void emplace_back(Args&&...);
+    template <typename Writer>
+    size_type append_uninitialized(size_type, Writer);
 
     iterator erase(const_iterator);
     iterator erase(const_iterator, const_iterator);
@@ -147,19 +154,74 @@ namespace ftl {
 
     void allocate(size_type);
     void deallocate() noexcept;
+    void copy_assign_alloc(const vector&, std::true_type);
+    void copy_assign_alloc(const vector&, std::false_type) noexcept {}
+    void move_assign(vector&, std::true_type) noexcept;
+    void move_assign(vector&, std::false_type);
+    void move_assign_alloc(vector&, std::true_type) noexcept;
+    void move_assign_alloc(vector&, std::false_type) noexcept {}
+    void swap_alloc(vector&, std::true_type) noexcept;
+    void swap_alloc(vector&, std::false_type) noexcept {}
 
     template <typename InputIt, detail::enable_if_input_iterator<InputIt> = 0>
     void construct_at_end(InputIt, InputIt);
     template <typename... Args>
     void construct_at_end(size_type, Args&&...);
+    void default_init_at_end(size_type, std::true_type) noexcept;
+    void default_init_at_end(size_type, std::false_type);
     void destroy_at_end(pointer) noexcept;
+    void ensure_spare_capacity(size_type);
+
+    template <typename InputIt>
+    void append_range(InputIt, InputIt, std::input_iterator_tag);
+    template <typename ForwardIt>
+    void append_range(ForwardIt, ForwardIt, std::forward_iterator_tag);
+    template <typename InputIt>
+    void assign_range(InputIt, InputIt, std::input_iterator_tag);
+    template <typename ForwardIt>
+    void assign_range(ForwardIt, ForwardIt, std::forward_iterator_tag);
+    template <typename InputIt>
+    pointer insert_range(pointer, InputIt, InputIt, std::input_iterator_tag);
+    template <typename ForwardIt>
+    pointer
+    insert_range(pointer, ForwardIt, ForwardIt, std::forward_iterator_tag);
+    template <typename ForwardIt>
+    void insert_range_in_place(std::true_type, pointer, ForwardIt, ForwardIt,
+        size_type);
+    pointer insert_fill(pointer, size_type, const_reference);
+    void insert_fill_in_place(std::true_type, pointer, size_type,
+        const_reference);
+    void insert_fill_in_place(std::false_type, pointer, size_type,
+        const_reference);
+    template <typename ForwardIt>
+    void insert_range_in_place(std::false_type, pointer, ForwardIt, ForwardIt,
+        size_type);
 
     template <typename... Args>
-    pointer emplace_unsafe(pointer, Args&&...);
+    void emplace_back_slow(std::true_type, Args&&...);
+    template <typename... Args>
+    void emplace_back_slow(std::false_type, Args&&...);
+    template <typename... Args>
+    pointer emplace_at(size_type, Args&&...);
+    template <typename... Args>
+    pointer emplace_at(std::true_type, size_type, Args&&...);
+    template <typename... Args>
+    pointer emplace_at(std::false_type, size_type, Args&&...);
 
     void reallocate_storage(size_type);
-    void move_right_uninitialized(pointer);
-    void move_right(pointer, pointer);
+    void reallocate_storage(size_type, std::true_type);
+    void reallocate_storage(size_type, std::false_type);
+    bool expand_in_place(size_type);
+    void swap_out_storage(pointer, size_type, pointer, size_type);
+    void swap_out_storage(pointer, size_type, pointer, size_type,
+        std::true_type) noexcept;
+    void swap_out_storage(pointer, size_type, pointer, size_type,
+        std::false_type);
+    void move_right(pointer, pointer, pointer);
+    void move_right(pointer, pointer, pointer, std::true_type) noexcept;
+    void move_right(pointer, pointer, pointer, std::false_type);
+    void move_left(pointer, pointer, std::true_type) noexcept;
+    void move_left(pointer, pointer, std::false_type);
     size_type growth_capacity(size_type) const;
 
     void throw_out_of_range() const;
@@ -171,8 +233,10 @@ namespace ftl {
     const allocator_type& alloc_() const noexcept;
   };
 
-  template <typename T, typename Allocator>
-  vector<T, Allocator>::vector(const vector& rhs) : vector(rhs.alloc_())
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  vector<T, Allocator, GrowthPolicy, Stats>::vector(const vector& rhs) :
+    vector(AllocTraits::select_on_container_copy_construction(rhs.alloc_()))
   {
     allocate(rhs.size());
     detail::exception_guard<Deleter> guard(Deleter(*this));
@@ -180,31 +244,54 @@ namespace ftl {
     guard.complete();
   }
 
-  template <typename T, typename Allocator>
-  vector<T, Allocator>::vector(vector&& rhs) noexcept :
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  vector<T, Allocator, GrowthPolicy, Stats>::vector(vector&& rhs) noexcept :
     begin_(std::exchange(rhs.begin_, nullptr)),
     end_(std::exchange(rhs.end_, nullptr)),
     end_cap_alloc_(std::move(rhs.end_cap_alloc_))
   {
+    rhs.end_cap_() = nullptr;
   }
 
-  template <typename T, typename Allocator>
-  vector<T, Allocator>::vector(const allocator_type& alloc) :
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  vector<T, Allocator, GrowthPolicy, Stats>::vector(
+      const allocator_type& alloc) :
     begin_(nullptr),
     end_(nullptr),
     end_cap_alloc_(nullptr, alloc)
   {
   }
 
-  template <typename T, typename Allocator>
-  vector<T, Allocator>::vector(size_type size, const allocator_type& alloc) :
-    vector(size, value_type(), alloc)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  vector<T, Allocator, GrowthPolicy, Stats>::vector(size_type size,
+      const allocator_type& alloc) :
+    vector(alloc)
   {
+    allocate(size);
+    detail::exception_guard<Deleter> guard(Deleter(*this));
+    construct_at_end(size);
+    guard.complete();
   }
 
-  template <typename T, typename Allocator>
-  vector<T, Allocator>::vector(size_type size, const_reference value,
-      const allocator_type& alloc) :
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  vector<T, Allocator, GrowthPolicy, Stats>::vector(size_type size,
+      default_init_t, const allocator_type& alloc) :
+    vector(alloc)
+  {
+    allocate(size);
+    detail::exception_guard<Deleter> guard(Deleter(*this));
+    default_init_at_end(size, CanSkipInit());
+    guard.complete();
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  vector<T, Allocator, GrowthPolicy, Stats>::vector(size_type size,
+      const_reference value, const allocator_type& alloc) :
     vector(alloc)
   {
     allocate(size);
@@ -213,22 +300,23 @@ namespace ftl {
     guard.complete();
   }
 
-  template <typename T, typename Allocator>
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
   template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
-  vector<T, Allocator>::vector(InputIt first, InputIt last,
+  vector<T, Allocator, GrowthPolicy, Stats>::vector(InputIt first, InputIt last,
       const allocator_type& alloc) :
     vector(alloc)
   {
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
     detail::exception_guard<Deleter> guard(Deleter(*this));
-    for (; first != last; ++first) {
-      emplace_back(*first);
-    }
+    append_range(first, last, category());
     guard.complete();
   }
 
-  template <typename T, typename Allocator>
-  vector<T, Allocator>::vector(std::initializer_list<value_type> list,
-      const allocator_type& alloc) :
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  vector<T, Allocator, GrowthPolicy, Stats>::vector(
+      std::initializer_list<value_type> list, const allocator_type& alloc) :
     vector(alloc)
   {
     allocate(list.size());
@@ -237,44 +325,57 @@ namespace ftl {
     guard.complete();
   }
 
-  template <typename T, typename Allocator>
-  vector<T, Allocator>::~vector()
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  vector<T, Allocator, GrowthPolicy, Stats>::~vector()
   {
     deallocate();
   }
 
-  template <typename T, typename Allocator>
-  vector<T, Allocator>& vector<T, Allocator>::operator=(const vector& rhs) &
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  vector<T, Allocator, GrowthPolicy, Stats>&
+  vector<T, Allocator, GrowthPolicy, Stats>::operator=(const vector& rhs) &
   {
-    vector copy = rhs;
-    swap(copy);
+    if (this != &rhs) {
+      copy_assign_alloc(rhs, PropagateOnCopy());
+      assign(rhs.begin_, rhs.end_);
+    }
     return *this;
   }
 
-  template <typename T, typename Allocator>
-  vector<T, Allocator>& vector<T, Allocator>::operator=(vector&& rhs) & noexcept
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  vector<T, Allocator, GrowthPolicy, Stats>&
+  vector<T, Allocator, GrowthPolicy, Stats>::operator=(vector&& rhs) & noexcept(
+      CanStealOnMove::value)
   {
-    deallocate();
-    swap(rhs);
+    move_assign(rhs, CanStealOnMove());
     return *this;
   }
 
-  template <typename T, typename Allocator>
-  typename vector<T, Allocator>::reference
-  vector<T, Allocator>::operator[](size_type index) noexcept
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::reference
+  vector<T, Allocator, GrowthPolicy, Stats>::operator[](
+      size_type index) noexcept
   {
     return *(begin_ + index);
   }
 
-  template <typename T, typename Allocator>
-  typename vector<T, Allocator>::const_reference
-  vector<T, Allocator>::operator[](size_type index) const noexcept
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::const_reference
+  vector<T, Allocator, GrowthPolicy, Stats>::operator[](
+      size_type index) const noexcept
   {
     return *(begin_ + index);
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::reserve(size_type new_capacity)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::reserve(
+      size_type new_capacity)
   {
     if (new_capacity <= capacity()) {
       return;
@@ -285,21 +386,48 @@ namespace ftl {
     reallocate_storage(new_capacity);
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::resize(size_type new_size, const_reference value)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::resize(size_type new_size)
+  {
+    if (size() >= new_size) {
+      destroy_at_end(begin_ + new_size);
+      return;
+    }
+    ensure_spare_capacity(new_size - size());
+    construct_at_end(new_size - size());
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::resize(size_type new_size,
+      const_reference value)
   {
     if (size() >= new_size) {
       destroy_at_end(begin_ + new_size);
       return;
     }
-    if (capacity() < new_size) {
-      reallocate_storage(growth_capacity(new_size));
+    insert_fill(end_, new_size - size(), value);
+  }
+
+  // Like resize, but new elements are default initialized: trivial types are
+  // left with indeterminate values for the caller to overwrite.
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::resize_for_overwrite(
+      size_type new_size)
+  {
+    if (size() >= new_size) {
+      destroy_at_end(begin_ + new_size);
+      return;
     }
-    construct_at_end(new_size - size(), value);
+    ensure_spare_capacity(new_size - size());
+    default_init_at_end(new_size - size(), CanSkipInit());
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::shrink_to_fit()
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::shrink_to_fit()
   {
     if (end_ == end_cap_()) {
       return;
@@ -307,42 +435,50 @@ namespace ftl {
     reallocate_storage(size());
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::clear() noexcept
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::clear() noexcept
   {
     destroy_at_end(begin_);
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::swap(vector& rhs) noexcept
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::swap(vector& rhs) noexcept
   {
     using std::swap;
     swap(begin_, rhs.begin_);
     swap(end_, rhs.end_);
-    swap(end_cap_alloc_, rhs.end_cap_alloc_);
+    swap(end_cap_(), rhs.end_cap_());
+    swap_alloc(rhs, PropagateOnSwap());
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::push_back(const_reference value)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::push_back(
+      const_reference value)
   {
     emplace_back(value);
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::push_back(value_type&& value)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::push_back(value_type&& value)
   {
     emplace_back(std::forward<value_type>(value));
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::pop_back()
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::pop_back()
   {
     destroy_at_end(end_ - 1);
   }
 
-  template <typename T, typename Allocator>
-  typename vector<T, Allocator>::reference
-  vector<T, Allocator>::at(size_type index)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::reference
+  vector<T, Allocator, GrowthPolicy, Stats>::at(size_type index)
   {
     if (index >= size()) {
       throw_out_of_range();
@@ -350,9 +486,10 @@ namespace ftl {
     return *(begin_ + index);
   }
 
-  template <typename T, typename Allocator>
-  typename vector<T, Allocator>::const_reference
-  vector<T, Allocator>::at(size_type index) const
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::const_reference
+  vector<T, Allocator, GrowthPolicy, Stats>::at(size_type index) const
   {
     if (index >= size()) {
       throw_out_of_range();
@@ -360,11 +497,13 @@ namespace ftl {
     return *(begin_ + index);
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::assign(size_type size, const_reference value)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::assign(size_type size,
+      const_reference value)
   {
     if (capacity() < size) {
-      vector tmp(size, value);
+      vector tmp(size, value, alloc_());
       swap(tmp);
       return;
     }
@@ -372,21 +511,23 @@ namespace ftl {
     construct_at_end(size, value);
   }
 
-  template <typename T, typename Allocator>
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
   template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
-  void vector<T, Allocator>::assign(InputIt first, InputIt last)
+  void vector<T, Allocator, GrowthPolicy, Stats>::assign(InputIt first,
+      InputIt last)
   {
-    clear();
-    for (; first != last; ++first) {
-      emplace_back(*first);
-    }
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    assign_range(first, last, category());
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::assign(std::initializer_list<value_type> list)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::assign(
+      std::initializer_list<value_type> list)
   {
     if (capacity() < list.size()) {
-      vector tmp(list);
+      vector tmp(list, alloc_());
       swap(tmp);
       return;
     }
@@ -394,111 +535,115 @@ namespace ftl {
     construct_at_end(list.begin(), list.end());
   }
 
-  template <typename T, typename Allocator>
-  typename vector<T, Allocator>::iterator
-  vector<T, Allocator>::insert(const_iterator position, const_reference value)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::iterator
+  vector<T, Allocator, GrowthPolicy, Stats>::insert(const_iterator position,
+      const_reference value)
   {
     return emplace(position, value);
   }
 
-  template <typename T, typename Allocator>
-  typename vector<T, Allocator>::iterator
-  vector<T, Allocator>::insert(const_iterator position, value_type&& value)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::iterator
+  vector<T, Allocator, GrowthPolicy, Stats>::insert(const_iterator position,
+      value_type&& value)
   {
     return emplace(position, std::forward<value_type>(value));
   }
 
-  template <typename T, typename Allocator>
-  typename vector<T, Allocator>::iterator
-  vector<T, Allocator>::insert(const_iterator position, size_type size,
-      const_reference value)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::iterator
+  vector<T, Allocator, GrowthPolicy, Stats>::insert(const_iterator position,
+      size_type size, const_reference value)
   {
-    size_type shift = position - begin();
-    if (end_ == end_cap_()) {
-      reallocate_storage(growth_capacity(capacity() + size));
-    }
-    pointer pos = begin_ + shift;
-    if (pos == end_) {
-      construct_at_end(size, value);
-    } else {
-      for (; size != 0; --size) {
-        pos = emplace_unsafe(pos, value) + 1;
-      }
-    }
-    return iterator(begin_ + shift);
+    pointer pos = begin_ + (position - cbegin());
+    return iterator(insert_fill(pos, size, value));
   }
 
-  template <typename T, typename Allocator>
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
   template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
-  typename vector<T, Allocator>::iterator
-  vector<T, Allocator>::insert(const_iterator position, InputIt first,
-      InputIt last)
+  typename vector<T, Allocator, GrowthPolicy, Stats>::iterator
+  vector<T, Allocator, GrowthPolicy, Stats>::insert(const_iterator position,
+      InputIt first, InputIt last)
   {
-    size_type shift = position - cbegin();
-    for (; first != last; ++first) {
-      position = emplace(position, *first);
-      ++position;
-    }
-    return iterator(begin_ + shift);
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    pointer pos = begin_ + (position - cbegin());
+    return iterator(insert_range(pos, first, last, category()));
   }
 
-  template <typename T, typename Allocator>
-  typename vector<T, Allocator>::iterator
-  vector<T, Allocator>::insert(const_iterator position,
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::iterator
+  vector<T, Allocator, GrowthPolicy, Stats>::insert(const_iterator position,
       std::initializer_list<value_type> list)
   {
-    size_type shift = position - begin();
-    if (size() + list.size() > capacity()) {
-      reallocate_storage(growth_capacity(size() + list.size()));
-    }
-    pointer pos = begin_ + shift;
-    if (pos == end_) {
-      construct_at_end(list.begin(), list.end());
-    } else {
-      for (auto i = list.begin(), end = list.end(); i != end; ++i) {
-        pos = emplace_unsafe(pos, *i) + 1;
-      }
-    }
-    return iterator(begin_ + shift);
+    return insert(position, list.begin(), list.end());
   }
 
-  template <typename T, typename Allocator>
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
   template <typename... Args>
-  typename vector<T, Allocator>::iterator
-  vector<T, Allocator>::emplace(const_iterator position, Args&&... args)
+  typename vector<T, Allocator, GrowthPolicy, Stats>::iterator
+  vector<T, Allocator, GrowthPolicy, Stats>::emplace(const_iterator position,
+      Args&&... args)
   {
     if (position == cend()) {
       emplace_back(std::forward<Args>(args)...);
       return iterator(end_ - 1);
     }
-    size_type shift = position - cbegin();
-    if (end_ == end_cap_()) {
-      reallocate_storage(growth_capacity(capacity() + 1));
-    }
-    pointer pos = begin_ + shift;
-    return iterator(emplace_unsafe(pos, std::forward<Args>(args)...));
+    return iterator(
+        emplace_at(position - cbegin(), std::forward<Args>(args)...));
   }
 
-  template <typename T, typename Allocator>
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
   template <typename... Args>
-  void vector<T, Allocator>::emplace_back(Args&&... args)
+  void vector<T, Allocator, GrowthPolicy, Stats>::emplace_back(Args&&... args)
   {
     if (end_ == end_cap_()) {
-      reallocate_storage(growth_capacity(capacity() + 1));
+      emplace_back_slow(CanRelocate(), std::forward<Args>(args)...);
+      return;
     }
-    construct_at_end(1, std::forward<Args>(args)...);
+    AllocTraits::construct(alloc_(), end_, std::forward<Args>(args)...);
+    ++end_;
+  }
+
+  // Hands writer(pointer, size_type) up to count elements of spare capacity
+  // past end(); writer returns how many of them it wrote, and only those
+  // become part of the vector.
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  template <typename Writer>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::size_type
+  vector<T, Allocator, GrowthPolicy, Stats>::append_uninitialized(
+      size_type count, Writer writer)
+  {
+    static_assert(std::is_trivially_copyable<value_type>::value &&
+            CanSkipInit::value,
+        "append_uninitialized requires a trivial value_type");
+    ensure_spare_capacity(count);
+    const size_type written = writer(end_, count);
+    end_ += std::min(written, count);
+    return written;
   }
 
-  template <typename T, typename Allocator>
-  typename vector<T, Allocator>::iterator
-  vector<T, Allocator>::erase(const_iterator position)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::iterator
+  vector<T, Allocator, GrowthPolicy, Stats>::erase(const_iterator position)
   {
     return erase(position, position + 1);
   }
 
-  template <typename T, typename Allocator>
-  typename vector<T, Allocator>::iterator
-  vector<T, Allocator>::erase(const_iterator first, const_iterator last)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::iterator
+  vector<T, Allocator, GrowthPolicy, Stats>::erase(const_iterator first,
+      const_iterator last)
   {
     pointer first_ptr = begin_ + (first - cbegin());
     pointer last_ptr = begin_ + (last - cbegin());
@@ -506,28 +651,30 @@ namespace ftl {
     if (count == 0) {
       return iterator(first_ptr);
     }
-    std::move(last_ptr, end_, first_ptr);
-    destroy_at_end(end_ - count);
+    move_left(first_ptr, last_ptr, CanRelocate());
     return iterator(first_ptr);
   }
 
-  template <typename T, typename Allocator>
-  typename vector<T, Allocator>::const_reverse_iterator
-  vector<T, Allocator>::crbegin() const noexcept
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::const_reverse_iterator
+  vector<T, Allocator, GrowthPolicy, Stats>::crbegin() const noexcept
   {
     return const_reverse_iterator(end());
   }
 
-  template <typename T, typename Allocator>
-  typename vector<T, Allocator>::const_reverse_iterator
-  vector<T, Allocator>::crend() const noexcept
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::const_reverse_iterator
+  vector<T, Allocator, GrowthPolicy, Stats>::crend() const noexcept
   {
     return const_reverse_iterator(begin());
   }
 
-  template <typename T, typename Allocator>
-  typename vector<T, Allocator>::size_type
-  vector<T, Allocator>::max_size() const noexcept
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::size_type
+  vector<T, Allocator, GrowthPolicy, Stats>::max_size() const noexcept
   {
     using size_limits = std::numeric_limits<size_type>;
     using diff_limits = std::numeric_limits<difference_type>;
@@ -537,8 +684,9 @@ namespace ftl {
     return std::min({ alloc_max, diff_max, bytes_max });
   }
 
-  template <typename T, typename Allocator>
-  class vector<T, Allocator>::Deleter
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  class vector<T, Allocator, GrowthPolicy, Stats>::Deleter
   {
   public:
     Deleter(vector& v) : v_(v) {}
@@ -548,65 +696,407 @@ namespace ftl {
     vector& v_;
   };
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::allocate(size_type size)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::allocate(size_type size)
   {
     if (size > max_size()) {
       throw_length_error();
     }
-    begin_ = AllocTraits::allocate(alloc_(), size);
+    auto allocation = StorageTraits::allocate_at_least(alloc_(), size);
+    begin_ = allocation.ptr;
     end_ = begin_;
-    end_cap_() = begin_ + size;
+    end_cap_() = begin_ + allocation.count;
+    Stats::on_allocate(allocation.count, allocation.count * sizeof(T));
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::deallocate() noexcept
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::deallocate() noexcept
   {
     if (begin_ != nullptr) {
       clear();
-      AllocTraits::deallocate(alloc_(), begin_, capacity());
+      StorageTraits::deallocate(alloc_(), begin_, capacity());
       begin_ = end_ = end_cap_() = nullptr;
     }
   }
 
-  template <typename T, typename Allocator>
+  // A propagating allocator replaces ours, so storage obtained from ours has
+  // to go first unless the two are interchangeable.
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::copy_assign_alloc(
+      const vector& rhs, std::true_type)
+  {
+    if (alloc_() != rhs.alloc_()) {
+      deallocate();
+    }
+    alloc_() = rhs.alloc_();
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::move_assign(vector& rhs,
+      std::true_type) noexcept
+  {
+    deallocate();
+    move_assign_alloc(rhs, PropagateOnMove());
+    begin_ = std::exchange(rhs.begin_, nullptr);
+    end_ = std::exchange(rhs.end_, nullptr);
+    end_cap_() = std::exchange(rhs.end_cap_(), nullptr);
+  }
+
+  // Storage can only be taken over from an equal allocator; otherwise the
+  // elements are moved one by one into storage owned by ours.
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::move_assign(vector& rhs,
+      std::false_type)
+  {
+    if (alloc_() == rhs.alloc_()) {
+      move_assign(rhs, std::true_type());
+      return;
+    }
+    assign(std::make_move_iterator(rhs.begin_),
+        std::make_move_iterator(rhs.end_));
+    rhs.clear();
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::move_assign_alloc(vector& rhs,
+      std::true_type) noexcept
+  {
+    alloc_() = std::move(rhs.alloc_());
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::swap_alloc(vector& rhs,
+      std::true_type) noexcept
+  {
+    using std::swap;
+    swap(alloc_(), rhs.alloc_());
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
   template <typename... Args>
-  void vector<T, Allocator>::construct_at_end(size_type size, Args&&... args)
+  void vector<T, Allocator, GrowthPolicy, Stats>::construct_at_end(
+      size_type size, Args&&... args)
   {
     for (size_type i = 0; i != size; ++i, ++end_) {
       AllocTraits::construct(alloc_(), end_, args...);
     }
   }
 
-  template <typename T, typename Allocator>
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
   template <typename InputIt, detail::enable_if_input_iterator<InputIt>>
-  void vector<T, Allocator>::construct_at_end(InputIt first, InputIt last)
+  void vector<T, Allocator, GrowthPolicy, Stats>::construct_at_end(
+      InputIt first, InputIt last)
   {
     for (; first != last; ++first, ++end_) {
       AllocTraits::construct(alloc_(), end_, *first);
     }
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::destroy_at_end(pointer new_end) noexcept
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::default_init_at_end(
+      size_type size, std::true_type) noexcept
+  {
+    end_ += size;
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void
+  vector<T, Allocator, GrowthPolicy, Stats>::default_init_at_end(size_type size,
+      std::false_type)
+  {
+    construct_at_end(size);
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::ensure_spare_capacity(
+      size_type count)
+  {
+    if (count > static_cast<size_type>(end_cap_() - end_)) {
+      reallocate_storage(growth_capacity(size() + count));
+    }
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::destroy_at_end(
+      pointer new_end) noexcept
   {
     for (; end_ != new_end; --end_) {
       AllocTraits::destroy(alloc_(), end_ - 1);
     }
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::reallocate_storage(size_type new_capacity)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  template <typename InputIt>
+  void vector<T, Allocator, GrowthPolicy, Stats>::append_range(InputIt first,
+      InputIt last, std::input_iterator_tag)
+  {
+    for (; first != last; ++first) {
+      emplace_back(*first);
+    }
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  template <typename ForwardIt>
+  void vector<T, Allocator, GrowthPolicy, Stats>::append_range(ForwardIt first,
+      ForwardIt last, std::forward_iterator_tag)
+  {
+    ensure_spare_capacity(std::distance(first, last));
+    construct_at_end(first, last);
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  template <typename InputIt>
+  void vector<T, Allocator, GrowthPolicy, Stats>::assign_range(InputIt first,
+      InputIt last, std::input_iterator_tag)
+  {
+    clear();
+    append_range(first, last, std::input_iterator_tag());
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  template <typename ForwardIt>
+  void vector<T, Allocator, GrowthPolicy, Stats>::assign_range(ForwardIt first,
+      ForwardIt last, std::forward_iterator_tag)
+  {
+    if (capacity() < static_cast<size_type>(std::distance(first, last))) {
+      vector tmp(first, last, alloc_());
+      swap(tmp);
+      return;
+    }
+    clear();
+    construct_at_end(first, last);
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  template <typename InputIt>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::pointer
+  vector<T, Allocator, GrowthPolicy, Stats>::insert_range(pointer position,
+      InputIt first, InputIt last, std::input_iterator_tag)
+  {
+    const size_type shift = position - begin_;
+    const_iterator pos(position);
+    for (; first != last; ++first) {
+      pos = emplace(pos, *first);
+      ++pos;
+    }
+    return begin_ + shift;
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  template <typename ForwardIt>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::pointer
+  vector<T, Allocator, GrowthPolicy, Stats>::insert_range(pointer position,
+      ForwardIt first, ForwardIt last, std::forward_iterator_tag)
+  {
+    const size_type count = std::distance(first, last);
+    if (count == 0) {
+      return position;
+    }
+    if (count <= static_cast<size_type>(end_cap_() - end_) ||
+        expand_in_place(growth_capacity(size() + count))) {
+      insert_range_in_place(CanRelocate(), position, first, last, count);
+      return position;
+    }
+    const size_type shift = position - begin_;
+    auto allocation = StorageTraits::allocate_at_least(alloc_(),
+        growth_capacity(size() + count));
+    pointer new_begin = allocation.ptr;
+    auto deleter = [&]() {
+      StorageTraits::deallocate(alloc_(), new_begin, allocation.count);
+    };
+
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    detail::uninitialized_copy(alloc_(), first, last, new_begin + shift);
+    guard.complete();
+    Stats::on_allocate(allocation.count, allocation.count * sizeof(T));
+    if (capacity() != 0) {
+      Stats::on_reallocate(size());
+    }
+    swap_out_storage(new_begin, allocation.count, position, count);
+    return begin_ + shift;
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  template <typename ForwardIt>
+  void vector<T, Allocator, GrowthPolicy, Stats>::insert_range_in_place(
+      std::true_type, pointer position, ForwardIt first, ForwardIt last,
+      size_type count)
+  {
+    move_right(position, end_, position + count, std::true_type());
+    auto rollback = [&]() {
+      end_ = detail::relocate(position + count, end_, position);
+    };
+
+    detail::exception_guard<decltype(rollback)> guard(rollback);
+    detail::uninitialized_copy(alloc_(), first, last, position);
+    guard.complete();
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  template <typename ForwardIt>
+  void vector<T, Allocator, GrowthPolicy, Stats>::insert_range_in_place(
+      std::false_type, pointer position, ForwardIt first, ForwardIt last,
+      size_type count)
+  {
+    pointer old_end = end_;
+    const size_type tail = old_end - position;
+    ForwardIt middle = last;
+    if (count > tail) {
+      middle = first;
+      std::advance(middle, tail);
+      construct_at_end(middle, last);
+    }
+    if (tail != 0) {
+      move_right(position, old_end, position + count, std::false_type());
+      std::copy(first, middle, position);
+    }
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::pointer
+  vector<T, Allocator, GrowthPolicy, Stats>::insert_fill(pointer position,
+      size_type count, const_reference value)
+  {
+    if (count == 0) {
+      return position;
+    }
+    if (count <= static_cast<size_type>(end_cap_() - end_) ||
+        expand_in_place(growth_capacity(size() + count))) {
+      insert_fill_in_place(CanRelocate(), position, count, value);
+      return position;
+    }
+    const size_type shift = position - begin_;
+    auto allocation = StorageTraits::allocate_at_least(alloc_(),
+        growth_capacity(size() + count));
+    pointer new_begin = allocation.ptr;
+    auto deleter = [&]() {
+      StorageTraits::deallocate(alloc_(), new_begin, allocation.count);
+    };
+
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    detail::uninitialized_fill_n(alloc_(), new_begin + shift, count, value);
+    guard.complete();
+    Stats::on_allocate(allocation.count, allocation.count * sizeof(T));
+    if (capacity() != 0) {
+      Stats::on_reallocate(size());
+    }
+    swap_out_storage(new_begin, allocation.count, position, count);
+    return begin_ + shift;
+  }
+
+  // value may refer to an element of *this; once the tail has been shifted
+  // it is read from its new location.
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::insert_fill_in_place(
+      std::true_type, pointer position, size_type count, const_reference value)
+  {
+    const_pointer source = std::addressof(value);
+    if (position <= source && source < end_) {
+      source += count;
+    }
+    move_right(position, end_, position + count, std::true_type());
+    auto rollback = [&]() {
+      end_ = detail::relocate(position + count, end_, position);
+    };
+
+    detail::exception_guard<decltype(rollback)> guard(rollback);
+    detail::uninitialized_fill_n(alloc_(), position, count, *source);
+    guard.complete();
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::insert_fill_in_place(
+      std::false_type, pointer position, size_type count, const_reference value)
+  {
+    pointer old_end = end_;
+    const size_type tail = old_end - position;
+    if (count > tail) {
+      construct_at_end(count - tail, value);
+    }
+    if (tail != 0) {
+      const_pointer source = std::addressof(value);
+      move_right(position, old_end, position + count, std::false_type());
+      if (position <= source && source < end_) {
+        source += count;
+      }
+      std::fill_n(position, std::min(count, tail), *source);
+    }
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::reallocate_storage(
+      size_type new_capacity)
+  {
+    if (new_capacity == 0) {
+      deallocate();
+      return;
+    }
+    if (new_capacity > capacity() && expand_in_place(new_capacity)) {
+      return;
+    }
+    reallocate_storage(new_capacity, CanRelocate());
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::reallocate_storage(
+      size_type new_capacity, std::true_type)
+  {
+    destroy_at_end(begin_ + std::min(new_capacity, size()));
+    const size_type old_size = size();
+    const size_type old_capacity = capacity();
+    auto allocation = StorageTraits::reallocate(alloc_(), begin_, old_size,
+        old_capacity, new_capacity);
+    begin_ = allocation.ptr;
+    end_ = begin_ + old_size;
+    end_cap_() = begin_ + allocation.count;
+    Stats::on_allocate(allocation.count, allocation.count * sizeof(T));
+    if (old_capacity != 0) {
+      Stats::on_reallocate(old_size);
+    }
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::reallocate_storage(
+      size_type new_capacity, std::false_type)
   {
     // TODO: too much responsibility: should be shrink storage and expand?
-    pointer new_begin = AllocTraits::allocate(alloc_(), new_capacity);
+    auto allocation = StorageTraits::allocate_at_least(alloc_(), new_capacity);
+    new_capacity = allocation.count;
+    pointer new_begin = allocation.ptr;
     pointer new_end = new_begin;
     pointer new_end_cap = new_begin + new_capacity;
     auto deleter = [&]() {
       for (; new_end != new_begin; --new_end) {
-        AllocTraits::destroy(alloc_(), new_end);
+        AllocTraits::destroy(alloc_(), new_end - 1);
       }
-      AllocTraits::deallocate(alloc_(), new_begin, new_capacity);
+      StorageTraits::deallocate(alloc_(), new_begin, new_capacity);
     };
 
     detail::exception_guard<decltype(deleter)> guard(deleter);
@@ -615,168 +1105,386 @@ namespace ftl {
       AllocTraits::construct(alloc_(), new_end, std::move_if_noexcept(*i));
     }
     guard.complete();
+    const bool had_storage = begin_ != nullptr;
     deallocate();
 
     begin_ = new_begin;
     end_ = new_end;
     end_cap_() = new_end_cap;
+    Stats::on_allocate(new_capacity, new_capacity * sizeof(T));
+    if (had_storage) {
+      Stats::on_reallocate(size());
+    }
   }
 
-  template <typename T, typename Allocator>
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
   template <typename... Args>
-  typename vector<T, Allocator>::pointer
-  vector<T, Allocator>::emplace_unsafe(pointer position, Args&&... args)
+  void vector<T, Allocator, GrowthPolicy, Stats>::emplace_back_slow(
+      std::true_type, Args&&... args)
+  {
+    alignas(value_type) unsigned char buffer[sizeof(value_type)];
+    pointer tmp = reinterpret_cast<pointer>(buffer);
+    AllocTraits::construct(alloc_(), tmp, std::forward<Args>(args)...);
+    auto destroy_tmp = [&]() { AllocTraits::destroy(alloc_(), tmp); };
+    detail::exception_guard<decltype(destroy_tmp)> guard(destroy_tmp);
+    reallocate_storage(growth_capacity(capacity() + 1));
+    guard.complete();
+    end_ = detail::relocate(tmp, tmp + 1, end_);
+  }
+
+  // The value is built before reallocating: args may refer to an element of
+  // the block that reallocate_storage releases.
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  template <typename... Args>
+  void vector<T, Allocator, GrowthPolicy, Stats>::emplace_back_slow(
+      std::false_type, Args&&... args)
+  {
+    value_type tmp(std::forward<Args>(args)...);
+    reallocate_storage(growth_capacity(capacity() + 1));
+    AllocTraits::construct(alloc_(), end_, std::move(tmp));
+    ++end_;
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  template <typename... Args>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::pointer
+  vector<T, Allocator, GrowthPolicy, Stats>::emplace_at(size_type index,
+      Args&&... args)
+  {
+    return emplace_at(CanRelocate(), index, std::forward<Args>(args)...);
+  }
+
+  // Inserts before begin_ + index, which must not be end_. In both overloads
+  // the value is built aside first: args may refer to an element that is
+  // about to be shifted or released by a reallocation, and a throwing
+  // constructor leaves *this intact.
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  template <typename... Args>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::pointer
+  vector<T, Allocator, GrowthPolicy, Stats>::emplace_at(std::true_type,
+      size_type index, Args&&... args)
+  {
+    alignas(value_type) unsigned char buffer[sizeof(value_type)];
+    pointer tmp = reinterpret_cast<pointer>(buffer);
+    AllocTraits::construct(alloc_(), tmp, std::forward<Args>(args)...);
+    if (end_ == end_cap_()) {
+      auto destroy_tmp = [&]() { AllocTraits::destroy(alloc_(), tmp); };
+      detail::exception_guard<decltype(destroy_tmp)> guard(destroy_tmp);
+      reallocate_storage(growth_capacity(capacity() + 1));
+      guard.complete();
+    }
+    pointer position = begin_ + index;
+    move_right(position, end_, position + 1, std::true_type());
+    detail::relocate(tmp, tmp + 1, position);
+    return position;
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  template <typename... Args>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::pointer
+  vector<T, Allocator, GrowthPolicy, Stats>::emplace_at(std::false_type,
+      size_type index, Args&&... args)
   {
-    move_right(position, position + 1);
-    *position = value_type(std::forward<Args>(args)...);
+    value_type tmp(std::forward<Args>(args)...);
+    if (end_ == end_cap_()) {
+      reallocate_storage(growth_capacity(capacity() + 1));
+    }
+    pointer position = begin_ + index;
+    move_right(position, end_, position + 1, std::false_type());
+    *position = std::move(tmp);
     return position;
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::move_right_uninitialized(pointer begin)
+  // Asks the allocator to extend the current block to new_capacity elements
+  // without moving it; elements stay where they are.
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  bool vector<T, Allocator, GrowthPolicy, Stats>::expand_in_place(
+      size_type new_capacity)
   {
-    construct_at_end(end_ - begin, std::move(*begin));
+    if (!StorageTraits::try_expand(alloc_(), begin_, capacity(),
+            new_capacity)) {
+      return false;
+    }
+    end_cap_() = begin_ + new_capacity;
+    Stats::on_expand_in_place(new_capacity);
+    return true;
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::move_right(pointer first, pointer out)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::swap_out_storage(
+      pointer new_begin, size_type new_capacity, pointer position,
+      size_type count)
   {
-    size_type shift = out - first;
-    pointer new_last = end_ - shift;
-    move_right_uninitialized(new_last);
-    std::move_backward(first, new_last, new_last + shift);
+    swap_out_storage(new_begin, new_capacity, position, count, CanRelocate());
   }
 
-  template <typename T, typename Allocator>
-  typename vector<T, Allocator>::size_type
-  vector<T, Allocator>::growth_capacity(size_type new_capacity) const
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::swap_out_storage(
+      pointer new_begin, size_type new_capacity, pointer position,
+      size_type count, std::true_type) noexcept
+  {
+    pointer new_position = new_begin + (position - begin_);
+    detail::relocate(begin_, position, new_begin);
+    pointer new_end = detail::relocate(position, end_, new_position + count);
+    StorageTraits::deallocate(alloc_(), begin_, capacity());
+    begin_ = new_begin;
+    end_ = new_end;
+    end_cap_() = new_begin + new_capacity;
+  }
+
+  // Moves the elements of *this into a new block around the already
+  // constructed range [new_position, new_position + count) and adopts it.
+  // On exception the new block and everything in it is released.
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::swap_out_storage(
+      pointer new_begin, size_type new_capacity, pointer position,
+      size_type count, std::false_type)
+  {
+    pointer new_first = new_begin + (position - begin_);
+    pointer new_last = new_first + count;
+    auto deleter = [&]() {
+      detail::destroy(alloc_(), new_first, new_last);
+      StorageTraits::deallocate(alloc_(), new_begin, new_capacity);
+    };
+
+    detail::exception_guard<decltype(deleter)> guard(deleter);
+    for (pointer i = position; i != begin_; --new_first) {
+      AllocTraits::construct(alloc_(), new_first - 1,
+          std::move_if_noexcept(*--i));
+    }
+    for (pointer i = position; i != end_; ++i, ++new_last) {
+      AllocTraits::construct(alloc_(), new_last, std::move_if_noexcept(*i));
+    }
+    guard.complete();
+    deallocate();
+
+    begin_ = new_begin;
+    end_ = new_last;
+    end_cap_() = new_begin + new_capacity;
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::move_right(pointer first,
+      pointer last, pointer out)
+  {
+    move_right(first, last, out, CanRelocate());
+  }
+
+  // Relocates [first, last) to out, leaving [first, out) uninitialized.
+  // last must be end_.
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::move_right(pointer first,
+      pointer last, pointer out, std::true_type) noexcept
+  {
+    Stats::on_shift(last - first);
+    end_ = detail::relocate(first, last, out);
+  }
+
+  // Moves [first, last) to out: destinations past end_ are move constructed,
+  // the others are move assigned. out must not be past end_.
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::move_right(pointer first,
+      pointer last, pointer out, std::false_type)
+  {
+    Stats::on_shift(last - first);
+    pointer old_end = end_;
+    pointer split = first + (old_end - out);
+    for (pointer i = split; i != last; ++i, ++end_) {
+      AllocTraits::construct(alloc_(), end_, std::move(*i));
+    }
+    std::move_backward(first, split, old_end);
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::move_left(pointer first,
+      pointer last, std::true_type) noexcept
+  {
+    for (pointer i = first; i != last; ++i) {
+      AllocTraits::destroy(alloc_(), i);
+    }
+    end_ = detail::relocate(last, end_, first);
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::move_left(pointer first,
+      pointer last, std::false_type)
+  {
+    pointer new_end = std::move(last, end_, first);
+    destroy_at_end(new_end);
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::size_type
+  vector<T, Allocator, GrowthPolicy, Stats>::growth_capacity(
+      size_type new_capacity) const
   {
     size_type max_sz = max_size();
     if (new_capacity > max_sz) {
       throw_length_error();
     }
-    size_type cap = capacity();
-    if (cap >= max_sz / 2) {
-      return max_sz;
-    }
-    return std::max(cap * 2, new_capacity);
+    return GrowthPolicy::template recommend<value_type>(capacity(),
+        new_capacity, max_sz);
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::throw_out_of_range() const
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::throw_out_of_range() const
   {
     throw std::out_of_range("ftl::vector out_of_range");
   }
 
-  template <typename T, typename Allocator>
-  void vector<T, Allocator>::throw_length_error() const
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void vector<T, Allocator, GrowthPolicy, Stats>::throw_length_error() const
   {
     throw std::length_error("ftl::vector length_error");
   }
 
-  template <typename T, typename Allocator>
-  typename vector<T, Allocator>::pointer&
-  vector<T, Allocator>::end_cap_() noexcept
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::pointer&
+  vector<T, Allocator, GrowthPolicy, Stats>::end_cap_() noexcept
   {
     return end_cap_alloc_.first();
   }
 
-  template <typename T, typename Allocator>
-  const typename vector<T, Allocator>::pointer&
-  vector<T, Allocator>::end_cap_() const noexcept
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  const typename vector<T, Allocator, GrowthPolicy, Stats>::pointer&
+  vector<T, Allocator, GrowthPolicy, Stats>::end_cap_() const noexcept
   {
     return end_cap_alloc_.first();
   }
 
-  template <typename T, typename Allocator>
-  typename vector<T, Allocator>::allocator_type&
-  vector<T, Allocator>::alloc_() noexcept
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  typename vector<T, Allocator, GrowthPolicy, Stats>::allocator_type&
+  vector<T, Allocator, GrowthPolicy, Stats>::alloc_() noexcept
   {
     return end_cap_alloc_.second();
   }
 
-  template <typename T, typename Allocator>
-  const typename vector<T, Allocator>::allocator_type&
-  vector<T, Allocator>::alloc_() const noexcept
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  const typename vector<T, Allocator, GrowthPolicy, Stats>::allocator_type&
+  vector<T, Allocator, GrowthPolicy, Stats>::alloc_() const noexcept
   {
     return end_cap_alloc_.second();
   }
 
-  template <typename T, typename Allocator>
-  void swap(vector<T, Allocator>& lhs, vector<T, Allocator>& rhs) noexcept
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void swap(vector<T, Allocator, GrowthPolicy, Stats>& lhs,
+      vector<T, Allocator, GrowthPolicy, Stats>& rhs) noexcept
   {
     lhs.swap(rhs);
   }
 
-  template <typename T, typename Allocator>
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
   bool
-  operator==(const vector<T, Allocator>& lhs, const vector<T, Allocator>& rhs)
+  operator==(const vector<T, Allocator, GrowthPolicy, Stats>& lhs,
+      const vector<T, Allocator, GrowthPolicy, Stats>& rhs)
   {
-    const bool is_same_size = lhs.size() == rhs.size();
-    return is_same_size && std::equal(lhs.cbegin(), lhs.cend(), rhs.cbegin());
+    return detail::contiguous_equal(lhs, rhs);
   }
 
 #if !defined(FTL_CPP20_FEATURES)
 
-  template <typename T, typename Allocator>
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
   bool
-  operator!=(const vector<T, Allocator>& lhs, const vector<T, Allocator>& rhs)
+  operator!=(const vector<T, Allocator, GrowthPolicy, Stats>& lhs,
+      const vector<T, Allocator, GrowthPolicy, Stats>& rhs)
   {
     return !(lhs == rhs);
   }
 
-  template <typename T, typename Allocator>
-  bool operator<(const vector<T, Allocator>& l, const vector<T, Allocator>& r)
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  bool operator<(const vector<T, Allocator, GrowthPolicy, Stats>& l,
+      const vector<T, Allocator, GrowthPolicy, Stats>& r)
   {
-    return std::lexicographical_compare(l.cbegin(), l.cend(), r.cbegin(),
-        r.cend());
+    return detail::contiguous_less(l, r);
   }
 
-  template <typename T, typename Allocator>
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
   bool
-  operator>(const vector<T, Allocator>& lhs, const vector<T, Allocator>& rhs)
+  operator>(const vector<T, Allocator, GrowthPolicy, Stats>& lhs,
+      const vector<T, Allocator, GrowthPolicy, Stats>& rhs)
   {
     return rhs < lhs;
   }
 
-  template <typename T, typename Allocator>
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
   bool
-  operator<=(const vector<T, Allocator>& lhs, const vector<T, Allocator>& rhs)
+  operator<=(const vector<T, Allocator, GrowthPolicy, Stats>& lhs,
+      const vector<T, Allocator, GrowthPolicy, Stats>& rhs)
   {
     return !(lhs > rhs);
   }
 
-  template <typename T, typename Allocator>
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
   bool
-  operator>=(const vector<T, Allocator>& lhs, const vector<T, Allocator>& rhs)
+  operator>=(const vector<T, Allocator, GrowthPolicy, Stats>& lhs,
+      const vector<T, Allocator, GrowthPolicy, Stats>& rhs)
   {
     return !(lhs < rhs);
   }
 
 #else
 
-  template <typename T, typename Allocator>
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
   auto
-  operator<=>(const vector<T, Allocator>& lhs, const vector<T, Allocator>& rhs)
+  operator<=>(const vector<T, Allocator, GrowthPolicy, Stats>& lhs,
+      const vector<T, Allocator, GrowthPolicy, Stats>& rhs)
   {
-    return std::lexicographical_compare_three_way(lhs.cbegin(), lhs.cend(),
-        rhs.cbegin(), rhs.cend());
+    return detail::contiguous_three_way(lhs, rhs);
   }
 
 #endif
 }
 
+#if defined(FTL_CPP17_FEATURES)
+
+namespace ftl {
+  namespace pmr {
+    template <typename T, typename GrowthPolicy = growth_factor_2>
+    using vector =
+        ftl::vector<T, std::pmr::polymorphic_allocator<T>, GrowthPolicy>;
+  }
+}
+
+#endif
+
 namespace std {
-  template <typename T, typename Allocator>
-  struct hash<ftl::vector<T, Allocator>>
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  struct hash<ftl::vector<T, Allocator, GrowthPolicy, Stats>>
   {
-    size_t operator()(const ftl::vector<T, Allocator>& vec) const
+    size_t
+    operator()(const ftl::vector<T, Allocator, GrowthPolicy, Stats>& vec) const
     {
-      size_t seed = vec.size();
-      for (const auto& elem : vec) {
-        seed ^= hash<T>{}(elem) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-      }
-      return seed;
+      return ftl::detail::hash_contiguous(vec);
     }
   };
 }
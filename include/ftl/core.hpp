@@ -5,6 +5,24 @@
 #ifndef FTL_CORE_HPP
 #define FTL_CORE_HPP
 
+#include "algorithms/parallel.hpp"
+#include "concurrency/spsc_ring.hpp"
+#include "concurrency/thread_pool.hpp"
+#include "containers/concurrent_vector.hpp"
+#include "containers/dynamic_bitset.hpp"
+#include "containers/flat_hash_map.hpp"
+#include "containers/flat_hash_set.hpp"
+#include "containers/flat_map.hpp"
+#include "containers/flat_set.hpp"
+#include "containers/inplace_vector.hpp"
+#include "containers/mmap_vector.hpp"
+#include "containers/segmented_vector.hpp"
+#include "containers/small_vector.hpp"
+#include "containers/soa_vector.hpp"
 #include "containers/vector.hpp"
+#include "io/serialize.hpp"
+#include "memory/arena.hpp"
+#include "memory/mmap_allocator.hpp"
+#include "memory/pool_allocator.hpp"
 
 #endif
@@ -0,0 +1,85 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_INTERNAL_BIT_OPS_HPP
+#define FTL_INTERNAL_BIT_OPS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#endif
+
+namespace ftl {
+  namespace detail {
+
+    inline unsigned popcount64(std::uint64_t x) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<unsigned>(__builtin_popcountll(x));
+#else
+      x = x - ((x >> 1) & 0x5555555555555555ULL);
+      x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+      x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+      return static_cast<unsigned>((x * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    // The index of the lowest set bit; x must not be zero. Compiles to
+    // tzcnt where BMI is available.
+    inline unsigned ctz64(std::uint64_t x) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<unsigned>(__builtin_ctzll(x));
+#else
+      unsigned count = 0;
+      for (; (x & 1) == 0; x >>= 1) {
+        ++count;
+      }
+      return count;
+#endif
+    }
+
+    // Counts the set bits of n words. With AVX2, each byte is split into
+    // nibbles that index a sixteen entry table of bit counts held in a
+    // register; the byte counts are summed per 64-bit lane with vpsadbw.
+    inline std::size_t popcount_words(const std::uint64_t* words,
+        std::size_t n) noexcept
+    {
+      std::size_t count = 0;
+      std::size_t i = 0;
+#if defined(__AVX2__)
+      if (n >= 16) {
+        const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2,
+            2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low_mask = _mm256_set1_epi8(0x0f);
+        __m256i total = _mm256_setzero_si256();
+        for (; i + 4 <= n; i += 4) {
+          const __m256i v =
+              _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+          const __m256i low = _mm256_and_si256(v, low_mask);
+          const __m256i high =
+              _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+          const __m256i bytes =
+              _mm256_add_epi8(_mm256_shuffle_epi8(table, low),
+                  _mm256_shuffle_epi8(table, high));
+          total = _mm256_add_epi64(total,
+              _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+        }
+        alignas(32) std::uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), total);
+        count = static_cast<std::size_t>(lanes[0] + lanes[1] + lanes[2] +
+            lanes[3]);
+      }
+#endif
+      for (; i != n; ++i) {
+        count += popcount64(words[i]);
+      }
+      return count;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,262 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_INTERNAL_COMPARE_HPP
+#define FTL_INTERNAL_COMPARE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include "config.hpp"
+#include "type_traits.hpp"
+
+#if defined(FTL_CPP20_FEATURES)
+#  include <compare>
+#endif
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#  include <emmintrin.h>
+#endif
+
+namespace ftl {
+  namespace detail {
+
+    // Comparisons of two contiguous ranges of the same element type. Ranges
+    // of trivially equality comparable elements are compared as bytes.
+    // Single byte unsigned integers are also ordered as bytes; wider integers
+    // are searched for the first differing element, which alone decides the
+    // order.
+
+    template <typename T>
+    struct is_byte_orderable :
+      std::integral_constant<bool,
+          sizeof(T) == 1 &&
+              ((std::is_integral<T>::value && std::is_unsigned<T>::value)
+#if defined(FTL_CPP17_FEATURES)
+                  || std::is_same<T, std::byte>::value
+#endif
+                  )>
+    {
+    };
+
+    template <typename T>
+    struct is_mismatch_orderable :
+      std::integral_constant<bool,
+          std::is_integral<T>::value && !is_byte_orderable<T>::value>
+    {
+    };
+
+    template <typename Container>
+    const typename Container::value_type* compare_data(const Container& c)
+    {
+      return c.empty() ? nullptr : std::addressof(*c.begin());
+    }
+
+    inline unsigned mismatch_ctz(unsigned mask) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+      unsigned count = 0;
+      for (; (mask & 1) == 0; mask >>= 1) {
+        ++count;
+      }
+      return count;
+#endif
+    }
+
+    // Returns the offset of the first byte at which l and r differ, or size
+    // if they are equal.
+    inline std::size_t mismatch_bytes(const unsigned char* l,
+        const unsigned char* r, std::size_t size) noexcept
+    {
+      std::size_t i = 0;
+#if defined(__AVX2__)
+      for (; i + 32 <= size; i += 32) {
+        const auto a =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(l + i));
+        const auto b =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r + i));
+        const auto mask = ~static_cast<unsigned>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+        if (mask != 0) {
+          return i + mismatch_ctz(mask);
+        }
+      }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+      for (; i + 16 <= size; i += 16) {
+        const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(l + i));
+        const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r + i));
+        const auto mask = ~static_cast<unsigned>(
+                              _mm_movemask_epi8(_mm_cmpeq_epi8(a, b))) &
+            0xffffu;
+        if (mask != 0) {
+          return i + mismatch_ctz(mask);
+        }
+      }
+#endif
+      for (; i + 8 <= size; i += 8) {
+        std::uint64_t a;
+        std::uint64_t b;
+        std::memcpy(&a, l + i, 8);
+        std::memcpy(&b, r + i, 8);
+        if (a != b) {
+          break;
+        }
+      }
+      while (i != size && l[i] == r[i]) {
+        ++i;
+      }
+      return i;
+    }
+
+    // Returns the index of the first element at which l and r differ, or n.
+    template <typename T>
+    std::size_t mismatch_index(const T* l, const T* r, std::size_t n) noexcept
+    {
+      if (n == 0) {
+        return 0;
+      }
+      return mismatch_bytes(reinterpret_cast<const unsigned char*>(l),
+                 reinterpret_cast<const unsigned char*>(r), n * sizeof(T)) /
+          sizeof(T);
+    }
+
+    template <typename T>
+    bool contiguous_equal(const T* l, const T* r, std::size_t n,
+        std::true_type /* trivially equality comparable */) noexcept
+    {
+      return n == 0 || std::memcmp(l, r, n * sizeof(T)) == 0;
+    }
+
+    template <typename T>
+    bool contiguous_equal(const T* l, const T* r, std::size_t n,
+        std::false_type /* trivially equality comparable */)
+    {
+      return std::equal(l, l + n, r);
+    }
+
+    template <typename T>
+    bool contiguous_equal(const T* l, const T* r, std::size_t n)
+    {
+      return contiguous_equal(l, r, n, is_trivially_equality_comparable<T>());
+    }
+
+    template <typename Container>
+    bool contiguous_equal(const Container& l, const Container& r)
+    {
+      return l.size() == r.size() &&
+          contiguous_equal(compare_data(l), compare_data(r), l.size());
+    }
+
+    // Returns memcmp of the common prefix of two byte ranges, or the order of
+    // their sizes when the prefix is equal.
+    template <typename T>
+    int compare_bytes(const T* l, std::size_t l_size, const T* r,
+        std::size_t r_size) noexcept
+    {
+      const std::size_t n = l_size < r_size ? l_size : r_size;
+      const int result = n == 0 ? 0 : std::memcmp(l, r, n);
+      if (result != 0) {
+        return result;
+      }
+      return l_size < r_size ? -1 : (r_size < l_size ? 1 : 0);
+    }
+
+    template <typename T>
+    bool contiguous_less(const T* l, std::size_t l_size, const T* r,
+        std::size_t r_size, std::true_type /* byte orderable */,
+        std::false_type /* mismatch orderable */) noexcept
+    {
+      return compare_bytes(l, l_size, r, r_size) < 0;
+    }
+
+    template <typename T>
+    bool contiguous_less(const T* l, std::size_t l_size, const T* r,
+        std::size_t r_size, std::false_type /* byte orderable */,
+        std::true_type /* mismatch orderable */) noexcept
+    {
+      const std::size_t n = l_size < r_size ? l_size : r_size;
+      const std::size_t i = mismatch_index(l, r, n);
+      return i != n ? l[i] < r[i] : l_size < r_size;
+    }
+
+    template <typename T>
+    bool contiguous_less(const T* l, std::size_t l_size, const T* r,
+        std::size_t r_size, std::false_type /* byte orderable */,
+        std::false_type /* mismatch orderable */)
+    {
+      return std::lexicographical_compare(l, l + l_size, r, r + r_size);
+    }
+
+    template <typename T>
+    bool contiguous_less(const T* l, std::size_t l_size, const T* r,
+        std::size_t r_size)
+    {
+      return contiguous_less(l, l_size, r, r_size, is_byte_orderable<T>(),
+          is_mismatch_orderable<T>());
+    }
+
+    template <typename Container>
+    bool contiguous_less(const Container& l, const Container& r)
+    {
+      return contiguous_less(compare_data(l), l.size(), compare_data(r),
+          r.size());
+    }
+
+#if defined(FTL_CPP20_FEATURES)
+
+    template <typename T>
+    auto contiguous_three_way(const T* l, std::size_t l_size, const T* r,
+        std::size_t r_size, std::true_type /* byte orderable */,
+        std::false_type /* mismatch orderable */) noexcept
+    {
+      return compare_bytes(l, l_size, r, r_size) <=> 0;
+    }
+
+    template <typename T>
+    auto contiguous_three_way(const T* l, std::size_t l_size, const T* r,
+        std::size_t r_size, std::false_type /* byte orderable */,
+        std::true_type /* mismatch orderable */) noexcept
+    {
+      const std::size_t n = l_size < r_size ? l_size : r_size;
+      const std::size_t i = mismatch_index(l, r, n);
+      return i != n ? l[i] <=> r[i] : l_size <=> r_size;
+    }
+
+    template <typename T>
+    auto contiguous_three_way(const T* l, std::size_t l_size, const T* r,
+        std::size_t r_size, std::false_type /* byte orderable */,
+        std::false_type /* mismatch orderable */)
+    {
+      return std::lexicographical_compare_three_way(l, l + l_size, r,
+          r + r_size);
+    }
+
+    template <typename T>
+    auto contiguous_three_way(const T* l, std::size_t l_size, const T* r,
+        std::size_t r_size)
+    {
+      return contiguous_three_way(l, l_size, r, r_size, is_byte_orderable<T>(),
+          is_mismatch_orderable<T>());
+    }
+
+    template <typename Container>
+    auto contiguous_three_way(const Container& l, const Container& r)
+    {
+      return contiguous_three_way(compare_data(l), l.size(), compare_data(r),
+          r.size());
+    }
+
+#endif
+  }
+}
+
+#endif
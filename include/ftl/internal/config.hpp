@@ -19,10 +19,31 @@
 #  endif
 #endif
 
+#if defined(__unix__) || defined(__APPLE__)
+#  define FTL_POSIX_FEATURES
+#endif
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && \
+    __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#  define FTL_BIG_ENDIAN
+#endif
+
 #if defined(FTL_CPP14_FEATURES)
 #  define FTL_CONSTEXPR_SINCE_CXX14 constexpr
 #else
 #  define FTL_CONSTEXPR_SINCE_CXX14
 #endif
 
+#if defined(FTL_CPP17_FEATURES)
+#  define FTL_CONSTEXPR_SINCE_CXX17 constexpr
+#else
+#  define FTL_CONSTEXPR_SINCE_CXX17
+#endif
+
+#if defined(FTL_CPP20_FEATURES)
+#  define FTL_CONSTEXPR_SINCE_CXX20 constexpr
+#else
+#  define FTL_CONSTEXPR_SINCE_CXX20
+#endif
+
 #endif
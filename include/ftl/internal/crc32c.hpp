@@ -0,0 +1,81 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_INTERNAL_CRC32C_HPP
+#define FTL_INTERNAL_CRC32C_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE4_2__)
+#  include <nmmintrin.h>
+#endif
+
+namespace ftl {
+  namespace detail {
+
+    struct crc32c_tables
+    {
+      std::uint32_t table[8][256];
+
+      crc32c_tables() noexcept
+      {
+        for (std::uint32_t i = 0; i != 256; ++i) {
+          std::uint32_t crc = i;
+          for (int bit = 0; bit != 8; ++bit) {
+            crc = (crc >> 1) ^ (0x82f63b78u & (0u - (crc & 1)));
+          }
+          table[0][i] = crc;
+        }
+        for (std::uint32_t i = 0; i != 256; ++i) {
+          for (int k = 1; k != 8; ++k) {
+            const std::uint32_t prev = table[k - 1][i];
+            table[k][i] = (prev >> 8) ^ table[0][prev & 0xff];
+          }
+        }
+      }
+    };
+
+    // CRC-32C (Castagnoli) of size bytes, continuing from the value crc
+    // returned for the bytes before them; start from 0. Uses the SSE4.2
+    // crc32 instruction when the target has it and slicing-by-8 tables
+    // otherwise, so the result is the same everywhere.
+    inline std::uint32_t crc32c(std::uint32_t crc, const void* data,
+        std::size_t size) noexcept
+    {
+      const auto* p = static_cast<const unsigned char*>(data);
+      crc = ~crc;
+#if defined(__SSE4_2__)
+      std::uint64_t crc64 = crc;
+      for (; size >= 8; size -= 8, p += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+      }
+      crc = static_cast<std::uint32_t>(crc64);
+      for (; size != 0; --size, ++p) {
+        crc = _mm_crc32_u8(crc, *p);
+      }
+#else
+      static const crc32c_tables tables;
+      const auto& t = tables.table;
+      for (; size >= 8; size -= 8, p += 8) {
+        const std::uint32_t low = crc ^
+            (std::uint32_t(p[0]) | std::uint32_t(p[1]) << 8 |
+                std::uint32_t(p[2]) << 16 | std::uint32_t(p[3]) << 24);
+        crc = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^
+            t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^ t[3][p[4]] ^
+            t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+      }
+      for (; size != 0; --size, ++p) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+      }
+#endif
+      return ~crc;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,62 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_INTERNAL_GROWTH_POLICY_HPP
+#define FTL_INTERNAL_GROWTH_POLICY_HPP
+
+#include <algorithm>
+#include <cstddef>
+
+namespace ftl {
+
+  // A growth policy picks the capacity a container moves to once it runs out
+  // of room. recommend<T>(capacity, required, max_size) is only called with
+  // required in (capacity, max_size] and must return a value in
+  // [required, max_size]. Custom policies only need that static member.
+
+  // Multiplies the capacity by Num / Den.
+  template <std::size_t Num, std::size_t Den>
+  struct geometric_growth
+  {
+    static_assert(Den != 0 && Num > Den, "growth factor must exceed 1");
+
+    template <typename T, typename Size>
+    static Size recommend(Size capacity, Size required, Size max_size) noexcept
+    {
+      if (capacity > max_size / Num * Den) {
+        return max_size;
+      }
+      const auto grown = capacity + capacity * (Num - Den) / Den;
+      return std::max(static_cast<Size>(grown), required);
+    }
+  };
+
+  using growth_factor_2 = geometric_growth<2, 1>;
+
+  // Leaves at most a third of the block unused and lets a sequence of
+  // reallocations eventually fit into the memory freed by earlier ones.
+  using growth_factor_1_5 = geometric_growth<3, 2>;
+
+  // Applies Base, then rounds the block up to the granularity the system
+  // allocator works in anyway: whole pages for blocks of at least PageSize
+  // bytes, max_align_t otherwise. The extra elements cost no memory.
+  template <typename Base = growth_factor_1_5, std::size_t PageSize = 4096>
+  struct page_rounded_growth
+  {
+    template <typename T, typename Size>
+    static Size recommend(Size capacity, Size required, Size max_size) noexcept
+    {
+      const Size count =
+          Base::template recommend<T>(capacity, required, max_size);
+      const std::size_t bytes = count * sizeof(T);
+      const std::size_t granule =
+          bytes >= PageSize ? PageSize : alignof(std::max_align_t);
+      const std::size_t padding = (granule - bytes % granule) % granule;
+      const Size extra = static_cast<Size>(padding / sizeof(T));
+      return count < max_size - extra ? count + extra : max_size;
+    }
+  };
+}
+
+#endif
@@ -0,0 +1,282 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_INTERNAL_HASH_HPP
+#define FTL_INTERNAL_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include "type_traits.hpp"
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#  include <emmintrin.h>
+#endif
+
+namespace ftl {
+  namespace detail {
+
+    // A byte hash in the style of wyhash for short inputs and XXH3 for long
+    // ones. Inputs longer than hash_long_threshold are consumed in 64 byte
+    // stripes by eight independent accumulators, using AVX2 or SSE2 when the
+    // target has them; all paths produce the same value. The result is not
+    // stable across platforms or library versions.
+
+    constexpr std::size_t hash_long_threshold = 256;
+    constexpr std::size_t hash_stripe_size = 64;
+    constexpr std::size_t hash_block_stripes = 16;
+    constexpr std::uint64_t hash_prime32 = 0x9e3779b1ULL;
+    constexpr std::uint64_t hash_prime64 = 0x9e3779b185ebca87ULL;
+
+    // Stripe s of a block reads the eight keys starting at hash_secret()[s];
+    // the block is then scrambled with the last eight.
+    inline const std::uint64_t* hash_secret() noexcept
+    {
+      static constexpr std::uint64_t secret[24] = {
+        0x0bd2db2e48789d20ULL, 0x7c621bc543b550a8ULL, 0xb27410639e13de46ULL,
+        0xd3c4eb1714b569e5ULL, 0x9fc8be2266edda39ULL, 0x491e4aceebe4be30ULL,
+        0x180afb1a9570beb0ULL, 0xca454537878d2950ULL, 0xa96a98c828045478ULL,
+        0xa4a4b920c8e15bf5ULL, 0xae09d92fba683111ULL, 0x1defe04876a32064ULL,
+        0x1b830cede5f3a95fULL, 0x5d45a31f3dd3297fULL, 0x1b37fd03b9ada18eULL,
+        0xa9cad3754033f149ULL, 0x2bbe59b3c2df09d1ULL, 0xc01f604b97fba984ULL,
+        0xdad0325410c910f5ULL, 0x0677e5dd8bdbadf9ULL, 0x2bc9abfd44bc3b36ULL,
+        0x08cf102312742cefULL, 0x495cf4650c95833dULL, 0x288961efe041bc37ULL,
+      };
+      return secret;
+    }
+
+    inline std::uint64_t hash_read64(const unsigned char* p) noexcept
+    {
+      std::uint64_t value;
+      std::memcpy(&value, p, sizeof(value));
+      return value;
+    }
+
+    inline std::uint64_t hash_read32(const unsigned char* p) noexcept
+    {
+      std::uint32_t value;
+      std::memcpy(&value, p, sizeof(value));
+      return value;
+    }
+
+    // Full 64 x 64 -> 128 bit product, folded to 64 bits.
+    inline std::uint64_t hash_mix(std::uint64_t a, std::uint64_t b) noexcept
+    {
+#if defined(__SIZEOF_INT128__)
+      __extension__ using uint128 = unsigned __int128;
+      const uint128 product = static_cast<uint128>(a) * b;
+      return static_cast<std::uint64_t>(product) ^
+          static_cast<std::uint64_t>(product >> 64);
+#else
+      const std::uint64_t a_lo = a & 0xffffffff;
+      const std::uint64_t a_hi = a >> 32;
+      const std::uint64_t b_lo = b & 0xffffffff;
+      const std::uint64_t b_hi = b >> 32;
+      const std::uint64_t lo_lo = a_lo * b_lo;
+      const std::uint64_t hi_lo = a_hi * b_lo;
+      const std::uint64_t lo_hi = a_lo * b_hi;
+      const std::uint64_t hi_hi = a_hi * b_hi;
+      const std::uint64_t cross =
+          (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+      const std::uint64_t hi = hi_hi + (hi_lo >> 32) + (cross >> 32);
+      const std::uint64_t lo = (cross << 32) | (lo_lo & 0xffffffff);
+      return lo ^ hi;
+#endif
+    }
+
+    inline std::uint64_t hash_finish(std::uint64_t a, std::uint64_t b,
+        std::uint64_t seed, std::size_t size) noexcept
+    {
+      return hash_mix(hash_secret()[0] ^ size,
+          hash_mix(a ^ hash_secret()[1], b ^ seed));
+    }
+
+    inline std::uint64_t hash_short(const unsigned char* p, std::size_t size,
+        std::uint64_t seed) noexcept
+    {
+      std::uint64_t a = 0;
+      std::uint64_t b = 0;
+      if (size >= 4) {
+        const std::size_t offset = (size >> 3) << 2;
+        a = (hash_read32(p) << 32) | hash_read32(p + offset);
+        b = (hash_read32(p + size - 4) << 32) |
+            hash_read32(p + size - 4 - offset);
+      } else if (size > 0) {
+        a = (std::uint64_t(p[0]) << 16) | (std::uint64_t(p[size >> 1]) << 8) |
+            p[size - 1];
+      }
+      return hash_finish(a, b, seed, size);
+    }
+
+    inline std::uint64_t hash_medium(const unsigned char* p, std::size_t size,
+        std::uint64_t seed) noexcept
+    {
+      std::size_t left = size;
+      for (; left > 16; left -= 16, p += 16) {
+        seed = hash_mix(hash_read64(p) ^ hash_secret()[2],
+            hash_read64(p + 8) ^ seed);
+      }
+      return hash_finish(hash_read64(p + left - 16), hash_read64(p + left - 8),
+          seed, size);
+    }
+
+    // acc[i] += lo32(d ^ k) * hi32(d ^ k) and acc[i ^ 1] += d for each lane
+    // i of the stripe.
+    inline void hash_accumulate(std::uint64_t* acc, const unsigned char* p,
+        const std::uint64_t* key) noexcept
+    {
+#if defined(__AVX2__)
+      for (int i = 0; i != 2; ++i) {
+        auto a = _mm256_loadu_si256(reinterpret_cast<__m256i*>(acc) + i);
+        const auto d =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p) + i);
+        const auto k =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key) + i);
+        const auto dk = _mm256_xor_si256(d, k);
+        const auto product = _mm256_mul_epu32(dk, _mm256_srli_epi64(dk, 32));
+        const auto swapped = _mm256_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+        a = _mm256_add_epi64(a, _mm256_add_epi64(product, swapped));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc) + i, a);
+      }
+#elif defined(__SSE2__) || defined(_M_X64)
+      for (int i = 0; i != 4; ++i) {
+        auto a = _mm_loadu_si128(reinterpret_cast<__m128i*>(acc) + i);
+        const auto d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p) + i);
+        const auto k =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(key) + i);
+        const auto dk = _mm_xor_si128(d, k);
+        const auto product = _mm_mul_epu32(dk, _mm_srli_epi64(dk, 32));
+        const auto swapped = _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+        a = _mm_add_epi64(a, _mm_add_epi64(product, swapped));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc) + i, a);
+      }
+#else
+      for (int i = 0; i != 8; ++i) {
+        const std::uint64_t d = hash_read64(p + 8 * i);
+        const std::uint64_t dk = d ^ key[i];
+        acc[i] += (dk & 0xffffffff) * (dk >> 32);
+        acc[i ^ 1] += d;
+      }
+#endif
+    }
+
+    // acc[i] = (acc[i] ^ (acc[i] >> 47) ^ k) * hash_prime32, so that
+    // accumulated products do not pile up in the low bits.
+    inline void hash_scramble(std::uint64_t* acc,
+        const std::uint64_t* key) noexcept
+    {
+#if defined(__AVX2__)
+      const auto prime = _mm256_set1_epi64x(hash_prime32);
+      for (int i = 0; i != 2; ++i) {
+        auto a = _mm256_loadu_si256(reinterpret_cast<__m256i*>(acc) + i);
+        const auto k =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key) + i);
+        a = _mm256_xor_si256(_mm256_xor_si256(a, _mm256_srli_epi64(a, 47)), k);
+        const auto lo = _mm256_mul_epu32(a, prime);
+        const auto hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+        a = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc) + i, a);
+      }
+#elif defined(__SSE2__) || defined(_M_X64)
+      const auto prime = _mm_set1_epi64x(hash_prime32);
+      for (int i = 0; i != 4; ++i) {
+        auto a = _mm_loadu_si128(reinterpret_cast<__m128i*>(acc) + i);
+        const auto k =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(key) + i);
+        a = _mm_xor_si128(_mm_xor_si128(a, _mm_srli_epi64(a, 47)), k);
+        const auto lo = _mm_mul_epu32(a, prime);
+        const auto hi = _mm_mul_epu32(_mm_srli_epi64(a, 32), prime);
+        a = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc) + i, a);
+      }
+#else
+      for (int i = 0; i != 8; ++i) {
+        acc[i] = (acc[i] ^ (acc[i] >> 47) ^ key[i]) * hash_prime32;
+      }
+#endif
+    }
+
+    inline std::uint64_t hash_long(const unsigned char* p, std::size_t size,
+        std::uint64_t seed) noexcept
+    {
+      std::uint64_t acc[8];
+      for (int i = 0; i != 8; ++i) {
+        acc[i] = hash_secret()[16 + i] ^ seed;
+      }
+      const std::size_t stripes = (size - 1) / hash_stripe_size;
+      std::size_t stripe = 0;
+      for (; stripe != stripes; ++stripe, p += hash_stripe_size) {
+        const std::size_t in_block = stripe % hash_block_stripes;
+        hash_accumulate(acc, p, hash_secret() + in_block);
+        if (in_block == hash_block_stripes - 1) {
+          hash_scramble(acc, hash_secret() + 16);
+        }
+      }
+      // The last stripe ends at the last byte and may overlap the previous.
+      const std::size_t tail = size - stripes * hash_stripe_size;
+      hash_accumulate(acc, p + tail - hash_stripe_size, hash_secret() + 11);
+
+      std::uint64_t result = size * hash_prime64;
+      for (int i = 0; i != 8; i += 2) {
+        result += hash_mix(acc[i] ^ hash_secret()[i + 1],
+            acc[i + 1] ^ hash_secret()[i + 2]);
+      }
+      result ^= result >> 37;
+      result *= 0x165667919e3779f9ULL;
+      return result ^ (result >> 32);
+    }
+
+    inline std::size_t hash_bytes(const void* data, std::size_t size,
+        std::uint64_t seed = 0) noexcept
+    {
+      auto p = static_cast<const unsigned char*>(data);
+      // A zero operand would cancel a whole product, so the seed never is.
+      seed ^= hash_mix(seed ^ hash_secret()[0], hash_secret()[1]);
+      if (size <= 16) {
+        return static_cast<std::size_t>(hash_short(p, size, seed));
+      }
+      if (size <= hash_long_threshold) {
+        return static_cast<std::size_t>(hash_medium(p, size, seed));
+      }
+      return static_cast<std::size_t>(hash_long(p, size, seed));
+    }
+
+    // Hashes a contiguous container: as bytes when its elements are
+    // trivially equality comparable, otherwise by combining std::hash of
+    // every element.
+    template <typename Container>
+    std::size_t hash_contiguous(const Container& c, std::true_type) noexcept
+    {
+      using value_type = typename Container::value_type;
+      const value_type* data = c.empty() ? nullptr : std::addressof(*c.begin());
+      return hash_bytes(data, c.size() * sizeof(value_type));
+    }
+
+    template <typename Container>
+    std::size_t hash_contiguous(const Container& c, std::false_type)
+    {
+      using value_type = typename Container::value_type;
+      std::size_t seed = c.size();
+      for (const auto& elem : c) {
+        seed ^= std::hash<value_type>{}(elem) + 0x9e3779b9 + (seed << 6) +
+            (seed >> 2);
+      }
+      return seed;
+    }
+
+    template <typename Container>
+    std::size_t hash_contiguous(const Container& c)
+    {
+      return hash_contiguous(c,
+          is_trivially_equality_comparable<typename Container::value_type>());
+    }
+  }
+}
+
+#endif
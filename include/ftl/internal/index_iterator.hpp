@@ -0,0 +1,200 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_INTERNAL_INDEX_ITERATOR_HPP
+#define FTL_INTERNAL_INDEX_ITERATOR_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace ftl {
+  namespace detail {
+
+    // What operator-> returns for proxy references: the proxy itself, kept
+    // alive for the duration of the member access.
+    template <typename Reference>
+    class arrow_proxy final
+    {
+    public:
+      explicit arrow_proxy(Reference ref) : ref_(std::move(ref)) {}
+
+      Reference* operator->() noexcept { return std::addressof(ref_); }
+
+    private:
+      Reference ref_;
+    };
+
+    // A random access iterator over a container whose elements are not
+    // contiguous but can be reached by index. It holds the container and
+    // an index and dereferences to (*container)[index]. Container is const
+    // qualified for const iterators. Reference may be a proxy type for
+    // containers whose operator[] returns one by value.
+    template <typename Container, typename Value, typename Reference = Value&>
+    class index_iterator final
+    {
+    public:
+      using value_type = typename std::remove_const<Value>::type;
+      using difference_type = std::ptrdiff_t;
+      using pointer = typename std::conditional<
+          std::is_reference<Reference>::value, Value*,
+          arrow_proxy<Reference>>::type;
+      using reference = Reference;
+      using iterator_category = std::random_access_iterator_tag;
+
+    private:
+      Container* c_;
+      std::size_t i_;
+
+    public:
+      index_iterator() noexcept : c_(nullptr), i_(0) {}
+      index_iterator(Container* c, std::size_t i) noexcept : c_(c), i_(i) {}
+
+      template <typename OtherContainer, typename OtherValue,
+          typename OtherReference,
+          typename = typename std::enable_if<
+              std::is_convertible<OtherContainer*, Container*>::value>::type>
+      index_iterator(const index_iterator<OtherContainer, OtherValue,
+          OtherReference>& other) noexcept :
+        c_(other.container()), i_(other.index())
+      {
+      }
+
+      Container* container() const noexcept { return c_; }
+      std::size_t index() const noexcept { return i_; }
+
+      reference operator*() const { return (*c_)[i_]; }
+      pointer operator->() const
+      {
+        return arrow(std::is_reference<Reference>());
+      }
+
+      reference operator[](difference_type n) const
+      {
+        return (*c_)[i_ + static_cast<std::size_t>(n)];
+      }
+
+      index_iterator& operator++() noexcept
+      {
+        ++i_;
+        return *this;
+      }
+
+      index_iterator operator++(int) noexcept
+      {
+        index_iterator temp = *this;
+        ++i_;
+        return temp;
+      }
+
+      index_iterator& operator--() noexcept
+      {
+        --i_;
+        return *this;
+      }
+
+      index_iterator operator--(int) noexcept
+      {
+        index_iterator temp = *this;
+        --i_;
+        return temp;
+      }
+
+      index_iterator& operator+=(difference_type n) noexcept
+      {
+        i_ += static_cast<std::size_t>(n);
+        return *this;
+      }
+
+      index_iterator& operator-=(difference_type n) noexcept
+      {
+        i_ -= static_cast<std::size_t>(n);
+        return *this;
+      }
+
+      friend index_iterator operator+(index_iterator it,
+          difference_type n) noexcept
+      {
+        return it += n;
+      }
+
+      friend index_iterator operator+(difference_type n,
+          index_iterator it) noexcept
+      {
+        return it += n;
+      }
+
+      friend index_iterator operator-(index_iterator it,
+          difference_type n) noexcept
+      {
+        return it -= n;
+      }
+
+    private:
+      pointer arrow(std::true_type) const { return std::addressof(**this); }
+      pointer arrow(std::false_type) const { return pointer(**this); }
+    };
+
+    template <typename C1, typename V1, typename R1, typename C2,
+        typename V2, typename R2>
+    bool operator==(const index_iterator<C1, V1, R1>& lhs,
+        const index_iterator<C2, V2, R2>& rhs) noexcept
+    {
+      return lhs.index() == rhs.index();
+    }
+
+    template <typename C1, typename V1, typename R1, typename C2,
+        typename V2, typename R2>
+    bool operator!=(const index_iterator<C1, V1, R1>& lhs,
+        const index_iterator<C2, V2, R2>& rhs) noexcept
+    {
+      return !(lhs == rhs);
+    }
+
+    template <typename C1, typename V1, typename R1, typename C2,
+        typename V2, typename R2>
+    bool operator<(const index_iterator<C1, V1, R1>& lhs,
+        const index_iterator<C2, V2, R2>& rhs) noexcept
+    {
+      return lhs.index() < rhs.index();
+    }
+
+    template <typename C1, typename V1, typename R1, typename C2,
+        typename V2, typename R2>
+    bool operator<=(const index_iterator<C1, V1, R1>& lhs,
+        const index_iterator<C2, V2, R2>& rhs) noexcept
+    {
+      return !(rhs < lhs);
+    }
+
+    template <typename C1, typename V1, typename R1, typename C2,
+        typename V2, typename R2>
+    bool operator>(const index_iterator<C1, V1, R1>& lhs,
+        const index_iterator<C2, V2, R2>& rhs) noexcept
+    {
+      return rhs < lhs;
+    }
+
+    template <typename C1, typename V1, typename R1, typename C2,
+        typename V2, typename R2>
+    bool operator>=(const index_iterator<C1, V1, R1>& lhs,
+        const index_iterator<C2, V2, R2>& rhs) noexcept
+    {
+      return !(lhs < rhs);
+    }
+
+    template <typename C1, typename V1, typename R1, typename C2,
+        typename V2, typename R2>
+    std::ptrdiff_t operator-(const index_iterator<C1, V1, R1>& lhs,
+        const index_iterator<C2, V2, R2>& rhs) noexcept
+    {
+      return static_cast<std::ptrdiff_t>(lhs.index()) -
+          static_cast<std::ptrdiff_t>(rhs.index());
+    }
+  }
+}
+
+#endif
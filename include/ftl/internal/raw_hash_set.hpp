@@ -0,0 +1,1220 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_INTERNAL_RAW_HASH_SET_HPP
+#define FTL_INTERNAL_RAW_HASH_SET_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "exception_guard.hpp"
+#include "hash.hpp"
+#include "relocate.hpp"
+#include "type_traits.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#  include <emmintrin.h>
+#endif
+
+namespace ftl {
+  namespace detail {
+
+    // The open addressing table behind flat_hash_map and flat_hash_set, in
+    // the style of Abseil's SwissTable. Every slot has a control byte: the
+    // low seven bits of the element's hash when the slot is full, or one of
+    // the special values below. Lookups compare a whole group of sixteen
+    // control bytes against the hash at once and only touch the slots that
+    // match, so a probe rarely reads more than one slot.
+    //
+    // The capacity is always 2^k - 1. The control array has a sentinel at
+    // index capacity, which ends iteration, followed by copies of the first
+    // group_width - 1 control bytes so that a group can be loaded at any
+    // slot without wrapping around.
+
+    using ctrl_t = signed char;
+
+    constexpr ctrl_t ctrl_empty = -128;
+    constexpr ctrl_t ctrl_deleted = -2;
+    constexpr ctrl_t ctrl_sentinel = -1;
+
+    inline bool is_full(ctrl_t c) noexcept { return c >= 0; }
+
+    inline unsigned group_ctz(std::uint32_t mask) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+      unsigned count = 0;
+      for (; (mask & 1) == 0; mask >>= 1) {
+        ++count;
+      }
+      return count;
+#endif
+    }
+
+    // The set bits of a group match, visited from the lowest.
+    class group_mask
+    {
+    public:
+      explicit group_mask(std::uint32_t mask) noexcept : mask_(mask) {}
+
+      explicit operator bool() const noexcept { return mask_ != 0; }
+      unsigned lowest() const noexcept { return group_ctz(mask_); }
+      unsigned trailing_zeros() const noexcept { return group_ctz(mask_); }
+      unsigned leading_zeros() const noexcept
+      {
+        unsigned count = 0;
+        for (std::uint32_t bit = 1u << 15; bit != 0 && (mask_ & bit) == 0;
+             bit >>= 1) {
+          ++count;
+        }
+        return count;
+      }
+
+      group_mask begin() const noexcept { return *this; }
+      group_mask end() const noexcept { return group_mask(0); }
+      unsigned operator*() const noexcept { return lowest(); }
+      group_mask& operator++() noexcept
+      {
+        mask_ &= mask_ - 1;
+        return *this;
+      }
+      bool operator!=(const group_mask& rhs) const noexcept
+      {
+        return mask_ != rhs.mask_;
+      }
+
+    private:
+      std::uint32_t mask_;
+    };
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+    class group
+    {
+    public:
+      static constexpr std::size_t width = 16;
+
+      explicit group(const ctrl_t* p) noexcept :
+        ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)))
+      {
+      }
+
+      group_mask match(ctrl_t h2) const noexcept
+      {
+        return group_mask(static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_))));
+      }
+
+      group_mask match_empty() const noexcept { return match(ctrl_empty); }
+
+      group_mask match_empty_or_deleted() const noexcept
+      {
+        return group_mask(static_cast<std::uint32_t>(_mm_movemask_epi8(
+            _mm_cmpgt_epi8(_mm_set1_epi8(ctrl_sentinel), ctrl_))));
+      }
+
+      unsigned count_leading_empty_or_deleted() const noexcept
+      {
+        const auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(
+            _mm_cmpgt_epi8(_mm_set1_epi8(ctrl_sentinel), ctrl_)));
+        return group_ctz(mask + 1);
+      }
+
+    private:
+      __m128i ctrl_;
+    };
+
+#else
+
+    class group
+    {
+    public:
+      static constexpr std::size_t width = 16;
+
+      explicit group(const ctrl_t* p) noexcept
+      {
+        std::memcpy(ctrl_, p, width);
+      }
+
+      group_mask match(ctrl_t h2) const noexcept
+      {
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i != width; ++i) {
+          mask |= static_cast<std::uint32_t>(ctrl_[i] == h2) << i;
+        }
+        return group_mask(mask);
+      }
+
+      group_mask match_empty() const noexcept { return match(ctrl_empty); }
+
+      group_mask match_empty_or_deleted() const noexcept
+      {
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i != width; ++i) {
+          mask |= static_cast<std::uint32_t>(ctrl_[i] < ctrl_sentinel) << i;
+        }
+        return group_mask(mask);
+      }
+
+      unsigned count_leading_empty_or_deleted() const noexcept
+      {
+        unsigned count = 0;
+        while (count != width && ctrl_[count] < ctrl_sentinel) {
+          ++count;
+        }
+        return count;
+      }
+
+    private:
+      ctrl_t ctrl_[width];
+    };
+
+#endif
+
+    // The control bytes of a table with no slots: a sentinel, so that
+    // begin() == end(), and empty bytes, so that every lookup stops at once.
+    inline ctrl_t* empty_group() noexcept
+    {
+      alignas(16) static ctrl_t ctrl[group::width] = { ctrl_sentinel,
+        ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty,
+        ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty,
+        ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty };
+      return ctrl;
+    }
+
+    // Visits groups at triangular offsets: every group is reached once
+    // before any repeats, because the capacity is a power of two minus one.
+    class probe_seq
+    {
+    public:
+      probe_seq(std::size_t hash, std::size_t mask) noexcept :
+        mask_(mask),
+        offset_(hash & mask),
+        index_(0)
+      {
+      }
+
+      std::size_t offset() const noexcept { return offset_; }
+      std::size_t offset(std::size_t i) const noexcept
+      {
+        return (offset_ + i) & mask_;
+      }
+
+      void next() noexcept
+      {
+        index_ += group::width;
+        offset_ = (offset_ + index_) & mask_;
+      }
+
+    private:
+      std::size_t mask_;
+      std::size_t offset_;
+      std::size_t index_;
+    };
+
+    // Hashes from std::hash are often the identity, but the table splits
+    // the hash into a probe start and seven tag bits, so both halves need
+    // entropy. One multiply spreads every input bit over the result.
+    inline std::size_t hash_spread(std::size_t hash) noexcept
+    {
+      return static_cast<std::size_t>(
+          hash_mix(static_cast<std::uint64_t>(hash) ^ hash_secret()[0],
+              hash_prime64));
+    }
+
+    inline std::size_t hash_h1(std::size_t hash) noexcept { return hash >> 7; }
+    inline ctrl_t hash_h2(std::size_t hash) noexcept
+    {
+      return static_cast<ctrl_t>(hash & 0x7f);
+    }
+
+    // The table is allowed to fill 7/8 of its slots.
+    inline std::size_t capacity_to_growth(std::size_t capacity) noexcept
+    {
+      return capacity - capacity / 8;
+    }
+
+    inline std::size_t growth_to_capacity(std::size_t growth) noexcept
+    {
+      return growth == 0 ? 0 : growth + (growth - 1) / 7;
+    }
+
+    // The smallest 2^k - 1 that is at least n.
+    inline std::size_t normalize_capacity(std::size_t n) noexcept
+    {
+      std::size_t capacity = 1;
+      while (capacity < n) {
+        capacity = capacity * 2 + 1;
+      }
+      return capacity;
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    class raw_hash_set;
+
+    template <typename Set, typename Value>
+    class raw_hash_iterator
+    {
+      template <typename, typename, typename, typename>
+      friend class raw_hash_set;
+      template <typename, typename>
+      friend class raw_hash_iterator;
+
+    public:
+      using value_type = typename std::remove_const<Value>::type;
+      using difference_type = std::ptrdiff_t;
+      using pointer = Value*;
+      using reference = Value&;
+      using iterator_category = std::forward_iterator_tag;
+
+      raw_hash_iterator() noexcept : ctrl_(nullptr), slot_(nullptr) {}
+
+      template <typename OtherValue,
+          typename = typename std::enable_if<
+              std::is_convertible<OtherValue*, Value*>::value>::type>
+      raw_hash_iterator(
+          const raw_hash_iterator<Set, OtherValue>& other) noexcept :
+        ctrl_(other.ctrl_),
+        slot_(other.slot_)
+      {
+      }
+
+      reference operator*() const noexcept { return *slot_; }
+      pointer operator->() const noexcept { return slot_; }
+
+      raw_hash_iterator& operator++() noexcept
+      {
+        ++ctrl_;
+        ++slot_;
+        skip_empty_or_deleted();
+        return *this;
+      }
+
+      raw_hash_iterator operator++(int) noexcept
+      {
+        raw_hash_iterator temp = *this;
+        ++*this;
+        return temp;
+      }
+
+      friend bool operator==(const raw_hash_iterator& lhs,
+          const raw_hash_iterator& rhs) noexcept
+      {
+        return lhs.ctrl_ == rhs.ctrl_;
+      }
+
+      friend bool operator!=(const raw_hash_iterator& lhs,
+          const raw_hash_iterator& rhs) noexcept
+      {
+        return lhs.ctrl_ != rhs.ctrl_;
+      }
+
+    private:
+      const ctrl_t* ctrl_;
+      Value* slot_;
+
+      raw_hash_iterator(const ctrl_t* ctrl, Value* slot) noexcept :
+        ctrl_(ctrl),
+        slot_(slot)
+      {
+      }
+
+      void skip_empty_or_deleted() noexcept
+      {
+        while (*ctrl_ < ctrl_sentinel) {
+          const unsigned shift = group(ctrl_).count_leading_empty_or_deleted();
+          ctrl_ += shift;
+          slot_ += shift;
+        }
+      }
+    };
+
+    // Policy describes what a slot holds:
+    //   key_type, value_type    the key and the stored element
+    //   mutable_type            value_type without const, to move out of
+    //   key(value)              the key of a stored element
+    //   mutable_ref(value)      the element as a mutable_type
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    class raw_hash_set
+    {
+    public:
+      using key_type = typename Policy::key_type;
+      using value_type = typename Policy::value_type;
+      using size_type = std::size_t;
+      using difference_type = std::ptrdiff_t;
+      using hasher = Hash;
+      using key_equal = Eq;
+      using allocator_type = Alloc;
+      using reference = value_type&;
+      using const_reference = const value_type&;
+      using iterator = raw_hash_iterator<raw_hash_set, value_type>;
+      using const_iterator = raw_hash_iterator<raw_hash_set, const value_type>;
+
+    private:
+      using AllocTraits = std::allocator_traits<allocator_type>;
+      using SlotAlloc =
+          typename AllocTraits::template rebind_alloc<value_type>;
+      using SlotTraits = std::allocator_traits<SlotAlloc>;
+      using mutable_type = typename Policy::mutable_type;
+      using CanRelocate = is_relocatable_with<SlotAlloc, mutable_type>;
+      using CanMove = std::integral_constant<bool,
+          CanRelocate::value ||
+              std::is_nothrow_move_constructible<mutable_type>::value>;
+      using PropagateOnCopy =
+          typename AllocTraits::propagate_on_container_copy_assignment;
+      using PropagateOnMove =
+          typename AllocTraits::propagate_on_container_move_assignment;
+      using PropagateOnSwap =
+          typename AllocTraits::propagate_on_container_swap;
+
+      static_assert(std::is_pointer<typename SlotTraits::pointer>::value,
+          "ftl hash containers need an allocator with raw pointers");
+
+      static constexpr bool transparent =
+          is_transparent<Hash>::value && is_transparent<Eq>::value;
+
+    protected:
+      // Lookups take any key type when both the hasher and the key equality
+      // are transparent, and key_type otherwise.
+      template <typename K>
+      using key_arg =
+          typename key_arg_impl<transparent>::template type<K, key_type>;
+
+    public:
+      raw_hash_set() noexcept(
+          std::is_nothrow_default_constructible<hasher>::value &&
+          std::is_nothrow_default_constructible<key_equal>::value &&
+          std::is_nothrow_default_constructible<allocator_type>::value) :
+        raw_hash_set(0)
+      {
+      }
+
+      explicit raw_hash_set(size_type bucket_count,
+          const hasher& hash = hasher(), const key_equal& eq = key_equal(),
+          const allocator_type& alloc = allocator_type());
+      explicit raw_hash_set(const allocator_type& alloc) :
+        raw_hash_set(0, hasher(), key_equal(), alloc)
+      {
+      }
+
+      template <typename InputIt, enable_if_input_iterator<InputIt> = 0>
+      raw_hash_set(InputIt first, InputIt last, size_type bucket_count = 0,
+          const hasher& hash = hasher(), const key_equal& eq = key_equal(),
+          const allocator_type& alloc = allocator_type()) :
+        raw_hash_set(bucket_count, hash, eq, alloc)
+      {
+        insert(first, last);
+      }
+
+      raw_hash_set(std::initializer_list<value_type> list,
+          size_type bucket_count = 0, const hasher& hash = hasher(),
+          const key_equal& eq = key_equal(),
+          const allocator_type& alloc = allocator_type()) :
+        raw_hash_set(list.begin(), list.end(), bucket_count, hash, eq, alloc)
+      {
+      }
+
+      raw_hash_set(const raw_hash_set&);
+      raw_hash_set(raw_hash_set&&) noexcept;
+      ~raw_hash_set();
+
+      raw_hash_set& operator=(const raw_hash_set&);
+      raw_hash_set& operator=(raw_hash_set&&) noexcept(
+          PropagateOnMove::value || AllocTraits::is_always_equal::value);
+      raw_hash_set& operator=(std::initializer_list<value_type>);
+
+      iterator begin() noexcept;
+      iterator end() noexcept { return iterator(ctrl_ + capacity_, nullptr); }
+      const_iterator begin() const noexcept
+      {
+        return const_cast<raw_hash_set*>(this)->begin();
+      }
+      const_iterator end() const noexcept
+      {
+        return const_cast<raw_hash_set*>(this)->end();
+      }
+      const_iterator cbegin() const noexcept { return begin(); }
+      const_iterator cend() const noexcept { return end(); }
+
+      bool empty() const noexcept { return size_ == 0; }
+      size_type size() const noexcept { return size_; }
+      size_type capacity() const noexcept { return capacity_; }
+      size_type bucket_count() const noexcept { return capacity_; }
+      size_type max_size() const noexcept;
+      float load_factor() const noexcept
+      {
+        return capacity_ == 0 ? 0.0f : float(size_) / float(capacity_);
+      }
+      float max_load_factor() const noexcept { return 7.0f / 8.0f; }
+
+      void clear() noexcept;
+      void reserve(size_type);
+      void rehash(size_type);
+      void swap(raw_hash_set&) noexcept;
+
+      std::pair<iterator, bool> insert(const value_type& value)
+      {
+        return emplace_key(Policy::key(value), value);
+      }
+
+      std::pair<iterator, bool> insert(value_type&& value)
+      {
+        return emplace_key(Policy::key(value), std::move(value));
+      }
+
+      iterator insert(const_iterator, const value_type& value)
+      {
+        return insert(value).first;
+      }
+
+      iterator insert(const_iterator, value_type&& value)
+      {
+        return insert(std::move(value)).first;
+      }
+
+      template <typename InputIt, enable_if_input_iterator<InputIt> = 0>
+      void insert(InputIt, InputIt);
+      void insert(std::initializer_list<value_type> list)
+      {
+        insert(list.begin(), list.end());
+      }
+
+      template <typename... Args>
+      std::pair<iterator, bool> emplace(Args&&...);
+      template <typename... Args>
+      iterator emplace_hint(const_iterator, Args&&... args)
+      {
+        return emplace(std::forward<Args>(args)...).first;
+      }
+
+      iterator erase(const_iterator);
+      iterator erase(iterator it) { return erase(const_iterator(it)); }
+      iterator erase(const_iterator, const_iterator);
+      template <typename K = key_type>
+      size_type erase(const key_arg<K>&);
+
+      template <typename K = key_type>
+      iterator find(const key_arg<K>& key)
+      {
+        return find_hashed(key, hash_of(key));
+      }
+
+      template <typename K = key_type>
+      const_iterator find(const key_arg<K>& key) const
+      {
+        return const_cast<raw_hash_set*>(this)->find_hashed(key,
+            hash_of(key));
+      }
+
+      template <typename K = key_type>
+      bool contains(const key_arg<K>& key) const
+      {
+        return find(key) != end();
+      }
+
+      template <typename K = key_type>
+      size_type count(const key_arg<K>& key) const
+      {
+        return contains(key) ? 1 : 0;
+      }
+
+      template <typename K = key_type>
+      std::pair<iterator, iterator> equal_range(const key_arg<K>&);
+      template <typename K = key_type>
+      std::pair<const_iterator, const_iterator> equal_range(
+          const key_arg<K>&) const;
+
+      hasher hash_function() const { return hash_; }
+      key_equal key_eq() const { return eq_; }
+      allocator_type get_allocator() const noexcept
+      {
+        return allocator_type(alloc_);
+      }
+
+    protected:
+      // Looks key up and, if it is missing, constructs a new element from
+      // args in the slot the key hashes to. The table is only changed once
+      // the element is constructed.
+      template <typename K, typename... Args>
+      std::pair<iterator, bool> emplace_key(const K& key, Args&&... args);
+
+      template <typename K>
+      iterator find_hashed(const K&, std::size_t);
+
+      const_iterator find_existing(const value_type& value) const
+      {
+        return find(Policy::key(value));
+      }
+
+    private:
+      ctrl_t* ctrl_;
+      value_type* slots_;
+      size_type size_;
+      size_type capacity_;
+      size_type growth_left_;
+      hasher hash_;
+      key_equal eq_;
+      SlotAlloc alloc_;
+
+      template <typename K>
+      std::size_t hash_of(const K& key) const
+      {
+        return hash_spread(hash_(key));
+      }
+
+      iterator iterator_at(size_type i) noexcept
+      {
+        return iterator(ctrl_ + i, slots_ + i);
+      }
+
+      template <typename... Args>
+      iterator insert_at(size_type, std::size_t, Args&&...);
+      static size_type slot_units(size_type capacity) noexcept;
+      void set_ctrl(size_type, ctrl_t) noexcept;
+      size_type find_first_non_full(std::size_t) const noexcept;
+      void allocate(size_type);
+      void deallocate() noexcept;
+      void destroy_slots() noexcept;
+      void resize(size_type);
+      void transfer_from(ctrl_t*, value_type*, size_type, size_type,
+          std::true_type);
+      void transfer_from(ctrl_t*, value_type*, size_type, size_type,
+          std::false_type);
+      void transfer_slot(value_type*, value_type*, std::true_type) noexcept;
+      void transfer_slot(value_type*, value_type*, std::false_type) noexcept;
+      void grow_for_insert();
+      void erase_at(size_type) noexcept;
+      void copy_from(const raw_hash_set&);
+      void steal(raw_hash_set&) noexcept;
+      void move_assign(raw_hash_set&, std::true_type) noexcept;
+      void move_assign(raw_hash_set&, std::false_type);
+      void copy_assign_alloc(const raw_hash_set&, std::true_type);
+      void copy_assign_alloc(const raw_hash_set&, std::false_type) noexcept {}
+      void move_assign_alloc(raw_hash_set&, std::true_type) noexcept;
+      void move_assign_alloc(raw_hash_set&, std::false_type) noexcept {}
+      void swap_alloc(raw_hash_set&, std::true_type) noexcept;
+      void swap_alloc(raw_hash_set&, std::false_type) noexcept {}
+      void throw_length_error() const;
+    };
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    raw_hash_set<Policy, Hash, Eq, Alloc>::raw_hash_set(size_type bucket_count,
+        const hasher& hash, const key_equal& eq, const allocator_type& alloc) :
+      ctrl_(empty_group()),
+      slots_(nullptr),
+      size_(0),
+      capacity_(0),
+      growth_left_(0),
+      hash_(hash),
+      eq_(eq),
+      alloc_(alloc)
+    {
+      if (bucket_count != 0) {
+        allocate(normalize_capacity(bucket_count));
+      }
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    raw_hash_set<Policy, Hash, Eq, Alloc>::raw_hash_set(
+        const raw_hash_set& rhs) :
+      raw_hash_set(0, rhs.hash_, rhs.eq_,
+          AllocTraits::select_on_container_copy_construction(
+              allocator_type(rhs.alloc_)))
+    {
+      copy_from(rhs);
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    raw_hash_set<Policy, Hash, Eq, Alloc>::raw_hash_set(
+        raw_hash_set&& rhs) noexcept :
+      ctrl_(std::exchange(rhs.ctrl_, empty_group())),
+      slots_(std::exchange(rhs.slots_, nullptr)),
+      size_(std::exchange(rhs.size_, 0)),
+      capacity_(std::exchange(rhs.capacity_, 0)),
+      growth_left_(std::exchange(rhs.growth_left_, 0)),
+      hash_(std::move(rhs.hash_)),
+      eq_(std::move(rhs.eq_)),
+      alloc_(std::move(rhs.alloc_))
+    {
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    raw_hash_set<Policy, Hash, Eq, Alloc>::~raw_hash_set()
+    {
+      destroy_slots();
+      deallocate();
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    raw_hash_set<Policy, Hash, Eq, Alloc>&
+    raw_hash_set<Policy, Hash, Eq, Alloc>::operator=(const raw_hash_set& rhs)
+    {
+      if (this != &rhs) {
+        clear();
+        copy_assign_alloc(rhs, PropagateOnCopy());
+        hash_ = rhs.hash_;
+        eq_ = rhs.eq_;
+        copy_from(rhs);
+      }
+      return *this;
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    raw_hash_set<Policy, Hash, Eq, Alloc>&
+    raw_hash_set<Policy, Hash, Eq, Alloc>::operator=(
+        raw_hash_set&& rhs) noexcept(PropagateOnMove::value ||
+        AllocTraits::is_always_equal::value)
+    {
+      if (this != &rhs) {
+        move_assign(rhs,
+            std::integral_constant<bool,
+                PropagateOnMove::value ||
+                    AllocTraits::is_always_equal::value>());
+      }
+      return *this;
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    raw_hash_set<Policy, Hash, Eq, Alloc>&
+    raw_hash_set<Policy, Hash, Eq, Alloc>::operator=(
+        std::initializer_list<value_type> list)
+    {
+      clear();
+      insert(list.begin(), list.end());
+      return *this;
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    typename raw_hash_set<Policy, Hash, Eq, Alloc>::iterator
+    raw_hash_set<Policy, Hash, Eq, Alloc>::begin() noexcept
+    {
+      iterator it(ctrl_, slots_);
+      it.skip_empty_or_deleted();
+      return it;
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    typename raw_hash_set<Policy, Hash, Eq, Alloc>::size_type
+    raw_hash_set<Policy, Hash, Eq, Alloc>::max_size() const noexcept
+    {
+      const size_type slots = SlotTraits::max_size(alloc_) / 2;
+      return capacity_to_growth(
+          std::min(slots, std::numeric_limits<size_type>::max() / 2));
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::clear() noexcept
+    {
+      destroy_slots();
+      if (capacity_ != 0) {
+        std::memset(ctrl_, ctrl_empty, capacity_ + group::width);
+        ctrl_[capacity_] = ctrl_sentinel;
+      }
+      size_ = 0;
+      growth_left_ = capacity_to_growth(capacity_);
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::reserve(size_type count)
+    {
+      if (count > size_ + growth_left_) {
+        if (count > max_size()) {
+          throw_length_error();
+        }
+        resize(normalize_capacity(growth_to_capacity(count)));
+      }
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::rehash(size_type count)
+    {
+      if (count == 0 && size_ == 0) {
+        destroy_slots();
+        deallocate();
+        return;
+      }
+      const size_type needed = std::max(count, growth_to_capacity(size_));
+      if (needed > max_size()) {
+        throw_length_error();
+      }
+      resize(normalize_capacity(needed));
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::swap(
+        raw_hash_set& rhs) noexcept
+    {
+      using std::swap;
+      swap(ctrl_, rhs.ctrl_);
+      swap(slots_, rhs.slots_);
+      swap(size_, rhs.size_);
+      swap(capacity_, rhs.capacity_);
+      swap(growth_left_, rhs.growth_left_);
+      swap(hash_, rhs.hash_);
+      swap(eq_, rhs.eq_);
+      swap_alloc(rhs, PropagateOnSwap());
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    template <typename InputIt, enable_if_input_iterator<InputIt>>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::insert(InputIt first,
+        InputIt last)
+    {
+      using category =
+          typename std::iterator_traits<InputIt>::iterator_category;
+      if (std::is_base_of<std::forward_iterator_tag, category>::value) {
+        reserve(size_ + static_cast<size_type>(std::distance(first, last)));
+      }
+      for (; first != last; ++first) {
+        insert(*first);
+      }
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    template <typename... Args>
+    std::pair<typename raw_hash_set<Policy, Hash, Eq, Alloc>::iterator, bool>
+    raw_hash_set<Policy, Hash, Eq, Alloc>::emplace(Args&&... args)
+    {
+      mutable_type value(std::forward<Args>(args)...);
+      return emplace_key(Policy::key(value), std::move(value));
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    typename raw_hash_set<Policy, Hash, Eq, Alloc>::iterator
+    raw_hash_set<Policy, Hash, Eq, Alloc>::erase(const_iterator pos)
+    {
+      iterator it(pos.ctrl_, const_cast<value_type*>(pos.slot_));
+      erase_at(static_cast<size_type>(it.ctrl_ - ctrl_));
+      ++it;
+      return it;
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    typename raw_hash_set<Policy, Hash, Eq, Alloc>::iterator
+    raw_hash_set<Policy, Hash, Eq, Alloc>::erase(const_iterator first,
+        const_iterator last)
+    {
+      if (first == cbegin() && last == cend()) {
+        clear();
+        return end();
+      }
+      while (first != last) {
+        first = erase(first);
+      }
+      return iterator(last.ctrl_, const_cast<value_type*>(last.slot_));
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    template <typename K>
+    typename raw_hash_set<Policy, Hash, Eq, Alloc>::size_type
+    raw_hash_set<Policy, Hash, Eq, Alloc>::erase(const key_arg<K>& key)
+    {
+      iterator it = find(key);
+      if (it == end()) {
+        return 0;
+      }
+      erase_at(static_cast<size_type>(it.ctrl_ - ctrl_));
+      return 1;
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    template <typename K>
+    std::pair<typename raw_hash_set<Policy, Hash, Eq, Alloc>::iterator,
+        typename raw_hash_set<Policy, Hash, Eq, Alloc>::iterator>
+    raw_hash_set<Policy, Hash, Eq, Alloc>::equal_range(const key_arg<K>& key)
+    {
+      iterator it = find(key);
+      if (it == end()) {
+        return { it, it };
+      }
+      iterator next = it;
+      return { it, ++next };
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    template <typename K>
+    std::pair<typename raw_hash_set<Policy, Hash, Eq, Alloc>::const_iterator,
+        typename raw_hash_set<Policy, Hash, Eq, Alloc>::const_iterator>
+    raw_hash_set<Policy, Hash, Eq, Alloc>::equal_range(
+        const key_arg<K>& key) const
+    {
+      return const_cast<raw_hash_set*>(this)->equal_range(key);
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    template <typename K, typename... Args>
+    std::pair<typename raw_hash_set<Policy, Hash, Eq, Alloc>::iterator, bool>
+    raw_hash_set<Policy, Hash, Eq, Alloc>::emplace_key(const K& key,
+        Args&&... args)
+    {
+      const std::size_t hash = hash_of(key);
+      iterator it = find_hashed(key, hash);
+      if (it != end()) {
+        return { it, false };
+      }
+      const size_type target = find_first_non_full(hash);
+      if (growth_left_ == 0 && ctrl_[target] != ctrl_deleted) {
+        // The arguments may refer to elements that growing moves, so the
+        // new element is built before the table changes.
+        mutable_type value(std::forward<Args>(args)...);
+        grow_for_insert();
+        return { insert_at(find_first_non_full(hash), hash, std::move(value)),
+          true };
+      }
+      return { insert_at(target, hash, std::forward<Args>(args)...), true };
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    template <typename... Args>
+    typename raw_hash_set<Policy, Hash, Eq, Alloc>::iterator
+    raw_hash_set<Policy, Hash, Eq, Alloc>::insert_at(size_type target,
+        std::size_t hash, Args&&... args)
+    {
+      SlotTraits::construct(alloc_, slots_ + target,
+          std::forward<Args>(args)...);
+      growth_left_ -= ctrl_[target] == ctrl_empty ? 1 : 0;
+      set_ctrl(target, hash_h2(hash));
+      ++size_;
+      return iterator_at(target);
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    template <typename K>
+    typename raw_hash_set<Policy, Hash, Eq, Alloc>::iterator
+    raw_hash_set<Policy, Hash, Eq, Alloc>::find_hashed(const K& key,
+        std::size_t hash)
+    {
+      probe_seq seq(hash_h1(hash), capacity_);
+      const ctrl_t h2 = hash_h2(hash);
+      for (;;) {
+        const group g(ctrl_ + seq.offset());
+        for (unsigned i : g.match(h2)) {
+          const size_type index = seq.offset(i);
+          if (eq_(key, Policy::key(slots_[index]))) {
+            return iterator_at(index);
+          }
+        }
+        if (g.match_empty()) {
+          return end();
+        }
+        seq.next();
+      }
+    }
+
+    // Slots come first in the block, then the control bytes, rounded up to
+    // whole slots.
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    typename raw_hash_set<Policy, Hash, Eq, Alloc>::size_type
+    raw_hash_set<Policy, Hash, Eq, Alloc>::slot_units(
+        size_type capacity) noexcept
+    {
+      const size_type ctrl_bytes = capacity + group::width;
+      return capacity + (ctrl_bytes + sizeof(value_type) - 1) /
+          sizeof(value_type);
+    }
+
+    // Writes the control byte of slot i and its copy past the sentinel.
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::set_ctrl(size_type i,
+        ctrl_t h) noexcept
+    {
+      constexpr size_type cloned = group::width - 1;
+      ctrl_[i] = h;
+      ctrl_[((i - cloned) & capacity_) + (cloned & capacity_)] = h;
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    typename raw_hash_set<Policy, Hash, Eq, Alloc>::size_type
+    raw_hash_set<Policy, Hash, Eq, Alloc>::find_first_non_full(
+        std::size_t hash) const noexcept
+    {
+      probe_seq seq(hash_h1(hash), capacity_);
+      for (;;) {
+        const group_mask mask = group(ctrl_ + seq.offset())
+                                    .match_empty_or_deleted();
+        if (mask) {
+          return seq.offset(mask.lowest());
+        }
+        seq.next();
+      }
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::allocate(size_type capacity)
+    {
+      value_type* slots = SlotTraits::allocate(alloc_, slot_units(capacity));
+      slots_ = slots;
+      ctrl_ = reinterpret_cast<ctrl_t*>(slots + capacity);
+      capacity_ = capacity;
+      std::memset(ctrl_, ctrl_empty, capacity + group::width);
+      ctrl_[capacity] = ctrl_sentinel;
+      growth_left_ = capacity_to_growth(capacity) - size_;
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::deallocate() noexcept
+    {
+      if (capacity_ != 0) {
+        SlotTraits::deallocate(alloc_, slots_, slot_units(capacity_));
+      }
+      ctrl_ = empty_group();
+      slots_ = nullptr;
+      size_ = 0;
+      capacity_ = 0;
+      growth_left_ = 0;
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::destroy_slots() noexcept
+    {
+      if (std::is_trivially_destructible<value_type>::value) {
+        return;
+      }
+      for (size_type i = 0; i != capacity_; ++i) {
+        if (is_full(ctrl_[i])) {
+          SlotTraits::destroy(alloc_, slots_ + i);
+        }
+      }
+    }
+
+    // Moves every element into a fresh table of the given capacity. Types
+    // whose move may throw are copied, and the old table is kept until all
+    // copies are made.
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::resize(size_type capacity)
+    {
+      ctrl_t* old_ctrl = ctrl_;
+      value_type* old_slots = slots_;
+      const size_type old_capacity = capacity_;
+      const size_type old_growth_left = growth_left_;
+      allocate(capacity);
+      transfer_from(old_ctrl, old_slots, old_capacity, old_growth_left,
+          CanMove());
+      if (old_capacity != 0) {
+        SlotTraits::deallocate(alloc_, old_slots, slot_units(old_capacity));
+      }
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::transfer_from(ctrl_t* old_ctrl,
+        value_type* old_slots, size_type old_capacity, size_type,
+        std::true_type)
+    {
+      for (size_type i = 0; i != old_capacity; ++i) {
+        if (is_full(old_ctrl[i])) {
+          const std::size_t hash = hash_of(Policy::key(old_slots[i]));
+          const size_type target = find_first_non_full(hash);
+          set_ctrl(target, hash_h2(hash));
+          transfer_slot(slots_ + target, old_slots + i, CanRelocate());
+        }
+      }
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::transfer_from(ctrl_t* old_ctrl,
+        value_type* old_slots, size_type old_capacity,
+        size_type old_growth_left, std::false_type)
+    {
+      value_type* new_slots = slots_;
+      const size_type new_capacity = capacity_;
+      auto deleter = [&]() {
+        destroy_slots();
+        SlotTraits::deallocate(alloc_, new_slots, slot_units(new_capacity));
+        ctrl_ = old_ctrl;
+        slots_ = old_slots;
+        capacity_ = old_capacity;
+        growth_left_ = old_growth_left;
+      };
+      exception_guard<decltype(deleter)> guard(deleter);
+      for (size_type i = 0; i != old_capacity; ++i) {
+        if (is_full(old_ctrl[i])) {
+          const std::size_t hash = hash_of(Policy::key(old_slots[i]));
+          const size_type target = find_first_non_full(hash);
+          SlotTraits::construct(alloc_, new_slots + target,
+              static_cast<const mutable_type&>(
+                  Policy::mutable_ref(old_slots[i])));
+          set_ctrl(target, hash_h2(hash));
+        }
+      }
+      guard.complete();
+      for (size_type i = 0; i != old_capacity; ++i) {
+        if (is_full(old_ctrl[i])) {
+          SlotTraits::destroy(alloc_, old_slots + i);
+        }
+      }
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::transfer_slot(value_type* to,
+        value_type* from, std::true_type) noexcept
+    {
+      std::memcpy(static_cast<void*>(to), static_cast<const void*>(from),
+          sizeof(value_type));
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::transfer_slot(value_type* to,
+        value_type* from, std::false_type) noexcept
+    {
+      SlotTraits::construct(alloc_, to, std::move(Policy::mutable_ref(*from)));
+      SlotTraits::destroy(alloc_, from);
+    }
+
+    // Tables that are mostly tombstones are rebuilt at the same size; the
+    // others double.
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::grow_for_insert()
+    {
+      if (capacity_ > group::width && size_ * 32 <= capacity_ * 25) {
+        resize(capacity_);
+      } else {
+        if (size_ >= max_size()) {
+          throw_length_error();
+        }
+        resize(capacity_ * 2 + 1);
+      }
+    }
+
+    // A slot may go back to empty only if no probe ever passed over it
+    // while it was full, which holds when the group around it had an empty
+    // slot on each side within one group width.
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::erase_at(size_type i) noexcept
+    {
+      SlotTraits::destroy(alloc_, slots_ + i);
+      --size_;
+      const size_type before = (i - group::width) & capacity_;
+      const group_mask empty_after = group(ctrl_ + i).match_empty();
+      const group_mask empty_before = group(ctrl_ + before).match_empty();
+      const bool was_never_full = empty_before && empty_after &&
+          empty_after.trailing_zeros() + empty_before.leading_zeros() <
+              group::width;
+      set_ctrl(i, was_never_full ? ctrl_empty : ctrl_deleted);
+      growth_left_ += was_never_full ? 1 : 0;
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::copy_from(
+        const raw_hash_set& rhs)
+    {
+      reserve(rhs.size_);
+      for (const value_type& value : rhs) {
+        const std::size_t hash = hash_of(Policy::key(value));
+        const size_type target = find_first_non_full(hash);
+        SlotTraits::construct(alloc_, slots_ + target, value);
+        set_ctrl(target, hash_h2(hash));
+        ++size_;
+        --growth_left_;
+      }
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::steal(
+        raw_hash_set& rhs) noexcept
+    {
+      ctrl_ = std::exchange(rhs.ctrl_, empty_group());
+      slots_ = std::exchange(rhs.slots_, nullptr);
+      size_ = std::exchange(rhs.size_, 0);
+      capacity_ = std::exchange(rhs.capacity_, 0);
+      growth_left_ = std::exchange(rhs.growth_left_, 0);
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::move_assign(raw_hash_set& rhs,
+        std::true_type) noexcept
+    {
+      destroy_slots();
+      deallocate();
+      move_assign_alloc(rhs, PropagateOnMove());
+      hash_ = std::move(rhs.hash_);
+      eq_ = std::move(rhs.eq_);
+      steal(rhs);
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::move_assign(raw_hash_set& rhs,
+        std::false_type)
+    {
+      if (alloc_ == rhs.alloc_) {
+        move_assign(rhs, std::true_type());
+        return;
+      }
+      clear();
+      hash_ = rhs.hash_;
+      eq_ = rhs.eq_;
+      reserve(rhs.size_);
+      for (value_type& value : rhs) {
+        insert(std::move(Policy::mutable_ref(value)));
+      }
+      rhs.clear();
+    }
+
+    // A propagating allocator replaces ours, so storage obtained from ours
+    // has to go first unless the two are interchangeable.
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::copy_assign_alloc(
+        const raw_hash_set& rhs, std::true_type)
+    {
+      if (alloc_ != rhs.alloc_) {
+        deallocate();
+      }
+      alloc_ = rhs.alloc_;
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::move_assign_alloc(
+        raw_hash_set& rhs, std::true_type) noexcept
+    {
+      alloc_ = std::move(rhs.alloc_);
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::swap_alloc(raw_hash_set& rhs,
+        std::true_type) noexcept
+    {
+      using std::swap;
+      swap(alloc_, rhs.alloc_);
+    }
+
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    void raw_hash_set<Policy, Hash, Eq, Alloc>::throw_length_error() const
+    {
+      throw std::length_error("ftl::raw_hash_set length_error");
+    }
+
+    // Two tables are equal when they hold the same elements, in whatever
+    // order.
+    template <typename Policy, typename Hash, typename Eq, typename Alloc>
+    bool hash_set_equal(const raw_hash_set<Policy, Hash, Eq, Alloc>& lhs,
+        const raw_hash_set<Policy, Hash, Eq, Alloc>& rhs)
+    {
+      if (lhs.size() != rhs.size()) {
+        return false;
+      }
+      const auto* small = &lhs;
+      const auto* large = &rhs;
+      if (small->capacity() > large->capacity()) {
+        std::swap(small, large);
+      }
+      for (const auto& value : *small) {
+        auto it = large->find(Policy::key(value));
+        if (it == large->end() || !(*it == value)) {
+          return false;
+        }
+      }
+      return true;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,169 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_INTERNAL_RELOCATE_HPP
+#define FTL_INTERNAL_RELOCATE_HPP
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include "type_traits.hpp"
+
+namespace ftl {
+  namespace detail {
+
+    template <typename T>
+    T* relocate(T* first, T* last, T* out) noexcept
+    {
+      if (first != last) {
+        std::memmove(static_cast<void*>(out), static_cast<const void*>(first),
+            (last - first) * sizeof(T));
+      }
+      return out + (last - first);
+    }
+
+    template <typename Pointer, typename Size>
+    struct allocation_result
+    {
+      Pointer ptr;
+      Size count;
+    };
+
+    template <typename Alloc, bool = is_reallocatable_with<Alloc>::value>
+    struct storage_traits
+    {
+      using traits = std::allocator_traits<Alloc>;
+      using pointer = typename traits::pointer;
+      using size_type = typename traits::size_type;
+      using allocation = allocation_result<pointer, size_type>;
+
+      static pointer allocate(Alloc& alloc, size_type capacity)
+      {
+        return traits::allocate(alloc, capacity);
+      }
+
+      static allocation allocate_at_least(Alloc& alloc, size_type capacity)
+      {
+        return allocate_at_least(alloc, capacity,
+            has_allocate_at_least<Alloc>());
+      }
+
+      static void
+      deallocate(Alloc& alloc, pointer p, size_type capacity) noexcept
+      {
+        if (p != nullptr) {
+          traits::deallocate(alloc, p, capacity);
+        }
+      }
+
+      static bool try_expand(Alloc& alloc, pointer p, size_type capacity,
+          size_type new_capacity)
+      {
+        return p != nullptr &&
+            try_expand(alloc, p, capacity, new_capacity,
+                has_try_expand<Alloc>());
+      }
+
+      // Moves [p, p + size) into a block of at least new_capacity elements.
+      // Only valid when is_relocatable_with<Alloc> holds.
+      static allocation reallocate(Alloc& alloc, pointer p, size_type size,
+          size_type capacity, size_type new_capacity)
+      {
+        return reallocate(alloc, p, size, capacity, new_capacity,
+            has_reallocate<Alloc>());
+      }
+
+    private:
+      static allocation reallocate(Alloc& alloc, pointer p, size_type size,
+          size_type capacity, size_type new_capacity, std::true_type)
+      {
+        auto result = alloc.reallocate(p, size, capacity, new_capacity);
+        return { result.ptr, static_cast<size_type>(result.count) };
+      }
+
+      static allocation reallocate(Alloc& alloc, pointer p, size_type size,
+          size_type capacity, size_type new_capacity, std::false_type)
+      {
+        allocation result = allocate_at_least(alloc, new_capacity);
+        relocate(p, p + size, result.ptr);
+        deallocate(alloc, p, capacity);
+        return result;
+      }
+
+      static allocation
+      allocate_at_least(Alloc& alloc, size_type capacity, std::true_type)
+      {
+        auto result = alloc.allocate_at_least(capacity);
+        return { result.ptr, static_cast<size_type>(result.count) };
+      }
+
+      static allocation
+      allocate_at_least(Alloc& alloc, size_type capacity, std::false_type)
+      {
+        return { allocate(alloc, capacity), capacity };
+      }
+
+      static bool try_expand(Alloc& alloc, pointer p, size_type capacity,
+          size_type new_capacity, std::true_type)
+      {
+        return alloc.try_expand(p, capacity, new_capacity);
+      }
+
+      static bool
+      try_expand(Alloc&, pointer, size_type, size_type, std::false_type)
+      {
+        return false;
+      }
+    };
+
+    template <typename Alloc>
+    struct storage_traits<Alloc, true>
+    {
+      using traits = std::allocator_traits<Alloc>;
+      using pointer = typename traits::pointer;
+      using size_type = typename traits::size_type;
+      using value_type = typename traits::value_type;
+      using allocation = allocation_result<pointer, size_type>;
+
+      static pointer allocate(Alloc&, size_type capacity)
+      {
+        void* p = std::malloc(capacity * sizeof(value_type));
+        if (p == nullptr && capacity != 0) {
+          throw std::bad_alloc();
+        }
+        return static_cast<pointer>(p);
+      }
+
+      static allocation allocate_at_least(Alloc& alloc, size_type capacity)
+      {
+        return { allocate(alloc, capacity), capacity };
+      }
+
+      static void deallocate(Alloc&, pointer p, size_type) noexcept
+      {
+        std::free(p);
+      }
+
+      // realloc already extends the block in place whenever it can.
+      static bool try_expand(Alloc&, pointer, size_type, size_type)
+      {
+        return false;
+      }
+
+      static allocation reallocate(Alloc&, pointer p, size_type,
+          size_type, size_type new_capacity)
+      {
+        void* new_p = std::realloc(static_cast<void*>(p),
+            new_capacity * sizeof(value_type));
+        if (new_p == nullptr) {
+          throw std::bad_alloc();
+        }
+        return { static_cast<pointer>(new_p), new_capacity };
+      }
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,195 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_INTERNAL_STATS_HPP
+#define FTL_INTERNAL_STATS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <ostream>
+
+namespace ftl {
+
+  // A stats policy is told about the storage events of a container:
+  //   on_allocate(capacity, bytes)    a new block was obtained
+  //   on_reallocate(relocated)        the elements moved to a new block
+  //   on_expand_in_place(capacity)    the block grew without moving
+  //   on_shift(count)                 count elements moved to open a gap
+  // All of them are static. The default policy ignores everything and
+  // costs nothing.
+  struct no_stats
+  {
+    static void on_allocate(std::size_t, std::size_t) noexcept {}
+    static void on_reallocate(std::size_t) noexcept {}
+    static void on_expand_in_place(std::size_t) noexcept {}
+    static void on_shift(std::size_t) noexcept {}
+  };
+
+  // Counters shared by every container recording under one name. They are
+  // updated with relaxed atomics: each value is exact, but a snapshot taken
+  // while containers are running need not be consistent across counters.
+  struct stats_counters
+  {
+    std::atomic<std::uint64_t> allocations{ 0 };
+    std::atomic<std::uint64_t> bytes_allocated{ 0 };
+    std::atomic<std::uint64_t> reallocations{ 0 };
+    std::atomic<std::uint64_t> elements_relocated{ 0 };
+    std::atomic<std::uint64_t> in_place_expansions{ 0 };
+    std::atomic<std::uint64_t> peak_capacity{ 0 };
+    std::atomic<std::uint64_t> shifts{ 0 };
+    std::atomic<std::uint64_t> elements_shifted{ 0 };
+
+    void record_capacity(std::uint64_t capacity) noexcept
+    {
+      std::uint64_t peak = peak_capacity.load(std::memory_order_relaxed);
+      while (peak < capacity &&
+          !peak_capacity.compare_exchange_weak(peak, capacity,
+              std::memory_order_relaxed)) {
+      }
+    }
+
+    void reset() noexcept
+    {
+      for (auto counter : { &allocations, &bytes_allocated, &reallocations,
+               &elements_relocated, &in_place_expansions, &peak_capacity,
+               &shifts, &elements_shifted }) {
+        counter->store(0, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  // The process-wide set of named counters. Entries are created on first
+  // use and live until exit, so references to them never dangle.
+  class stats_registry final
+  {
+  public:
+    static stats_registry& instance()
+    {
+      static stats_registry* registry = new stats_registry();
+      return *registry;
+    }
+
+    stats_registry(const stats_registry&) = delete;
+    stats_registry& operator=(const stats_registry&) = delete;
+
+    // Returns the counters for name, creating them if needed. name must
+    // outlive the registry; string literals do.
+    stats_counters& counters(const char* name)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (entry* e = entries_; e != nullptr; e = e->next) {
+        if (std::strcmp(e->name, name) == 0) {
+          return e->counters;
+        }
+      }
+      entries_ = new entry(name, entries_);
+      return entries_->counters;
+    }
+
+    // Calls f(name, counters) for every entry, newest first.
+    template <typename F>
+    void for_each(F f)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (entry* e = entries_; e != nullptr; e = e->next) {
+        f(e->name, static_cast<const stats_counters&>(e->counters));
+      }
+    }
+
+    void reset()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (entry* e = entries_; e != nullptr; e = e->next) {
+        e->counters.reset();
+      }
+    }
+
+    // Writes one line per entry. Entries that reallocated often relative to
+    // their peak capacity are the ones worth a reserve().
+    void dump(std::ostream& out)
+    {
+      for_each([&out](const char* name, const stats_counters& c) {
+        out << name << ": allocations=" << load(c.allocations)
+            << " bytes=" << load(c.bytes_allocated)
+            << " reallocations=" << load(c.reallocations)
+            << " relocated=" << load(c.elements_relocated)
+            << " expanded_in_place=" << load(c.in_place_expansions)
+            << " peak_capacity=" << load(c.peak_capacity)
+            << " shifts=" << load(c.shifts)
+            << " shifted=" << load(c.elements_shifted) << '\n';
+      });
+    }
+
+  private:
+    struct entry
+    {
+      entry(const char* n, entry* nx) : name(n), next(nx) {}
+
+      const char* name;
+      entry* next;
+      stats_counters counters;
+    };
+
+    std::mutex mutex_;
+    entry* entries_ = nullptr;
+
+    stats_registry() = default;
+
+    static std::uint64_t load(const std::atomic<std::uint64_t>& counter)
+    {
+      return counter.load(std::memory_order_relaxed);
+    }
+  };
+
+  // Records into the registry entry named by Tag::name(), a static function
+  // returning a string literal. Give each call site of interest its own tag,
+  // or share one across a subsystem:
+  //   struct parser_tokens { static const char* name() { return "tokens"; } };
+  //   ftl::vector<token, std::allocator<token>, ftl::growth_factor_2,
+  //       ftl::tagged_stats<parser_tokens>> tokens;
+  template <typename Tag>
+  struct tagged_stats
+  {
+    static void on_allocate(std::size_t capacity, std::size_t bytes) noexcept
+    {
+      stats_counters& c = counters();
+      c.allocations.fetch_add(1, std::memory_order_relaxed);
+      c.bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+      c.record_capacity(capacity);
+    }
+
+    static void on_reallocate(std::size_t relocated) noexcept
+    {
+      stats_counters& c = counters();
+      c.reallocations.fetch_add(1, std::memory_order_relaxed);
+      c.elements_relocated.fetch_add(relocated, std::memory_order_relaxed);
+    }
+
+    static void on_expand_in_place(std::size_t capacity) noexcept
+    {
+      stats_counters& c = counters();
+      c.in_place_expansions.fetch_add(1, std::memory_order_relaxed);
+      c.record_capacity(capacity);
+    }
+
+    static void on_shift(std::size_t count) noexcept
+    {
+      stats_counters& c = counters();
+      c.shifts.fetch_add(1, std::memory_order_relaxed);
+      c.elements_shifted.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    static stats_counters& counters() noexcept
+    {
+      static stats_counters& c = stats_registry::instance().counters(
+          Tag::name());
+      return c;
+    }
+  };
+}
+
+#endif
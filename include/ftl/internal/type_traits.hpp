@@ -0,0 +1,302 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_INTERNAL_TYPE_TRAITS_HPP
+#define FTL_INTERNAL_TYPE_TRAITS_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "config.hpp"
+
+#if defined(FTL_CPP17_FEATURES)
+#  include <memory_resource>
+#endif
+
+namespace ftl {
+
+  // A type is trivially relocatable when moving an object to a new address
+  // and ending the lifetime of the source can be replaced by a plain byte
+  // copy. Trivially copyable types qualify automatically; other types may
+  // opt in by specializing this trait:
+  //
+  //   template <>
+  //   struct ftl::is_trivially_relocatable<my_handle> : std::true_type {};
+  template <typename T>
+  struct is_trivially_relocatable : std::is_trivially_copyable<T>
+  {
+  };
+
+  template <typename T>
+  struct is_trivially_relocatable<std::unique_ptr<T>> : std::true_type
+  {
+  };
+
+  template <typename T>
+  struct is_trivially_relocatable<std::shared_ptr<T>> : std::true_type
+  {
+  };
+
+  template <typename T>
+  struct is_trivially_relocatable<std::weak_ptr<T>> : std::true_type
+  {
+  };
+
+  template <typename T1, typename T2>
+  struct is_trivially_relocatable<std::pair<T1, T2>> :
+    std::integral_constant<bool,
+        is_trivially_relocatable<typename std::remove_const<T1>::type>::value &&
+            is_trivially_relocatable<
+                typename std::remove_const<T2>::type>::value>
+  {
+  };
+
+  // A type is trivially equality comparable when two objects compare equal
+  // exactly if their object representations are identical, so containers of
+  // it may be compared and hashed as raw bytes. This holds for integers,
+  // enumerations and pointers; other types with no padding and a
+  // memberwise operator== may opt in by specializing this trait.
+  template <typename T>
+  struct is_trivially_equality_comparable :
+    std::integral_constant<bool,
+        std::is_integral<T>::value || std::is_enum<T>::value ||
+            std::is_pointer<T>::value>
+  {
+  };
+}
+
+namespace ftl {
+
+  // Tag selecting default initialization, which leaves trivially default
+  // constructible elements with indeterminate values.
+  struct default_init_t
+  {
+    explicit default_init_t() = default;
+  };
+
+  constexpr default_init_t default_init = default_init_t();
+
+  // Tag stating that a range is already sorted and free of duplicates, so
+  // the sorted containers may merge it without sorting or checking.
+  struct sorted_unique_t
+  {
+    explicit sorted_unique_t() = default;
+  };
+
+  constexpr sorted_unique_t sorted_unique = sorted_unique_t();
+}
+
+namespace ftl {
+  namespace detail {
+
+    template <typename...>
+    using void_t = void;
+
+    template <typename T, typename = void>
+    struct is_input_iterator : std::false_type
+    {
+    };
+
+    template <typename T>
+    struct is_input_iterator<T,
+        void_t<typename std::iterator_traits<T>::iterator_category>> :
+      std::is_base_of<std::input_iterator_tag,
+          typename std::iterator_traits<T>::iterator_category>
+    {
+    };
+
+    template <typename Iterator>
+    using enable_if_input_iterator =
+        typename std::enable_if<is_input_iterator<Iterator>::value, int>::type;
+
+    template <typename T, typename = void>
+    struct is_transparent : std::false_type
+    {
+    };
+
+    template <typename T>
+    struct is_transparent<T, void_t<typename T::is_transparent>> :
+      std::true_type
+    {
+    };
+
+    // Selects the argument type of a lookup: the caller's K for transparent
+    // function objects and Key otherwise, where a non-deduced K leaves the
+    // usual implicit conversions to Key in place.
+    template <bool Transparent>
+    struct key_arg_impl
+    {
+      template <typename K, typename Key>
+      using type = Key;
+    };
+
+    template <>
+    struct key_arg_impl<true>
+    {
+      template <typename K, typename Key>
+      using type = K;
+    };
+
+    template <typename Alloc>
+    struct is_std_allocator : std::false_type
+    {
+    };
+
+    template <typename T>
+    struct is_std_allocator<std::allocator<T>> : std::true_type
+    {
+    };
+
+    template <typename, typename Alloc, typename... Args>
+    struct has_construct_impl : std::false_type
+    {
+    };
+
+    template <typename Alloc, typename... Args>
+    struct has_construct_impl<void_t<decltype(std::declval<Alloc&>().construct(
+                                  std::declval<Args>()...))>,
+        Alloc, Args...> : std::true_type
+    {
+    };
+
+    template <typename Alloc, typename... Args>
+    struct has_construct : has_construct_impl<void, Alloc, Args...>
+    {
+    };
+
+    template <typename Alloc, typename T, typename = void>
+    struct has_destroy_impl : std::false_type
+    {
+    };
+
+    template <typename Alloc, typename T>
+    struct has_destroy_impl<Alloc, T,
+        void_t<decltype(std::declval<Alloc&>().destroy(std::declval<T*>()))>> :
+      std::true_type
+    {
+    };
+
+    template <typename Alloc, typename T>
+    struct has_destroy : has_destroy_impl<Alloc, T>
+    {
+    };
+
+#if defined(FTL_CPP17_FEATURES)
+    // polymorphic_allocator only adds uses-allocator construction on top of
+    // the default behaviour, so it is transparent for element types that
+    // take no allocator. Its destroy() is deprecated and just runs the
+    // destructor, so it is never probed.
+    template <typename U, typename T, typename... Args>
+    struct has_construct<std::pmr::polymorphic_allocator<U>, T*, Args...> :
+      std::uses_allocator<T, std::pmr::polymorphic_allocator<U>>
+    {
+    };
+
+    template <typename U, typename T>
+    struct has_destroy<std::pmr::polymorphic_allocator<U>, T> :
+      std::false_type
+    {
+    };
+#endif
+
+    // Optional allocator extensions. allocate_at_least(n) returns an object
+    // with members ptr and count, like std::allocation_result, for a block of
+    // count >= n elements. try_expand(p, n, new_n) grows the block at p from
+    // n to new_n elements in place and reports whether it succeeded.
+    // reallocate(p, size, n, new_n) moves the first size elements of the
+    // block at p bitwise into one of at least new_n elements, returning it
+    // like allocate_at_least; it is only used for relocatable elements.
+    template <typename Alloc, typename = void>
+    struct has_allocate_at_least : std::false_type
+    {
+    };
+
+    template <typename Alloc>
+    struct has_allocate_at_least<Alloc,
+        void_t<decltype(std::declval<Alloc&>().allocate_at_least(
+            std::declval<
+                typename std::allocator_traits<Alloc>::size_type>()))>> :
+      std::true_type
+    {
+    };
+
+    template <typename Alloc, typename = void>
+    struct has_try_expand : std::false_type
+    {
+    };
+
+    template <typename Alloc>
+    struct has_try_expand<Alloc,
+        void_t<decltype(std::declval<Alloc&>().try_expand(
+            std::declval<typename std::allocator_traits<Alloc>::pointer>(),
+            std::declval<typename std::allocator_traits<Alloc>::size_type>(),
+            std::declval<
+                typename std::allocator_traits<Alloc>::size_type>()))>> :
+      std::true_type
+    {
+    };
+
+    template <typename Alloc, typename = void>
+    struct has_reallocate : std::false_type
+    {
+    };
+
+    template <typename Alloc>
+    struct has_reallocate<Alloc,
+        void_t<decltype(std::declval<Alloc&>().reallocate(
+            std::declval<typename std::allocator_traits<Alloc>::pointer>(),
+            std::declval<typename std::allocator_traits<Alloc>::size_type>(),
+            std::declval<typename std::allocator_traits<Alloc>::size_type>(),
+            std::declval<
+                typename std::allocator_traits<Alloc>::size_type>()))>> :
+      std::true_type
+    {
+    };
+
+    // Elements owned by a container using Alloc may be relocated bitwise only
+    // if the allocator hands out raw pointers and does not hook construction
+    // or destruction, since those hooks would be skipped.
+    template <typename Alloc,
+        typename T = typename std::allocator_traits<Alloc>::value_type>
+    struct is_relocatable_with :
+      std::integral_constant<bool,
+          is_trivially_relocatable<T>::value &&
+              std::is_pointer<
+                  typename std::allocator_traits<Alloc>::pointer>::value &&
+              (is_std_allocator<Alloc>::value ||
+                  (!has_construct<Alloc, T*, T&&>::value &&
+                      !has_destroy<Alloc, T>::value))>
+    {
+    };
+
+    // Default initialization may be skipped entirely when it is a no-op and
+    // the allocator does not hook value construction.
+    template <typename Alloc,
+        typename T = typename std::allocator_traits<Alloc>::value_type>
+    struct is_trivially_default_init_with :
+      std::integral_constant<bool,
+          std::is_trivially_default_constructible<T>::value &&
+              (is_std_allocator<Alloc>::value ||
+                  !has_construct<Alloc, T*>::value)>
+    {
+    };
+
+    // std::allocator storage of relocatable elements is served by malloc so
+    // that growth can use realloc and extend the block in place.
+    template <typename Alloc,
+        typename T = typename std::allocator_traits<Alloc>::value_type>
+    struct is_reallocatable_with :
+      std::integral_constant<bool,
+          is_relocatable_with<Alloc, T>::value &&
+              is_std_allocator<Alloc>::value &&
+              alignof(T) <= alignof(std::max_align_t)>
+    {
+    };
+  }
+}
+
+#endif
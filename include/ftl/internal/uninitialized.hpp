@@ -0,0 +1,88 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_INTERNAL_UNINITIALIZED_HPP
+#define FTL_INTERNAL_UNINITIALIZED_HPP
+
+#include <memory>
+#include <utility>
+#include "exception_guard.hpp"
+
+namespace ftl {
+  namespace detail {
+
+    // Allocator-aware counterparts of the std::uninitialized_* algorithms:
+    // on exception every element constructed so far is destroyed again.
+
+    template <typename Alloc, typename InputIt, typename Pointer>
+    Pointer
+    uninitialized_copy(Alloc& alloc, InputIt first, InputIt last, Pointer out)
+    {
+      using traits = std::allocator_traits<Alloc>;
+      Pointer begin = out;
+      auto deleter = [&]() {
+        for (; out != begin; --out) {
+          traits::destroy(alloc, out - 1);
+        }
+      };
+      exception_guard<decltype(deleter)> guard(deleter);
+      for (; first != last; ++first, ++out) {
+        traits::construct(alloc, out, *first);
+      }
+      guard.complete();
+      return out;
+    }
+
+    template <typename Alloc, typename Size, typename Pointer, typename... Args>
+    Pointer uninitialized_fill_n(Alloc& alloc, Pointer out, Size count,
+        const Args&... args)
+    {
+      using traits = std::allocator_traits<Alloc>;
+      Pointer begin = out;
+      auto deleter = [&]() {
+        for (; out != begin; --out) {
+          traits::destroy(alloc, out - 1);
+        }
+      };
+      exception_guard<decltype(deleter)> guard(deleter);
+      for (; count != 0; --count, ++out) {
+        traits::construct(alloc, out, args...);
+      }
+      guard.complete();
+      return out;
+    }
+
+    // Moves elements unless that could throw and a copy is available, in
+    // which case the source is left intact on failure.
+    template <typename Alloc, typename Pointer>
+    Pointer uninitialized_move_if_noexcept(Alloc& alloc, Pointer first,
+        Pointer last, Pointer out)
+    {
+      using traits = std::allocator_traits<Alloc>;
+      Pointer begin = out;
+      auto deleter = [&]() {
+        for (; out != begin; --out) {
+          traits::destroy(alloc, out - 1);
+        }
+      };
+      exception_guard<decltype(deleter)> guard(deleter);
+      for (; first != last; ++first, ++out) {
+        traits::construct(alloc, out, std::move_if_noexcept(*first));
+      }
+      guard.complete();
+      return out;
+    }
+
+    template <typename Alloc, typename Pointer>
+    void destroy(Alloc& alloc, Pointer first, Pointer last) noexcept
+    {
+      using traits = std::allocator_traits<Alloc>;
+      for (; first != last; ++first) {
+        traits::destroy(alloc, first);
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,138 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_INTERNAL_WORK_DEQUE_HPP
+#define FTL_INTERNAL_WORK_DEQUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ftl {
+  namespace detail {
+
+    // The Chase-Lev work-stealing deque, with the memory orderings of Le et
+    // al., "Correct and Efficient Work-Stealing for Weak Memory Models". One
+    // owner thread pushes and pops at the bottom; any thread may steal from
+    // the top. The ring grows when full; replaced rings are kept until the
+    // deque is destroyed because a thief may still be reading one.
+    template <typename T>
+    class work_deque final
+    {
+    public:
+      explicit work_deque(std::size_t capacity = 256) :
+        ring_(new ring(capacity))
+      {
+        current_.store(ring_.get(), std::memory_order_relaxed);
+      }
+
+      work_deque(const work_deque&) = delete;
+      work_deque& operator=(const work_deque&) = delete;
+
+      // Owner only.
+      void push(T* item)
+      {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        const std::int64_t t = top_.load(std::memory_order_acquire);
+        ring* r = current_.load(std::memory_order_relaxed);
+        if (b - t > static_cast<std::int64_t>(r->mask)) {
+          r = grow(r, t, b);
+        }
+        r->store(b, item);
+        bottom_.store(b + 1, std::memory_order_release);
+      }
+
+      // Owner only. Takes the most recently pushed item, or returns null.
+      T* pop() noexcept
+      {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        ring* r = current_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+          bottom_.store(b + 1, std::memory_order_relaxed);
+          return nullptr;
+        }
+        T* item = r->load(b);
+        if (t == b) {
+          if (!top_.compare_exchange_strong(t, t + 1,
+                  std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            item = nullptr;
+          }
+          bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+      }
+
+      // Any thread. Takes the oldest item, or returns null when the deque is
+      // empty or another thread won the race for it.
+      T* steal() noexcept
+      {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) {
+          return nullptr;
+        }
+        T* item = current_.load(std::memory_order_acquire)->load(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                std::memory_order_relaxed)) {
+          return nullptr;
+        }
+        return item;
+      }
+
+    private:
+      struct ring
+      {
+        explicit ring(std::size_t capacity) :
+          mask(capacity - 1), slots(new std::atomic<T*>[capacity])
+        {
+        }
+
+        T* load(std::int64_t i) const noexcept
+        {
+          return slots[static_cast<std::size_t>(i) & mask].load(
+              std::memory_order_relaxed);
+        }
+
+        void store(std::int64_t i, T* item) noexcept
+        {
+          slots[static_cast<std::size_t>(i) & mask].store(item,
+              std::memory_order_relaxed);
+        }
+
+        std::size_t mask;
+        std::unique_ptr<std::atomic<T*>[]> slots;
+      };
+
+      // The padding keeps the top_ the thieves contend on off the cache line
+      // of the owner's bottom_. It is padding rather than alignas so that
+      // deques may be allocated with new before C++17.
+      std::atomic<std::int64_t> top_{ 0 };
+      unsigned char padding_[64];
+      std::atomic<std::int64_t> bottom_{ 0 };
+      std::atomic<ring*> current_{ nullptr };
+      std::unique_ptr<ring> ring_;
+      std::vector<std::unique_ptr<ring>> retired_;
+
+      ring* grow(ring* r, std::int64_t t, std::int64_t b)
+      {
+        std::unique_ptr<ring> bigger(new ring(2 * (r->mask + 1)));
+        for (std::int64_t i = t; i != b; ++i) {
+          bigger->store(i, r->load(i));
+        }
+        retired_.push_back(std::move(ring_));
+        ring_ = std::move(bigger);
+        current_.store(ring_.get(), std::memory_order_release);
+        return ring_.get();
+      }
+    };
+  }
+}
+
+#endif
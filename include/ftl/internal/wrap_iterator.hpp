@@ -5,12 +5,23 @@
 #ifndef FTL_INTERNAL_WRAP_ITERATOR_HPP
 #define FTL_INTERNAL_WRAP_ITERATOR_HPP
 
+#include <cstddef>
 #include <iterator>
 #include "config.hpp"
 
 namespace ftl {
-  template <typename T, typename Allocator>
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
   class vector;
+
+  template <typename T, std::size_t N, typename Allocator>
+  class small_vector;
+
+  template <typename T, std::size_t N>
+  class inplace_vector;
+
+  template <typename T>
+  class mmap_vector;
 }
 
 namespace ftl {
@@ -37,110 +48,127 @@ namespace ftl {
       iterator_type i_;
 
     public:
-      wrap_iterator() {}
+      constexpr wrap_iterator() : i_() {}
 
       template <typename OtherIt,
           typename = typename std::enable_if<
               std::is_convertible<OtherIt, iterator_type>::value>::type>
-      wrap_iterator(const wrap_iterator<OtherIt>& other) : i_(other.base()){};
+      constexpr wrap_iterator(const wrap_iterator<OtherIt>& other) :
+        i_(other.base()){};
 
-      iterator_type base() const { return i_; }
-      reference operator*() const { return *i_; }
+      constexpr iterator_type base() const { return i_; }
+      constexpr reference operator*() const { return *i_; }
 
-      pointer operator->() const { return std::addressof(*i_); }
+      FTL_CONSTEXPR_SINCE_CXX17 pointer operator->() const
+      {
+        return std::addressof(*i_);
+      }
 
-      reference operator[](difference_type n) const { return i_[n]; }
+      constexpr reference operator[](difference_type n) const { return i_[n]; }
 
-      wrap_iterator& operator++()
+      FTL_CONSTEXPR_SINCE_CXX14 wrap_iterator& operator++()
       {
         ++i_;
         return *this;
       }
 
-      wrap_iterator operator++(int)
+      FTL_CONSTEXPR_SINCE_CXX14 wrap_iterator operator++(int)
       {
         wrap_iterator temp = *this;
         ++(*this);
         return temp;
       }
 
-      wrap_iterator& operator--()
+      FTL_CONSTEXPR_SINCE_CXX14 wrap_iterator& operator--()
       {
         --i_;
         return *this;
       }
 
-      wrap_iterator operator--(int)
+      FTL_CONSTEXPR_SINCE_CXX14 wrap_iterator operator--(int)
       {
         wrap_iterator temp = *this;
         --(*this);
         return temp;
       }
 
-      wrap_iterator& operator+=(difference_type n)
+      FTL_CONSTEXPR_SINCE_CXX14 wrap_iterator& operator+=(difference_type n)
       {
         i_ += n;
         return *this;
       }
 
-      wrap_iterator& operator-=(difference_type n)
+      FTL_CONSTEXPR_SINCE_CXX14 wrap_iterator& operator-=(difference_type n)
       {
         i_ -= n;
         return *this;
       }
 
     private:
-      explicit wrap_iterator(iterator_type i) : i_(i) {}
+      constexpr explicit wrap_iterator(iterator_type i) : i_(i) {}
 
       template <typename T>
       friend class wrap_iterator;
 
-      template <typename T, typename Allocator>
+      template <typename T, typename Allocator, typename GrowthPolicy,
+          typename Stats>
       friend class ftl::vector;
+
+      template <typename T, std::size_t N, typename Allocator>
+      friend class ftl::small_vector;
+
+      template <typename T, std::size_t N>
+      friend class ftl::inplace_vector;
+
+      template <typename T>
+      friend class ftl::mmap_vector;
     };
 
     template <typename It1, typename It2>
-    bool
+    constexpr bool
     operator==(const wrap_iterator<It1>& lhs, const wrap_iterator<It2>& rhs)
     {
       return lhs.base() == rhs.base();
     }
 
     template <typename It1, typename It2>
-    bool
+    constexpr bool
     operator!=(const wrap_iterator<It1>& lhs, const wrap_iterator<It2>& rhs)
     {
       return !(lhs == rhs);
     }
 
     template <typename It1, typename It2>
-    bool operator<(const wrap_iterator<It1>& lhs, const wrap_iterator<It2>& rhs)
+    constexpr bool
+    operator<(const wrap_iterator<It1>& lhs, const wrap_iterator<It2>& rhs)
     {
       return lhs.base() < rhs.base();
     }
 
     template <typename It1, typename It2>
-    bool
+    constexpr bool
     operator<=(const wrap_iterator<It1>& lhs, const wrap_iterator<It2>& rhs)
     {
       return !(rhs < lhs);
     }
 
     template <typename It1, typename It2>
-    bool operator>(const wrap_iterator<It1>& lhs, const wrap_iterator<It2>& rhs)
+    constexpr bool
+    operator>(const wrap_iterator<It1>& lhs, const wrap_iterator<It2>& rhs)
     {
       return rhs < lhs;
     }
 
     template <typename It1, typename It2>
-    bool
+    constexpr bool
     operator>=(const wrap_iterator<It1>& lhs, const wrap_iterator<It2>& rhs)
     {
       return !(lhs < rhs);
     }
 
     template <typename It>
-    wrap_iterator<It> operator+(const wrap_iterator<It>& it,
+    FTL_CONSTEXPR_SINCE_CXX14 wrap_iterator<It> operator+(
+        const wrap_iterator<It>& it,
         typename wrap_iterator<It>::difference_type n)
     {
       wrap_iterator<It> result = it;
@@ -149,21 +177,24 @@ namespace ftl {
     }
 
     template <typename It>
-    wrap_iterator<It> operator+(typename wrap_iterator<It>::difference_type n,
+    FTL_CONSTEXPR_SINCE_CXX14 wrap_iterator<It> operator+(
+        typename wrap_iterator<It>::difference_type n,
         const wrap_iterator<It>& it)
     {
       return it + n;
     }
 
     template <typename It1, typename It2>
-    auto operator-(const wrap_iterator<It1>& lhs, const wrap_iterator<It2>& rhs)
+    constexpr auto
+    operator-(const wrap_iterator<It1>& lhs, const wrap_iterator<It2>& rhs)
         -> decltype(lhs.base() - rhs.base())
     {
       return lhs.base() - rhs.base();
     }
 
     template <typename It>
-    wrap_iterator<It> operator-(const wrap_iterator<It>& it,
+    FTL_CONSTEXPR_SINCE_CXX14 wrap_iterator<It> operator-(
+        const wrap_iterator<It>& it,
         typename wrap_iterator<It>::difference_type n)
     {
       wrap_iterator<It> result = it;
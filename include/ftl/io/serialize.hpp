@@ -0,0 +1,526 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_IO_SERIALIZE_HPP
+#define FTL_IO_SERIALIZE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <istream>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include "../containers/vector.hpp"
+#include "../internal/config.hpp"
+#include "../internal/crc32c.hpp"
+#include "../internal/exception_guard.hpp"
+#include "../internal/type_traits.hpp"
+
+#if defined(FTL_POSIX_FEATURES)
+#  include <cerrno>
+#  include <climits>
+#  include <system_error>
+#  include <sys/uio.h>
+#  include <unistd.h>
+#endif
+
+// Binary serialization of ftl::vector. A serialized vector is a 32 byte
+// header followed by the payload, all little-endian:
+//
+//   offset  size  field
+//        0     4  magic, the bytes "FTLV"
+//        4     2  format version, serialize_version
+//        6     2  flags; bit 0 is set when the checksum field is valid
+//        8     4  sizeof the innermost element type
+//       12     4  nesting depth, 0 for a vector of elements
+//       16     8  payload size in bytes
+//       24     4  CRC-32C of the payload, or 0
+//       28     4  reserved, 0
+//
+// The payload of a vector is its element count as 8 bytes followed by its
+// elements: the raw bytes of trivially copyable elements, or the payloads
+// of nested vectors one after another.
+
+namespace ftl {
+
+  // The format version serialize writes; deserialize rejects later ones.
+  constexpr std::uint16_t serialize_version = 1;
+
+  namespace detail {
+
+    constexpr std::size_t serial_header_size = 32;
+    constexpr std::uint32_t serial_magic = 0x564c5446;
+    constexpr std::uint16_t serial_flag_checksum = 1;
+    // The most a count read from the input may reserve ahead of the data;
+    // larger runs grow as their bytes arrive.
+    constexpr std::size_t serial_read_chunk = std::size_t(1) << 20;
+
+    inline void serial_store(unsigned char* p, std::uint64_t value,
+        std::size_t size) noexcept
+    {
+      for (std::size_t i = 0; i != size; ++i) {
+        p[i] = static_cast<unsigned char>(value >> (8 * i));
+      }
+    }
+
+    inline std::uint64_t serial_load(const unsigned char* p,
+        std::size_t size) noexcept
+    {
+      std::uint64_t value = 0;
+      for (std::size_t i = 0; i != size; ++i) {
+        value |= std::uint64_t(p[i]) << (8 * i);
+      }
+      return value;
+    }
+
+    inline std::uint64_t serial_little_endian(std::uint64_t value) noexcept
+    {
+#if defined(FTL_BIG_ENDIAN)
+      return __builtin_bswap64(value);
+#else
+      return value;
+#endif
+    }
+
+    [[noreturn]] inline void throw_serial_error(const char* what)
+    {
+      throw std::runtime_error(what);
+    }
+
+    // Elements are written as their object representation, which is the
+    // little-endian layout only on little-endian hosts.
+    template <typename T>
+    struct serial_traits
+    {
+      static_assert(std::is_trivially_copyable<T>::value,
+          "ftl::serialize needs trivially copyable elements");
+#if defined(FTL_BIG_ENDIAN)
+      static_assert(sizeof(T) == 1,
+          "ftl::serialize only writes byte elements on big-endian hosts");
+#endif
+
+      using is_leaf = std::true_type;
+
+      static constexpr std::uint32_t depth() noexcept { return 0; }
+      static constexpr std::uint32_t element_size() noexcept
+      {
+        return static_cast<std::uint32_t>(sizeof(T));
+      }
+    };
+
+    template <typename T, typename Allocator, typename GrowthPolicy,
+        typename Stats>
+    struct serial_traits<vector<T, Allocator, GrowthPolicy, Stats>>
+    {
+      using is_leaf = std::false_type;
+
+      static constexpr std::uint32_t depth() noexcept
+      {
+        return serial_traits<T>::depth() + 1;
+      }
+      static constexpr std::uint32_t element_size() noexcept
+      {
+        return serial_traits<T>::element_size();
+      }
+    };
+
+    struct serial_chunk
+    {
+      const void* data;
+      std::size_t size;
+    };
+
+    // The serialized form of a vector as a list of byte ranges, ready for
+    // a single writev. Elements are referenced where they are; only the
+    // little-endian counts are stored here.
+    class serial_gather final
+    {
+    public:
+      template <typename T, typename Allocator, typename GrowthPolicy,
+          typename Stats>
+      serial_gather(const vector<T, Allocator, GrowthPolicy, Stats>& v,
+          bool checksum) :
+        size_(0)
+      {
+        add(v);
+        std::size_t next = 0;
+        for (auto& chunk : chunks_) {
+          if (chunk.data == nullptr) {
+            chunk.data = counts_.data() + next++;
+          }
+        }
+        const std::uint32_t crc = checksum ? payload_checksum() : 0;
+        serial_store(header_, serial_magic, 4);
+        serial_store(header_ + 4, serialize_version, 2);
+        serial_store(header_ + 6, checksum ? serial_flag_checksum : 0, 2);
+        serial_store(header_ + 8, serial_traits<T>::element_size(), 4);
+        serial_store(header_ + 12, serial_traits<T>::depth(), 4);
+        serial_store(header_ + 16, size_, 8);
+        serial_store(header_ + 24, crc, 4);
+        serial_store(header_ + 28, 0, 4);
+      }
+
+      const unsigned char* header() const noexcept { return header_; }
+      const vector<serial_chunk>& chunks() const noexcept { return chunks_; }
+
+    private:
+      unsigned char header_[serial_header_size];
+      vector<std::uint64_t> counts_;
+      vector<serial_chunk> chunks_;
+      std::uint64_t size_;
+
+      // Counts are added as null chunks and pointed at counts_ once it has
+      // stopped growing.
+      template <typename T, typename Allocator, typename GrowthPolicy,
+          typename Stats>
+      void add(const vector<T, Allocator, GrowthPolicy, Stats>& v)
+      {
+        counts_.push_back(serial_little_endian(v.size()));
+        chunks_.push_back(serial_chunk{nullptr, sizeof(std::uint64_t)});
+        size_ += sizeof(std::uint64_t);
+        add_elements(v, typename serial_traits<T>::is_leaf());
+      }
+
+      template <typename Vector>
+      void add_elements(const Vector& v, std::true_type)
+      {
+        if (!v.empty()) {
+          const std::size_t bytes = v.size() * sizeof(v[0]);
+          chunks_.push_back(serial_chunk{std::addressof(v[0]), bytes});
+          size_ += bytes;
+        }
+      }
+
+      template <typename Vector>
+      void add_elements(const Vector& v, std::false_type)
+      {
+        for (const auto& element : v) {
+          add(element);
+        }
+      }
+
+      std::uint32_t payload_checksum() const noexcept
+      {
+        std::uint32_t crc = 0;
+        for (const auto& chunk : chunks_) {
+          crc = crc32c(crc, chunk.data, chunk.size);
+        }
+        return crc;
+      }
+    };
+
+    inline void serial_write(std::ostream& os, const void* data,
+        std::size_t size)
+    {
+      os.write(static_cast<const char*>(data),
+          static_cast<std::streamsize>(size));
+      if (!os) {
+        throw std::ios_base::failure("ftl::serialize write failed");
+      }
+    }
+
+    class serial_stream_source final
+    {
+    public:
+      explicit serial_stream_source(std::istream& is) noexcept : is_(is) {}
+
+      void read(void* data, std::size_t size)
+      {
+        is_.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+        if (static_cast<std::size_t>(is_.gcount()) != size) {
+          throw_serial_error("ftl::deserialize truncated input");
+        }
+      }
+
+    private:
+      std::istream& is_;
+    };
+
+#if defined(FTL_POSIX_FEATURES)
+#  if defined(IOV_MAX)
+    constexpr std::size_t serial_iov_max = IOV_MAX;
+#  else
+    constexpr std::size_t serial_iov_max = 1024;
+#  endif
+
+    // Writes all of iov, retrying short writes from where they stopped.
+    inline void serial_writev(int fd, struct iovec* iov, std::size_t count)
+    {
+      while (count != 0) {
+        const int batch = static_cast<int>(std::min(count, serial_iov_max));
+        ssize_t written = ::writev(fd, iov, batch);
+        if (written < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+          throw std::system_error(errno, std::generic_category(),
+              "ftl::serialize writev");
+        }
+        for (; count != 0 && static_cast<std::size_t>(written) >= iov->iov_len;
+             ++iov, --count) {
+          written -= static_cast<ssize_t>(iov->iov_len);
+        }
+        if (count != 0) {
+          iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+          iov->iov_len -= static_cast<std::size_t>(written);
+        }
+      }
+    }
+
+    class serial_fd_source final
+    {
+    public:
+      explicit serial_fd_source(int fd) noexcept : fd_(fd) {}
+
+      void read(void* data, std::size_t size)
+      {
+        auto* p = static_cast<char*>(data);
+        while (size != 0) {
+          const ssize_t n = ::read(fd_, p, size);
+          if (n < 0) {
+            if (errno == EINTR) {
+              continue;
+            }
+            throw std::system_error(errno, std::generic_category(),
+                "ftl::deserialize read");
+          }
+          if (n == 0) {
+            throw_serial_error("ftl::deserialize truncated input");
+          }
+          p += n;
+          size -= static_cast<std::size_t>(n);
+        }
+      }
+
+    private:
+      int fd_;
+    };
+#endif
+
+    // Reads the payload from Source, checking every count against the
+    // bytes the header promised and summing the checksum on the way. The
+    // payload size itself comes from the input, so callers only allocate
+    // ahead of the data in chunks of serial_read_chunk bytes.
+    template <typename Source>
+    class serial_reader final
+    {
+    public:
+      serial_reader(Source& source, std::uint64_t size, bool checksum) :
+        source_(source),
+        remaining_(size),
+        crc_(0),
+        checksum_(checksum)
+      {
+      }
+
+      void read(void* data, std::size_t size)
+      {
+        if (size > remaining_) {
+          throw_serial_error("ftl::deserialize corrupt payload");
+        }
+        source_.read(data, size);
+        remaining_ -= size;
+        if (checksum_) {
+          crc_ = crc32c(crc_, data, size);
+        }
+      }
+
+      std::size_t read_count(std::size_t element_size)
+      {
+        unsigned char bytes[sizeof(std::uint64_t)];
+        read(bytes, sizeof(bytes));
+        const std::uint64_t count = serial_load(bytes, sizeof(bytes));
+        if (count > remaining_ / element_size) {
+          throw_serial_error("ftl::deserialize corrupt payload");
+        }
+        return static_cast<std::size_t>(count);
+      }
+
+      std::uint64_t remaining() const noexcept { return remaining_; }
+      std::uint32_t checksum() const noexcept { return crc_; }
+
+    private:
+      Source& source_;
+      std::uint64_t remaining_;
+      std::uint32_t crc_;
+      bool checksum_;
+    };
+
+    template <typename Reader, typename T, typename Allocator,
+        typename GrowthPolicy, typename Stats>
+    void serial_read(Reader&, vector<T, Allocator, GrowthPolicy, Stats>&);
+
+    // Reads straight into spare capacity, without constructing first.
+    template <typename Reader, typename Vector>
+    void serial_read_leaf(Reader& reader, Vector& v, std::size_t count,
+        std::true_type)
+    {
+      using value_type = typename Vector::value_type;
+      const std::size_t step =
+          std::max<std::size_t>(serial_read_chunk / sizeof(value_type), 1);
+      while (count != 0) {
+        const std::size_t n = std::min(count, step);
+        v.append_uninitialized(n,
+            [&reader](typename Vector::pointer first, std::size_t size) {
+              reader.read(std::addressof(*first), size * sizeof(value_type));
+              return size;
+            });
+        count -= n;
+      }
+    }
+
+    template <typename Reader, typename Vector>
+    void serial_read_leaf(Reader& reader, Vector& v, std::size_t count,
+        std::false_type)
+    {
+      using value_type = typename Vector::value_type;
+      const std::size_t step =
+          std::max<std::size_t>(serial_read_chunk / sizeof(value_type), 1);
+      while (count != 0) {
+        const std::size_t n = std::min(count, step);
+        const std::size_t size = v.size();
+        v.resize(size + n);
+        reader.read(std::addressof(v[size]), n * sizeof(value_type));
+        count -= n;
+      }
+    }
+
+    template <typename Reader, typename Vector>
+    void serial_read_elements(Reader& reader, Vector& v, std::true_type)
+    {
+      using value_type = typename Vector::value_type;
+      using CanSkipInit =
+          is_trivially_default_init_with<typename Vector::allocator_type>;
+      const std::size_t count = reader.read_count(sizeof(value_type));
+      serial_read_leaf(reader, v, count, CanSkipInit());
+    }
+
+    template <typename Reader, typename Vector>
+    void serial_read_elements(Reader& reader, Vector& v, std::false_type)
+    {
+      using value_type = typename Vector::value_type;
+      const std::size_t count = reader.read_count(sizeof(std::uint64_t));
+      v.reserve(v.size() +
+          std::min(count, serial_read_chunk / sizeof(value_type)));
+      for (std::size_t i = 0; i != count; ++i) {
+        v.emplace_back();
+        serial_read(reader, v.back());
+      }
+    }
+
+    template <typename Reader, typename T, typename Allocator,
+        typename GrowthPolicy, typename Stats>
+    void serial_read(Reader& reader,
+        vector<T, Allocator, GrowthPolicy, Stats>& v)
+    {
+      serial_read_elements(reader, v, typename serial_traits<T>::is_leaf());
+    }
+
+    template <typename Source, typename T, typename Allocator,
+        typename GrowthPolicy, typename Stats>
+    void serial_deserialize(Source& source,
+        vector<T, Allocator, GrowthPolicy, Stats>& v)
+    {
+      v.clear();
+      auto rollback = [&v]() { v.clear(); };
+      exception_guard<decltype(rollback)> guard(rollback);
+      unsigned char header[serial_header_size];
+      source.read(header, sizeof(header));
+      if (serial_load(header, 4) != serial_magic) {
+        throw_serial_error("ftl::deserialize bad magic");
+      }
+      const auto flags = serial_load(header + 6, 2);
+      if (serial_load(header + 4, 2) > serialize_version ||
+          (flags & ~std::uint64_t(serial_flag_checksum)) != 0) {
+        throw_serial_error("ftl::deserialize unsupported version");
+      }
+      if (serial_load(header + 8, 4) != serial_traits<T>::element_size() ||
+          serial_load(header + 12, 4) != serial_traits<T>::depth()) {
+        throw_serial_error("ftl::deserialize element type mismatch");
+      }
+      const bool checksum = (flags & serial_flag_checksum) != 0;
+      serial_reader<Source> reader(source, serial_load(header + 16, 8),
+          checksum);
+      try {
+        serial_read(reader, v);
+      } catch (const std::bad_alloc&) {
+        throw_serial_error("ftl::deserialize payload too large");
+      } catch (const std::length_error&) {
+        throw_serial_error("ftl::deserialize payload too large");
+      }
+      if (reader.remaining() != 0) {
+        throw_serial_error("ftl::deserialize corrupt payload");
+      }
+      if (checksum && reader.checksum() != serial_load(header + 24, 4)) {
+        throw_serial_error("ftl::deserialize checksum mismatch");
+      }
+      guard.complete();
+    }
+  }
+
+  // Writes v to os with one write per contiguous run of elements: one for
+  // a vector of trivially copyable elements, one per innermost vector when
+  // vectors are nested. With checksum set the header carries a CRC-32C of
+  // the payload that deserialize verifies.
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void serialize(std::ostream& os,
+      const vector<T, Allocator, GrowthPolicy, Stats>& v,
+      bool checksum = false)
+  {
+    const detail::serial_gather gather(v, checksum);
+    detail::serial_write(os, gather.header(), detail::serial_header_size);
+    for (const auto& chunk : gather.chunks()) {
+      detail::serial_write(os, chunk.data, chunk.size);
+    }
+  }
+
+  // Replaces the contents of v with a vector read from is. Elements are
+  // read straight into spare capacity, which grows as the data arrives
+  // rather than as the header claims. Throws std::runtime_error on
+  // malformed input, a payload too large to allocate, or a checksum
+  // mismatch, leaving v empty.
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void deserialize(std::istream& is,
+      vector<T, Allocator, GrowthPolicy, Stats>& v)
+  {
+    detail::serial_stream_source source(is);
+    detail::serial_deserialize(source, v);
+  }
+
+#if defined(FTL_POSIX_FEATURES)
+  // Writes v to the file descriptor fd with a single writev of the header
+  // and every element run, split only past IOV_MAX runs.
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void serialize(int fd, const vector<T, Allocator, GrowthPolicy, Stats>& v,
+      bool checksum = false)
+  {
+    const detail::serial_gather gather(v, checksum);
+    vector<struct iovec> iov;
+    iov.reserve(gather.chunks().size() + 1);
+    iov.push_back(iovec{const_cast<unsigned char*>(gather.header()),
+        detail::serial_header_size});
+    for (const auto& chunk : gather.chunks()) {
+      iov.push_back(iovec{const_cast<void*>(chunk.data), chunk.size});
+    }
+    detail::serial_writev(fd, iov.data(), iov.size());
+  }
+
+  template <typename T, typename Allocator, typename GrowthPolicy,
+      typename Stats>
+  void deserialize(int fd, vector<T, Allocator, GrowthPolicy, Stats>& v)
+  {
+    detail::serial_fd_source source(fd);
+    detail::serial_deserialize(source, v);
+  }
+#endif
+}
+
+#endif
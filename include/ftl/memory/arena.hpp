@@ -0,0 +1,203 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_MEMORY_ARENA_HPP
+#define FTL_MEMORY_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+namespace ftl {
+
+  // A monotonic allocator. allocate() bumps a pointer through the current
+  // block and chains a new, twice as large block once that one runs out.
+  // Individual deallocations are no-ops: memory is returned all at once by
+  // release() or the destructor. An arena may start from a caller supplied
+  // buffer, typically on the stack, which it uses before touching the heap.
+  class arena final
+  {
+  public:
+    static constexpr std::size_t default_block_size = 4096;
+
+    arena() noexcept : arena(default_block_size) {}
+    explicit arena(std::size_t block_size) noexcept;
+    arena(void* buffer, std::size_t size,
+        std::size_t block_size = default_block_size) noexcept;
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+    ~arena() { release(); }
+
+    void* allocate(std::size_t bytes,
+        std::size_t alignment = alignof(std::max_align_t));
+    void deallocate(void*, std::size_t) noexcept {}
+    bool try_expand(void* p, std::size_t bytes, std::size_t new_bytes) noexcept;
+    void release() noexcept;
+
+    // Bytes handed out since construction or the last release(), padding
+    // included.
+    std::size_t bytes_allocated() const noexcept { return allocated_; }
+
+  private:
+    struct block
+    {
+      block* next;
+    };
+
+    unsigned char* initial_;
+    std::size_t initial_size_;
+    std::size_t block_size_;
+    std::size_t next_block_size_;
+    unsigned char* cur_;
+    unsigned char* end_;
+    block* blocks_;
+    std::size_t allocated_;
+
+    void* allocate_from_new_block(std::size_t bytes, std::size_t alignment);
+  };
+
+  inline arena::arena(std::size_t block_size) noexcept :
+    arena(nullptr, 0, block_size)
+  {
+  }
+
+  inline arena::arena(void* buffer, std::size_t size,
+      std::size_t block_size) noexcept :
+    initial_(static_cast<unsigned char*>(buffer)),
+    initial_size_(size),
+    block_size_(block_size),
+    next_block_size_(block_size),
+    cur_(initial_),
+    end_(initial_ + size),
+    blocks_(nullptr),
+    allocated_(0)
+  {
+  }
+
+  inline void* arena::allocate(std::size_t bytes, std::size_t alignment)
+  {
+    const std::size_t padding =
+        (0 - reinterpret_cast<std::uintptr_t>(cur_)) & (alignment - 1);
+    const std::size_t available = end_ - cur_;
+    if (padding > available || bytes > available - padding) {
+      return allocate_from_new_block(bytes, alignment);
+    }
+    void* p = cur_ + padding;
+    cur_ += padding + bytes;
+    allocated_ += padding + bytes;
+    return p;
+  }
+
+  // Grows the most recent allocation when the current block has room for it.
+  inline bool arena::try_expand(void* p, std::size_t bytes,
+      std::size_t new_bytes) noexcept
+  {
+    if (static_cast<unsigned char*>(p) + bytes != cur_ ||
+        new_bytes - bytes > static_cast<std::size_t>(end_ - cur_)) {
+      return false;
+    }
+    cur_ += new_bytes - bytes;
+    allocated_ += new_bytes - bytes;
+    return true;
+  }
+
+  inline void arena::release() noexcept
+  {
+    while (blocks_ != nullptr) {
+      block* next = blocks_->next;
+      ::operator delete(blocks_);
+      blocks_ = next;
+    }
+    cur_ = initial_;
+    end_ = initial_ + initial_size_;
+    next_block_size_ = block_size_;
+    allocated_ = 0;
+  }
+
+  inline void*
+  arena::allocate_from_new_block(std::size_t bytes, std::size_t alignment)
+  {
+    const std::size_t overhead = sizeof(block) + alignment;
+    if (bytes > std::numeric_limits<std::size_t>::max() - overhead) {
+      throw std::bad_alloc();
+    }
+    std::size_t size = next_block_size_;
+    if (size < bytes + overhead) {
+      size = bytes + overhead;
+    }
+    block* new_block = static_cast<block*>(::operator new(size));
+    new_block->next = blocks_;
+    blocks_ = new_block;
+    cur_ = reinterpret_cast<unsigned char*>(new_block + 1);
+    end_ = reinterpret_cast<unsigned char*>(new_block) + size;
+    if (next_block_size_ <= std::numeric_limits<std::size_t>::max() / 2) {
+      next_block_size_ *= 2;
+    }
+    return allocate(bytes, alignment);
+  }
+
+  // A stateful allocator drawing from an arena, usable with ftl::vector and
+  // the standard containers. Like std::pmr::polymorphic_allocator it does not
+  // propagate on copy, move or swap: containers stay on the arena they were
+  // created with, and assigning between arenas copies elements.
+  template <typename T>
+  class arena_allocator
+  {
+  public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+    using is_always_equal = std::false_type;
+
+    arena_allocator(arena& source) noexcept : arena_(&source) {}
+
+    template <typename U>
+    arena_allocator(const arena_allocator<U>& other) noexcept :
+      arena_(other.get_arena())
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+      if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+        throw std::bad_array_new_length();
+      }
+      return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+      arena_->deallocate(p, n * sizeof(T));
+    }
+
+    bool try_expand(T* p, std::size_t n, std::size_t new_n) noexcept
+    {
+      return arena_->try_expand(p, n * sizeof(T), new_n * sizeof(T));
+    }
+
+    arena* get_arena() const noexcept { return arena_; }
+
+  private:
+    arena* arena_;
+  };
+
+  template <typename T, typename U>
+  bool operator==(const arena_allocator<T>& lhs,
+      const arena_allocator<U>& rhs) noexcept
+  {
+    return lhs.get_arena() == rhs.get_arena();
+  }
+
+  template <typename T, typename U>
+  bool operator!=(const arena_allocator<T>& lhs,
+      const arena_allocator<U>& rhs) noexcept
+  {
+    return !(lhs == rhs);
+  }
+}
+
+#endif
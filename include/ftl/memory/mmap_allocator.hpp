@@ -0,0 +1,186 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_MEMORY_MMAP_ALLOCATOR_HPP
+#define FTL_MEMORY_MMAP_ALLOCATOR_HPP
+
+#include "../internal/config.hpp"
+
+#if defined(FTL_POSIX_FEATURES)
+
+#  include <cstddef>
+#  include <limits>
+#  include <memory>
+#  include <new>
+#  include <type_traits>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#  include "../internal/relocate.hpp"
+
+namespace ftl {
+  namespace detail {
+
+    // Blocks of at least this many bytes are mapped directly; smaller ones
+    // are not worth a system call and come from operator new.
+    constexpr std::size_t mmap_threshold = 1024 * 1024;
+    constexpr std::size_t mmap_huge_page_size = 2 * 1024 * 1024;
+
+    inline std::size_t mmap_page_size() noexcept
+    {
+      static const std::size_t size =
+          static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+      return size;
+    }
+
+    inline std::size_t mmap_length(std::size_t bytes, bool huge) noexcept
+    {
+      const std::size_t granule =
+          huge ? mmap_huge_page_size : mmap_page_size();
+      return (bytes + granule - 1) / granule * granule;
+    }
+
+    inline void* mmap_map(std::size_t length, bool huge)
+    {
+      void* p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
+          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (p == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+#  if defined(MADV_HUGEPAGE)
+      if (huge) {
+        ::madvise(p, length, MADV_HUGEPAGE);
+      }
+#  else
+      static_cast<void>(huge);
+#  endif
+      return p;
+    }
+
+    // Resizes the mapping at p, moving it only if may_move is set. Returns
+    // null on failure; without mremap nothing but an unchanged length works.
+    inline void* mmap_remap(void* p, std::size_t length,
+        std::size_t new_length, bool may_move) noexcept
+    {
+      if (length == new_length) {
+        return p;
+      }
+#  if defined(__linux__)
+      void* new_p =
+          ::mremap(p, length, new_length, may_move ? MREMAP_MAYMOVE : 0);
+      return new_p == MAP_FAILED ? nullptr : new_p;
+#  else
+      static_cast<void>(may_move);
+      return nullptr;
+#  endif
+    }
+  }
+
+  // An allocator for very large buffers. Blocks of 1 MiB and more are
+  // anonymous mappings rounded up to whole pages, or to 2 MiB huge pages
+  // when HugePages is set; smaller blocks come from operator new. On Linux a
+  // mapping is grown in place or moved by mremap, so a vector of trivially
+  // relocatable elements never copies its contents when it grows, and
+  // shrinking returns the dropped pages to the system at once.
+  template <typename T, bool HugePages = false>
+  class mmap_allocator
+  {
+  public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind
+    {
+      using other = mmap_allocator<U, HugePages>;
+    };
+
+    mmap_allocator() noexcept = default;
+
+    template <typename U>
+    mmap_allocator(const mmap_allocator<U, HugePages>&) noexcept
+    {
+    }
+
+    T* allocate(std::size_t n) { return allocate_at_least(n).ptr; }
+
+    detail::allocation_result<T*, std::size_t> allocate_at_least(std::size_t n)
+    {
+      if (n > (std::numeric_limits<std::size_t>::max() -
+                  detail::mmap_huge_page_size) /
+              sizeof(T)) {
+        throw std::bad_array_new_length();
+      }
+      if (!is_mapped(n)) {
+        return { std::allocator<T>().allocate(n), n };
+      }
+      const std::size_t length = mapped_length(n);
+      return { static_cast<T*>(detail::mmap_map(length, HugePages)),
+        length / sizeof(T) };
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+      if (is_mapped(n)) {
+        ::munmap(p, mapped_length(n));
+      } else {
+        std::allocator<T>().deallocate(p, n);
+      }
+    }
+
+    bool try_expand(T* p, std::size_t n, std::size_t new_n) noexcept
+    {
+      return is_mapped(n) && is_mapped(new_n) &&
+          detail::mmap_remap(p, mapped_length(n), mapped_length(new_n),
+              false) != nullptr;
+    }
+
+    detail::allocation_result<T*, std::size_t> reallocate(T* p,
+        std::size_t size, std::size_t n, std::size_t new_n)
+    {
+      if (is_mapped(n) && is_mapped(new_n)) {
+        const std::size_t new_length = mapped_length(new_n);
+        void* new_p =
+            detail::mmap_remap(p, mapped_length(n), new_length, true);
+        if (new_p != nullptr) {
+          return { static_cast<T*>(new_p), new_length / sizeof(T) };
+        }
+      }
+      auto result = allocate_at_least(new_n);
+      detail::relocate(p, p + size, result.ptr);
+      deallocate(p, n);
+      return result;
+    }
+
+  private:
+    static bool is_mapped(std::size_t n) noexcept
+    {
+      return n * sizeof(T) >= detail::mmap_threshold &&
+          alignof(T) <= detail::mmap_page_size();
+    }
+
+    static std::size_t mapped_length(std::size_t n) noexcept
+    {
+      return detail::mmap_length(n * sizeof(T), HugePages);
+    }
+  };
+
+  template <typename T, typename U, bool HugePages>
+  constexpr bool operator==(const mmap_allocator<T, HugePages>&,
+      const mmap_allocator<U, HugePages>&) noexcept
+  {
+    return true;
+  }
+
+  template <typename T, typename U, bool HugePages>
+  constexpr bool operator!=(const mmap_allocator<T, HugePages>&,
+      const mmap_allocator<U, HugePages>&) noexcept
+  {
+    return false;
+  }
+}
+
+#endif
+
+#endif
@@ -0,0 +1,333 @@
+// This file is part of the FTL Project, under the GNU General Public License
+// v3.0. See https://www.gnu.org/licenses/gpl-3.0.txt for license information.
+// SPDX-License-Identifier: GPL-3.0
+
+#ifndef FTL_MEMORY_POOL_ALLOCATOR_HPP
+#define FTL_MEMORY_POOL_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include "../internal/relocate.hpp"
+
+namespace ftl {
+  namespace detail {
+
+    // Requests are rounded up to one of the power of two size classes
+    // [pool_min_block, pool_max_block]; anything larger goes to operator new.
+    constexpr std::size_t pool_min_block = 16;
+    constexpr std::size_t pool_max_block = 4096;
+    constexpr std::size_t pool_class_count = 9;
+    constexpr std::size_t pool_slab_size = 64 * 1024;
+
+    struct pool_block
+    {
+      pool_block* next;
+    };
+
+    inline std::size_t pool_size_class(std::size_t bytes) noexcept
+    {
+      std::size_t size_class = 0;
+      for (std::size_t size = pool_min_block; size < bytes; size *= 2) {
+        ++size_class;
+      }
+      return size_class;
+    }
+
+    inline std::size_t pool_block_size(std::size_t size_class) noexcept
+    {
+      return pool_min_block << size_class;
+    }
+
+    // Blocks move between a thread cache and the depot in batches of this
+    // many, roughly 16 KiB worth.
+    inline std::size_t pool_batch_size(std::size_t size_class) noexcept
+    {
+      const std::size_t count = 16 * 1024 / pool_block_size(size_class);
+      return count < 8 ? 8 : count;
+    }
+
+    // Process-wide store of free blocks, one locked free list per size class.
+    // It carves new blocks out of slabs that are never returned to the
+    // system: the depot lives, and keeps its slabs reachable, until exit.
+    class pool_depot final
+    {
+    public:
+      static pool_depot& instance()
+      {
+        static pool_depot* depot = new pool_depot();
+        return *depot;
+      }
+
+      // Hands out up to count blocks as a null-terminated list and stores the
+      // number actually taken in count; at least one unless this throws.
+      pool_block* take(std::size_t size_class, std::size_t& count)
+      {
+        size_class_state& state = classes_[size_class];
+        std::lock_guard<std::mutex> lock(state.mutex);
+        pool_block* head = nullptr;
+        std::size_t taken = 0;
+        while (taken != count && state.free != nullptr) {
+          pool_block* block = state.free;
+          state.free = block->next;
+          block->next = head;
+          head = block;
+          ++taken;
+        }
+        const std::size_t size = pool_block_size(size_class);
+        while (taken != count) {
+          if (state.slab_cur == state.slab_end) {
+            if (taken != 0) {
+              break;
+            }
+            refill_slab(state, size);
+          }
+          auto block = reinterpret_cast<pool_block*>(state.slab_cur);
+          state.slab_cur += size;
+          block->next = head;
+          head = block;
+          ++taken;
+        }
+        count = taken;
+        return head;
+      }
+
+      // Takes back the list [head, tail] of blocks.
+      void give(std::size_t size_class, pool_block* head,
+          pool_block* tail) noexcept
+      {
+        size_class_state& state = classes_[size_class];
+        std::lock_guard<std::mutex> lock(state.mutex);
+        tail->next = state.free;
+        state.free = head;
+      }
+
+    private:
+      struct size_class_state
+      {
+        std::mutex mutex;
+        pool_block* free = nullptr;
+        unsigned char* slab_cur = nullptr;
+        unsigned char* slab_end = nullptr;
+        pool_block* slabs = nullptr;
+      };
+
+      size_class_state classes_[pool_class_count];
+
+      pool_depot() = default;
+
+      static void refill_slab(size_class_state& state, std::size_t size)
+      {
+        const std::size_t bytes =
+            pool_slab_size < size * 2 ? size * 2 : pool_slab_size;
+        auto slab = static_cast<unsigned char*>(::operator new(bytes));
+        auto header = reinterpret_cast<pool_block*>(slab);
+        header->next = state.slabs;
+        state.slabs = header;
+        state.slab_cur = slab + size;
+        state.slab_end = slab + bytes / size * size;
+      }
+    };
+
+    // Per-thread free lists. A list that grows past two batches sends one
+    // batch back to the depot, so blocks freed on another thread than the
+    // one that allocated them flow back instead of piling up.
+    class pool_thread_cache final
+    {
+    public:
+      pool_thread_cache() = default;
+      pool_thread_cache(const pool_thread_cache&) = delete;
+      pool_thread_cache& operator=(const pool_thread_cache&) = delete;
+
+      ~pool_thread_cache()
+      {
+        for (std::size_t i = 0; i != pool_class_count; ++i) {
+          if (lists_[i].head != nullptr) {
+            pool_block* tail = lists_[i].head;
+            while (tail->next != nullptr) {
+              tail = tail->next;
+            }
+            pool_depot::instance().give(i, lists_[i].head, tail);
+          }
+        }
+        destroyed() = true;
+      }
+
+      // Null once the calling thread has destroyed its cache; callers then
+      // go to the depot directly.
+      static pool_thread_cache* get() noexcept
+      {
+        if (destroyed()) {
+          return nullptr;
+        }
+        static thread_local pool_thread_cache cache;
+        return &cache;
+      }
+
+      void* allocate(std::size_t size_class)
+      {
+        free_list& list = lists_[size_class];
+        if (list.head == nullptr) {
+          list.count = pool_batch_size(size_class);
+          list.head = pool_depot::instance().take(size_class, list.count);
+        }
+        pool_block* block = list.head;
+        list.head = block->next;
+        --list.count;
+        return block;
+      }
+
+      void deallocate(void* p, std::size_t size_class) noexcept
+      {
+        free_list& list = lists_[size_class];
+        auto block = static_cast<pool_block*>(p);
+        block->next = list.head;
+        list.head = block;
+        const std::size_t batch = pool_batch_size(size_class);
+        if (++list.count >= 2 * batch) {
+          pool_block* tail = list.head;
+          for (std::size_t i = 1; i != batch; ++i) {
+            tail = tail->next;
+          }
+          pool_block* head = list.head;
+          list.head = tail->next;
+          list.count -= batch;
+          pool_depot::instance().give(size_class, head, tail);
+        }
+      }
+
+    private:
+      struct free_list
+      {
+        pool_block* head = nullptr;
+        std::size_t count = 0;
+      };
+
+      free_list lists_[pool_class_count];
+
+      static bool& destroyed() noexcept
+      {
+        static thread_local bool value = false;
+        return value;
+      }
+    };
+
+    inline void* pool_allocate(std::size_t bytes)
+    {
+      if (bytes > pool_max_block) {
+        return ::operator new(bytes);
+      }
+      const std::size_t size_class = pool_size_class(bytes);
+      if (pool_thread_cache* cache = pool_thread_cache::get()) {
+        return cache->allocate(size_class);
+      }
+      std::size_t count = 1;
+      return pool_depot::instance().take(size_class, count);
+    }
+
+    inline void pool_deallocate(void* p, std::size_t bytes) noexcept
+    {
+      if (bytes > pool_max_block) {
+        ::operator delete(p);
+        return;
+      }
+      const std::size_t size_class = pool_size_class(bytes);
+      if (pool_thread_cache* cache = pool_thread_cache::get()) {
+        cache->deallocate(p, size_class);
+        return;
+      }
+      auto block = static_cast<pool_block*>(p);
+      pool_depot::instance().give(size_class, block, block);
+    }
+  }
+
+  // A stateless allocator for many small, short-lived allocations shared by
+  // many threads. Requests up to 4 KiB come from per-thread free lists split
+  // into power of two size classes, so the common case takes no lock; the
+  // lists trade blocks with a shared depot in batches. A block may be freed
+  // by any thread. Larger or over-aligned requests go to operator new.
+  template <typename T>
+  class pool_allocator
+  {
+  public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    pool_allocator() noexcept = default;
+
+    template <typename U>
+    pool_allocator(const pool_allocator<U>&) noexcept
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+      if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+        throw std::bad_array_new_length();
+      }
+      return allocate(n, is_pooled());
+    }
+
+    // Rounds the request up to the whole size class, which vector then uses
+    // as capacity.
+    detail::allocation_result<T*, std::size_t> allocate_at_least(std::size_t n)
+    {
+      T* p = allocate(n);
+      if (!is_pooled::value || n * sizeof(T) > detail::pool_max_block) {
+        return { p, n };
+      }
+      const std::size_t size = detail::pool_block_size(
+          detail::pool_size_class(n * sizeof(T)));
+      return { p, size / sizeof(T) };
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+      deallocate(p, n, is_pooled());
+    }
+
+  private:
+    using is_pooled = std::integral_constant<bool,
+        alignof(T) <= alignof(std::max_align_t)>;
+
+    T* allocate(std::size_t n, std::true_type)
+    {
+      return static_cast<T*>(detail::pool_allocate(n * sizeof(T)));
+    }
+
+    T* allocate(std::size_t n, std::false_type)
+    {
+      return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n, std::true_type) noexcept
+    {
+      detail::pool_deallocate(p, n * sizeof(T));
+    }
+
+    void deallocate(T* p, std::size_t n, std::false_type) noexcept
+    {
+      std::allocator<T>().deallocate(p, n);
+    }
+  };
+
+  template <typename T, typename U>
+  constexpr bool operator==(const pool_allocator<T>&,
+      const pool_allocator<U>&) noexcept
+  {
+    return true;
+  }
+
+  template <typename T, typename U>
+  constexpr bool operator!=(const pool_allocator<T>&,
+      const pool_allocator<U>&) noexcept
+  {
+    return false;
+  }
+}
+
+#endif
@@ -0,0 +1,179 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+#if defined(FTL_CPP17_FEATURES)
+#  include <memory_resource>
+#endif
+
+namespace test {
+  template <typename T>
+  using ArenaVectorT = ftl::vector<T, ftl::arena_allocator<T>>;
+
+  bool IsAligned(const void* p, size_t alignment)
+  {
+    return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+  }
+
+  template <typename T>
+  bool IsInside(const T* p, const void* buffer, size_t size)
+  {
+    auto bytes = reinterpret_cast<const unsigned char*>(p);
+    auto begin = static_cast<const unsigned char*>(buffer);
+    return bytes >= begin && bytes < begin + size;
+  }
+
+  TEST(Arena, BumpsThroughBlock)
+  {
+    ftl::arena arena;
+    auto a = static_cast<unsigned char*>(arena.allocate(3, 1));
+    auto b = static_cast<unsigned char*>(arena.allocate(8, 8));
+    auto c = static_cast<unsigned char*>(arena.allocate(1, 1));
+    EXPECT_EQ(b - a, 8);
+    EXPECT_EQ(c - b, 8);
+    EXPECT_TRUE(IsAligned(b, 8));
+    EXPECT_EQ(arena.bytes_allocated(), 17);
+  }
+
+  TEST(Arena, UsesInitialBufferFirst)
+  {
+    alignas(std::max_align_t) unsigned char buffer[256];
+    ftl::arena arena(buffer, sizeof(buffer));
+    for (int i = 0; i != 16; ++i) {
+      EXPECT_TRUE(IsInside(static_cast<unsigned char*>(arena.allocate(16)),
+          buffer, sizeof(buffer)));
+    }
+    void* heap = arena.allocate(16);
+    EXPECT_FALSE(IsInside(static_cast<unsigned char*>(heap), buffer,
+        sizeof(buffer)));
+
+    arena.release();
+    EXPECT_EQ(arena.bytes_allocated(), 0);
+    EXPECT_EQ(arena.allocate(16), buffer);
+  }
+
+  TEST(Arena, ChainsBlocksAndServesLargeRequests)
+  {
+    ftl::arena arena(64);
+    std::vector<int*> blocks;
+    for (int i = 0; i != 1000; ++i) {
+      auto p = static_cast<int*>(arena.allocate(sizeof(int) * 10, 4));
+      std::fill(p, p + 10, i);
+      blocks.push_back(p);
+    }
+    void* large = arena.allocate(1 << 20, 64);
+    EXPECT_TRUE(IsAligned(large, 64));
+    for (int i = 0; i != 1000; ++i) {
+      ASSERT_EQ(blocks[i][9], i);
+    }
+  }
+
+  TEST(Arena, ExpandsLastAllocationOnly)
+  {
+    ftl::arena arena;
+    void* first = arena.allocate(16);
+    EXPECT_TRUE(arena.try_expand(first, 16, 64));
+    void* second = arena.allocate(16);
+    EXPECT_EQ(static_cast<unsigned char*>(second) -
+            static_cast<unsigned char*>(first),
+        64);
+    EXPECT_FALSE(arena.try_expand(first, 64, 128));
+    EXPECT_FALSE(arena.try_expand(second, 16, 1 << 20));
+  }
+
+  TEST(ArenaAllocator, VectorGrowsInPlace)
+  {
+    alignas(std::max_align_t) unsigned char buffer[1 << 12];
+    ftl::arena arena(buffer, sizeof(buffer));
+    ArenaVectorT<int> vector(arena);
+    vector.push_back(0);
+    const int* data = vector.data();
+    for (int i = 1; i != 500; ++i) {
+      vector.push_back(i);
+    }
+    EXPECT_EQ(vector.data(), data);
+    EXPECT_TRUE(IsInside(vector.data(), buffer, sizeof(buffer)));
+    for (int i = 0; i != 500; ++i) {
+      ASSERT_EQ(vector[i], i);
+    }
+  }
+
+  TEST(ArenaAllocator, CopyStaysOnSourceArena)
+  {
+    ftl::arena arena;
+    ArenaVectorT<std::string> vector(arena);
+    vector.assign({ "a", "b", "c" });
+    ArenaVectorT<std::string> copy(vector);
+    EXPECT_EQ(copy.get_allocator().get_arena(), &arena);
+    EXPECT_TRUE(copy == vector);
+  }
+
+  TEST(ArenaAllocator, AssignmentKeepsTargetArena)
+  {
+    ftl::arena first_arena;
+    ftl::arena second_arena;
+    ArenaVectorT<std::string> first(first_arena);
+    ArenaVectorT<std::string> second(second_arena);
+    first.assign({ "x", "y" });
+    second.assign({ "1", "2", "3" });
+
+    first = second;
+    EXPECT_EQ(first.get_allocator().get_arena(), &first_arena);
+    EXPECT_TRUE(first == second);
+
+    second.push_back(std::string(40, '4'));
+    first = std::move(second);
+    EXPECT_EQ(first.get_allocator().get_arena(), &first_arena);
+    EXPECT_EQ(second.get_allocator().get_arena(), &second_arena);
+    EXPECT_EQ(first.size(), 4);
+    EXPECT_EQ(first.back(), std::string(40, '4'));
+    EXPECT_TRUE(second.empty());
+  }
+
+  TEST(ArenaAllocator, MoveAssignmentOnSameArenaSteals)
+  {
+    ftl::arena arena;
+    ArenaVectorT<int> first(arena);
+    ArenaVectorT<int> second(arena);
+    second.assign({ 1, 2, 3 });
+    const int* data = second.data();
+    first = std::move(second);
+    EXPECT_EQ(first.data(), data);
+    EXPECT_EQ(second.data(), nullptr);
+  }
+
+#if defined(FTL_CPP17_FEATURES)
+  TEST(PmrVector, AllocatesFromResource)
+  {
+    alignas(std::max_align_t) unsigned char buffer[1 << 12];
+    std::pmr::monotonic_buffer_resource resource(buffer, sizeof(buffer),
+        std::pmr::null_memory_resource());
+    ftl::pmr::vector<int> vector(&resource);
+    for (int i = 0; i != 100; ++i) {
+      vector.push_back(i);
+    }
+    EXPECT_TRUE(IsInside(vector.data(), buffer, sizeof(buffer)));
+    EXPECT_EQ(vector.get_allocator().resource(), &resource);
+
+    ftl::pmr::vector<int> copy(vector);
+    EXPECT_EQ(copy.get_allocator().resource(),
+        std::pmr::get_default_resource());
+    EXPECT_TRUE(copy == vector);
+  }
+
+  TEST(PmrVector, RelocatesTriviallyRelocatableElements)
+  {
+    using IntAlloc = std::pmr::polymorphic_allocator<int>;
+    using StringAlloc = std::pmr::polymorphic_allocator<std::pmr::string>;
+    EXPECT_TRUE((ftl::detail::is_relocatable_with<IntAlloc, int>::value));
+    EXPECT_TRUE(
+        (ftl::detail::is_trivially_default_init_with<IntAlloc, int>::value));
+    EXPECT_FALSE((ftl::detail::is_reallocatable_with<IntAlloc, int>::value));
+    EXPECT_TRUE((ftl::detail::has_construct<StringAlloc, std::pmr::string*,
+        std::pmr::string&&>::value));
+  }
+#endif
+}
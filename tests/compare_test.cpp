@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  template <typename Vector>
+  Vector MakeSequence(size_t size)
+  {
+    using T = typename Vector::value_type;
+    Vector vector;
+    for (size_t i = 0; i != size; ++i) {
+      vector.push_back(static_cast<T>(i * 37 + 5));
+    }
+    return vector;
+  }
+
+  // Changes the element at every position in turn, both up and down, and
+  // checks the operators against the element by element algorithms.
+  template <typename Vector>
+  void ExpectMatchesElementwise(size_t size)
+  {
+    using T = typename Vector::value_type;
+    const Vector base = MakeSequence<Vector>(size);
+    for (size_t pos = 0; pos < size; ++pos) {
+      for (int delta : { -1, 1 }) {
+        Vector other(base);
+        other[pos] = static_cast<T>(other[pos] + delta);
+        const bool less = std::lexicographical_compare(base.begin(),
+            base.end(), other.begin(), other.end());
+        EXPECT_FALSE(base == other) << size << ' ' << pos;
+        EXPECT_EQ(base < other, less) << size << ' ' << pos;
+        EXPECT_EQ(other < base, !less) << size << ' ' << pos;
+        EXPECT_EQ(base <= other, less) << size << ' ' << pos;
+        EXPECT_EQ(base >= other, !less) << size << ' ' << pos;
+      }
+    }
+    EXPECT_TRUE(base == Vector(base));
+    EXPECT_FALSE(base < Vector(base));
+  }
+
+  template <typename Vector>
+  void ExpectPrefixOrdersFirst(size_t size)
+  {
+    const Vector longer = MakeSequence<Vector>(size + 1);
+    const Vector shorter(longer.begin(), longer.end() - 1);
+    EXPECT_FALSE(shorter == longer);
+    EXPECT_TRUE(shorter < longer);
+    EXPECT_FALSE(longer < shorter);
+  }
+
+  TEST(VectorComparison, BytesMatchElementwise)
+  {
+    for (size_t size = 1; size < 80; size += 3) {
+      ExpectMatchesElementwise<ftl::vector<std::uint8_t>>(size);
+      ExpectPrefixOrdersFirst<ftl::vector<std::uint8_t>>(size);
+    }
+  }
+
+  TEST(VectorComparison, WideIntegersMatchElementwise)
+  {
+    for (size_t size = 1; size < 40; size += 3) {
+      ExpectMatchesElementwise<ftl::vector<std::uint16_t>>(size);
+      ExpectMatchesElementwise<ftl::vector<std::uint64_t>>(size);
+      ExpectMatchesElementwise<ftl::vector<std::int32_t>>(size);
+      ExpectPrefixOrdersFirst<ftl::vector<std::uint64_t>>(size);
+    }
+  }
+
+  TEST(VectorComparison, SignedOrderIsNotByteOrder)
+  {
+    ftl::vector<std::int32_t> negative{ 1, -1 };
+    ftl::vector<std::int32_t> positive{ 1, 1 };
+    EXPECT_TRUE(negative < positive);
+    ftl::vector<char> low{ 'a', static_cast<char>(-1) };
+    ftl::vector<char> high{ 'a', 1 };
+    EXPECT_EQ(low < high, static_cast<char>(-1) < 1);
+  }
+
+  TEST(VectorComparison, EmptyVectors)
+  {
+    ftl::vector<std::uint8_t> empty;
+    ftl::vector<std::uint8_t> one{ 0 };
+    EXPECT_TRUE(empty == ftl::vector<std::uint8_t>());
+    EXPECT_FALSE(empty < ftl::vector<std::uint8_t>());
+    EXPECT_TRUE(empty < one);
+    EXPECT_FALSE(one < empty);
+  }
+
+  TEST(VectorComparison, FallbackTypesKeepTheirOperators)
+  {
+    ftl::vector<double> zero{ 0.0 };
+    ftl::vector<double> negative_zero{ -0.0 };
+    EXPECT_TRUE(zero == negative_zero);
+    EXPECT_FALSE(negative_zero < zero);
+
+    ftl::vector<std::string> words{ "apple", "pear" };
+    ftl::vector<std::string> other{ "apple", "plum" };
+    EXPECT_FALSE(words == other);
+    EXPECT_TRUE(words < other);
+  }
+
+  TEST(SmallVectorComparison, MatchesElementwise)
+  {
+    for (size_t size = 1; size < 40; size += 3) {
+      ExpectMatchesElementwise<ftl::small_vector<std::uint8_t, 8>>(size);
+      ExpectMatchesElementwise<ftl::small_vector<std::uint32_t, 8>>(size);
+      ExpectPrefixOrdersFirst<ftl::small_vector<std::uint8_t, 8>>(size);
+    }
+  }
+
+#if defined(FTL_CPP20_FEATURES)
+
+  TEST(VectorComparison, ThreeWay)
+  {
+    ftl::vector<std::uint8_t> bytes{ 1, 2, 3 };
+    ftl::vector<std::uint8_t> more_bytes{ 1, 2, 3, 0 };
+    EXPECT_EQ(bytes <=> more_bytes, std::strong_ordering::less);
+    EXPECT_EQ(bytes <=> bytes, std::strong_ordering::equal);
+
+    ftl::vector<std::int64_t> keys{ 5, -7 };
+    ftl::vector<std::int64_t> larger_keys{ 5, 7 };
+    EXPECT_EQ(larger_keys <=> keys, std::strong_ordering::greater);
+
+    ftl::vector<double> values{ 1.0, 2.0 };
+    EXPECT_EQ(values <=> values, std::partial_ordering::equivalent);
+  }
+
+#endif
+}
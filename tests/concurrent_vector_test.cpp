@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  // While set, allocations of at least this many bytes made by the current
+  // thread fail.
+  thread_local std::size_t fail_allocations_from = 0;
+}
+
+void* operator new(std::size_t size)
+{
+  if (test::fail_allocations_from != 0 &&
+      size >= test::fail_allocations_from) {
+    throw std::bad_alloc();
+  }
+  if (void* p = std::malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace test {
+  using VectorT = ftl::concurrent_vector<int>;
+
+  struct ThrowOnValue
+  {
+    int value;
+
+    explicit ThrowOnValue(int v) : value(v)
+    {
+      if (v < 0) {
+        throw std::runtime_error("negative");
+      }
+    }
+  };
+
+  TEST(ConcurrentVector, PushBackAndIndex)
+  {
+    VectorT vector;
+    EXPECT_TRUE(vector.empty());
+    for (int i = 0; i < 1000; ++i) {
+      EXPECT_EQ(vector.push_back(i), i);
+    }
+    ASSERT_EQ(vector.size(), 1000u);
+    for (int i = 0; i < 1000; ++i) {
+      ASSERT_EQ(vector[static_cast<size_t>(i)], i);
+    }
+    EXPECT_EQ(vector.at(999), 999);
+    EXPECT_THROW(vector.at(1000), std::out_of_range);
+    EXPECT_GE(vector.capacity(), vector.size());
+    EXPECT_TRUE(std::is_sorted(vector.begin(), vector.end()));
+    EXPECT_EQ(vector.end() - vector.begin(), 1000);
+  }
+
+  TEST(ConcurrentVector, ReferencesStayValidAcrossGrowth)
+  {
+    ftl::concurrent_vector<std::string> vector;
+    std::string& first = vector.emplace_back(3, 'a');
+    const std::string* address = &first;
+    for (int i = 0; i < 5000; ++i) {
+      vector.push_back(std::to_string(i));
+    }
+    EXPECT_EQ(&vector[0], address);
+    EXPECT_EQ(first, "aaa");
+  }
+
+  TEST(ConcurrentVector, ConcurrentProducers)
+  {
+    constexpr int threads = 4;
+    constexpr int per_thread = 5000;
+    VectorT vector;
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; ++t) {
+      producers.emplace_back([&vector, t] {
+        for (int i = 0; i < per_thread; ++i) {
+          int& elem = vector.push_back(t * per_thread + i);
+          ASSERT_EQ(elem, t * per_thread + i);
+        }
+      });
+    }
+    for (auto& producer : producers) {
+      producer.join();
+    }
+    ASSERT_EQ(vector.size(), static_cast<size_t>(threads * per_thread));
+    auto compacted = vector.compact();
+    std::sort(compacted.begin(), compacted.end());
+    for (int i = 0; i < threads * per_thread; ++i) {
+      ASSERT_EQ(compacted[static_cast<size_t>(i)], i);
+    }
+  }
+
+  TEST(ConcurrentVector, ReadersSeePublishedElements)
+  {
+    constexpr int count = 20000;
+    VectorT vector;
+    std::atomic<bool> done{ false };
+    std::thread reader([&] {
+      size_t seen = 0;
+      while (!done.load() || seen != vector.size()) {
+        const size_t size = vector.size();
+        ASSERT_GE(size, seen);
+        for (size_t i = seen; i < size; ++i) {
+          ASSERT_EQ(vector[i], static_cast<int>(i - i % 2));
+        }
+        seen = size;
+      }
+    });
+    std::thread writer([&] {
+      for (int i = 0; i < count; i += 2) {
+        vector.grow_by(2, i);
+      }
+    });
+    writer.join();
+    done.store(true);
+    reader.join();
+    EXPECT_EQ(vector.size(), static_cast<size_t>(count));
+  }
+
+  TEST(ConcurrentVector, GrowByIsContiguousInIndex)
+  {
+    VectorT vector;
+    vector.push_back(-1);
+    auto it = vector.grow_by(100, 7);
+    EXPECT_EQ(it - vector.begin(), 1);
+    EXPECT_EQ(vector.size(), 101u);
+    EXPECT_EQ(std::count(vector.begin(), vector.end(), 7), 100);
+    auto zeros = vector.grow_by(3);
+    EXPECT_EQ(zeros[0] + zeros[1] + zeros[2], 0);
+    EXPECT_EQ(vector.grow_by(0), vector.end());
+  }
+
+  TEST(ConcurrentVector, ReserveAndClear)
+  {
+    VectorT vector;
+    vector.reserve(1000);
+    const size_t capacity = vector.capacity();
+    EXPECT_GE(capacity, 1000u);
+    vector.grow_by(1000, 5);
+    EXPECT_EQ(vector.capacity(), capacity);
+    vector.clear();
+    EXPECT_TRUE(vector.empty());
+    EXPECT_EQ(vector.capacity(), capacity);
+    vector.push_back(9);
+    EXPECT_EQ(vector.compact(), ftl::vector<int>{ 9 });
+  }
+
+  TEST(ConcurrentVector, ThrowingConstructorLeavesHole)
+  {
+    ftl::concurrent_vector<ThrowOnValue> vector;
+    vector.emplace_back(1);
+    EXPECT_THROW(vector.emplace_back(-1), std::runtime_error);
+    vector.emplace_back(3);
+    vector.grow_by(2, ThrowOnValue(0));
+    ASSERT_EQ(vector.size(), 5u);
+    EXPECT_THROW(vector.at(1), std::out_of_range);
+    EXPECT_EQ(vector.at(2).value, 3);
+    auto compacted = vector.compact();
+    ASSERT_EQ(compacted.size(), 4u);
+    EXPECT_EQ(compacted[1].value, 3);
+  }
+
+  TEST(ConcurrentVector, FailedSegmentAllocationLeavesHole)
+  {
+    VectorT vector;
+    vector.grow_by(16, 1);
+    fail_allocations_from = 32 * sizeof(int);
+    EXPECT_THROW(vector.push_back(2), std::bad_alloc);
+    fail_allocations_from = 0;
+    ASSERT_EQ(vector.size(), 17u);
+    EXPECT_THROW(vector.at(16), std::out_of_range);
+
+    vector.push_back(3);
+    ASSERT_EQ(vector.size(), 49u);
+    EXPECT_EQ(vector.at(48), 3);
+    ftl::vector<int> expected(16, 1);
+    expected.push_back(3);
+    EXPECT_EQ(vector.compact(), expected);
+
+    vector.clear();
+    vector.grow_by(40, 4);
+    EXPECT_EQ(vector.size(), 40u);
+    EXPECT_EQ(vector.compact(), ftl::vector<int>(40, 4));
+  }
+
+  TEST(ConcurrentVector, FailedGrowByAcrossSegments)
+  {
+    VectorT vector;
+    vector.grow_by(10, 1);
+    fail_allocations_from = 32 * sizeof(int);
+    EXPECT_THROW(vector.grow_by(20, 2), std::bad_alloc);
+    fail_allocations_from = 0;
+    ASSERT_EQ(vector.size(), 30u);
+    for (size_t i = 10; i != 30; ++i) {
+      EXPECT_THROW(vector.at(i), std::out_of_range);
+    }
+    vector.grow_by(4, 3);
+    ASSERT_EQ(vector.size(), 52u);
+    ftl::vector<int> expected(10, 1);
+    expected.insert(expected.end(), 4, 3);
+    EXPECT_EQ(vector.compact(), expected);
+  }
+
+  TEST(ConcurrentVector, IterationAfterFailedAppend)
+  {
+    VectorT vector;
+    vector.grow_by(16, 1);
+    fail_allocations_from = 32 * sizeof(int);
+    EXPECT_THROW(vector.push_back(2), std::bad_alloc);
+    fail_allocations_from = 0;
+    vector.push_back(3);
+
+    int sum = 0;
+    for (size_t i = 0; i != vector.size(); ++i) {
+      try {
+        sum += vector.at(i);
+      } catch (const std::out_of_range&) {
+      }
+    }
+    EXPECT_EQ(sum, 19);
+#ifndef NDEBUG
+    EXPECT_DEATH(
+        {
+          for (int value : vector) {
+            sum += value;
+          }
+        },
+        "is_ready");
+#endif
+  }
+}
@@ -0,0 +1,145 @@
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  using BitsetT = ftl::dynamic_bitset;
+
+  TEST(DynamicBitset, SetTestAndFlip)
+  {
+    BitsetT bits(130);
+    EXPECT_EQ(bits.size(), 130u);
+    EXPECT_EQ(bits.num_blocks(), 3u);
+    EXPECT_TRUE(bits.none());
+    bits.set(0).set(64).set(129);
+    EXPECT_TRUE(bits.test(64));
+    EXPECT_FALSE(bits.test(63));
+    EXPECT_THROW(bits.test(130), std::out_of_range);
+    EXPECT_THROW(bits.set(130), std::out_of_range);
+    EXPECT_EQ(bits.count(), 3u);
+    bits[5] = true;
+    bits[64] = false;
+    EXPECT_TRUE(bits[5]);
+    EXPECT_FALSE(bits[64]);
+    bits.flip(5);
+    EXPECT_FALSE(bits[5]);
+    bits.reset(0);
+    EXPECT_EQ(bits.count(), 1u);
+
+    bits.flip();
+    EXPECT_EQ(bits.count(), 129u);
+    EXPECT_FALSE(bits.all());
+    bits.set();
+    EXPECT_TRUE(bits.all());
+    EXPECT_EQ(bits.count(), 130u);
+    bits.reset();
+    EXPECT_TRUE(bits.none());
+  }
+
+  TEST(DynamicBitset, ResizeKeepsUnusedBitsClear)
+  {
+    BitsetT bits(10, true);
+    EXPECT_EQ(bits.count(), 10u);
+    EXPECT_EQ(bits.data()[0], 0x3ffu);
+    bits.resize(70, true);
+    EXPECT_EQ(bits.count(), 70u);
+    bits.resize(66);
+    EXPECT_EQ(bits.count(), 66u);
+    EXPECT_EQ(bits.data()[1], 0x3u);
+    bits.resize(200);
+    EXPECT_EQ(bits.count(), 66u);
+    EXPECT_FALSE(bits[66]);
+
+    BitsetT pushed;
+    for (int i = 0; i < 100; ++i) {
+      pushed.push_back(i % 3 == 0);
+    }
+    EXPECT_EQ(pushed.size(), 100u);
+    EXPECT_EQ(pushed.count(), 34u);
+    pushed.pop_back();
+    EXPECT_EQ(pushed.count(), 33u);
+    pushed.clear();
+    EXPECT_TRUE(pushed.empty());
+  }
+
+  TEST(DynamicBitset, FindAndIterateSetBits)
+  {
+    BitsetT bits(1000);
+    const std::vector<std::size_t> positions{ 3, 63, 64, 65, 500, 999 };
+    for (std::size_t i : positions) {
+      bits.set(i);
+    }
+    std::vector<std::size_t> found;
+    for (auto i = bits.find_first(); i != BitsetT::npos;
+         i = bits.find_next(i)) {
+      found.push_back(i);
+    }
+    EXPECT_EQ(found, positions);
+
+    std::vector<std::size_t> visited;
+    bits.for_each_set([&](std::size_t i) { visited.push_back(i); });
+    EXPECT_EQ(visited, positions);
+    EXPECT_EQ(bits.find_next(999), BitsetT::npos);
+    EXPECT_EQ(BitsetT(64).find_first(), BitsetT::npos);
+    EXPECT_EQ(BitsetT().find_first(), BitsetT::npos);
+  }
+
+  TEST(DynamicBitset, CountMatchesBitByBit)
+  {
+    std::mt19937_64 engine(7);
+    for (std::size_t size : { 1u, 63u, 64u, 255u, 1024u, 4099u }) {
+      BitsetT bits(size);
+      std::size_t expected = 0;
+      for (std::size_t i = 0; i < size; ++i) {
+        if (engine() % 3 == 0) {
+          bits[i] = true;
+          ++expected;
+        }
+      }
+      ASSERT_EQ(bits.count(), expected) << size;
+    }
+  }
+
+  TEST(DynamicBitset, BooleanOperations)
+  {
+    BitsetT a(100);
+    BitsetT b(100);
+    for (std::size_t i = 0; i < 100; ++i) {
+      a[i] = i % 2 == 0;
+      b[i] = i % 3 == 0;
+    }
+    EXPECT_EQ((a & b).count(), 17u);
+    EXPECT_EQ((a | b).count(), 67u);
+    EXPECT_EQ((a ^ b).count(), 50u);
+    EXPECT_EQ((a - b).count(), 33u);
+    EXPECT_EQ((~a).count(), 50u);
+    EXPECT_EQ(~~a, a);
+    BitsetT c = a;
+    c &= b;
+    c |= a - b;
+    EXPECT_EQ(c, a);
+    c ^= c;
+    EXPECT_TRUE(c.none());
+    EXPECT_THROW(a &= BitsetT(99), std::invalid_argument);
+  }
+
+  TEST(DynamicBitset, CopySwapAndCompare)
+  {
+    BitsetT a(70);
+    a.set(69);
+    BitsetT b = a;
+    EXPECT_EQ(a, b);
+    b.set(1);
+    EXPECT_NE(a, b);
+    EXPECT_NE(BitsetT(3), BitsetT(4));
+    BitsetT moved = std::move(b);
+    EXPECT_TRUE(moved.test(1));
+    swap(moved, a);
+    EXPECT_FALSE(moved.test(1));
+    EXPECT_TRUE(a.test(1));
+  }
+}
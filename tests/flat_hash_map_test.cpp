@@ -0,0 +1,146 @@
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  using MapT = ftl::flat_hash_map<int, std::string>;
+
+  // Moves may throw, so rehashing copies it; the copy fails on request.
+  struct FragileCopy
+  {
+    static int copies_left;
+
+    int value;
+
+    FragileCopy(int v) : value(v) {}
+    FragileCopy(const FragileCopy& rhs) : value(rhs.value)
+    {
+      if (copies_left-- == 0) {
+        throw std::runtime_error("copy");
+      }
+    }
+    FragileCopy(FragileCopy&& rhs) noexcept(false) : value(rhs.value) {}
+  };
+
+  int FragileCopy::copies_left = -1;
+
+  TEST(FlatHashMap, SubscriptAtAndFind)
+  {
+    MapT map;
+    for (int i = 0; i < 500; ++i) {
+      map[i] = std::to_string(i);
+    }
+    ASSERT_EQ(map.size(), 500u);
+    for (int i = 0; i < 500; ++i) {
+      ASSERT_EQ(map.at(i), std::to_string(i));
+    }
+    EXPECT_THROW(map.at(500), std::out_of_range);
+    const MapT& view = map;
+    EXPECT_EQ(view.at(7), "7");
+    EXPECT_EQ(view.find(8)->second, "8");
+    EXPECT_EQ(view.find(-1), view.end());
+    map[3] += "!";
+    EXPECT_EQ(map[3], "3!");
+    EXPECT_EQ(map[1000], "");
+    EXPECT_EQ(map.size(), 501u);
+  }
+
+  TEST(FlatHashMap, InsertTryEmplaceAndAssign)
+  {
+    MapT map;
+    EXPECT_TRUE(map.insert({ 1, "one" }).second);
+    EXPECT_FALSE(map.insert({ 1, "uno" }).second);
+    EXPECT_EQ(map[1], "one");
+    EXPECT_TRUE(map.emplace(2, "two").second);
+    EXPECT_TRUE(map.try_emplace(3, 5, 'x').second);
+    EXPECT_EQ(map[3], "xxxxx");
+
+    std::string value = "kept";
+    EXPECT_FALSE(map.try_emplace(3, std::move(value)).second);
+    EXPECT_EQ(value, "kept");
+    EXPECT_FALSE(map.insert_or_assign(3, "three").second);
+    EXPECT_EQ(map[3], "three");
+    EXPECT_TRUE(map.insert_or_assign(4, "four").second);
+
+    std::vector<std::pair<int, std::string>> pairs{ { 5, "five" },
+      { 6, "six" }, { 1, "ignored" } };
+    map.insert(pairs.begin(), pairs.end());
+    EXPECT_EQ(map.size(), 6u);
+    EXPECT_EQ(map[1], "one");
+    EXPECT_EQ(map.erase(5), 1u);
+    EXPECT_FALSE(map.contains(5));
+  }
+
+  TEST(FlatHashMap, MoveOnlyValuesSurviveGrowth)
+  {
+    ftl::flat_hash_map<std::string, std::unique_ptr<int>> map;
+    for (int i = 0; i < 1000; ++i) {
+      map.try_emplace(std::to_string(i), std::make_unique<int>(i));
+    }
+    for (int i = 0; i < 1000; i += 3) {
+      map.erase(std::to_string(i));
+    }
+    for (int i = 1000; i < 1500; ++i) {
+      map.try_emplace(std::to_string(i), std::make_unique<int>(i));
+    }
+    EXPECT_EQ(map.size(), 1166u);
+    for (const auto& entry : map) {
+      ASSERT_EQ(std::to_string(*entry.second), entry.first);
+    }
+  }
+
+  TEST(FlatHashMap, ArgumentsMayReferToElements)
+  {
+    MapT map;
+    map[0] = std::string(40, 'a');
+    while (map.size() != map.capacity() - map.capacity() / 8) {
+      map[static_cast<int>(map.size())] = "filler";
+    }
+    const auto capacity = map.capacity();
+    map.try_emplace(-1, map.at(0));
+    EXPECT_GT(map.capacity(), capacity);
+    EXPECT_EQ(map.at(-1), std::string(40, 'a'));
+  }
+
+  TEST(FlatHashMap, RehashIsStronglyExceptionSafe)
+  {
+    ftl::flat_hash_map<int, FragileCopy> map;
+    map.emplace(0, 0);
+    while (map.size() < 20 ||
+        map.size() != map.capacity() - map.capacity() / 8) {
+      map.emplace(static_cast<int>(map.size()), 1);
+    }
+    const auto size = map.size();
+    FragileCopy::copies_left = 2;
+    EXPECT_THROW(map.emplace(-1, 2), std::runtime_error);
+    FragileCopy::copies_left = -1;
+    EXPECT_EQ(map.size(), size);
+    EXPECT_FALSE(map.contains(-1));
+    EXPECT_EQ(map.at(0).value, 0);
+    map.emplace(-1, 2);
+    EXPECT_EQ(map.at(-1).value, 2);
+    EXPECT_EQ(map.size(), size + 1);
+  }
+
+  TEST(FlatHashMap, VectorKeysAndCompare)
+  {
+    ftl::flat_hash_map<ftl::vector<int>, int> map;
+    map[ftl::vector<int>{ 1, 2, 3 }] = 6;
+    map[ftl::vector<int>{}] = 0;
+    EXPECT_EQ(map.at(ftl::vector<int>{ 1, 2, 3 }), 6);
+    EXPECT_EQ(map.count(ftl::vector<int>{ 1, 2 }), 0u);
+
+    auto copy = map;
+    EXPECT_EQ(copy, map);
+    copy[ftl::vector<int>{}] = 1;
+    EXPECT_NE(copy, map);
+    auto range = copy.equal_range(ftl::vector<int>{});
+    EXPECT_EQ(std::distance(range.first, range.second), 1);
+    EXPECT_EQ(range.first->second, 1);
+  }
+}
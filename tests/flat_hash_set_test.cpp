@@ -0,0 +1,194 @@
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  using SetT = ftl::flat_hash_set<int>;
+
+  // Hashes every key to the same group so probing and tombstones are hit.
+  struct CollidingHash
+  {
+    std::size_t operator()(int) const noexcept { return 0; }
+  };
+
+  // Lets std::string sets be queried with C strings without a temporary.
+  struct StringHash
+  {
+    using is_transparent = void;
+
+    std::size_t operator()(const std::string& s) const noexcept
+    {
+      return std::hash<std::string>()(s);
+    }
+    std::size_t operator()(const char* s) const noexcept
+    {
+      return std::hash<std::string>()(s);
+    }
+  };
+
+  struct StringEq
+  {
+    using is_transparent = void;
+
+    template <typename A, typename B>
+    bool operator()(const A& a, const B& b) const noexcept
+    {
+      return std::string(a) == std::string(b);
+    }
+  };
+
+  TEST(FlatHashSet, InsertFindErase)
+  {
+    SetT set;
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(set.find(1), set.end());
+    for (int i = 0; i < 1000; ++i) {
+      EXPECT_TRUE(set.insert(i * 7).second);
+    }
+    EXPECT_FALSE(set.insert(7).second);
+    ASSERT_EQ(set.size(), 1000u);
+    EXPECT_LE(set.load_factor(), set.max_load_factor());
+    for (int i = 0; i < 1000; ++i) {
+      ASSERT_TRUE(set.contains(i * 7));
+      ASSERT_FALSE(set.contains(i * 7 + 1));
+    }
+    EXPECT_EQ(*set.find(70), 70);
+    EXPECT_EQ(set.count(71), 0u);
+    EXPECT_EQ(std::distance(set.begin(), set.end()), 1000);
+
+    for (int i = 0; i < 1000; i += 2) {
+      ASSERT_EQ(set.erase(i * 7), 1u);
+    }
+    EXPECT_EQ(set.erase(0), 0u);
+    EXPECT_EQ(set.size(), 500u);
+    for (int i = 0; i < 1000; ++i) {
+      ASSERT_EQ(set.contains(i * 7), i % 2 == 1);
+    }
+  }
+
+  TEST(FlatHashSet, CollisionsAndTombstones)
+  {
+    ftl::flat_hash_set<int, CollidingHash> set;
+    for (int round = 0; round < 20; ++round) {
+      for (int i = 0; i < 40; ++i) {
+        ASSERT_TRUE(set.insert(round * 100 + i).second);
+      }
+      for (int i = 0; i < 40; ++i) {
+        ASSERT_TRUE(set.contains(round * 100 + i));
+      }
+      for (int i = 0; i < 40; i += 2) {
+        ASSERT_EQ(set.erase(round * 100 + i), 1u);
+      }
+    }
+    EXPECT_EQ(set.size(), 400u);
+    for (int round = 0; round < 20; ++round) {
+      for (int i = 0; i < 40; ++i) {
+        ASSERT_EQ(set.contains(round * 100 + i), i % 2 == 1);
+      }
+    }
+  }
+
+  TEST(FlatHashSet, EraseWhileIterating)
+  {
+    SetT set;
+    for (int i = 0; i < 200; ++i) {
+      set.insert(i);
+    }
+    for (auto it = set.begin(); it != set.end();) {
+      it = *it % 3 == 0 ? set.erase(it) : std::next(it);
+    }
+    EXPECT_EQ(set.size(), 133u);
+    int sum = 0;
+    for (int value : set) {
+      EXPECT_NE(value % 3, 0);
+      sum += value;
+    }
+    EXPECT_EQ(sum, 19900 - 6633);
+    set.erase(set.begin(), set.end());
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(set.begin(), set.end());
+  }
+
+  TEST(FlatHashSet, ReserveAndRehash)
+  {
+    SetT set;
+    set.reserve(100);
+    const auto capacity = set.capacity();
+    EXPECT_GE(capacity, 100u);
+    for (int i = 0; i < 100; ++i) {
+      set.insert(i);
+    }
+    EXPECT_EQ(set.capacity(), capacity);
+    set.rehash(1000);
+    EXPECT_GE(set.bucket_count(), 1000u);
+    EXPECT_EQ(set.size(), 100u);
+    EXPECT_TRUE(set.contains(99));
+    set.clear();
+    EXPECT_TRUE(set.empty());
+    set.rehash(0);
+    EXPECT_EQ(set.capacity(), 0u);
+    set.insert(5);
+    EXPECT_TRUE(set.contains(5));
+  }
+
+  TEST(FlatHashSet, RangeInsertAndVectorKeys)
+  {
+    std::vector<int> values(50, 3);
+    values.push_back(4);
+    SetT set(values.begin(), values.end());
+    EXPECT_EQ(set.size(), 2u);
+    set.insert({ 1, 2, 3 });
+    EXPECT_EQ(set.size(), 4u);
+
+    ftl::flat_hash_set<ftl::vector<int>> vectors;
+    vectors.insert(ftl::vector<int>{ 1, 2, 3 });
+    vectors.insert(ftl::vector<int>{ 1, 2 });
+    EXPECT_FALSE(vectors.insert(ftl::vector<int>{ 1, 2, 3 }).second);
+    EXPECT_TRUE(vectors.contains(ftl::vector<int>{ 1, 2 }));
+    EXPECT_FALSE(vectors.contains(ftl::vector<int>{ 2, 1 }));
+  }
+
+  TEST(FlatHashSet, HeterogeneousLookup)
+  {
+    ftl::flat_hash_set<std::string, StringHash, StringEq> set{ "alpha",
+      "beta", "gamma" };
+    EXPECT_TRUE(set.contains("beta"));
+    EXPECT_FALSE(set.contains("delta"));
+    EXPECT_EQ(*set.find("gamma"), "gamma");
+    EXPECT_EQ(set.erase("alpha"), 1u);
+    EXPECT_EQ(set.size(), 2u);
+  }
+
+  TEST(FlatHashSet, CopyMoveSwapAndCompare)
+  {
+    ftl::flat_hash_set<std::string> set;
+    for (int i = 0; i < 100; ++i) {
+      set.insert(std::to_string(i));
+    }
+    auto copy = set;
+    EXPECT_EQ(copy, set);
+    copy.erase("42");
+    EXPECT_NE(copy, set);
+    copy.insert("42");
+    EXPECT_EQ(copy, set);
+
+    auto moved = std::move(copy);
+    EXPECT_TRUE(copy.empty());
+    EXPECT_EQ(moved, set);
+    copy = set;
+    moved = std::move(copy);
+    EXPECT_EQ(moved, set);
+
+    ftl::flat_hash_set<std::string> other{ "x" };
+    swap(other, moved);
+    EXPECT_EQ(other, set);
+    EXPECT_EQ(moved.size(), 1u);
+    other = { "a", "b" };
+    EXPECT_EQ(other.size(), 2u);
+  }
+}
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  using MapT = ftl::flat_map<int, std::string>;
+
+  TEST(FlatMap, SubscriptAtAndFind)
+  {
+    MapT map;
+    for (int i : { 5, 1, 9, 3, 7 }) {
+      map[i] = std::to_string(i);
+    }
+    EXPECT_EQ(map.keys(), (ftl::vector<int>{ 1, 3, 5, 7, 9 }));
+    EXPECT_EQ(map.values()[2], "5");
+    EXPECT_EQ(map.at(9), "9");
+    EXPECT_THROW(map.at(2), std::out_of_range);
+    const MapT& view = map;
+    EXPECT_EQ(view.at(3), "3");
+    EXPECT_EQ(view.find(4), view.end());
+    EXPECT_EQ(map.find(7)->second, "7");
+    map.find(7)->second = "seven";
+    EXPECT_EQ(map[7], "seven");
+    EXPECT_EQ(map.lower_bound(6)->first, 7);
+    EXPECT_EQ(map.upper_bound(7)->first, 9);
+    EXPECT_EQ(map.equal_range(4).first, map.equal_range(4).second);
+  }
+
+  TEST(FlatMap, InsertTryEmplaceAndErase)
+  {
+    MapT map;
+    EXPECT_TRUE(map.insert({ 2, "two" }).second);
+    EXPECT_FALSE(map.insert({ 2, "deux" }).second);
+    EXPECT_TRUE(map.emplace(1, "one").second);
+    EXPECT_TRUE(map.try_emplace(3, 3, 'c').second);
+    std::string kept = "kept";
+    EXPECT_FALSE(map.try_emplace(3, std::move(kept)).second);
+    EXPECT_EQ(kept, "kept");
+    EXPECT_FALSE(map.insert_or_assign(3, "three").second);
+    EXPECT_EQ(map.at(3), "three");
+    EXPECT_EQ(map.values(), (ftl::vector<std::string>{ "one", "two",
+                                "three" }));
+
+    auto it = map.erase(map.find(2));
+    EXPECT_EQ(it->first, 3);
+    EXPECT_EQ(map.erase(1), 1u);
+    EXPECT_EQ(map.erase(1), 0u);
+    EXPECT_EQ(map.size(), 1u);
+    map.erase(map.begin(), map.end());
+    EXPECT_TRUE(map.empty());
+  }
+
+  TEST(FlatMap, BulkInsertMergesBatches)
+  {
+    MapT map{ { 10, "a" }, { 20, "b" }, { 30, "c" } };
+    const std::vector<std::pair<int, std::string>> sorted{ { 5, "x" },
+      { 20, "ignored" }, { 25, "y" }, { 40, "z" } };
+    map.insert(ftl::sorted_unique, sorted.begin(), sorted.end());
+    EXPECT_EQ(map.keys(), (ftl::vector<int>{ 5, 10, 20, 25, 30, 40 }));
+    EXPECT_EQ(map.values(),
+        (ftl::vector<std::string>{ "x", "a", "b", "y", "c", "z" }));
+
+    std::vector<std::pair<int, std::string>> unsorted{ { 50, "p" },
+      { 1, "q" }, { 50, "dup" }, { 10, "ignored" }, { 35, "r" } };
+    map.insert(unsorted.begin(), unsorted.end());
+    EXPECT_EQ(map.keys(),
+        (ftl::vector<int>{ 1, 5, 10, 20, 25, 30, 35, 40, 50 }));
+    EXPECT_EQ(map.at(50), "p");
+    EXPECT_EQ(map.at(10), "a");
+
+    map.insert(ftl::sorted_unique, { { 60, "s" }, { 70, "t" } });
+    EXPECT_EQ(map.size(), 11u);
+    EXPECT_EQ(map.rbegin()->second, "t");
+  }
+
+  TEST(FlatMap, BulkInsertOfMoveOnlyValues)
+  {
+    ftl::flat_map<int, std::unique_ptr<int>> map;
+    for (int i = 0; i < 100; i += 2) {
+      map.try_emplace(i, std::make_unique<int>(i));
+    }
+    std::vector<std::pair<int, std::unique_ptr<int>>> batch;
+    for (int i = 99; i > 0; i -= 2) {
+      batch.emplace_back(i, std::make_unique<int>(i));
+    }
+    map.insert(std::make_move_iterator(batch.begin()),
+        std::make_move_iterator(batch.end()));
+    ASSERT_EQ(map.size(), 100u);
+    int expected = 0;
+    for (auto row : map) {
+      ASSERT_EQ(row.first, expected);
+      ASSERT_EQ(*row.second, expected);
+      ++expected;
+    }
+  }
+
+  TEST(FlatMap, ConstructionFromColumns)
+  {
+    MapT map(ftl::vector<int>{ 3, 1, 2, 1 },
+        ftl::vector<std::string>{ "c", "a", "b", "dup" });
+    EXPECT_EQ(map.keys(), (ftl::vector<int>{ 1, 2, 3 }));
+    EXPECT_EQ(map.values(), (ftl::vector<std::string>{ "a", "b", "c" }));
+
+    MapT presorted(ftl::sorted_unique, ftl::vector<int>{ 1, 2 },
+        ftl::vector<std::string>{ "x", "y" });
+    EXPECT_EQ(presorted.at(2), "y");
+
+    EXPECT_THROW(MapT(ftl::vector<int>{ 1, 2 }, ftl::vector<std::string>{ "a" }),
+        std::invalid_argument);
+    EXPECT_THROW(MapT(ftl::sorted_unique, ftl::vector<int>{ 1 },
+                     ftl::vector<std::string>{ "a", "b" }),
+        std::invalid_argument);
+  }
+
+  TEST(FlatMap, ExtractAndReplaceKeepStorage)
+  {
+    MapT map{ { 1, "a" }, { 2, "b" } };
+    const int* keys = map.keys().data();
+    const std::string* values = map.values().data();
+    MapT::containers columns = std::move(map).extract();
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(columns.keys.data(), keys);
+    EXPECT_EQ(columns.values.data(), values);
+    map.replace(std::move(columns.keys), std::move(columns.values));
+    EXPECT_EQ(map.keys().data(), keys);
+    EXPECT_EQ(map.at(2), "b");
+    EXPECT_THROW(map.replace(ftl::vector<int>{ 1 }, ftl::vector<std::string>{}),
+        std::invalid_argument);
+    EXPECT_EQ(map.size(), 2u);
+  }
+
+  TEST(FlatMap, HeterogeneousLookupAndCompare)
+  {
+    ftl::flat_map<std::string, int, std::less<>> map{ { "b", 2 },
+      { "a", 1 } };
+    EXPECT_EQ(map.at("a"), 1);
+    EXPECT_TRUE(map.contains("b"));
+    EXPECT_EQ(map.erase("b"), 1u);
+
+    MapT lhs{ { 1, "a" }, { 2, "b" } };
+    MapT rhs = lhs;
+    EXPECT_EQ(lhs, rhs);
+    rhs[2] = "c";
+    EXPECT_NE(lhs, rhs);
+    EXPECT_LT(lhs, rhs);
+    swap(lhs, rhs);
+    EXPECT_EQ(lhs.at(2), "c");
+    EXPECT_GT(lhs, rhs);
+  }
+}
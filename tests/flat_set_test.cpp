@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  using SetT = ftl::flat_set<int>;
+
+  TEST(FlatSet, InsertFindErase)
+  {
+    SetT set;
+    EXPECT_TRUE(set.empty());
+    for (int i : { 5, 1, 9, 3, 7 }) {
+      EXPECT_TRUE(set.insert(i).second);
+    }
+    EXPECT_FALSE(set.insert(3).second);
+    EXPECT_TRUE(set.emplace(4).second);
+    EXPECT_EQ(set.keys(), (ftl::vector<int>{ 1, 3, 4, 5, 7, 9 }));
+    EXPECT_EQ(*set.find(7), 7);
+    EXPECT_EQ(set.find(8), set.end());
+    EXPECT_EQ(*set.lower_bound(6), 7);
+    EXPECT_EQ(*set.upper_bound(7), 9);
+    EXPECT_EQ(set.count(1), 1u);
+    EXPECT_EQ(set.erase(1), 1u);
+    EXPECT_EQ(set.erase(2), 0u);
+    EXPECT_EQ(*set.erase(set.find(4)), 5);
+    EXPECT_EQ(set.keys(), (ftl::vector<int>{ 3, 5, 7, 9 }));
+    EXPECT_EQ(*set.rbegin(), 9);
+  }
+
+  TEST(FlatSet, BulkInsertMergesBatches)
+  {
+    SetT set{ 10, 20, 30, 40 };
+    const std::vector<int> sorted{ 5, 20, 25, 45 };
+    set.insert(ftl::sorted_unique, sorted.begin(), sorted.end());
+    EXPECT_EQ(set.keys(), (ftl::vector<int>{ 5, 10, 20, 25, 30, 40, 45 }));
+
+    const std::vector<int> unsorted{ 50, 1, 25, 1, 35, 50 };
+    set.insert(unsorted.begin(), unsorted.end());
+    EXPECT_EQ(set.keys(),
+        (ftl::vector<int>{ 1, 5, 10, 20, 25, 30, 35, 40, 45, 50 }));
+
+    set.insert(ftl::sorted_unique, { 60, 70 });
+    EXPECT_EQ(set.size(), 12u);
+    EXPECT_TRUE(std::is_sorted(set.begin(), set.end()));
+  }
+
+  TEST(FlatSet, BulkInsertKeepsExistingKeys)
+  {
+    using Entry = std::pair<int, char>;
+    auto by_first = [](const Entry& lhs, const Entry& rhs) {
+      return lhs.first < rhs.first;
+    };
+    ftl::flat_set<Entry, decltype(by_first)> set(by_first);
+    set.insert({ { 2, 'a' }, { 4, 'a' }, { 6, 'a' } });
+    set.insert(ftl::sorted_unique, { { 1, 'b' }, { 4, 'b' }, { 7, 'b' } });
+    const ftl::vector<Entry> expected{ { 1, 'b' }, { 2, 'a' }, { 4, 'a' },
+      { 6, 'a' }, { 7, 'b' } };
+    EXPECT_EQ(set.keys(), expected);
+  }
+
+  TEST(FlatSet, ConstructionSortsAndDeduplicates)
+  {
+    SetT set(ftl::vector<int>{ 3, 1, 2, 3, 1 });
+    EXPECT_EQ(set.keys(), (ftl::vector<int>{ 1, 2, 3 }));
+    ftl::flat_set<int, std::greater<int>> descending{ 1, 3, 2 };
+    EXPECT_EQ(*descending.begin(), 3);
+    SetT presorted(ftl::sorted_unique, ftl::vector<int>{ 1, 4, 9 });
+    EXPECT_TRUE(presorted.contains(4));
+  }
+
+  TEST(FlatSet, ExtractAndReplaceKeepStorage)
+  {
+    SetT set{ 1, 2, 3 };
+    const int* data = set.keys().data();
+    ftl::vector<int> keys = std::move(set).extract();
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(keys.data(), data);
+    set.replace(std::move(keys));
+    EXPECT_EQ(set.keys().data(), data);
+    EXPECT_EQ(set.size(), 3u);
+  }
+
+  TEST(FlatSet, HeterogeneousLookup)
+  {
+    ftl::flat_set<std::string, std::less<>> set{ "pear", "apple", "fig" };
+    EXPECT_TRUE(set.contains("fig"));
+    EXPECT_EQ(*set.find("apple"), "apple");
+    EXPECT_EQ(set.erase("pear"), 1u);
+    EXPECT_EQ(set.size(), 2u);
+  }
+
+  TEST(FlatSet, CopySwapAndCompare)
+  {
+    SetT set{ 1, 2, 3 };
+    SetT copy = set;
+    EXPECT_EQ(copy, set);
+    copy.insert(4);
+    EXPECT_NE(copy, set);
+    EXPECT_LT(set, copy);
+    SetT other{ 9 };
+    swap(other, copy);
+    EXPECT_EQ(copy, SetT{ 9 });
+    EXPECT_EQ(other.size(), 4u);
+    other = { 7, 8 };
+    EXPECT_EQ(other.keys(), (ftl::vector<int>{ 7, 8 }));
+  }
+}
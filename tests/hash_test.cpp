@@ -0,0 +1,97 @@
+#include <cstdint>
+#include <set>
+#include <string>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  struct Point
+  {
+    std::int32_t x;
+    std::int32_t y;
+  };
+}
+
+template <>
+struct ftl::is_trivially_equality_comparable<test::Point> : std::true_type
+{
+};
+
+namespace test {
+  using ByteVectorT = ftl::vector<std::uint8_t>;
+
+  ByteVectorT MakeBytes(size_t size)
+  {
+    ByteVectorT bytes(size);
+    for (size_t i = 0; i != size; ++i) {
+      bytes[i] = static_cast<std::uint8_t>(i * 131 + 7);
+    }
+    return bytes;
+  }
+
+  size_t Hash(const ByteVectorT& bytes)
+  {
+    return std::hash<ByteVectorT>{}(bytes);
+  }
+
+  TEST(VectorHash, EqualContentsHashEqual)
+  {
+    for (size_t size = 0; size < 1100; size += size < 70 ? 1 : 37) {
+      ByteVectorT bytes = MakeBytes(size);
+      ByteVectorT copy(bytes);
+      copy.reserve(size * 2 + 1);
+      ASSERT_EQ(Hash(bytes), Hash(copy)) << size;
+    }
+  }
+
+  TEST(VectorHash, EveryByteMatters)
+  {
+    for (size_t size : { 1, 3, 4, 9, 16, 17, 100, 256, 257, 1000, 2100 }) {
+      const ByteVectorT bytes = MakeBytes(size);
+      std::set<size_t> hashes{ Hash(bytes) };
+      for (size_t i = 0; i != size; ++i) {
+        ByteVectorT changed(bytes);
+        changed[i] ^= 1;
+        hashes.insert(Hash(changed));
+      }
+      EXPECT_EQ(hashes.size(), size + 1) << size;
+    }
+  }
+
+  TEST(VectorHash, LengthAndOrderMatter)
+  {
+    std::set<size_t> hashes;
+    for (size_t size = 0; size != 300; ++size) {
+      hashes.insert(Hash(ByteVectorT(size, 0)));
+    }
+    EXPECT_EQ(hashes.size(), 300);
+
+    ByteVectorT stripes = MakeBytes(1024);
+    ByteVectorT swapped(stripes);
+    std::swap_ranges(swapped.begin(), swapped.begin() + 64,
+        swapped.begin() + 64);
+    EXPECT_NE(Hash(stripes), Hash(swapped));
+  }
+
+  TEST(VectorHash, ContainersAgree)
+  {
+    const ByteVectorT bytes = MakeBytes(40);
+    ftl::small_vector<std::uint8_t, 8> small(bytes.begin(), bytes.end());
+    ftl::inplace_vector<std::uint8_t, 64> inplace(bytes.begin(), bytes.end());
+    EXPECT_EQ(Hash(bytes), std::hash<decltype(small)>{}(small));
+    EXPECT_EQ(Hash(bytes), std::hash<decltype(inplace)>{}(inplace));
+  }
+
+  TEST(VectorHash, OptInAndFallbackTypes)
+  {
+    ftl::vector<Point> points{ { 1, 2 }, { 3, 4 } };
+    ftl::vector<Point> other{ { 1, 2 }, { 4, 3 } };
+    EXPECT_NE(std::hash<ftl::vector<Point>>{}(points),
+        std::hash<ftl::vector<Point>>{}(other));
+
+    ftl::vector<std::string> strings{ "a", std::string(100, 'b') };
+    ftl::vector<std::string> copy(strings);
+    EXPECT_EQ(std::hash<ftl::vector<std::string>>{}(strings),
+        std::hash<ftl::vector<std::string>>{}(copy));
+  }
+}
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  constexpr size_t Capacity = 8;
+  using InplaceVectorT = ftl::inplace_vector<int, Capacity>;
+  using InplaceStringVectorT = ftl::inplace_vector<std::string, Capacity>;
+
+  std::string LongString(int i)
+  {
+    return std::to_string(i) + std::string(32, '#');
+  }
+
+  TEST(InplaceVector, Layout)
+  {
+    EXPECT_EQ(sizeof(InplaceVectorT), sizeof(size_t) + Capacity * sizeof(int));
+    EXPECT_TRUE(std::is_trivially_copyable<InplaceVectorT>::value);
+    EXPECT_FALSE(std::is_trivially_copyable<InplaceStringVectorT>::value);
+    EXPECT_EQ(InplaceVectorT::capacity(), Capacity);
+    EXPECT_EQ(InplaceVectorT::max_size(), Capacity);
+
+    InplaceVectorT vector{ 1, 2, 3 };
+    auto object = reinterpret_cast<const unsigned char*>(&vector);
+    auto data = reinterpret_cast<const unsigned char*>(vector.data());
+    EXPECT_TRUE(data >= object && data < object + sizeof(vector));
+  }
+
+  TEST(InplaceVector, PushBackUpToCapacity)
+  {
+    InplaceStringVectorT vector;
+    for (int i = 0; i != static_cast<int>(Capacity); ++i) {
+      vector.push_back(LongString(i));
+    }
+    EXPECT_EQ(vector.size(), Capacity);
+    EXPECT_THROW(vector.push_back("overflow"), std::bad_alloc);
+    EXPECT_THROW(vector.emplace_back(), std::bad_alloc);
+    EXPECT_EQ(vector.size(), Capacity);
+    EXPECT_EQ(vector.back(), LongString(Capacity - 1));
+  }
+
+  TEST(InplaceVector, TryPushBack)
+  {
+    InplaceVectorT vector;
+    for (int i = 0; i != static_cast<int>(Capacity); ++i) {
+      int* inserted = vector.try_push_back(i);
+      ASSERT_NE(inserted, nullptr);
+      EXPECT_EQ(inserted, &vector.back());
+    }
+    EXPECT_EQ(vector.try_push_back(42), nullptr);
+    EXPECT_EQ(vector.try_emplace_back(42), nullptr);
+    EXPECT_EQ(vector.size(), Capacity);
+
+    ftl::inplace_vector<std::unique_ptr<int>, 1> pointers;
+    auto value = std::make_unique<int>(7);
+    EXPECT_NE(pointers.try_push_back(std::move(value)), nullptr);
+    EXPECT_EQ(*pointers.front(), 7);
+    value = std::make_unique<int>(8);
+    EXPECT_EQ(pointers.try_push_back(std::move(value)), nullptr);
+    EXPECT_NE(value, nullptr);
+  }
+
+  TEST(InplaceVector, ConstructorsThrowWhenTooLarge)
+  {
+    std::vector<int> values(Capacity + 1, 1);
+    std::istringstream stream("1 2 3 4 5 6 7 8 9");
+    EXPECT_THROW(InplaceVectorT(Capacity + 1), std::bad_alloc);
+    EXPECT_THROW(InplaceVectorT(Capacity + 1, 1), std::bad_alloc);
+    EXPECT_THROW(InplaceVectorT(values.begin(), values.end()), std::bad_alloc);
+    EXPECT_THROW(InplaceVectorT(std::istream_iterator<int>(stream),
+                     std::istream_iterator<int>()),
+        std::bad_alloc);
+    InplaceVectorT full(Capacity);
+    EXPECT_EQ(full.size(), Capacity);
+  }
+
+  TEST(InplaceVector, MatchesStdVector)
+  {
+    for (size_t count : { 0, 1, 2, 5 }) {
+      for (size_t shift = 0; shift <= 3; ++shift) {
+        InplaceStringVectorT vector{ "a", "b", "c" };
+        std::vector<std::string> expected{ "a", "b", "c" };
+        std::vector<std::string> values;
+        for (size_t i = 0; i != count; ++i) {
+          values.push_back(LongString(i));
+        }
+        auto it = vector.insert(vector.cbegin() + shift, values.begin(),
+            values.end());
+        EXPECT_EQ(it, vector.begin() + shift);
+        expected.insert(expected.begin() + shift, values.begin(),
+            values.end());
+        ASSERT_TRUE(std::equal(vector.begin(), vector.end(),
+            expected.begin(), expected.end()));
+
+        vector.erase(vector.begin() + shift, vector.begin() + shift + count);
+        vector.insert(vector.cbegin() + shift, count, "fill");
+        expected.erase(expected.begin() + shift,
+            expected.begin() + shift + count);
+        expected.insert(expected.begin() + shift, count, "fill");
+        ASSERT_TRUE(std::equal(vector.begin(), vector.end(),
+            expected.begin(), expected.end()));
+      }
+    }
+  }
+
+  TEST(InplaceVector, InsertOverflowThrows)
+  {
+    InplaceVectorT vector(Capacity - 1);
+    std::vector<int> values{ 1, 2 };
+    EXPECT_THROW(vector.insert(vector.cbegin(), values.begin(), values.end()),
+        std::bad_alloc);
+    EXPECT_THROW(vector.insert(vector.cbegin(), 2, 1), std::bad_alloc);
+    EXPECT_EQ(vector.size(), Capacity - 1);
+    vector.insert(vector.cbegin(), 5);
+    EXPECT_THROW(vector.emplace(vector.cbegin(), 6), std::bad_alloc);
+    EXPECT_EQ(vector.front(), 5);
+  }
+
+  TEST(InplaceVector, InputIteratorInsert)
+  {
+    InplaceVectorT vector{ 1, 5 };
+    std::istringstream stream("2 3 4");
+    vector.insert(vector.cbegin() + 1, std::istream_iterator<int>(stream),
+        std::istream_iterator<int>());
+    EXPECT_TRUE(vector == InplaceVectorT({ 1, 2, 3, 4, 5 }));
+  }
+
+  TEST(InplaceVector, ValueFromSameVector)
+  {
+    InplaceStringVectorT vector{ LongString(0), LongString(1), LongString(2) };
+    vector.insert(vector.cbegin(), 2, vector[1]);
+    EXPECT_TRUE(vector ==
+        InplaceStringVectorT({ LongString(1), LongString(1), LongString(0),
+            LongString(1), LongString(2) }));
+    vector.emplace(vector.cbegin() + 1, vector.back());
+    EXPECT_EQ(vector[1], LongString(2));
+    vector.resize(7, vector.front());
+    EXPECT_EQ(vector.back(), LongString(1));
+  }
+
+  TEST(InplaceVector, CopyMoveAndSwap)
+  {
+    InplaceStringVectorT source{ LongString(1), LongString(2) };
+    InplaceStringVectorT copy(source);
+    EXPECT_TRUE(copy == source);
+    InplaceStringVectorT moved(std::move(copy));
+    EXPECT_TRUE(moved == source);
+
+    InplaceStringVectorT other{ "x", "y", "z", "w" };
+    moved = other;
+    EXPECT_TRUE(moved == other);
+    moved = source;
+    EXPECT_TRUE(moved == source);
+
+    moved.swap(other);
+    EXPECT_TRUE(moved == InplaceStringVectorT({ "x", "y", "z", "w" }));
+    EXPECT_TRUE(other == source);
+    swap(moved, other);
+    EXPECT_TRUE(moved == source);
+  }
+
+  TEST(InplaceVector, AssignAndResize)
+  {
+    InplaceVectorT vector{ 1, 2, 3 };
+    vector.assign(5, 4);
+    EXPECT_TRUE(vector == InplaceVectorT({ 4, 4, 4, 4, 4 }));
+    vector.assign({ 7, 8 });
+    EXPECT_TRUE(vector == InplaceVectorT({ 7, 8 }));
+    EXPECT_THROW(vector.assign(Capacity + 1, 0), std::bad_alloc);
+    vector.resize(4);
+    EXPECT_TRUE(vector == InplaceVectorT({ 7, 8, 0, 0 }));
+    vector.resize_for_overwrite(Capacity);
+    EXPECT_EQ(vector.size(), Capacity);
+    EXPECT_THROW(vector.resize(Capacity + 1), std::bad_alloc);
+    EXPECT_THROW(vector.reserve(Capacity + 1), std::bad_alloc);
+    vector.clear();
+    EXPECT_TRUE(vector.empty());
+  }
+
+  TEST(InplaceVector, AppendUninitialized)
+  {
+    InplaceVectorT vector{ 1 };
+    auto written = vector.append_uninitialized(3, [](int* out, size_t n) {
+      std::iota(out, out + n, 2);
+      return n;
+    });
+    EXPECT_EQ(written, 3);
+    EXPECT_TRUE(vector == InplaceVectorT({ 1, 2, 3, 4 }));
+  }
+
+  TEST(InplaceVector, AtOutOfRange)
+  {
+    InplaceVectorT vector{ 1 };
+    EXPECT_EQ(vector.at(0), 1);
+    EXPECT_THROW(vector.at(1), std::out_of_range);
+  }
+
+  TEST(InplaceVector, ComparisonAndHash)
+  {
+    InplaceVectorT a{ 1, 2, 3 };
+    InplaceVectorT b{ 1, 2, 4 };
+    EXPECT_TRUE(a < b);
+    EXPECT_TRUE(a != b);
+    b.back() = 3;
+    EXPECT_TRUE(a == b);
+    EXPECT_EQ(std::hash<InplaceVectorT>{}(a), std::hash<InplaceVectorT>{}(b));
+  }
+
+#if defined(FTL_CPP20_FEATURES)
+  constexpr int ConstexprSum()
+  {
+    ftl::inplace_vector<int, 4> vector{ 3, 1 };
+    vector.push_back(4);
+    vector.insert(vector.begin(), 2);
+    if (vector.try_push_back(5) != nullptr) {
+      return -1;
+    }
+    vector.erase(vector.begin() + 1);
+    return std::accumulate(vector.begin(), vector.end(), 0);
+  }
+
+  static_assert(ConstexprSum() == 7);
+#endif
+}
@@ -0,0 +1,107 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+#if defined(FTL_POSIX_FEATURES)
+
+namespace test {
+  template <typename T>
+  using MmapVectorT = ftl::vector<T, ftl::mmap_allocator<T>>;
+
+  constexpr size_t MappedInts = ftl::detail::mmap_threshold / sizeof(int);
+
+  bool IsPageAligned(const void* p)
+  {
+    return reinterpret_cast<std::uintptr_t>(p) %
+        ftl::detail::mmap_page_size() ==
+        0;
+  }
+
+  TEST(MmapAllocator, SmallBlocksUseHeap)
+  {
+    ftl::mmap_allocator<int> allocator;
+    auto allocation = allocator.allocate_at_least(10);
+    EXPECT_EQ(allocation.count, 10);
+    allocator.deallocate(allocation.ptr, allocation.count);
+  }
+
+  TEST(MmapAllocator, LargeBlocksArePageRounded)
+  {
+    ftl::mmap_allocator<int> allocator;
+    auto allocation = allocator.allocate_at_least(MappedInts + 1);
+    EXPECT_TRUE(IsPageAligned(allocation.ptr));
+    EXPECT_EQ(allocation.count * sizeof(int) % ftl::detail::mmap_page_size(),
+        0);
+    EXPECT_GT(allocation.count, MappedInts + 1);
+    allocation.ptr[allocation.count - 1] = 1;
+    allocator.deallocate(allocation.ptr, allocation.count);
+
+    ftl::mmap_allocator<int, true> huge;
+    auto huge_allocation = huge.allocate_at_least(MappedInts);
+    EXPECT_EQ(huge_allocation.count * sizeof(int),
+        ftl::detail::mmap_huge_page_size);
+    huge.deallocate(huge_allocation.ptr, huge_allocation.count);
+  }
+
+  std::uint32_t Scramble(size_t i)
+  {
+    return static_cast<std::uint32_t>(i * 2654435761u);
+  }
+
+  TEST(MmapAllocator, VectorGrowsAndShrinks)
+  {
+    MmapVectorT<std::uint32_t> vector;
+    const size_t count = 4 * MappedInts;
+    for (size_t i = 0; i != count; ++i) {
+      vector.push_back(Scramble(i));
+    }
+    EXPECT_TRUE(IsPageAligned(vector.data()));
+    for (size_t i = 0; i != count; ++i) {
+      ASSERT_EQ(vector[i], Scramble(i));
+    }
+
+    vector.resize(MappedInts + 7);
+    vector.shrink_to_fit();
+    EXPECT_LT(vector.capacity(), MappedInts + 7 + 4096);
+    EXPECT_EQ(vector.back(), Scramble(MappedInts + 6));
+
+    vector.resize(100);
+    vector.shrink_to_fit();
+    EXPECT_EQ(vector.capacity(), 100);
+    EXPECT_EQ(vector[99], Scramble(99));
+  }
+
+#  if defined(__linux__)
+  TEST(MmapAllocator, ExpandsMappingInPlace)
+  {
+    ftl::mmap_allocator<int> allocator;
+    auto allocation = allocator.allocate_at_least(MappedInts);
+    allocation.ptr[0] = 42;
+    if (allocator.try_expand(allocation.ptr, allocation.count,
+            2 * allocation.count)) {
+      allocation.ptr[2 * allocation.count - 1] = 1;
+      allocation.count *= 2;
+    }
+    auto moved = allocator.reallocate(allocation.ptr, 1, allocation.count,
+        8 * allocation.count);
+    EXPECT_EQ(moved.ptr[0], 42);
+    moved.ptr[moved.count - 1] = 1;
+    allocator.deallocate(moved.ptr, moved.count);
+  }
+#  endif
+
+  TEST(MmapAllocator, NonRelocatableElements)
+  {
+    MmapVectorT<std::string> vector;
+    for (int i = 0; i != 100000; ++i) {
+      vector.push_back(std::to_string(i));
+    }
+    for (int i = 0; i < 100000; i += 997) {
+      ASSERT_EQ(vector[i], std::to_string(i));
+    }
+  }
+}
+
+#endif
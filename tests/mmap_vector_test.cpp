@@ -0,0 +1,227 @@
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+#if defined(FTL_POSIX_FEATURES)
+
+namespace test {
+  class MmapVector : public ::testing::Test
+  {
+  protected:
+    void SetUp() override
+    {
+      char name[] = "/tmp/ftl_mmap_vector_XXXXXX";
+      const int fd = ::mkstemp(name);
+      ASSERT_NE(fd, -1);
+      ::close(fd);
+      path = name;
+    }
+
+    void TearDown() override { std::remove(path.c_str()); }
+
+    std::size_t FileSize() const
+    {
+      std::FILE* file = std::fopen(path.c_str(), "rb");
+      std::fseek(file, 0, SEEK_END);
+      const long size = std::ftell(file);
+      std::fclose(file);
+      return static_cast<std::size_t>(size);
+    }
+
+    std::string path;
+  };
+
+  TEST_F(MmapVector, DefaultConstructedIsClosed)
+  {
+    ftl::mmap_vector<int> vector;
+    EXPECT_FALSE(vector.is_open());
+    EXPECT_TRUE(vector.empty());
+    EXPECT_EQ(vector.data(), nullptr);
+    EXPECT_EQ(vector.begin(), vector.end());
+  }
+
+  TEST_F(MmapVector, EmptyFileMapsNothing)
+  {
+    ftl::mmap_vector<int> vector(path);
+    EXPECT_TRUE(vector.is_open());
+    EXPECT_FALSE(vector.writable());
+    EXPECT_EQ(vector.size(), 0);
+    EXPECT_EQ(vector.data(), nullptr);
+    vector.advise(ftl::mmap_advice::sequential);
+  }
+
+  TEST_F(MmapVector, WriteThenReadBack)
+  {
+    {
+      ftl::mmap_vector<std::uint64_t> vector(path, ftl::mmap_mode::read_write);
+      for (std::uint64_t i = 0; i != 100000; ++i) {
+        vector.push_back(i);
+      }
+      EXPECT_GE(vector.capacity(), vector.size());
+    }
+    EXPECT_EQ(FileSize(), 100000 * sizeof(std::uint64_t));
+
+    const ftl::mmap_vector<std::uint64_t> vector(path);
+    ASSERT_EQ(vector.size(), 100000);
+    EXPECT_EQ(vector.front(), 0);
+    EXPECT_EQ(vector.back(), 99999);
+    EXPECT_EQ(vector.at(1234), 1234);
+    EXPECT_EQ(std::accumulate(vector.begin(), vector.end(), std::uint64_t()),
+        std::uint64_t(99999) * 100000 / 2);
+    EXPECT_EQ(*vector.rbegin(), 99999);
+  }
+
+  TEST_F(MmapVector, ReopenAndAppend)
+  {
+    {
+      ftl::mmap_vector<int> vector(path, ftl::mmap_mode::read_write);
+      vector.resize(10, 7);
+    }
+    ftl::mmap_vector<int> vector(path, ftl::mmap_mode::read_write);
+    ASSERT_EQ(vector.size(), 10);
+    vector.push_back(8);
+    vector.resize(20);
+    EXPECT_EQ(vector[9], 7);
+    EXPECT_EQ(vector[10], 8);
+    EXPECT_EQ(vector[19], 0);
+    vector.sync();
+    vector.close();
+    EXPECT_EQ(FileSize(), 20 * sizeof(int));
+  }
+
+  TEST_F(MmapVector, ShrinkTruncatesOnClose)
+  {
+    ftl::mmap_vector<int> vector(path, ftl::mmap_mode::read_write);
+    vector.resize(5000, 1);
+    vector.resize(3);
+    vector.pop_back();
+    EXPECT_EQ(vector.size(), 2);
+    vector.close();
+    EXPECT_FALSE(vector.is_open());
+    EXPECT_EQ(FileSize(), 2 * sizeof(int));
+  }
+
+  TEST_F(MmapVector, ReserveKeepsElements)
+  {
+    ftl::mmap_vector<int> vector(path, ftl::mmap_mode::read_write);
+    vector.push_back(1);
+    vector.reserve(1 << 20);
+    EXPECT_GE(vector.capacity(), 1u << 20);
+    EXPECT_EQ(vector.size(), 1);
+    EXPECT_EQ(vector[0], 1);
+    const int* after = vector.data();
+    for (int i = 1; i != 1 << 20; ++i) {
+      vector.push_back(i);
+    }
+    EXPECT_EQ(vector.data(), after);
+  }
+
+  TEST_F(MmapVector, ReadOnlyRejectsWrites)
+  {
+    {
+      ftl::mmap_vector<int> vector(path, ftl::mmap_mode::read_write);
+      vector.push_back(1);
+    }
+    ftl::mmap_vector<int> vector(path);
+    EXPECT_THROW(vector.push_back(2), std::logic_error);
+    EXPECT_THROW(vector.resize(4), std::logic_error);
+    EXPECT_THROW(vector.reserve(4), std::logic_error);
+    EXPECT_THROW(vector.pop_back(), std::logic_error);
+    EXPECT_THROW(vector.clear(), std::logic_error);
+    EXPECT_THROW(vector[0], std::logic_error);
+    EXPECT_THROW(vector.front(), std::logic_error);
+    EXPECT_THROW(vector.data(), std::logic_error);
+    EXPECT_THROW(vector.begin(), std::logic_error);
+    EXPECT_THROW(vector.at(0), std::logic_error);
+    EXPECT_THROW(vector.at(1), std::out_of_range);
+    vector.sync();
+
+    const ftl::mmap_vector<int>& view = vector;
+    ASSERT_EQ(view.size(), 1);
+    EXPECT_EQ(view[0], 1);
+    EXPECT_EQ(*view.begin(), 1);
+    EXPECT_EQ(vector.cend() - vector.cbegin(), 1);
+  }
+
+  TEST_F(MmapVector, MissingFileThrows)
+  {
+    EXPECT_THROW(ftl::mmap_vector<int>("/nonexistent/ftl_mmap_vector"),
+        std::system_error);
+  }
+
+  TEST_F(MmapVector, PartialElementThrows)
+  {
+    {
+      ftl::mmap_vector<char> vector(path, ftl::mmap_mode::read_write);
+      vector.resize(6, 'x');
+    }
+    EXPECT_THROW(ftl::mmap_vector<int>{path}, std::invalid_argument);
+    ftl::mmap_vector<char> vector(path);
+    EXPECT_EQ(vector.size(), 6);
+  }
+
+  struct Triple
+  {
+    std::uint32_t a, b, c;
+  };
+
+  TEST_F(MmapVector, FileReadableWithoutClose)
+  {
+    ftl::mmap_vector<Triple> writer(path, ftl::mmap_mode::read_write);
+    for (std::uint32_t i = 0; i != 5; ++i) {
+      writer.push_back({ i, i + 1, i + 2 });
+    }
+    EXPECT_EQ(FileSize(), writer.capacity() * sizeof(Triple));
+
+    const ftl::mmap_vector<Triple> reader(path);
+    ASSERT_EQ(reader.size(), writer.capacity());
+    for (std::uint32_t i = 0; i != 5; ++i) {
+      EXPECT_EQ(reader[i].a, i);
+      EXPECT_EQ(reader[i].c, i + 2);
+    }
+    EXPECT_EQ(reader.back().b, 0u);
+
+    writer.close();
+    EXPECT_EQ(FileSize(), 5 * sizeof(Triple));
+  }
+
+  TEST_F(MmapVector, Advise)
+  {
+    ftl::mmap_vector<double> vector(path, ftl::mmap_mode::read_write);
+    vector.resize(100000, 1.5);
+    vector.advise(ftl::mmap_advice::sequential);
+    vector.advise(ftl::mmap_advice::willneed, 1000, 50000);
+    vector.advise(ftl::mmap_advice::random, 99999, 1);
+    vector.advise(ftl::mmap_advice::normal, 5, 0);
+    EXPECT_THROW(vector.advise(ftl::mmap_advice::willneed, 99999, 2),
+        std::out_of_range);
+    vector.sync(true);
+    EXPECT_EQ(vector[54321], 1.5);
+  }
+
+  TEST_F(MmapVector, MoveAndSwap)
+  {
+    ftl::mmap_vector<int> a(path, ftl::mmap_mode::read_write);
+    a.push_back(3);
+    ftl::mmap_vector<int> b(std::move(a));
+    EXPECT_FALSE(a.is_open());
+    ASSERT_TRUE(b.is_open());
+    EXPECT_EQ(b[0], 3);
+
+    ftl::mmap_vector<int> c;
+    c = std::move(b);
+    EXPECT_FALSE(b.is_open());
+    swap(b, c);
+    EXPECT_TRUE(b.writable());
+    EXPECT_EQ(b.size(), 1);
+    EXPECT_FALSE(c.is_open());
+  }
+}
+
+#endif
@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  using VectorT = ftl::vector<int>;
+
+  VectorT MakeRandom(size_t size, std::uint32_t seed)
+  {
+    VectorT vector(size);
+    for (auto& elem : vector) {
+      seed = seed * 1664525u + 1013904223u;
+      elem = static_cast<int>(seed >> 12) % 1000;
+    }
+    return vector;
+  }
+
+  // Small grains make every algorithm split many times even on short input.
+  constexpr size_t grains[] = { 1, 7, 64, 0 };
+
+  TEST(Parallel, ForEachVisitsEveryElementOnce)
+  {
+    ftl::thread_pool pool(4);
+    for (size_t grain : grains) {
+      VectorT vector(1000, 1);
+      ftl::parallel::for_each(pool, vector.begin(), vector.end(),
+          [](int& elem) { elem *= 3; }, grain);
+      EXPECT_EQ(std::count(vector.begin(), vector.end(), 3), 1000) << grain;
+    }
+    VectorT vector(5000, 2);
+    ftl::parallel::for_each(vector.begin(), vector.end(),
+        [](int& elem) { ++elem; });
+    EXPECT_EQ(std::count(vector.begin(), vector.end(), 3), 5000);
+  }
+
+  TEST(Parallel, TransformIntoOtherAndSameRange)
+  {
+    ftl::thread_pool pool(4);
+    for (size_t grain : grains) {
+      const VectorT source = MakeRandom(777, 1);
+      ftl::vector<double> halves(source.size());
+      auto end = ftl::parallel::transform(pool, source.begin(), source.end(),
+          halves.begin(), [](int x) { return x / 2.0; }, grain);
+      EXPECT_EQ(end, halves.end());
+      for (size_t i = 0; i != source.size(); ++i) {
+        ASSERT_EQ(halves[i], source[i] / 2.0) << grain;
+      }
+
+      VectorT in_place(source);
+      ftl::parallel::transform(pool, in_place.begin(), in_place.end(),
+          in_place.begin(), [](int x) { return -x; }, grain);
+      for (size_t i = 0; i != source.size(); ++i) {
+        ASSERT_EQ(in_place[i], -source[i]) << grain;
+      }
+    }
+  }
+
+  TEST(Parallel, ReduceKeepsElementOrder)
+  {
+    ftl::thread_pool pool(4);
+    const VectorT numbers = MakeRandom(10000, 2);
+    ftl::vector<std::string> letters;
+    for (int i = 0; i != 300; ++i) {
+      letters.push_back(std::string(1, static_cast<char>('a' + i % 26)));
+    }
+    const std::string expected =
+        std::accumulate(letters.begin(), letters.end(), std::string(">"));
+    for (size_t grain : grains) {
+      EXPECT_EQ(ftl::parallel::reduce(pool, numbers.begin(), numbers.end(),
+                    10L, std::plus<>(), grain),
+          std::accumulate(numbers.begin(), numbers.end(), 10L));
+      EXPECT_EQ(ftl::parallel::reduce(pool, letters.begin(), letters.end(),
+                    std::string(">"), std::plus<>(), grain),
+          expected);
+    }
+    EXPECT_EQ(ftl::parallel::reduce(numbers.begin(), numbers.begin(), 5), 5);
+  }
+
+  TEST(Parallel, InclusiveScanMatchesPartialSum)
+  {
+    ftl::thread_pool pool(4);
+    for (size_t size : { 1, 2, 63, 64, 65, 1000, 4097 }) {
+      const VectorT source = MakeRandom(size, 3);
+      VectorT expected(size);
+      std::partial_sum(source.begin(), source.end(), expected.begin());
+      for (size_t grain : grains) {
+        VectorT result(size);
+        auto end = ftl::parallel::inclusive_scan(pool, source.begin(),
+            source.end(), result.begin(), std::plus<>(), grain);
+        EXPECT_EQ(end, result.end());
+        EXPECT_EQ(result, expected) << size << ' ' << grain;
+
+        VectorT in_place(source);
+        ftl::parallel::inclusive_scan(pool, in_place.begin(), in_place.end(),
+            in_place.begin(), std::plus<>(), grain);
+        EXPECT_EQ(in_place, expected) << size << ' ' << grain;
+      }
+    }
+  }
+
+  TEST(Parallel, SortMatchesStdSort)
+  {
+    ftl::thread_pool pool(4);
+    for (size_t size : { 0, 1, 2, 3, 100, 1000, 5003 }) {
+      for (size_t grain : grains) {
+        VectorT vector = MakeRandom(size, static_cast<std::uint32_t>(size));
+        VectorT expected(vector);
+        std::sort(expected.begin(), expected.end());
+        ftl::parallel::sort(pool, vector.begin(), vector.end(), std::less<>(),
+            grain);
+        EXPECT_EQ(vector, expected) << size << ' ' << grain;
+      }
+    }
+    VectorT descending = MakeRandom(20000, 4);
+    ftl::parallel::sort(descending.begin(), descending.end(),
+        std::greater<>());
+    EXPECT_TRUE(std::is_sorted(descending.begin(), descending.end(),
+        std::greater<>()));
+  }
+
+  TEST(Parallel, SortMoveOnlyElements)
+  {
+    ftl::thread_pool pool(3);
+    const VectorT keys = MakeRandom(2000, 5);
+    ftl::vector<std::unique_ptr<int>> vector;
+    for (int key : keys) {
+      vector.push_back(std::make_unique<int>(key));
+    }
+    ftl::parallel::sort(pool, vector.begin(), vector.end(),
+        [](const std::unique_ptr<int>& l, const std::unique_ptr<int>& r) {
+          return *l < *r;
+        },
+        16);
+    VectorT expected(keys);
+    std::sort(expected.begin(), expected.end());
+    for (size_t i = 0; i != expected.size(); ++i) {
+      ASSERT_NE(vector[i], nullptr);
+      ASSERT_EQ(*vector[i], expected[i]);
+    }
+  }
+
+  TEST(Parallel, RemoveIfKeepsOrderOfTheRest)
+  {
+    ftl::thread_pool pool(4);
+    auto is_odd = [](int x) { return x % 2 != 0; };
+    for (size_t size : { 0, 1, 10, 999, 4000 }) {
+      for (size_t grain : grains) {
+        VectorT vector = MakeRandom(size, 6);
+        VectorT expected(vector);
+        expected.erase(std::remove_if(expected.begin(), expected.end(), is_odd),
+            expected.end());
+        auto end = ftl::parallel::remove_if(pool, vector.begin(), vector.end(),
+            is_odd, grain);
+        vector.erase(end, vector.end());
+        EXPECT_EQ(vector, expected) << size << ' ' << grain;
+      }
+    }
+
+    ftl::vector<std::string> words{ "keep", "", "these", "", "", "words" };
+    auto end = ftl::parallel::remove_if(pool, words.begin(), words.end(),
+        [](const std::string& word) { return word.empty(); }, 1);
+    words.erase(end, words.end());
+    EXPECT_EQ(words, (ftl::vector<std::string>{ "keep", "these", "words" }));
+  }
+
+  TEST(Parallel, ExceptionsReachTheCaller)
+  {
+    ftl::thread_pool pool(4);
+    VectorT vector(1000, 0);
+    vector[617] = 1;
+    EXPECT_THROW(ftl::parallel::for_each(pool, vector.begin(), vector.end(),
+                     [](int elem) {
+                       if (elem == 1) {
+                         throw std::runtime_error("bad element");
+                       }
+                     },
+                     8),
+        std::runtime_error);
+    EXPECT_EQ(ftl::parallel::reduce(pool, vector.begin(), vector.end(), 0,
+                  std::plus<>(), 8),
+        1);
+  }
+
+  TEST(Parallel, CallableFromInsideThePool)
+  {
+    ftl::thread_pool pool(2);
+    auto sorted = pool.submit([&pool] {
+      VectorT vector = MakeRandom(3000, 7);
+      ftl::parallel::sort(pool, vector.begin(), vector.end(), std::less<>(),
+          32);
+      return std::is_sorted(vector.begin(), vector.end());
+    });
+    EXPECT_TRUE(sorted.get());
+  }
+}
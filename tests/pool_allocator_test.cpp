@@ -0,0 +1,160 @@
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  template <typename T>
+  using PoolVectorT = ftl::vector<T, ftl::pool_allocator<T>>;
+
+  struct alignas(64) OverAligned
+  {
+    unsigned char bytes[64];
+  };
+
+  TEST(PoolAllocator, ReusesFreedBlocks)
+  {
+    ftl::pool_allocator<int> allocator;
+    int* first = allocator.allocate(10);
+    allocator.deallocate(first, 10);
+    int* second = allocator.allocate(12);
+    EXPECT_EQ(first, second);
+    allocator.deallocate(second, 12);
+  }
+
+  TEST(PoolAllocator, SizeClassesAndAlignment)
+  {
+    ftl::pool_allocator<unsigned char> allocator;
+    std::vector<std::pair<unsigned char*, size_t>> blocks;
+    for (size_t bytes = 1; bytes <= 8192; bytes = bytes * 3 / 2 + 1) {
+      unsigned char* p = allocator.allocate(bytes);
+      EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) %
+              alignof(std::max_align_t),
+          0);
+      std::fill(p, p + bytes, static_cast<unsigned char>(bytes));
+      blocks.emplace_back(p, bytes);
+    }
+    for (auto& block : blocks) {
+      for (size_t i = 0; i != block.second; ++i) {
+        ASSERT_EQ(block.first[i], static_cast<unsigned char>(block.second));
+      }
+      allocator.deallocate(block.first, block.second);
+    }
+
+    ftl::pool_allocator<OverAligned> over_aligned;
+    OverAligned* p = over_aligned.allocate(3);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % 64, 0);
+    over_aligned.deallocate(p, 3);
+  }
+
+  TEST(PoolAllocator, VectorUsesWholeSizeClass)
+  {
+    PoolVectorT<int> vector;
+    vector.push_back(1);
+    EXPECT_EQ(vector.capacity(), ftl::detail::pool_min_block / sizeof(int));
+    for (int i = 2; i <= 1000; ++i) {
+      vector.push_back(i);
+    }
+    EXPECT_EQ(vector.front(), 1);
+    EXPECT_EQ(vector.back(), 1000);
+
+    PoolVectorT<std::string> strings{ "a", "b" };
+    PoolVectorT<std::string> moved;
+    moved = std::move(strings);
+    EXPECT_EQ(moved.size(), 2);
+    EXPECT_TRUE(strings.empty());
+  }
+
+  TEST(PoolAllocator, ConcurrentChurn)
+  {
+    const unsigned thread_count =
+        std::max(4u, std::thread::hardware_concurrency());
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t != thread_count; ++t) {
+      threads.emplace_back([t, &failed] {
+        for (int round = 0; round != 2000; ++round) {
+          PoolVectorT<unsigned> vector;
+          const unsigned count = (round * 7 + t) % 300;
+          for (unsigned i = 0; i != count; ++i) {
+            vector.push_back(t ^ i);
+          }
+          for (unsigned i = 0; i != count; ++i) {
+            if (vector[i] != (t ^ i)) {
+              failed = true;
+            }
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_FALSE(failed);
+  }
+
+  // Blocks allocated on producer threads are freed on consumer threads, so
+  // they have to travel back through the depot.
+  TEST(PoolAllocator, CrossThreadDeallocation)
+  {
+    using BlockT = PoolVectorT<size_t>;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<BlockT> queue;
+    constexpr int Producers = 4;
+    constexpr int PerProducer = 5000;
+    std::atomic<int> consumed(0);
+    std::atomic<bool> failed(false);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p != Producers; ++p) {
+      threads.emplace_back([&, p] {
+        for (int i = 0; i != PerProducer; ++i) {
+          BlockT block(static_cast<size_t>(i % 64 + 1), p * PerProducer + i);
+          std::lock_guard<std::mutex> lock(mutex);
+          queue.push_back(std::move(block));
+          ready.notify_one();
+        }
+      });
+    }
+    for (int c = 0; c != Producers; ++c) {
+      threads.emplace_back([&] {
+        for (;;) {
+          BlockT block;
+          {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&] {
+              return !queue.empty() || consumed == Producers * PerProducer;
+            });
+            if (queue.empty()) {
+              return;
+            }
+            block = std::move(queue.front());
+            queue.pop_front();
+          }
+          for (size_t value : block) {
+            if (value != block.front()) {
+              failed = true;
+            }
+          }
+          if (++consumed == Producers * PerProducer) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.notify_all();
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_FALSE(failed);
+    EXPECT_EQ(consumed, Producers * PerProducer);
+  }
+}
@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  using VectorT = ftl::segmented_vector<int, 8>;
+
+  // Neither copyable nor movable, like a mutex-holding record.
+  struct Pinned
+  {
+    explicit Pinned(int v) : value(v) {}
+    Pinned(const Pinned&) = delete;
+    Pinned& operator=(const Pinned&) = delete;
+
+    int value;
+    std::mutex mutex;
+  };
+
+  struct Counted
+  {
+    static int live;
+    static int throw_at;
+
+    int value;
+
+    Counted(int v) : value(v)
+    {
+      if (v == throw_at) {
+        throw std::runtime_error("throw_at");
+      }
+      ++live;
+    }
+    Counted(const Counted& rhs) : Counted(rhs.value) {}
+    ~Counted() { --live; }
+  };
+
+  int Counted::live = 0;
+  int Counted::throw_at = -1;
+
+  TEST(SegmentedVector, DefaultSegmentSizeFitsAPage)
+  {
+    EXPECT_EQ(ftl::segmented_vector<char>::segment_size, 4096u);
+    EXPECT_EQ(ftl::segmented_vector<int>::segment_size, 1024u);
+    EXPECT_EQ((ftl::segmented_vector<char[1000]>::segment_size), 16u);
+  }
+
+  TEST(SegmentedVector, PushBackAndIndex)
+  {
+    VectorT vector;
+    EXPECT_TRUE(vector.empty());
+    for (int i = 0; i < 100; ++i) {
+      vector.push_back(i);
+    }
+    ASSERT_EQ(vector.size(), 100u);
+    EXPECT_EQ(vector.capacity(), 104u);
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_EQ(vector[static_cast<size_t>(i)], i);
+    }
+    EXPECT_EQ(vector.front(), 0);
+    EXPECT_EQ(vector.back(), 99);
+    EXPECT_EQ(vector.at(42), 42);
+    EXPECT_THROW(vector.at(100), std::out_of_range);
+  }
+
+  TEST(SegmentedVector, AppendingKeepsAddresses)
+  {
+    ftl::segmented_vector<Pinned, 4> vector;
+    Pinned& first = vector.emplace_back(1);
+    const Pinned* addresses[50];
+    addresses[0] = &first;
+    for (int i = 1; i < 50; ++i) {
+      addresses[i] = &vector.emplace_back(i + 1);
+    }
+    for (size_t i = 0; i < 50; ++i) {
+      ASSERT_EQ(&vector[i], addresses[i]);
+      ASSERT_EQ(vector[i].value, static_cast<int>(i + 1));
+    }
+    EXPECT_EQ(first.value, 1);
+  }
+
+  TEST(SegmentedVector, IteratorsAndAlgorithms)
+  {
+    VectorT vector(30);
+    std::iota(vector.begin(), vector.end(), 0);
+    EXPECT_EQ(std::accumulate(vector.cbegin(), vector.cend(), 0), 435);
+    EXPECT_EQ(vector.end() - vector.begin(), 30);
+    std::reverse(vector.begin(), vector.end());
+    EXPECT_EQ(vector.front(), 29);
+    std::sort(vector.begin(), vector.end());
+    EXPECT_TRUE(std::is_sorted(vector.begin(), vector.end()));
+    EXPECT_EQ(*vector.rbegin(), 29);
+    VectorT::const_iterator it = vector.begin() + 5;
+    EXPECT_EQ(*it, 5);
+    EXPECT_EQ(it[3], 8);
+  }
+
+  TEST(SegmentedVector, ForEachSegmentCoversElementsInOrder)
+  {
+    VectorT vector(21, 1);
+    size_t segments = 0;
+    int next = 0;
+    vector.for_each_segment([&](int* first, int* last) {
+      EXPECT_LE(last - first, 8);
+      for (; first != last; ++first) {
+        *first = next++;
+      }
+      ++segments;
+    });
+    EXPECT_EQ(segments, 3u);
+    EXPECT_EQ(next, 21);
+    const VectorT& view = vector;
+    long sum = 0;
+    view.for_each_segment([&](const int* first, const int* last) {
+      sum = std::accumulate(first, last, sum);
+    });
+    EXPECT_EQ(sum, 210);
+  }
+
+  TEST(SegmentedVector, ResizeReserveAndShrink)
+  {
+    VectorT vector;
+    vector.reserve(20);
+    EXPECT_EQ(vector.capacity(), 24u);
+    vector.resize(10, 7);
+    EXPECT_EQ(std::count(vector.begin(), vector.end(), 7), 10);
+    vector.resize(3);
+    EXPECT_EQ(vector.size(), 3u);
+    vector.resize(5);
+    EXPECT_EQ(vector[4], 0);
+    vector.push_back(9);
+    vector.push_back(9);
+    vector.push_back(9);
+    vector.pop_back();
+    vector.pop_back();
+    EXPECT_EQ(vector.size(), 6u);
+    EXPECT_EQ(vector.back(), 9);
+    vector.shrink_to_fit();
+    EXPECT_EQ(vector.capacity(), 8u);
+    vector.clear();
+    EXPECT_EQ(vector.capacity(), 8u);
+    vector.shrink_to_fit();
+    EXPECT_EQ(vector.capacity(), 0u);
+  }
+
+  TEST(SegmentedVector, CopyMoveSwapAndCompare)
+  {
+    VectorT vector{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    VectorT copy(vector);
+    EXPECT_EQ(copy, vector);
+    copy.back() = 11;
+    EXPECT_NE(copy, vector);
+    EXPECT_LT(vector, copy);
+    EXPECT_GE(copy, vector);
+
+    VectorT moved(std::move(copy));
+    EXPECT_TRUE(copy.empty());
+    EXPECT_EQ(moved.back(), 11);
+
+    copy = vector;
+    EXPECT_EQ(copy, vector);
+    moved = std::move(copy);
+    EXPECT_EQ(moved, vector);
+
+    VectorT other{ 42 };
+    swap(other, moved);
+    EXPECT_EQ(other, vector);
+    EXPECT_EQ(moved, VectorT{ 42 });
+
+    other = { 3, 2, 1 };
+    EXPECT_EQ(other.size(), 3u);
+    EXPECT_EQ(other[2], 1);
+  }
+
+  TEST(SegmentedVector, ConstructorExceptionsLeakNothing)
+  {
+    Counted::throw_at = 13;
+    const int values[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14 };
+    using CountedVector = ftl::segmented_vector<Counted, 4>;
+    EXPECT_THROW(CountedVector(std::begin(values), std::end(values)),
+        std::runtime_error);
+    EXPECT_EQ(Counted::live, 0);
+
+    CountedVector vector(std::begin(values), std::begin(values) + 12);
+    EXPECT_EQ(Counted::live, 12);
+    EXPECT_THROW(vector.emplace_back(13), std::runtime_error);
+    EXPECT_EQ(vector.size(), 12u);
+    Counted::throw_at = 7;
+    EXPECT_THROW(CountedVector copy(vector), std::runtime_error);
+    EXPECT_EQ(Counted::live, 12);
+    Counted::throw_at = -1;
+    vector.clear();
+    EXPECT_EQ(Counted::live, 0);
+  }
+}
@@ -0,0 +1,186 @@
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+#if defined(FTL_POSIX_FEATURES)
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+namespace test {
+  struct Record
+  {
+    std::uint32_t id;
+    float score;
+    std::uint16_t tags[3];
+  };
+
+  std::string Serialized(const ftl::vector<int>& v, bool checksum)
+  {
+    std::ostringstream os;
+    ftl::serialize(os, v, checksum);
+    return os.str();
+  }
+
+  TEST(Serialize, Crc32cCheckValue)
+  {
+    EXPECT_EQ(ftl::detail::crc32c(0, "123456789", 9), 0xe3069283u);
+    const std::uint32_t head = ftl::detail::crc32c(0, "1234", 4);
+    EXPECT_EQ(ftl::detail::crc32c(head, "56789", 5), 0xe3069283u);
+  }
+
+  TEST(Serialize, HeaderLayout)
+  {
+    const std::string bytes = Serialized({1, 2, 3}, false);
+    ASSERT_EQ(bytes.size(), 32 + 8 + 3 * sizeof(int));
+    EXPECT_EQ(bytes.substr(0, 4), "FTLV");
+    EXPECT_EQ(bytes[4], 1);
+    EXPECT_EQ(bytes[8], static_cast<char>(sizeof(int)));
+    EXPECT_EQ(bytes[16], 8 + 3 * sizeof(int));
+    EXPECT_EQ(bytes[32], 3);
+  }
+
+  TEST(Serialize, RoundTripRecords)
+  {
+    ftl::vector<Record> records;
+    for (std::uint32_t i = 0; i != 1000; ++i) {
+      records.push_back(Record{i, i * 0.5f, {1, 2, 3}});
+    }
+    std::stringstream stream;
+    ftl::serialize(stream, records);
+
+    ftl::vector<Record> read{Record{}};
+    ftl::deserialize(stream, read);
+    ASSERT_EQ(read.size(), records.size());
+    for (std::size_t i = 0; i != read.size(); ++i) {
+      ASSERT_EQ(read[i].id, records[i].id);
+      ASSERT_EQ(read[i].score, records[i].score);
+      ASSERT_EQ(read[i].tags[2], 3);
+    }
+  }
+
+  TEST(Serialize, RoundTripEmpty)
+  {
+    std::stringstream stream;
+    ftl::serialize(stream, ftl::vector<double>());
+    ftl::vector<double> read{1.0, 2.0};
+    ftl::deserialize(stream, read);
+    EXPECT_TRUE(read.empty());
+  }
+
+  TEST(Serialize, RoundTripNested)
+  {
+    ftl::vector<ftl::vector<ftl::vector<std::int16_t>>> nested(3);
+    nested[0].resize(2);
+    nested[0][1] = {1, 2, 3};
+    nested[2].push_back({});
+    nested[2].push_back({-7});
+    std::stringstream stream;
+    ftl::serialize(stream, nested, true);
+
+    decltype(nested) read;
+    ftl::deserialize(stream, read);
+    EXPECT_EQ(read, nested);
+  }
+
+  TEST(Serialize, ChecksumDetectsCorruption)
+  {
+    ftl::vector<int> v(100, 5);
+    std::string bytes = Serialized(v, true);
+    {
+      std::istringstream is(bytes);
+      ftl::vector<int> read;
+      ftl::deserialize(is, read);
+      EXPECT_EQ(read, v);
+    }
+    bytes[100] ^= 1;
+    std::istringstream is(bytes);
+    ftl::vector<int> read{1, 2};
+    EXPECT_THROW(ftl::deserialize(is, read), std::runtime_error);
+    EXPECT_TRUE(read.empty());
+  }
+
+  TEST(Serialize, RejectsMalformedInput)
+  {
+    const std::string bytes = Serialized({1, 2, 3}, false);
+    ftl::vector<int> read;
+
+    std::istringstream truncated(bytes.substr(0, bytes.size() - 1));
+    EXPECT_THROW(ftl::deserialize(truncated, read), std::runtime_error);
+
+    std::string magic = bytes;
+    magic[0] = 'X';
+    std::istringstream bad_magic(magic);
+    EXPECT_THROW(ftl::deserialize(bad_magic, read), std::runtime_error);
+
+    std::string version = bytes;
+    version[4] = 2;
+    std::istringstream bad_version(version);
+    EXPECT_THROW(ftl::deserialize(bad_version, read), std::runtime_error);
+
+    std::string count = bytes;
+    count[39] = 0x10;
+    std::istringstream huge_count(count);
+    EXPECT_THROW(ftl::deserialize(huge_count, read), std::runtime_error);
+
+    std::istringstream wrong_type(bytes);
+    ftl::vector<std::int64_t> longs;
+    EXPECT_THROW(ftl::deserialize(wrong_type, longs), std::runtime_error);
+  }
+
+  void StoreLittleEndian(std::string& bytes, size_t offset, std::uint64_t value)
+  {
+    for (size_t i = 0; i != 8; ++i) {
+      bytes[offset + i] = static_cast<char>(value >> (8 * i));
+    }
+  }
+
+  TEST(Serialize, CorruptHeaderDoesNotAllocatePayload)
+  {
+    std::string bytes = Serialized({1, 2, 3}, false).substr(0, 40);
+    StoreLittleEndian(bytes, 16, std::uint64_t(1) << 62);
+    StoreLittleEndian(bytes, 32, std::uint64_t(1) << 59);
+    std::istringstream is(bytes);
+    ftl::vector<int> read{1, 2};
+    EXPECT_THROW(ftl::deserialize(is, read), std::runtime_error);
+    EXPECT_TRUE(read.empty());
+    EXPECT_LE(read.capacity(), (1u << 20) / sizeof(int));
+
+    std::ostringstream os;
+    ftl::serialize(os, ftl::vector<ftl::vector<int>>{{1}, {2, 3}});
+    std::string nested = os.str().substr(0, 40);
+    StoreLittleEndian(nested, 16, std::uint64_t(1) << 62);
+    StoreLittleEndian(nested, 32, std::uint64_t(1) << 59);
+    std::istringstream nested_is(nested);
+    ftl::vector<ftl::vector<int>> nested_read;
+    EXPECT_THROW(ftl::deserialize(nested_is, nested_read), std::runtime_error);
+    EXPECT_TRUE(nested_read.empty());
+  }
+
+#if defined(FTL_POSIX_FEATURES)
+  TEST(Serialize, FileDescriptorRoundTrip)
+  {
+    char name[] = "/tmp/ftl_serialize_XXXXXX";
+    const int fd = ::mkstemp(name);
+    ASSERT_NE(fd, -1);
+
+    ftl::vector<ftl::vector<std::uint64_t>> v(3000);
+    for (std::size_t i = 0; i != v.size(); ++i) {
+      v[i].resize(i % 7, i);
+    }
+    ftl::serialize(fd, v, true);
+    ASSERT_EQ(::lseek(fd, 0, SEEK_SET), 0);
+
+    decltype(v) read;
+    ftl::deserialize(fd, read);
+    EXPECT_EQ(read, v);
+    EXPECT_THROW(ftl::deserialize(fd, read), std::runtime_error);
+    ::close(fd);
+    std::remove(name);
+  }
+#endif
+}
@@ -0,0 +1,371 @@
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  struct AllocationCounter
+  {
+    size_t allocations = 0;
+    size_t deallocations = 0;
+  };
+
+  template <typename T>
+  class CountingAllocator
+  {
+  public:
+    using value_type = T;
+
+    explicit CountingAllocator(AllocationCounter* counter) : counter_(counter)
+    {
+    }
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) :
+      counter_(other.counter())
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+      ++counter_->allocations;
+      return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+      ++counter_->deallocations;
+      std::allocator<T>().deallocate(p, n);
+    }
+
+    AllocationCounter* counter() const { return counter_; }
+
+    friend bool operator==(const CountingAllocator& lhs,
+        const CountingAllocator& rhs)
+    {
+      return lhs.counter_ == rhs.counter_;
+    }
+
+    friend bool operator!=(const CountingAllocator& lhs,
+        const CountingAllocator& rhs)
+    {
+      return !(lhs == rhs);
+    }
+
+  private:
+    AllocationCounter* counter_;
+  };
+
+  constexpr size_t InlineSize = 8;
+  using SmallVectorT = ftl::small_vector<int, InlineSize>;
+  using SmallStringVectorT = ftl::small_vector<std::string, 4>;
+
+  template <typename Vector>
+  bool StoresInline(const Vector& vector)
+  {
+    auto object = reinterpret_cast<const unsigned char*>(&vector);
+    auto data = reinterpret_cast<const unsigned char*>(vector.data());
+    return data >= object && data < object + sizeof(vector);
+  }
+
+  std::string LongString(int i)
+  {
+    return std::to_string(i) + std::string(32, '#');
+  }
+
+  TEST(SmallVector, Layout)
+  {
+    EXPECT_EQ(sizeof(SmallVectorT),
+        3 * sizeof(int*) + InlineSize * sizeof(int));
+    EXPECT_EQ(SmallVectorT::inline_capacity(), InlineSize);
+  }
+
+  TEST(SmallVector, DefaultIsInline)
+  {
+    SmallVectorT vector;
+    EXPECT_TRUE(vector.empty());
+    EXPECT_TRUE(vector.is_inline());
+    EXPECT_TRUE(StoresInline(vector));
+    EXPECT_EQ(vector.capacity(), InlineSize);
+  }
+
+  TEST(SmallVector, NoAllocationUpToInlineCapacity)
+  {
+    AllocationCounter counter;
+    ftl::small_vector<int, InlineSize, CountingAllocator<int>> vector(
+        CountingAllocator<int>{ &counter });
+    for (int i = 0; i != static_cast<int>(InlineSize); ++i) {
+      vector.push_back(i);
+    }
+    EXPECT_EQ(counter.allocations, 0);
+    EXPECT_TRUE(vector.is_inline());
+    vector.push_back(8);
+    EXPECT_EQ(counter.allocations, 1);
+    EXPECT_FALSE(vector.is_inline());
+    EXPECT_FALSE(StoresInline(vector));
+    for (int i = 0; i != 9; ++i) {
+      EXPECT_EQ(vector[i], i);
+    }
+  }
+
+  TEST(SmallVector, InlineToHeapTransition)
+  {
+    SmallStringVectorT vector;
+    std::vector<std::string> expected;
+    for (int i = 0; i != 20; ++i) {
+      vector.push_back(LongString(i));
+      expected.push_back(LongString(i));
+      EXPECT_EQ(vector.is_inline(), vector.size() <= 4);
+      ASSERT_TRUE(std::equal(vector.begin(), vector.end(), expected.begin(),
+          expected.end()));
+    }
+  }
+
+  TEST(SmallVector, ShrinkToFitReturnsInline)
+  {
+    SmallStringVectorT vector;
+    for (int i = 0; i != 10; ++i) {
+      vector.emplace_back(LongString(i));
+    }
+    vector.erase(vector.begin() + 2, vector.end());
+    EXPECT_FALSE(vector.is_inline());
+    vector.shrink_to_fit();
+    EXPECT_TRUE(vector.is_inline());
+    EXPECT_EQ(vector.capacity(), 4);
+    EXPECT_TRUE(vector == SmallStringVectorT({ LongString(0), LongString(1) }));
+
+    SmallVectorT ints(100, 1);
+    ints.resize(3);
+    ints.shrink_to_fit();
+    EXPECT_TRUE(ints.is_inline());
+    EXPECT_TRUE(ints == SmallVectorT({ 1, 1, 1 }));
+  }
+
+  TEST(SmallVector, MoveInline)
+  {
+    SmallStringVectorT source{ LongString(1), LongString(2) };
+    SmallStringVectorT moved(std::move(source));
+    EXPECT_TRUE(moved.is_inline());
+    EXPECT_TRUE(source.empty());
+    EXPECT_TRUE(moved == SmallStringVectorT({ LongString(1), LongString(2) }));
+
+    SmallStringVectorT assigned{ LongString(3) };
+    assigned = std::move(moved);
+    EXPECT_TRUE(moved.empty());
+    EXPECT_TRUE(
+        assigned == SmallStringVectorT({ LongString(1), LongString(2) }));
+  }
+
+  TEST(SmallVector, MoveHeapStealsBlock)
+  {
+    SmallVectorT source(50);
+    std::iota(source.begin(), source.end(), 0);
+    auto data = source.data();
+    SmallVectorT moved(std::move(source));
+    EXPECT_EQ(moved.data(), data);
+    EXPECT_TRUE(source.empty());
+    EXPECT_TRUE(source.is_inline());
+    EXPECT_EQ(moved.size(), 50);
+    EXPECT_EQ(moved.back(), 49);
+  }
+
+  TEST(SmallVector, SwapMixed)
+  {
+    SmallStringVectorT small{ "a", "b" };
+    SmallStringVectorT large;
+    for (int i = 0; i != 10; ++i) {
+      large.push_back(LongString(i));
+    }
+    const SmallStringVectorT small_copy = small;
+    const SmallStringVectorT large_copy = large;
+    small.swap(large);
+    EXPECT_TRUE(small == large_copy);
+    EXPECT_TRUE(large == small_copy);
+    EXPECT_TRUE(large.is_inline());
+    swap(small, large);
+    EXPECT_TRUE(small == small_copy);
+    EXPECT_TRUE(large == large_copy);
+  }
+
+  TEST(SmallVector, CopyAndAssign)
+  {
+    SmallVectorT source{ 1, 2, 3 };
+    SmallVectorT copy(source);
+    EXPECT_TRUE(copy == source);
+    EXPECT_TRUE(copy.is_inline());
+    SmallVectorT large(40, 7);
+    copy = large;
+    EXPECT_TRUE(copy == large);
+    copy = source;
+    EXPECT_TRUE(copy == source);
+  }
+
+  TEST(SmallVector, InsertAcrossTransition)
+  {
+    for (size_t count : { 1, 2, 5, 12 }) {
+      for (size_t shift = 0; shift <= 3; ++shift) {
+        SmallStringVectorT vector{ "x", "y", "z" };
+        std::vector<std::string> expected{ "x", "y", "z" };
+        std::vector<std::string> values;
+        for (size_t i = 0; i != count; ++i) {
+          values.push_back(LongString(i));
+        }
+        vector.insert(vector.cbegin() + shift, values.begin(), values.end());
+        expected.insert(expected.begin() + shift, values.begin(),
+            values.end());
+        ASSERT_TRUE(std::equal(vector.begin(), vector.end(),
+            expected.begin(), expected.end()));
+
+        vector.insert(vector.cbegin() + shift, count, "fill");
+        expected.insert(expected.begin() + shift, count, "fill");
+        ASSERT_TRUE(std::equal(vector.begin(), vector.end(),
+            expected.begin(), expected.end()));
+      }
+    }
+  }
+
+  TEST(SmallVector, EmplaceWhenFull)
+  {
+    SmallStringVectorT vector{ "a", "b", "c", "d" };
+    auto it = vector.emplace(vector.cbegin() + 1, vector[3]);
+    EXPECT_EQ(it, vector.begin() + 1);
+    EXPECT_FALSE(vector.is_inline());
+    EXPECT_TRUE(vector == SmallStringVectorT({ "a", "d", "b", "c", "d" }));
+  }
+
+  TEST(SmallVector, EraseAndResize)
+  {
+    SmallVectorT vector(20);
+    std::iota(vector.begin(), vector.end(), 0);
+    vector.erase(vector.begin(), vector.begin() + 15);
+    EXPECT_TRUE(vector == SmallVectorT({ 15, 16, 17, 18, 19 }));
+    vector.resize(2);
+    vector.resize(4, 9);
+    EXPECT_TRUE(vector == SmallVectorT({ 15, 16, 9, 9 }));
+    vector.resize_for_overwrite(6);
+    EXPECT_EQ(vector.size(), 6);
+  }
+
+  TEST(SmallVector, AtOutOfRange)
+  {
+    SmallVectorT vector{ 1 };
+    EXPECT_EQ(vector.at(0), 1);
+    EXPECT_THROW(vector.at(1), std::out_of_range);
+  }
+
+  TEST(SmallVector, ZeroInlineCapacity)
+  {
+    ftl::small_vector<std::unique_ptr<int>, 0> vector;
+    EXPECT_EQ(vector.capacity(), 0);
+    for (int i = 0; i != 10; ++i) {
+      vector.push_back(std::make_unique<int>(i));
+    }
+    vector.erase(vector.begin());
+    EXPECT_EQ(*vector.front(), 1);
+    vector.clear();
+    vector.shrink_to_fit();
+    EXPECT_EQ(vector.capacity(), 0);
+  }
+
+  TEST(SmallVector, ComparisonAndHash)
+  {
+    SmallVectorT a{ 1, 2, 3 };
+    SmallVectorT b{ 1, 2, 4 };
+    EXPECT_TRUE(a < b);
+    EXPECT_FALSE(a == b);
+    b.back() = 3;
+    EXPECT_TRUE(a == b);
+    EXPECT_EQ(std::hash<SmallVectorT>{}(a), std::hash<SmallVectorT>{}(b));
+  }
+
+  template <typename T>
+  using ArenaSmallVectorT =
+      ftl::small_vector<T, 4, ftl::arena_allocator<T>>;
+
+  template <typename T>
+  bool IsInside(const T* p, const void* buffer, size_t size)
+  {
+    auto bytes = reinterpret_cast<const unsigned char*>(p);
+    auto begin = static_cast<const unsigned char*>(buffer);
+    return bytes >= begin && bytes < begin + size;
+  }
+
+  TEST(SmallVectorAllocator, MoveAssignmentBetweenArenas)
+  {
+    alignas(std::max_align_t) unsigned char first_buffer[4096];
+    alignas(std::max_align_t) unsigned char second_buffer[4096];
+    ftl::arena first_arena(first_buffer, sizeof(first_buffer));
+    ftl::arena second_arena(second_buffer, sizeof(second_buffer));
+    ArenaSmallVectorT<std::string> first(first_arena);
+    ArenaSmallVectorT<std::string> second(second_arena);
+    for (int i = 0; i != 10; ++i) {
+      second.push_back(LongString(i));
+    }
+    const ArenaSmallVectorT<std::string> expected(second);
+
+    first = std::move(second);
+    EXPECT_EQ(first.get_allocator().get_arena(), &first_arena);
+    EXPECT_EQ(second.get_allocator().get_arena(), &second_arena);
+    EXPECT_TRUE(IsInside(first.data(), first_buffer, sizeof(first_buffer)));
+    EXPECT_TRUE(first == expected);
+    EXPECT_TRUE(second.empty());
+
+    ArenaSmallVectorT<std::string> same(first_arena);
+    same.assign(expected.begin(), expected.end());
+    const std::string* data = same.data();
+    first = std::move(same);
+    EXPECT_EQ(first.data(), data);
+  }
+
+  TEST(SmallVectorAllocator, SwapBetweenArenas)
+  {
+    alignas(std::max_align_t) unsigned char first_buffer[4096];
+    alignas(std::max_align_t) unsigned char second_buffer[4096];
+    ftl::arena first_arena(first_buffer, sizeof(first_buffer));
+    ftl::arena second_arena(second_buffer, sizeof(second_buffer));
+    ArenaSmallVectorT<int> first(first_arena);
+    ArenaSmallVectorT<int> second(second_arena);
+    for (int i = 0; i != 20; ++i) {
+      first.push_back(i);
+      second.push_back(-i);
+    }
+    const ArenaSmallVectorT<int> first_copy(first);
+    const ArenaSmallVectorT<int> second_copy(second);
+
+    first.swap(second);
+    EXPECT_EQ(first.get_allocator().get_arena(), &first_arena);
+    EXPECT_EQ(second.get_allocator().get_arena(), &second_arena);
+    EXPECT_TRUE(IsInside(first.data(), first_buffer, sizeof(first_buffer)));
+    EXPECT_TRUE(IsInside(second.data(), second_buffer, sizeof(second_buffer)));
+    EXPECT_TRUE(first == second_copy);
+    EXPECT_TRUE(second == first_copy);
+
+    second.resize(2);
+    second.shrink_to_fit();
+    ASSERT_TRUE(second.is_inline());
+    swap(first, second);
+    EXPECT_TRUE(IsInside(first.data(), first_buffer, sizeof(first_buffer)));
+    EXPECT_TRUE(IsInside(second.data(), second_buffer, sizeof(second_buffer)));
+    EXPECT_TRUE(first == ArenaSmallVectorT<int>({ 0, 1 }, first_arena));
+    EXPECT_TRUE(second == second_copy);
+  }
+
+  TEST(SmallVectorAllocator, CopyAssignmentKeepsTargetArena)
+  {
+    ftl::arena first_arena;
+    ftl::arena second_arena;
+    ArenaSmallVectorT<std::string> first(first_arena);
+    ArenaSmallVectorT<std::string> second({ "a", "b", "c", "d", "e" },
+        second_arena);
+    ArenaSmallVectorT<std::string> copy(second);
+    EXPECT_EQ(copy.get_allocator().get_arena(), &second_arena);
+    first = second;
+    EXPECT_EQ(first.get_allocator().get_arena(), &first_arena);
+    EXPECT_TRUE(first == second);
+  }
+}
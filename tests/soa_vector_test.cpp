@@ -0,0 +1,196 @@
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  using ParticlesT = ftl::soa_vector<float, float, int>;
+
+  // Moves may throw, so growth copies it; the copy fails on request.
+  struct FragileCopy
+  {
+    static int copies_left;
+
+    int value;
+
+    FragileCopy(int v) : value(v) {}
+    FragileCopy(const FragileCopy& rhs) : value(rhs.value)
+    {
+      if (copies_left-- == 0) {
+        throw std::runtime_error("copy");
+      }
+    }
+    FragileCopy(FragileCopy&& rhs) noexcept(false) : value(rhs.value) {}
+  };
+
+  int FragileCopy::copies_left = -1;
+
+  bool IsAligned(const void* p, std::size_t alignment)
+  {
+    return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+  }
+
+  TEST(SoaVector, EmplaceBackAndRowAccess)
+  {
+    ParticlesT particles;
+    EXPECT_TRUE(particles.empty());
+    for (int i = 0; i < 100; ++i) {
+      particles.emplace_back(i * 0.5f, i * 2.0f, i);
+    }
+    particles.push_back(std::make_tuple(1.0f, 2.0f, 3));
+    ASSERT_EQ(particles.size(), 101u);
+    EXPECT_GE(particles.capacity(), 101u);
+    EXPECT_EQ(particles[10], std::make_tuple(5.0f, 20.0f, 10));
+    EXPECT_EQ(particles.back(), std::make_tuple(1.0f, 2.0f, 3));
+    EXPECT_EQ(std::get<2>(particles.front()), 0);
+    EXPECT_EQ(std::get<1>(particles.at(4)), 8.0f);
+    EXPECT_THROW(particles.at(101), std::out_of_range);
+
+    std::get<2>(particles[7]) = -1;
+    EXPECT_EQ(particles.data<2>()[7], -1);
+    particles.pop_back();
+    EXPECT_EQ(particles.size(), 100u);
+  }
+
+  TEST(SoaVector, ColumnsAreAlignedSpans)
+  {
+    ParticlesT particles(37);
+    EXPECT_TRUE(IsAligned(particles.data<0>(), 64));
+    EXPECT_TRUE(IsAligned(particles.data<1>(), 64));
+    EXPECT_TRUE(IsAligned(particles.data<2>(), 64));
+
+    auto ids = particles.column<2>();
+    ASSERT_EQ(ids.size(), 37u);
+    std::iota(ids.begin(), ids.end(), 0);
+    EXPECT_EQ(std::get<2>(particles[36]), 36);
+
+    const ParticlesT& view = particles;
+    auto xs = view.column<0>();
+    EXPECT_EQ(std::accumulate(xs.begin(), xs.end(), 0.0f), 0.0f);
+    EXPECT_EQ(view.column<2>()[5], 5);
+  }
+
+  TEST(SoaVector, ProxyIteration)
+  {
+    ParticlesT particles;
+    for (int i = 0; i < 50; ++i) {
+      particles.emplace_back(static_cast<float>(i), 1.0f, i);
+    }
+    for (auto row : particles) {
+      std::get<1>(row) = std::get<0>(row) * 2.0f;
+    }
+    for (auto it = particles.begin(); it < particles.end(); it += 7) {
+      *it = std::make_tuple(-1.0f, -1.0f, -1);
+    }
+    int minus_ones = 0;
+    for (ParticlesT::const_iterator it = particles.cbegin();
+         it != particles.cend(); ++it) {
+      const auto row = *it;
+      if (std::get<2>(row) == -1) {
+        ++minus_ones;
+      } else {
+        EXPECT_EQ(std::get<1>(row), std::get<0>(row) * 2.0f);
+      }
+    }
+    EXPECT_EQ(minus_ones, 8);
+    EXPECT_EQ(particles.end() - particles.begin(), 50);
+  }
+
+  TEST(SoaVector, NonTrivialColumnsSurviveGrowth)
+  {
+    ftl::soa_vector<std::string, std::unique_ptr<int>, double> rows;
+    for (int i = 0; i < 300; ++i) {
+      rows.emplace_back(std::to_string(i), std::make_unique<int>(i), i * 0.5);
+    }
+    for (int i = 0; i < 300; ++i) {
+      ASSERT_EQ(std::get<0>(rows[static_cast<size_t>(i)]), std::to_string(i));
+      ASSERT_EQ(*std::get<1>(rows[static_cast<size_t>(i)]), i);
+    }
+    rows.resize(10);
+    rows.shrink_to_fit();
+    EXPECT_EQ(rows.capacity(), 10u);
+    EXPECT_EQ(*std::get<1>(rows.back()), 9);
+    rows.clear();
+    rows.shrink_to_fit();
+    EXPECT_EQ(rows.capacity(), 0u);
+  }
+
+  TEST(SoaVector, EmplaceFromOwnElements)
+  {
+    ftl::soa_vector<std::string, int> rows;
+    rows.emplace_back(std::string(40, 'a'), 1);
+    while (rows.size() != rows.capacity()) {
+      rows.emplace_back(std::string(40, 'b'), 2);
+    }
+    rows.emplace_back(std::get<0>(rows[0]), std::get<1>(rows[0]));
+    EXPECT_EQ(std::get<0>(rows.back()), std::string(40, 'a'));
+    EXPECT_EQ(std::get<1>(rows.back()), 1);
+  }
+
+  TEST(SoaVector, ThrowingCopyConstructionReleasesStorage)
+  {
+    ftl::soa_vector<int, FragileCopy, std::string> rows;
+    for (int i = 0; i != 5; ++i) {
+      rows.emplace_back(i, i, std::string(40, 'x'));
+    }
+    FragileCopy::copies_left = 2;
+    EXPECT_THROW(
+        (ftl::soa_vector<int, FragileCopy, std::string>(rows)),
+        std::runtime_error);
+    FragileCopy::copies_left = -1;
+    ftl::soa_vector<int, FragileCopy, std::string> copy(rows);
+    EXPECT_EQ(copy.size(), rows.size());
+    EXPECT_EQ(std::get<1>(copy[4]).value, 4);
+  }
+
+  TEST(SoaVector, GrowthIsStronglyExceptionSafe)
+  {
+    ftl::soa_vector<int, FragileCopy, std::string> rows;
+    rows.emplace_back(0, 0, "zero");
+    while (rows.size() != rows.capacity()) {
+      rows.emplace_back(1, 1, "one");
+    }
+    const auto before = rows.size();
+    const int* ints = rows.data<0>();
+    FragileCopy::copies_left = 0;
+    EXPECT_THROW(rows.emplace_back(2, 2, "two"), std::runtime_error);
+    FragileCopy::copies_left = -1;
+    EXPECT_EQ(rows.size(), before);
+    EXPECT_EQ(rows.data<0>(), ints);
+    EXPECT_EQ(std::get<2>(rows[0]), "zero");
+    rows.emplace_back(2, 2, "two");
+    EXPECT_EQ(std::get<1>(rows.back()).value, 2);
+    EXPECT_EQ(std::get<2>(rows[0]), "zero");
+  }
+
+  TEST(SoaVector, CopyMoveSwapAndCompare)
+  {
+    ftl::soa_vector<int, std::string> rows;
+    for (int i = 0; i < 20; ++i) {
+      rows.emplace_back(i, std::to_string(i));
+    }
+    auto copy = rows;
+    EXPECT_EQ(copy, rows);
+    std::get<1>(copy[19]) = "changed";
+    EXPECT_NE(copy, rows);
+
+    auto moved = std::move(copy);
+    EXPECT_TRUE(copy.empty());
+    EXPECT_EQ(std::get<1>(moved.back()), "changed");
+    copy = rows;
+    EXPECT_EQ(copy, rows);
+    moved = std::move(copy);
+    EXPECT_EQ(moved, rows);
+
+    ftl::soa_vector<int, std::string> other;
+    other.emplace_back(-1, "other");
+    swap(other, moved);
+    EXPECT_EQ(other, rows);
+    EXPECT_EQ(moved.size(), 1u);
+  }
+}
@@ -0,0 +1,163 @@
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  struct ThrowingCopy
+  {
+    static int live;
+    int value;
+
+    ThrowingCopy(int value) : value(value) { ++live; }
+    ThrowingCopy(const ThrowingCopy& other) : value(other.value)
+    {
+      if (value < 0) {
+        throw std::runtime_error("copy");
+      }
+      ++live;
+    }
+    ~ThrowingCopy() { --live; }
+  };
+
+  int ThrowingCopy::live = 0;
+
+  template <typename Wait>
+  void TransferInOrder(std::size_t batch)
+  {
+    constexpr std::uint64_t count = 20000;
+    ftl::spsc_ring<std::uint64_t, Wait> ring(64);
+    std::thread producer([&ring, batch]() {
+      std::uint64_t values[16];
+      for (std::uint64_t i = 0; i < count; i += batch) {
+        const std::size_t n =
+            static_cast<std::size_t>(std::min<std::uint64_t>(batch, count - i));
+        std::iota(values, values + n, i);
+        if (n == 1) {
+          ring.push(values[0]);
+        } else {
+          ring.push_n(values, n);
+        }
+      }
+    });
+    std::uint64_t expected = 0;
+    std::uint64_t values[16];
+    while (expected != count) {
+      const std::size_t n = static_cast<std::size_t>(
+          std::min<std::uint64_t>(batch, count - expected));
+      if (n == 1) {
+        values[0] = ring.pop();
+      } else {
+        ring.pop_n(values, n);
+      }
+      for (std::size_t i = 0; i != n; ++i) {
+        ASSERT_EQ(values[i], expected++);
+      }
+    }
+    producer.join();
+    EXPECT_TRUE(ring.empty());
+  }
+
+  TEST(SpscRing, CapacityIsRoundedUp)
+  {
+    EXPECT_EQ(ftl::spsc_ring<int>(0).capacity(), 1);
+    EXPECT_EQ(ftl::spsc_ring<int>(5).capacity(), 8);
+    EXPECT_EQ(ftl::spsc_ring<int>(64).capacity(), 64);
+    EXPECT_THROW(ftl::spsc_ring<int>(ftl::spsc_ring<int>::max_size() + 1),
+        std::length_error);
+  }
+
+  TEST(SpscRing, PushAndPopSingle)
+  {
+    ftl::spsc_ring<std::string> ring(4);
+    EXPECT_TRUE(ring.empty());
+    for (int i = 0; i != 4; ++i) {
+      EXPECT_TRUE(ring.try_push(std::to_string(i)));
+    }
+    EXPECT_FALSE(ring.try_push("full"));
+    EXPECT_FALSE(ring.try_emplace(3, 'x'));
+    EXPECT_EQ(ring.size(), 4);
+
+    std::string value;
+    EXPECT_TRUE(ring.try_pop(value));
+    EXPECT_EQ(value, "0");
+    EXPECT_TRUE(ring.try_emplace(3, 'x'));
+    EXPECT_EQ(ring.pop(), "1");
+    EXPECT_EQ(ring.pop(), "2");
+    EXPECT_EQ(ring.pop(), "3");
+    EXPECT_EQ(ring.pop(), "xxx");
+    EXPECT_FALSE(ring.try_pop(value));
+  }
+
+  TEST(SpscRing, BatchesWrapAround)
+  {
+    ftl::spsc_ring<int> ring(8);
+    const int input[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    EXPECT_EQ(ring.try_push_n(input, 6), 6);
+    int output[10] = {};
+    EXPECT_EQ(ring.try_pop_n(output, 5), 5);
+    EXPECT_EQ(output[4], 4);
+
+    EXPECT_EQ(ring.try_push_n(input, 10), 7);
+    EXPECT_EQ(ring.try_push_n(input, 1), 0);
+    EXPECT_EQ(ring.size(), 8);
+    EXPECT_EQ(ring.try_pop_n(output, 10), 8);
+    EXPECT_EQ(output[0], 5);
+    for (int i = 1; i != 8; ++i) {
+      EXPECT_EQ(output[i], i - 1);
+    }
+    EXPECT_EQ(ring.try_pop_n(output, 10), 0);
+  }
+
+  TEST(SpscRing, DestroysRemainingElements)
+  {
+    auto counter = std::make_shared<int>();
+    {
+      ftl::spsc_ring<std::shared_ptr<int>> ring(4);
+      ring.push(counter);
+      ring.push(counter);
+      ring.pop();
+      ring.push(counter);
+      EXPECT_EQ(counter.use_count(), 3);
+    }
+    EXPECT_EQ(counter.use_count(), 1);
+  }
+
+  TEST(SpscRing, ThrowingCopyPushesNothing)
+  {
+    {
+      ftl::spsc_ring<ThrowingCopy> ring(4);
+      ring.push(ThrowingCopy(0));
+      ring.pop();
+      const ThrowingCopy input[] = {3, 4, 5, -1};
+      EXPECT_THROW(ring.try_push_n(input, 4), std::runtime_error);
+      EXPECT_TRUE(ring.empty());
+      EXPECT_EQ(ThrowingCopy::live, 4);
+      EXPECT_EQ(ring.try_push_n(input, 3), 3);
+      EXPECT_EQ(ring.pop().value, 3);
+    }
+    EXPECT_EQ(ThrowingCopy::live, 0);
+  }
+
+  TEST(SpscRing, SpinTransfer)
+  {
+    TransferInOrder<ftl::spin_wait>(1);
+    TransferInOrder<ftl::spin_wait>(16);
+  }
+
+  TEST(SpscRing, YieldTransfer)
+  {
+    TransferInOrder<ftl::yield_wait>(1);
+    TransferInOrder<ftl::yield_wait>(7);
+  }
+
+  TEST(SpscRing, FutexTransfer)
+  {
+    TransferInOrder<ftl::futex_wait>(1);
+    TransferInOrder<ftl::futex_wait>(13);
+  }
+}
@@ -0,0 +1,96 @@
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  struct GrowTag
+  {
+    static const char* name() { return "test.grow"; }
+  };
+
+  struct ReserveTag
+  {
+    static const char* name() { return "test.reserve"; }
+  };
+
+  struct ThreadTag
+  {
+    static const char* name() { return "test.threads"; }
+  };
+
+  template <typename T, typename Tag>
+  using TrackedVectorT =
+      ftl::vector<T, std::allocator<T>, ftl::growth_factor_2,
+          ftl::tagged_stats<Tag>>;
+
+  uint64_t Load(const std::atomic<uint64_t>& counter)
+  {
+    return counter.load();
+  }
+
+  TEST(VectorStats, DisabledCostsNothing)
+  {
+    EXPECT_EQ(sizeof(ftl::vector<int>),
+        sizeof(ftl::vector<int, std::allocator<int>, ftl::growth_factor_2,
+            ftl::no_stats>));
+  }
+
+  TEST(VectorStats, CountsGrowth)
+  {
+    auto& counters = ftl::tagged_stats<GrowTag>::counters();
+    counters.reset();
+    {
+      TrackedVectorT<std::string, GrowTag> vector;
+      for (int i = 0; i != 100; ++i) {
+        vector.push_back(std::to_string(i));
+      }
+      vector.insert(vector.begin() + 90, "x");
+    }
+    EXPECT_EQ(Load(counters.allocations), 8);
+    EXPECT_EQ(Load(counters.reallocations), 7);
+    EXPECT_EQ(Load(counters.elements_relocated), 127);
+    EXPECT_EQ(Load(counters.peak_capacity), 128);
+    EXPECT_EQ(Load(counters.bytes_allocated), 255 * sizeof(std::string));
+    EXPECT_EQ(Load(counters.shifts), 1);
+    EXPECT_EQ(Load(counters.elements_shifted), 10);
+  }
+
+  TEST(VectorStats, ReserveAvoidsReallocation)
+  {
+    auto& counters = ftl::tagged_stats<ReserveTag>::counters();
+    counters.reset();
+    TrackedVectorT<int, ReserveTag> vector;
+    vector.reserve(100);
+    for (int i = 0; i != 100; ++i) {
+      vector.push_back(i);
+    }
+    EXPECT_EQ(Load(counters.allocations), 1);
+    EXPECT_EQ(Load(counters.reallocations), 0);
+    EXPECT_EQ(Load(counters.peak_capacity), 100);
+  }
+
+  TEST(VectorStats, AggregatesAcrossThreadsAndDumps)
+  {
+    ftl::stats_registry::instance().reset();
+    std::vector<std::thread> threads;
+    for (int t = 0; t != 4; ++t) {
+      threads.emplace_back([] {
+        for (int round = 0; round != 100; ++round) {
+          TrackedVectorT<int, ThreadTag> vector(3, 0);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(Load(ftl::tagged_stats<ThreadTag>::counters().allocations), 400);
+
+    std::ostringstream out;
+    ftl::stats_registry::instance().dump(out);
+    EXPECT_NE(out.str().find("test.threads: allocations=400 "),
+        std::string::npos);
+  }
+}
@@ -0,0 +1,159 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ftl/core.hpp>
+#include <gtest/gtest.h>
+
+namespace test {
+  long Fibonacci(ftl::thread_pool& pool, int n)
+  {
+    if (n < 2) {
+      return n;
+    }
+    auto left = pool.submit([&pool, n] { return Fibonacci(pool, n - 1); });
+    const long right = Fibonacci(pool, n - 2);
+    return left.get() + right;
+  }
+
+  TEST(ThreadPool, SubmitReturnsResult)
+  {
+    ftl::thread_pool pool(2);
+    auto answer = pool.submit([] { return 42; });
+    auto text = pool.submit([] { return std::string("pool"); });
+    EXPECT_EQ(answer.get(), 42);
+    EXPECT_EQ(text.get(), "pool");
+    EXPECT_FALSE(answer.valid());
+  }
+
+  TEST(ThreadPool, MoveOnlyResultsAndTasks)
+  {
+    ftl::thread_pool pool(2);
+    auto owned = std::make_unique<int>(7);
+    auto handle = pool.submit([p = std::move(owned)]() mutable {
+      return std::move(p);
+    });
+    auto result = handle.get();
+    ASSERT_NE(result, nullptr);
+    EXPECT_EQ(*result, 7);
+  }
+
+  TEST(ThreadPool, ExceptionReachesGet)
+  {
+    ftl::thread_pool pool(2);
+    auto failing = pool.submit([]() -> int { throw std::runtime_error("x"); });
+    auto nothing = pool.submit([] { throw std::logic_error("y"); });
+    EXPECT_THROW(failing.get(), std::runtime_error);
+    EXPECT_THROW(nothing.get(), std::logic_error);
+  }
+
+  TEST(ThreadPool, WaitIdleWaitsForSpawnedTasks)
+  {
+    ftl::thread_pool pool(4);
+    std::atomic<int> count{ 0 };
+    for (int i = 0; i != 100; ++i) {
+      pool.submit([&pool, &count] {
+        for (int j = 0; j != 10; ++j) {
+          pool.submit([&count] { ++count; });
+        }
+        ++count;
+      });
+    }
+    pool.wait_idle();
+    EXPECT_EQ(count.load(), 1100);
+  }
+
+  TEST(ThreadPool, NestedWaitsDoNotDeadlock)
+  {
+    for (std::size_t workers : { 1, 2, 4 }) {
+      ftl::thread_pool pool(workers);
+      auto result = pool.submit([&pool] { return Fibonacci(pool, 18); });
+      EXPECT_EQ(result.get(), 2584) << workers;
+    }
+  }
+
+  // One task spawns every child onto its own deque and then blocks, so the
+  // children can only run on the other workers by being stolen.
+  TEST(ThreadPool, IdleWorkersStealUnderImbalancedLoad)
+  {
+    ftl::thread_pool pool(4);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    std::thread::id spawner;
+    pool.submit([&] {
+          spawner = std::this_thread::get_id();
+          for (int i = 0; i != 64; ++i) {
+            pool.submit([&] {
+              std::this_thread::sleep_for(std::chrono::milliseconds(1));
+              std::lock_guard<std::mutex> lock(mutex);
+              threads.insert(std::this_thread::get_id());
+            });
+          }
+          std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        })
+        .wait();
+    pool.wait_idle();
+    threads.erase(spawner);
+    EXPECT_GE(threads.size(), 2u);
+  }
+
+  TEST(ThreadPool, ParkedWorkersWakeForNewTasks)
+  {
+    ftl::thread_pool pool(3);
+    for (int round = 0; round != 5; ++round) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      std::vector<ftl::task_handle<int>> handles;
+      for (int i = 0; i != 10; ++i) {
+        handles.push_back(pool.submit([i] { return i * i; }));
+      }
+      int sum = 0;
+      for (auto& handle : handles) {
+        sum += handle.get();
+      }
+      EXPECT_EQ(sum, 285);
+    }
+  }
+
+  TEST(ThreadPool, ExternalThreadsSubmitConcurrently)
+  {
+    ftl::thread_pool pool(2);
+    std::atomic<int> count{ 0 };
+    std::vector<std::thread> producers;
+    for (int t = 0; t != 4; ++t) {
+      producers.emplace_back([&] {
+        for (int i = 0; i != 500; ++i) {
+          pool.submit([&count] { ++count; });
+        }
+      });
+    }
+    for (auto& producer : producers) {
+      producer.join();
+    }
+    pool.wait_idle();
+    EXPECT_EQ(count.load(), 2000);
+  }
+
+  TEST(ThreadPool, DestructorRunsQueuedTasks)
+  {
+    std::atomic<int> count{ 0 };
+    {
+      ftl::thread_pool pool(1);
+      for (int i = 0; i != 100; ++i) {
+        pool.submit([&count] { ++count; });
+      }
+    }
+    EXPECT_EQ(count.load(), 100);
+  }
+
+  TEST(ThreadPool, ZeroWorkersMeansOne)
+  {
+    ftl::thread_pool pool(0);
+    EXPECT_EQ(pool.size(), 1u);
+    EXPECT_EQ(pool.submit([] { return 1; }).get(), 1);
+  }
+}
@@ -1,7 +1,12 @@
 #include <algorithm>
 #include <initializer_list>
 #include <iterator>
+#include <limits>
+#include <memory>
 #include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
 #include <ftl/core.hpp>
 #include <gtest/gtest.h>
 
@@ -115,6 +120,9 @@ namespace test {
     VectorT moved(std::move(vector));
     AssertInvariants(moved, copy.size());
     AssertVectorsEqual(copy, moved);
+    EXPECT_EQ(vector.capacity(), 0u);
+    vector.push_back(1);
+    EXPECT_EQ(vector.size(), 1u);
   }
 
   TEST(VectorAssignmentOperator, Move)
@@ -320,6 +328,22 @@ namespace test {
     AssertInvariants(filled, copy.size() + values.size());
   }
 
+  TEST_F(VectorTest, InsertIteratorWithoutReallocation)
+  {
+    auto values = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    filled.reserve(filled.size() + values.size());
+    const auto data = filled.data();
+    size_t shift = 2;
+    auto it = filled.insert(filled.cbegin() + shift, values.begin(),
+        values.end());
+    EXPECT_EQ(filled.data(), data);
+    ASSERT_EQ(std::distance(filled.begin(), it), shift);
+    EXPECT_TRUE(std::equal(it, it + values.size(), values.begin()));
+    EXPECT_TRUE(std::equal(it + values.size(), filled.end(),
+        copy.begin() + shift));
+    AssertInvariants(filled, copy.size() + values.size());
+  }
+
   TEST_F(VectorTest, InsertInitializerList)
   {
     std::initializer_list<VectorT::value_type> values = { 1, 2, 3, 4, 5, 6 };
@@ -434,3 +458,594 @@ namespace test {
     EXPECT_FALSE(vec2 < vec1);
   }
 }
+
+namespace test {
+  class Handle
+  {
+  public:
+    explicit Handle(int value) : value_(new int(value)) {}
+    Handle(const Handle& rhs) : value_(new int(*rhs.value_)) {}
+    Handle(Handle&& rhs) noexcept : value_(std::exchange(rhs.value_, nullptr))
+    {
+    }
+    Handle& operator=(Handle rhs) noexcept
+    {
+      std::swap(value_, rhs.value_);
+      return *this;
+    }
+    ~Handle() { delete value_; }
+
+    int value() const { return *value_; }
+
+  private:
+    int* value_;
+  };
+}
+
+template <>
+struct ftl::is_trivially_relocatable<test::Handle> : std::true_type
+{
+};
+
+namespace test {
+  using HandleVectorT = ftl::vector<Handle>;
+
+  TEST(VectorRelocation, Traits)
+  {
+    EXPECT_TRUE(ftl::is_trivially_relocatable<double>::value);
+    EXPECT_TRUE(ftl::is_trivially_relocatable<Handle>::value);
+    EXPECT_TRUE(ftl::is_trivially_relocatable<std::unique_ptr<int>>::value);
+    EXPECT_FALSE(ftl::is_trivially_relocatable<std::vector<int>>::value);
+  }
+
+  TEST(VectorRelocation, GrowthKeepsValues)
+  {
+    HandleVectorT vector;
+    for (int i = 0; i != 1000; ++i) {
+      vector.emplace_back(i);
+    }
+    ASSERT_EQ(vector.size(), 1000);
+    for (int i = 0; i != 1000; ++i) {
+      EXPECT_EQ(vector[i].value(), i);
+    }
+    vector.shrink_to_fit();
+    EXPECT_EQ(vector.capacity(), vector.size());
+    EXPECT_EQ(vector.back().value(), 999);
+  }
+
+  TEST(VectorRelocation, InsertAndErase)
+  {
+    HandleVectorT vector;
+    for (int i = 0; i != 10; ++i) {
+      vector.emplace_back(i);
+    }
+    vector.emplace(vector.begin() + 3, 100);
+    vector.insert(vector.begin(), vector[5]);
+    vector.erase(vector.begin() + 1, vector.begin() + 3);
+    const int expected[] = { 4, 2, 100, 3, 4, 5, 6, 7, 8, 9 };
+    ASSERT_EQ(vector.size(), std::size(expected));
+    for (size_t i = 0; i != vector.size(); ++i) {
+      EXPECT_EQ(vector[i].value(), expected[i]);
+    }
+  }
+
+  TEST(VectorRelocation, UniquePtr)
+  {
+    ftl::vector<std::unique_ptr<int>> vector;
+    for (int i = 0; i != 100; ++i) {
+      vector.push_back(std::make_unique<int>(i));
+    }
+    vector.erase(vector.begin(), vector.begin() + 50);
+    vector.insert(vector.begin(), std::make_unique<int>(-1));
+    ASSERT_EQ(vector.size(), 51);
+    EXPECT_EQ(*vector.front(), -1);
+    EXPECT_EQ(*vector[1], 50);
+    EXPECT_EQ(*vector.back(), 99);
+  }
+}
+
+namespace test {
+  using StringVectorT = ftl::vector<std::string>;
+
+  std::vector<std::string> MakeStrings(size_t count, const std::string& prefix)
+  {
+    std::vector<std::string> result;
+    for (size_t i = 0; i != count; ++i) {
+      result.push_back(prefix + std::to_string(i) + std::string(20, '.'));
+    }
+    return result;
+  }
+
+  TEST(VectorRangeInsert, MatchesStdVector)
+  {
+    const auto source = MakeStrings(10, "old");
+    for (size_t count : { 0, 1, 3, 10, 25 }) {
+      const auto values = MakeStrings(count, "new");
+      for (size_t shift = 0; shift <= source.size(); ++shift) {
+        for (size_t extra : { 0, 30 }) {
+          StringVectorT vector(source.begin(), source.end());
+          vector.reserve(vector.size() + extra);
+          std::vector<std::string> expected(source);
+          expected.insert(expected.begin() + shift, values.begin(),
+              values.end());
+          auto it = vector.insert(vector.cbegin() + shift, values.begin(),
+              values.end());
+          EXPECT_EQ(it - vector.begin(), shift);
+          ASSERT_EQ(vector.size(), expected.size());
+          EXPECT_TRUE(std::equal(vector.begin(), vector.end(),
+              expected.begin()));
+        }
+      }
+    }
+  }
+
+  TEST(VectorRangeInsert, InputIterator)
+  {
+    std::istringstream stream("1 2 3 4");
+    VectorT vector{ 0, 5 };
+    auto it = vector.insert(vector.cbegin() + 1,
+        std::istream_iterator<int>(stream), std::istream_iterator<int>());
+    EXPECT_EQ(it, vector.begin() + 1);
+    AssertVectorsEqual(vector, VectorT{ 0, 1, 2, 3, 4, 5 });
+  }
+
+  TEST(VectorRangeInsert, ConstructorAllocatesOnce)
+  {
+    const auto values = MakeStrings(37, "v");
+    StringVectorT vector(values.begin(), values.end());
+    EXPECT_EQ(vector.size(), values.size());
+    EXPECT_EQ(vector.capacity(), values.size());
+  }
+
+  TEST(VectorRangeInsert, ConstructorFromInputIterator)
+  {
+    std::istringstream stream("1 2 3");
+    VectorT vector(std::istream_iterator<int>(stream),
+        std::istream_iterator<int>{});
+    AssertVectorsEqual(vector, VectorT{ 1, 2, 3 });
+  }
+
+  TEST(VectorRangeInsert, AssignGrowAndShrink)
+  {
+    const auto small = MakeStrings(3, "s");
+    const auto large = MakeStrings(40, "l");
+    StringVectorT vector(small.begin(), small.end());
+    vector.assign(large.begin(), large.end());
+    ASSERT_EQ(vector.size(), large.size());
+    EXPECT_TRUE(std::equal(vector.begin(), vector.end(), large.begin()));
+    const auto capacity = vector.capacity();
+    vector.assign(small.begin(), small.end());
+    ASSERT_EQ(vector.size(), small.size());
+    EXPECT_EQ(vector.capacity(), capacity);
+    EXPECT_TRUE(std::equal(vector.begin(), vector.end(), small.begin()));
+  }
+}
+
+namespace test {
+  TEST(VectorFillInsert, MatchesStdVector)
+  {
+    const auto source = MakeStrings(10, "old");
+    const std::string value(30, 'x');
+    for (size_t count : { 0, 1, 3, 10, 25 }) {
+      for (size_t shift = 0; shift <= source.size(); ++shift) {
+        for (size_t extra : { 0, 2, 30 }) {
+          StringVectorT vector(source.begin(), source.end());
+          vector.reserve(vector.size() + extra);
+          std::vector<std::string> expected(source);
+          expected.insert(expected.begin() + shift, count, value);
+          auto it = vector.insert(vector.cbegin() + shift, count, value);
+          EXPECT_EQ(it - vector.begin(), shift);
+          ASSERT_EQ(vector.size(), expected.size());
+          EXPECT_TRUE(std::equal(vector.begin(), vector.end(),
+              expected.begin()));
+        }
+      }
+    }
+  }
+
+  TEST(VectorFillInsert, SpareCapacitySmallerThanCount)
+  {
+    VectorT vector{ 1, 2, 3 };
+    vector.reserve(4);
+    vector.insert(vector.cbegin() + 1, 5, 7.0);
+    AssertVectorsEqual(vector, VectorT{ 1, 7, 7, 7, 7, 7, 2, 3 });
+  }
+
+  TEST(VectorFillInsert, ValueFromSameVector)
+  {
+    StringVectorT strings{ "a", "b", "c", "d" };
+    strings.reserve(16);
+    strings.insert(strings.cbegin(), 2, strings[2]);
+    EXPECT_TRUE(strings == StringVectorT({ "c", "c", "a", "b", "c", "d" }));
+
+    VectorT vector{ 1, 2, 3, 4 };
+    vector.reserve(16);
+    vector.insert(vector.cbegin() + 1, 3, vector[3]);
+    AssertVectorsEqual(vector, VectorT{ 1, 4, 4, 4, 2, 3, 4 });
+    vector.insert(vector.cbegin(), 10, vector.back());
+    AssertInvariants(vector, 17);
+    AssertAllElementsEqual(VectorT(vector.begin(), vector.begin() + 10), 4);
+  }
+
+  TEST(VectorFillInsert, InitializerListIntoStrings)
+  {
+    StringVectorT vector{ "a", "e" };
+    auto it = vector.insert(vector.cbegin() + 1, { "b", "c", "d" });
+    EXPECT_EQ(it, vector.begin() + 1);
+    EXPECT_TRUE(vector == StringVectorT({ "a", "b", "c", "d", "e" }));
+  }
+
+  TEST(VectorEmplace, ValueFromFullVector)
+  {
+    ftl::vector<long> vector(64);
+    std::iota(vector.begin(), vector.end(), 0);
+    vector.shrink_to_fit();
+    ASSERT_EQ(vector.size(), vector.capacity());
+    vector.insert(vector.begin(), vector[63]);
+    ASSERT_EQ(vector.size(), 65);
+    EXPECT_EQ(vector[0], 63);
+    EXPECT_EQ(vector[1], 0);
+    EXPECT_EQ(vector.back(), 63);
+  }
+
+  TEST(VectorEmplace, ValueFromSameVectorNonRelocatable)
+  {
+    StringVectorT strings{ "a", "b", "c", "d" };
+    strings.reserve(16);
+    strings.insert(strings.begin(), strings[1]);
+    EXPECT_TRUE(strings == StringVectorT({ "b", "a", "b", "c", "d" }));
+
+    strings.shrink_to_fit();
+    ASSERT_EQ(strings.size(), strings.capacity());
+    strings.insert(strings.begin() + 1, strings[4]);
+    EXPECT_TRUE(strings == StringVectorT({ "b", "d", "a", "b", "c", "d" }));
+
+    strings.shrink_to_fit();
+    strings.push_back(strings[2]);
+    EXPECT_TRUE(
+        strings == StringVectorT({ "b", "d", "a", "b", "c", "d", "a" }));
+  }
+}
+
+namespace test {
+  TEST(VectorDefaultInit, ResizeForOverwrite)
+  {
+    ftl::vector<int> vector{ 1, 2 };
+    vector.resize_for_overwrite(100);
+    EXPECT_EQ(vector.size(), 100);
+    EXPECT_EQ(vector[0], 1);
+    EXPECT_EQ(vector[1], 2);
+    std::iota(vector.begin() + 2, vector.end(), 3);
+    EXPECT_EQ(vector.back(), 100);
+    vector.resize_for_overwrite(10);
+    EXPECT_EQ(vector.size(), 10);
+    EXPECT_EQ(vector.back(), 10);
+  }
+
+  TEST(VectorDefaultInit, ResizeForOverwriteNonTrivial)
+  {
+    StringVectorT vector{ "a" };
+    vector.resize_for_overwrite(3);
+    EXPECT_TRUE(vector == StringVectorT({ "a", "", "" }));
+  }
+
+  TEST(VectorDefaultInit, Constructor)
+  {
+    ftl::vector<unsigned char> vector(64, ftl::default_init);
+    EXPECT_EQ(vector.size(), 64);
+    EXPECT_EQ(vector.capacity(), 64);
+    StringVectorT strings(2, ftl::default_init);
+    EXPECT_TRUE(strings == StringVectorT({ "", "" }));
+  }
+
+  TEST(VectorDefaultInit, ResizeValueFromSameVector)
+  {
+    StringVectorT vector{ "a", "b" };
+    vector.shrink_to_fit();
+    vector.resize(5, vector[0]);
+    EXPECT_TRUE(vector == StringVectorT({ "a", "b", "a", "a", "a" }));
+  }
+
+  TEST(VectorDefaultInit, AppendUninitialized)
+  {
+    const char text[] = "hello, world";
+    ftl::vector<char> vector{ '>' };
+    auto written = vector.append_uninitialized(64, [&](char* out, size_t n) {
+      EXPECT_GE(n, sizeof(text) - 1);
+      std::copy(text, text + sizeof(text) - 1, out);
+      return sizeof(text) - 1;
+    });
+    EXPECT_EQ(written, sizeof(text) - 1);
+    ASSERT_EQ(vector.size(), sizeof(text));
+    EXPECT_GE(vector.capacity(), 65);
+    EXPECT_TRUE(std::equal(vector.begin() + 1, vector.end(), text));
+  }
+
+  TEST(VectorDefaultInit, AppendUninitializedThrows)
+  {
+    ftl::vector<int> vector{ 1, 2, 3 };
+    EXPECT_THROW(vector.append_uninitialized(8,
+                     [](int*, size_t) -> size_t { throw std::exception(); }),
+        std::exception);
+    EXPECT_TRUE(vector == ftl::vector<int>({ 1, 2, 3 }));
+  }
+}
+
+namespace test {
+  // Hands out blocks from a fixed buffer; the most recent block can grow in
+  // place as long as the buffer has room.
+  struct BumpArena
+  {
+    alignas(std::max_align_t) unsigned char buffer[1 << 16];
+    size_t top = 0;
+    size_t allocations = 0;
+    size_t expansions = 0;
+  };
+
+  template <typename T>
+  class ExpandingAllocator
+  {
+  public:
+    using value_type = T;
+
+    struct Allocation
+    {
+      T* ptr;
+      size_t count;
+    };
+
+    explicit ExpandingAllocator(BumpArena* arena) : arena_(arena) {}
+
+    template <typename U>
+    ExpandingAllocator(const ExpandingAllocator<U>& other) :
+      arena_(other.arena())
+    {
+    }
+
+    T* allocate(size_t n) { return allocate_at_least(n).ptr; }
+
+    Allocation allocate_at_least(size_t n)
+    {
+      n = (n + 7) / 8 * 8;
+      size_t start = (arena_->top + alignof(T) - 1) / alignof(T) * alignof(T);
+      if (start + n * sizeof(T) > sizeof(arena_->buffer)) {
+        throw std::bad_alloc();
+      }
+      ++arena_->allocations;
+      arena_->top = start + n * sizeof(T);
+      return { reinterpret_cast<T*>(arena_->buffer + start), n };
+    }
+
+    void deallocate(T*, size_t) {}
+
+    bool try_expand(T* p, size_t n, size_t new_n)
+    {
+      auto end = reinterpret_cast<unsigned char*>(p + n);
+      size_t new_top = (end - arena_->buffer) + (new_n - n) * sizeof(T);
+      if (end != arena_->buffer + arena_->top ||
+          new_top > sizeof(arena_->buffer)) {
+        return false;
+      }
+      ++arena_->expansions;
+      arena_->top = new_top;
+      return true;
+    }
+
+    BumpArena* arena() const { return arena_; }
+
+    friend bool operator==(const ExpandingAllocator& lhs,
+        const ExpandingAllocator& rhs)
+    {
+      return lhs.arena_ == rhs.arena_;
+    }
+
+    friend bool operator!=(const ExpandingAllocator& lhs,
+        const ExpandingAllocator& rhs)
+    {
+      return !(lhs == rhs);
+    }
+
+  private:
+    BumpArena* arena_;
+  };
+
+  template <typename Vector>
+  std::vector<size_t> CapacitySteps(Vector& vector, size_t count)
+  {
+    std::vector<size_t> steps{ vector.capacity() };
+    for (size_t i = 0; i != count; ++i) {
+      vector.push_back(typename Vector::value_type());
+      if (vector.capacity() != steps.back()) {
+        steps.push_back(vector.capacity());
+      }
+    }
+    return steps;
+  }
+
+  TEST(VectorGrowth, DefaultDoubles)
+  {
+    ftl::vector<int> vector;
+    auto steps = CapacitySteps(vector, 1000);
+    for (size_t i = 2; i < steps.size(); ++i) {
+      EXPECT_EQ(steps[i], steps[i - 1] * 2);
+    }
+  }
+
+  TEST(VectorGrowth, FactorOneAndHalf)
+  {
+    ftl::vector<int, std::allocator<int>, ftl::growth_factor_1_5> vector;
+    auto steps = CapacitySteps(vector, 1000);
+    for (size_t i = 1; i < steps.size(); ++i) {
+      EXPECT_EQ(steps[i], std::max(steps[i - 1] * 3 / 2, steps[i - 1] + 1));
+    }
+    EXPECT_LT(steps.back(), 1500);
+  }
+
+  TEST(VectorGrowth, PageRounded)
+  {
+    using Policy = ftl::page_rounded_growth<>;
+    const size_t max = std::numeric_limits<size_t>::max() / sizeof(int);
+    EXPECT_EQ(Policy::recommend<int>(size_t(1000), size_t(1001), max), 2048);
+    EXPECT_EQ(Policy::recommend<int>(size_t(1), size_t(2), max), 4);
+    EXPECT_EQ(Policy::recommend<int>(max - 1, max, max), max);
+
+    ftl::vector<char, std::allocator<char>, Policy> vector;
+    for (size_t capacity : CapacitySteps(vector, 100000)) {
+      EXPECT_EQ(capacity % (capacity >= 4096 ? 4096 : 16), 0) << capacity;
+    }
+  }
+
+  TEST(VectorGrowth, ExpandsInPlace)
+  {
+    BumpArena arena;
+    ftl::vector<std::string, ExpandingAllocator<std::string>> vector(
+        ExpandingAllocator<std::string>{ &arena });
+    vector.push_back(std::string(32, 'a'));
+    const std::string* data = vector.data();
+    EXPECT_EQ(vector.capacity(), 8);
+    for (int i = 1; i != 100; ++i) {
+      vector.push_back(std::to_string(i));
+    }
+    std::vector<std::string> middle{ "x", "y", "z" };
+    vector.insert(vector.cbegin() + 1, middle.begin(), middle.end());
+    vector.insert(vector.cbegin() + 1, 50, "fill");
+    EXPECT_EQ(vector.data(), data);
+    EXPECT_EQ(arena.allocations, 1);
+    EXPECT_GT(arena.expansions, 0);
+    EXPECT_EQ(vector.size(), 153);
+    EXPECT_EQ(vector[0], std::string(32, 'a'));
+    EXPECT_EQ(vector[51], "x");
+    EXPECT_EQ(vector.back(), "99");
+  }
+
+  TEST(VectorGrowth, FallsBackWhenExpansionFails)
+  {
+    BumpArena arena;
+    ExpandingAllocator<int> alloc{ &arena };
+    ftl::vector<int, ExpandingAllocator<int>> first(alloc);
+    ftl::vector<int, ExpandingAllocator<int>> second(alloc);
+    first.push_back(1);
+    second.push_back(2);
+    const int* data = first.data();
+    for (int i = 0; i != 20; ++i) {
+      first.push_back(i);
+    }
+    EXPECT_NE(first.data(), data);
+    EXPECT_EQ(first.front(), 1);
+    EXPECT_EQ(first.back(), 19);
+    EXPECT_EQ(second.front(), 2);
+  }
+}
+
+namespace test {
+  // Allocator whose instances differ by id; whether it propagates is chosen
+  // by the Propagate parameter.
+  template <typename T, bool Propagate>
+  class TaggedAllocator
+  {
+  public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment =
+        std::integral_constant<bool, Propagate>;
+    using propagate_on_container_move_assignment =
+        std::integral_constant<bool, Propagate>;
+    using propagate_on_container_swap = std::integral_constant<bool, Propagate>;
+    using is_always_equal = std::false_type;
+
+    template <typename U>
+    struct rebind
+    {
+      using other = TaggedAllocator<U, Propagate>;
+    };
+
+    explicit TaggedAllocator(int id) : id_(id) {}
+
+    template <typename U>
+    TaggedAllocator(const TaggedAllocator<U, Propagate>& other) :
+      id_(other.id())
+    {
+    }
+
+    T* allocate(size_t n) { return std::allocator<T>().allocate(n); }
+    void deallocate(T* p, size_t n) { std::allocator<T>().deallocate(p, n); }
+
+    TaggedAllocator select_on_container_copy_construction() const
+    {
+      return TaggedAllocator(id_ + 100);
+    }
+
+    int id() const { return id_; }
+
+    friend bool operator==(const TaggedAllocator& lhs,
+        const TaggedAllocator& rhs)
+    {
+      return lhs.id_ == rhs.id_;
+    }
+
+    friend bool operator!=(const TaggedAllocator& lhs,
+        const TaggedAllocator& rhs)
+    {
+      return !(lhs == rhs);
+    }
+
+  private:
+    int id_;
+  };
+
+  template <bool Propagate>
+  using TaggedVectorT =
+      ftl::vector<std::string, TaggedAllocator<std::string, Propagate>>;
+
+  TEST(VectorAllocator, CopyConstructionSelectsAllocator)
+  {
+    TaggedVectorT<false> vector({ "a", "b" },
+        TaggedAllocator<std::string, false>(1));
+    TaggedVectorT<false> copy(vector);
+    EXPECT_EQ(copy.get_allocator().id(), 101);
+    EXPECT_TRUE(copy == vector);
+  }
+
+  TEST(VectorAllocator, PropagatingAllocatorFollowsAssignment)
+  {
+    using AllocT = TaggedAllocator<std::string, true>;
+    TaggedVectorT<true> first({ "a", "b", "c" }, AllocT(1));
+    TaggedVectorT<true> second({ "x" }, AllocT(2));
+    first = second;
+    EXPECT_EQ(first.get_allocator().id(), 2);
+    EXPECT_TRUE(first == second);
+
+    TaggedVectorT<true> third({ "y", "z" }, AllocT(3));
+    const std::string* data = third.data();
+    first = std::move(third);
+    EXPECT_EQ(first.get_allocator().id(), 3);
+    EXPECT_EQ(first.data(), data);
+
+    first.swap(second);
+    EXPECT_EQ(first.get_allocator().id(), 2);
+    EXPECT_EQ(second.get_allocator().id(), 3);
+    EXPECT_EQ(second.data(), data);
+  }
+
+  TEST(VectorAllocator, NonPropagatingAllocatorStays)
+  {
+    using AllocT = TaggedAllocator<std::string, false>;
+    TaggedVectorT<false> first({ "a", "b", "c" }, AllocT(1));
+    TaggedVectorT<false> second({ "x" }, AllocT(2));
+    first = second;
+    EXPECT_EQ(first.get_allocator().id(), 1);
+    EXPECT_TRUE(first == second);
+
+    TaggedVectorT<false> third({ "y", "z" }, AllocT(3));
+    const std::string* data = third.data();
+    first = std::move(third);
+    EXPECT_EQ(first.get_allocator().id(), 1);
+    EXPECT_NE(first.data(), data);
+    EXPECT_TRUE(first == TaggedVectorT<false>({ "y", "z" }, AllocT(1)));
+    EXPECT_TRUE(third.empty());
+
+    TaggedVectorT<false> same({ "w" }, AllocT(1));
+    data = same.data();
+    first = std::move(same);
+    EXPECT_EQ(first.data(), data);
+  }
+}